@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ * Project:  WindNinja
+ * Purpose:  C API testing of asynchronous runs with per-run callbacks
+ *
+ * gcc -g -Wall -o test_capi_async_runs test_capi_async_runs.c -lninja -lpthread
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY,
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+#include "windninja.h"
+#include <stdio.h> //for printf
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h> //for usleep
+
+#define MAX_PATH_LEN 512
+#define NUM_NINJAS 3 //must be equal to array sizes
+
+/*
+ * Runs report from their own threads, possibly at the same time
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    int nCalls;
+    int seen[NUM_NINJAS];
+    double maxSpeed[NUM_NINJAS];
+    int badView;
+} runResults;
+
+static void runComplete(const ninjaRunResult *pResult, void *pUser)
+{
+    runResults *results = (runResults *)pUser;
+    double maxSpeed = 0.0;
+    int bad = pResult->speed == NULL || pResult->direction == NULL ||
+              pResult->u == NULL || pResult->v == NULL || pResult->w == NULL ||
+              pResult->nCols <= 0 || pResult->nRows <= 0;
+    if(!bad)
+    {
+        for(int k=0; k<pResult->nCols*pResult->nRows; k++)
+        {
+            if(pResult->speed[k] > maxSpeed)
+            {
+                maxSpeed = pResult->speed[k];
+            }
+        }
+    }
+
+    pthread_mutex_lock(&results->mutex);
+    results->nCalls++;
+    if(pResult->runNumber >= 0 && pResult->runNumber < NUM_NINJAS)
+    {
+        results->seen[pResult->runNumber]++;
+        results->maxSpeed[pResult->runNumber] = maxSpeed;
+    }
+    results->badView |= bad;
+    pthread_mutex_unlock(&results->mutex);
+}
+
+int main()
+{
+    NinjaArmyH* ninjaArmy = NULL;
+    const int nCPUs = 2;
+    char ** papszOptions = NULL;
+    NinjaErr err = 0;
+    int failed = 0;
+    err = NinjaInit("C-API autotest", papszOptions); //initialize global singletons and environments (GDAL_DATA, etc.)
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaInit: err = %d\n", err);
+    }
+
+    // manually set your wnDataPath (makes it easier for setting paths and testing)
+    // must replace the "~/" part with your exact path
+    const char* wnDataPath = "~/src/wind/windninja/data";
+
+    char demFile[MAX_PATH_LEN];
+    snprintf(demFile, sizeof(demFile), "%s%s", wnDataPath, "/../autotest/api/data/missoula_valley.tif");
+    const double speedList[] = {5.5, 8.0, 11.0};
+    const char * speedUnits = "mps";
+    const double directionList[] = {270.0, 270.0, 270.0};
+
+    /*
+     * Make and prepare the army
+     */
+    ninjaArmy = NinjaInitializeArmy();
+    if( NULL == ninjaArmy )
+    {
+        printf("NinjaInitializeArmy: ninjaArmy = NULL\n");
+        return 1;
+    }
+    err = NinjaMakeDomainAverageArmy(ninjaArmy, NUM_NINJAS, 0, speedList, speedUnits, directionList, papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaMakeDomainAverageArmy: err = %d\n", err);
+        return 1;
+    }
+    for(unsigned int i=0; i<NUM_NINJAS; i++)
+    {
+        err = NinjaSetNumberCPUs(ninjaArmy, i, nCPUs, papszOptions);
+        err |= NinjaSetInitializationMethod(ninjaArmy, i, "domain_average", true, papszOptions);
+        err |= NinjaSetDem(ninjaArmy, i, demFile, papszOptions);
+        err |= NinjaSetPosition(ninjaArmy, i, papszOptions);
+        err |= NinjaSetInputWindHeight(ninjaArmy, i, 10.0, "m", papszOptions);
+        err |= NinjaSetOutputWindHeight(ninjaArmy, i, 10.0, "m", papszOptions);
+        err |= NinjaSetOutputSpeedUnits(ninjaArmy, i, speedUnits, papszOptions);
+        err |= NinjaSetDiurnalWinds(ninjaArmy, i, 0, papszOptions);
+        err |= NinjaSetUniVegetation(ninjaArmy, i, "grass", papszOptions);
+        err |= NinjaSetMeshResolutionChoice(ninjaArmy, i, "coarse", papszOptions);
+        if(err != NINJA_SUCCESS)
+        {
+            printf("setting up ninja %d: err = %d\n", i, err);
+            return 1;
+        }
+    }
+
+    /*
+     * Start the runs, poll them while they go and wait for the end
+     */
+    runResults results = {0};
+    pthread_mutex_init(&results.mutex, NULL);
+    err = NinjaStartRunsAsync(ninjaArmy, nCPUs, runComplete, &results, true, papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaStartRunsAsync: err = %d\n", err);
+        return 1;
+    }
+
+    int nFinished = 0;
+    bool finished = false;
+    while(!finished)
+    {
+        err = NinjaPollRuns(ninjaArmy, &nFinished, &finished, papszOptions);
+        if(err != NINJA_SUCCESS)
+        {
+            printf("NinjaPollRuns: err = %d\n", err);
+            failed = 1;
+            break;
+        }
+        usleep(100000);
+    }
+    printf("%d runs finished\n", nFinished);
+
+    err = NinjaWaitRuns(ninjaArmy, papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaWaitRuns: err = %d\n", err);
+        failed = 1;
+    }
+
+    /*
+     * Every run reported once, with full views, and faster inputs gave
+     * faster winds
+     */
+    if(results.nCalls != NUM_NINJAS || results.badView)
+    {
+        printf("callbacks: %d calls, bad views = %d\n", results.nCalls, results.badView);
+        failed = 1;
+    }
+    for(int i=0; i<NUM_NINJAS; i++)
+    {
+        printf("run %d: reported %d times, max speed %g\n", i, results.seen[i], results.maxSpeed[i]);
+        if(results.seen[i] != 1 || (i > 0 && results.maxSpeed[i] <= results.maxSpeed[i-1]))
+        {
+            failed = 1;
+        }
+    }
+    pthread_mutex_destroy(&results.mutex);
+
+    /*
+     * Clean up
+     */
+    err = NinjaDestroyArmy(ninjaArmy, papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaDestroyArmy: err = %d\n", err);
+    }
+
+    // must be called to cleanup ninjaInit();
+    err = NinjaFinalize(papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaFinalize: err = %d\n", err);
+    }
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed;
+}
@@ -0,0 +1,224 @@
+/******************************************************************************
+ *
+ * Project:  WindNinja
+ * Purpose:  C API testing of two armies run at the same time from two threads
+ *
+ * gcc -g -Wall -o test_capi_concurrent_armies test_capi_concurrent_armies.c -lninja -lpthread
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY,
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+#include "windninja.h"
+#include <stdio.h> //for printf, FILE, fopen, fclose
+#include <stdbool.h>
+#include <math.h>
+#include <pthread.h>
+
+#define MAX_PATH_LEN 512
+#define NUM_ARMIES 2
+#define NUM_NINJAS 2 //ninjas in each army - must be equal to array sizes
+
+/*
+ * Each thread makes, runs and keeps its own army.  Both armies use the same
+ * inputs, so their output grids must match if the armies did not interfere.
+ */
+typedef struct
+{
+    const char * demFile;
+    int nCPUs;
+    NinjaArmyH * ninjaArmy;
+    int failed;
+} armyJob;
+
+static void * runArmy(void * arg)
+{
+    armyJob * job = (armyJob *)arg;
+    char ** papszOptions = NULL;
+    NinjaErr err = 0;
+
+    const char * initializationMethod = "domain_average";
+    const char * meshChoice = "coarse";
+    const char * vegetation = "grass";
+    const double height = 10.0;
+    const char * heightUnits = "m";
+    bool momentumFlag = 0; //we're using the conservation of mass solver
+    bool matchedPoints = true;
+    const double speedList[] = {5.5, 5.5};
+    const char * speedUnits = "mps";
+    const double directionList[] = {220.0, 300.0};
+
+    job->failed = 0;
+    job->ninjaArmy = NinjaInitializeArmy();
+    if( NULL == job->ninjaArmy )
+    {
+        printf("NinjaInitializeArmy: ninjaArmy = NULL\n");
+        job->failed = 1;
+        return NULL;
+    }
+
+    err = NinjaMakeDomainAverageArmy(job->ninjaArmy, NUM_NINJAS, momentumFlag, speedList, speedUnits, directionList, papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaMakeDomainAverageArmy: err = %d\n", err);
+        job->failed = 1;
+        return NULL;
+    }
+
+    for(unsigned int i=0; i<NUM_NINJAS; i++)
+    {
+        err = NinjaSetNumberCPUs(job->ninjaArmy, i, job->nCPUs, papszOptions);
+        err |= NinjaSetInitializationMethod(job->ninjaArmy, i, initializationMethod, matchedPoints, papszOptions);
+        err |= NinjaSetDem(job->ninjaArmy, i, job->demFile, papszOptions);
+        err |= NinjaSetPosition(job->ninjaArmy, i, papszOptions);
+        err |= NinjaSetInputWindHeight(job->ninjaArmy, i, height, heightUnits, papszOptions);
+        err |= NinjaSetOutputWindHeight(job->ninjaArmy, i, height, heightUnits, papszOptions);
+        err |= NinjaSetOutputSpeedUnits(job->ninjaArmy, i, speedUnits, papszOptions);
+        err |= NinjaSetDiurnalWinds(job->ninjaArmy, i, 0, papszOptions);
+        err |= NinjaSetUniVegetation(job->ninjaArmy, i, vegetation, papszOptions);
+        err |= NinjaSetMeshResolutionChoice(job->ninjaArmy, i, meshChoice, papszOptions);
+        if(err != NINJA_SUCCESS)
+        {
+            printf("setting up ninja %d: err = %d\n", i, err);
+            job->failed = 1;
+            return NULL;
+        }
+    }
+
+    err = NinjaStartRuns(job->ninjaArmy, job->nCPUs, papszOptions);
+    if(err != 1) //NinjaStartRuns returns 1 on success
+    {
+        printf("NinjaStartRuns: err = %d\n", err);
+        job->failed = 1;
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    const int nCPUs = 2; //per army
+    char ** papszOptions = NULL;
+    NinjaErr err = 0;
+    int failed = 0;
+    err = NinjaInit("C-API autotest", papszOptions); //initialize global singletons and environments (GDAL_DATA, etc.)
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaInit: err = %d\n", err);
+    }
+
+    // manually set your wnDataPath (makes it easier for setting paths and testing)
+    // must replace the "~/" part with your exact path
+    const char* wnDataPath = "~/src/wind/windninja/data";
+
+    char demFile[MAX_PATH_LEN];
+    snprintf(demFile, sizeof(demFile), "%s%s", wnDataPath, "/../autotest/api/data/missoula_valley.tif");
+
+    /*
+     * Run the armies at the same time
+     */
+    armyJob jobs[NUM_ARMIES];
+    pthread_t threads[NUM_ARMIES];
+    for(int a=0; a<NUM_ARMIES; a++)
+    {
+        jobs[a].demFile = demFile;
+        jobs[a].nCPUs = nCPUs;
+        jobs[a].ninjaArmy = NULL;
+        jobs[a].failed = 0;
+        if(pthread_create(&threads[a], NULL, runArmy, &jobs[a]) != 0)
+        {
+            printf("pthread_create failed for army %d\n", a);
+            return 1;
+        }
+    }
+    for(int a=0; a<NUM_ARMIES; a++)
+    {
+        pthread_join(threads[a], NULL);
+        if(jobs[a].failed)
+        {
+            printf("army %d failed\n", a);
+            failed = 1;
+        }
+    }
+
+    /*
+     * Compare the output grids of the armies, only the first ninja of an
+     * army is kept after NinjaStartRuns
+     */
+    if(!failed)
+    {
+        for(int i=0; i<1; i++)
+        {
+            const int nCols = NinjaGetOutputGridnCols(jobs[0].ninjaArmy, i, papszOptions);
+            const int nRows = NinjaGetOutputGridnRows(jobs[0].ninjaArmy, i, papszOptions);
+            if(nCols != NinjaGetOutputGridnCols(jobs[1].ninjaArmy, i, papszOptions) ||
+               nRows != NinjaGetOutputGridnRows(jobs[1].ninjaArmy, i, papszOptions))
+            {
+                printf("ninja %d: output grid sizes differ between the armies\n", i);
+                failed = 1;
+                continue;
+            }
+            const double * speed0 = NinjaGetOutputSpeedGrid(jobs[0].ninjaArmy, i, papszOptions);
+            const double * speed1 = NinjaGetOutputSpeedGrid(jobs[1].ninjaArmy, i, papszOptions);
+            const double * dir0 = NinjaGetOutputDirectionGrid(jobs[0].ninjaArmy, i, papszOptions);
+            const double * dir1 = NinjaGetOutputDirectionGrid(jobs[1].ninjaArmy, i, papszOptions);
+            double maxDiff = 0.0;
+            for(int k=0; k<nCols*nRows; k++)
+            {
+                double dDir = fabs(dir0[k] - dir1[k]);
+                if(dDir > 180.0)
+                {
+                    dDir = 360.0 - dDir;
+                }
+                maxDiff = fmax(maxDiff, fabs(speed0[k] - speed1[k]));
+                maxDiff = fmax(maxDiff, dDir);
+            }
+            printf("ninja %d: max difference between the armies = %g\n", i, maxDiff);
+            if(maxDiff > 1e-3)
+            {
+                failed = 1;
+            }
+        }
+    }
+
+    /*
+     * Clean up
+     */
+    for(int a=0; a<NUM_ARMIES; a++)
+    {
+        if(jobs[a].ninjaArmy != NULL)
+        {
+            err = NinjaDestroyArmy(jobs[a].ninjaArmy, papszOptions);
+            if(err != NINJA_SUCCESS)
+            {
+                printf("NinjaDestroyArmy: err = %d\n", err);
+            }
+        }
+    }
+
+    // must be called to cleanup ninjaInit();
+    err = NinjaFinalize(papszOptions);
+    if(err != NINJA_SUCCESS)
+    {
+        printf("NinjaFinalize: err = %d\n", err);
+    }
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed;
+}
@@ -0,0 +1,224 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the CG deflation space
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include <vector>
+#include <cmath>
+
+#include "deflationSpace.h"
+#include "ninjaBlas.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "DEFLATION_SPACE" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       deflation_space/build
+*       deflation_space/deflated_cg
+******************************************************************************/
+
+/*
+** 1D Laplacian with a small shift, an SPD matrix with a known spectrum
+** (2 - 2cos(j pi/(n+1)) + shift) and many small eigenvalues, so plain CG
+** converges slowly and deflation pays off.
+*/
+static const double shift = 1e-4;
+
+static void laplacian( int n, const double *x, double *y )
+{
+    for( int i = 0; i < n; i++ )
+    {
+        double v = ( 2.0 + shift ) * x[i];
+        if( i > 0 )
+            v -= x[i-1];
+        if( i < n - 1 )
+            v -= x[i+1];
+        y[i] = v;
+    }
+}
+
+static double laplacianEigenvalue( int n, int j )
+{
+    return 2.0 - 2.0 * std::cos( j * M_PI / ( n + 1 ) ) + shift;
+}
+
+/*
+** Solve the tridiagonal system directly (Thomas algorithm).
+*/
+static std::vector<double> directSolve( int n, const std::vector<double> &b )
+{
+    std::vector<double> c( n ), d( n ), x( n );
+    double m = 2.0 + shift;
+    c[0] = -1.0 / m;
+    d[0] = b[0] / m;
+    for( int i = 1; i < n; i++ )
+    {
+        m = 2.0 + shift + c[i-1];
+        c[i] = -1.0 / m;
+        d[i] = ( b[i] + d[i-1] ) / m;
+    }
+    x[n-1] = d[n-1];
+    for( int i = n - 2; i >= 0; i-- )
+        x[i] = d[i] - c[i] * x[i+1];
+    return x;
+}
+
+/*
+** CG as done by ninja::solve() with deflation (no preconditioner), updating
+** the space after the solve.  Returns the iteration count.
+*/
+static int deflatedCG( DeflationSpace &space, int n, const std::vector<double> &b,
+                       std::vector<double> &x )
+{
+    std::vector<double> r( b ), z( n ), p( n ), q( n ), W, AW, U, AU;
+    DeflationProjector projector;
+    x.assign( n, 0.0 );
+
+    int k = space.getVectors( n, W );
+    if( k > 0 )
+    {
+        AW.resize( W.size() );
+        for( int c = 0; c < k; c++ )
+            laplacian( n, &W[c*n], &AW[c*n] );
+        BOOST_REQUIRE( projector.initialize( n, k, &W[0], &AW[0] ) );
+        projector.correctInitialGuess( &x[0], &r[0] );
+    }
+
+    RitzCollector collector( n, space.getMaxVectors(), space.getWindowSize() );
+    double normb = ninjaBlas::dnrm2( n, &b[0] );
+    double rho, rho_1 = 0.0, alpha, beta = 0.0;
+    int it;
+    for( it = 1; it < 10 * n; it++ )
+    {
+        z = r;
+        rho = ninjaBlas::ddot( n, &z[0], &r[0] );
+        if( it == 1 )
+            p = z;
+        else
+        {
+            beta = rho / rho_1;
+            ninjaBlas::dxpay( n, &z[0], beta, &p[0] );
+        }
+        if( projector.size() > 0 )
+            projector.deflateDirection( &z[0], &p[0] );
+        laplacian( n, &p[0], &q[0] );
+        alpha = rho / ninjaBlas::ddot( n, &p[0], &q[0] );
+        collector.add( &z[0], rho, alpha, beta );
+        if( ninjaBlas::dcgUpdate( n, alpha, &p[0], &q[0], &x[0], &r[0] ) / normb < 1e-10 )
+            break;
+        rho_1 = rho;
+    }
+
+    int m = collector.finish( U );
+    AU.resize( U.size() );
+    for( int c = 0; c < m; c++ )
+        laplacian( n, &U[c*n], &AU[c*n] );
+    space.update( n, projector.size(), W.empty() ? NULL : &W[0], AW.empty() ? NULL : &AW[0],
+                  m, m > 0 ? &U[0] : NULL, m > 0 ? &AU[0] : NULL );
+    return it;
+}
+
+static std::vector<double> rightHandSide( int n, int seed )
+{
+    std::vector<double> b( n );
+    for( int i = 0; i < n; i++ )
+        b[i] = std::sin( 0.7 * ( i + 1 ) * ( seed + 1 ) ) + 0.3 * std::cos( 0.11 * i * seed );
+    return b;
+}
+
+BOOST_AUTO_TEST_SUITE( deflation_space )
+
+/**
+* Test that a space built from a CG solve holds unit vectors close to the
+* eigenvectors of the smallest eigenvalues, and that it is only handed out
+* for vectors of its own length.
+*/
+BOOST_AUTO_TEST_CASE( build )
+{
+    int n = 200;
+    DeflationSpace space( 4, 16 );
+    std::vector<double> x, W;
+
+    BOOST_CHECK_EQUAL( space.getVectors( n, W ), 0 );
+    deflatedCG( space, n, rightHandSide( n, 1 ), x );
+
+    int k = space.getVectors( n, W );
+    BOOST_REQUIRE_EQUAL( k, space.getMaxVectors() );
+    BOOST_REQUIRE_EQUAL( (int)W.size(), n * k );
+
+    std::vector<double> Aw( n );
+    for( int c = 0; c < k; c++ )
+    {
+        BOOST_CHECK_CLOSE( ninjaBlas::dnrm2( n, &W[c*n] ), 1.0, 1e-6 );
+        //Rayleigh quotient, among the smallest eigenvalues
+        laplacian( n, &W[c*n], &Aw[0] );
+        double lambda = ninjaBlas::ddot( n, &W[c*n], &Aw[0] );
+        BOOST_CHECK_LT( lambda, laplacianEigenvalue( n, 2 * k ) );
+        BOOST_CHECK_GE( lambda, laplacianEigenvalue( n, 1 ) * ( 1.0 - 1e-6 ) );
+    }
+
+    BOOST_CHECK_EQUAL( space.getVectors( n + 1, W ), 0 );
+    space.clear();
+    BOOST_CHECK_EQUAL( space.getVectors( n, W ), 0 );
+}
+
+/**
+* Test that solves deflated with a recycled space give the same solution as
+* a direct solve in fewer iterations than the first, undeflated solve.
+*/
+BOOST_AUTO_TEST_CASE( deflated_cg )
+{
+    int n = 200;
+    DeflationSpace space( 8, 24 );
+    std::vector<double> x;
+
+    int firstIterations = 0;
+    for( int s = 0; s < 4; s++ )
+    {
+        std::vector<double> b = rightHandSide( n, s );
+        int iterations = deflatedCG( space, n, b, x );
+        if( s == 0 )
+            firstIterations = iterations;
+        else
+            BOOST_CHECK_LT( iterations, firstIterations * 0.8 );
+
+        std::vector<double> exact = directSolve( n, b );
+        double err = 0.0, norm = 0.0;
+        for( int i = 0; i < n; i++ )
+        {
+            err += ( x[i] - exact[i] ) * ( x[i] - exact[i] );
+            norm += exact[i] * exact[i];
+        }
+        BOOST_CHECK_SMALL( std::sqrt( err / norm ), 1e-6 );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
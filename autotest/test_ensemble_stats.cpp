@@ -0,0 +1,214 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the ensemble statistics of army output grids
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "ensembleStats.h"
+#include "ninja_conv.h"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "ENSEMBLE_STATS" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       ensemble_stats/few_runs
+*       ensemble_stats/quantiles
+*       ensemble_stats/mismatch
+******************************************************************************/
+
+struct EnsembleDir
+{
+    EnsembleDir()
+    {
+        GDALAllRegister();
+        pszEnsembleDir = CPLStrdup( CPLGenerateTempFilename( "NINJA_ENSEMBLE" ) );
+        VSIMkdir( pszEnsembleDir, 0777 );
+        prefix = CPLFormFilename( pszEnsembleDir, "test", NULL );
+    }
+    ~EnsembleDir()
+    {
+        NinjaUnlinkTree( pszEnsembleDir );
+        CPLFree( pszEnsembleDir );
+    }
+    AsciiGrid<double> readStat( const char *pszName )
+    {
+        AsciiGrid<double> grid;
+        grid.GDALReadGrid( prefix + "_ensemble_" + pszName + ".asc" );
+        return grid;
+    }
+    char *pszEnsembleDir;
+    std::string prefix;
+};
+
+/*
+** Speed of run r in cell c of a 2x2 grid: 1000 distinct values spread over
+** [5, 25), uniformly in two cells and skewed toward 5 in the others, in an
+** order that is neither sorted nor the same for every cell.
+*/
+static const int nCells = 4;
+
+static double runSpeed( int r, int c, int nRuns )
+{
+    double v = ( ( r * 617 + c * 131 ) % nRuns ) / (double)nRuns;
+    return c % 2 ? 5.0 + 20.0 * v : 5.0 + 20.0 * v * v;
+}
+
+/*
+** Quantile of sorted values, interpolated between ranks like
+** EnsembleStats does for five runs or less.
+*/
+static double exactQuantile( const std::vector<double> &sorted, double p )
+{
+    double rank = p * ( sorted.size() - 1 );
+    int i = (int)rank;
+    if( i >= (int)sorted.size() - 1 )
+        return sorted.back();
+    return sorted[i] + ( rank - i ) * ( sorted[i+1] - sorted[i] );
+}
+
+static void addRuns( EnsembleStats &stats, int nRuns, const std::string &prefix )
+{
+    for( int r = 0; r < nRuns; r++ )
+    {
+        AsciiGrid<double> speed( 2, 2, 0.0, 0.0, 100.0, -9999.0, 0.0 );
+        AsciiGrid<double> direction( 2, 2, 0.0, 0.0, 100.0, -9999.0, r % 2 ? 350.0 : 10.0 );
+        for( int c = 0; c < nCells; c++ )
+            speed( c / 2, c % 2 ) = runSpeed( r, c, nRuns );
+        stats.add( speed, direction, prefix );
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE( ensemble_stats, EnsembleDir )
+
+/**
+* Test that up to five runs give the exact mean, standard deviation, maximum,
+* percentiles and circular mean direction.
+*/
+BOOST_AUTO_TEST_CASE( few_runs )
+{
+    const int nRuns = 5;
+    std::vector<double> percentiles;
+    percentiles.push_back( 10.0 );
+    percentiles.push_back( 50.0 );
+    percentiles.push_back( 90.0 );
+    EnsembleStats stats( percentiles );
+    addRuns( stats, nRuns, prefix );
+    BOOST_CHECK_EQUAL( stats.getNumRuns(), nRuns );
+    BOOST_CHECK_EQUAL( stats.write().size(), 7u );
+
+    AsciiGrid<double> mean = readStat( "mean_vel" );
+    AsciiGrid<double> stdDev = readStat( "std_vel" );
+    AsciiGrid<double> maximum = readStat( "max_vel" );
+    AsciiGrid<double> p10 = readStat( "p10_vel" );
+    AsciiGrid<double> p50 = readStat( "p50_vel" );
+    AsciiGrid<double> p90 = readStat( "p90_vel" );
+    AsciiGrid<double> direction = readStat( "mean_ang" );
+    for( int c = 0; c < nCells; c++ )
+    {
+        std::vector<double> values;
+        double sum = 0.0, sum2 = 0.0;
+        for( int r = 0; r < nRuns; r++ )
+        {
+            values.push_back( runSpeed( r, c, nRuns ) );
+            sum += values.back();
+        }
+        double m = sum / nRuns;
+        for( int r = 0; r < nRuns; r++ )
+            sum2 += ( values[r] - m ) * ( values[r] - m );
+        std::sort( values.begin(), values.end() );
+
+        int i = c / 2, j = c % 2;
+        BOOST_CHECK_SMALL( mean( i, j ) - m, 0.006 );
+        BOOST_CHECK_SMALL( stdDev( i, j ) - sqrt( sum2 / ( nRuns - 1 ) ), 0.006 );
+        BOOST_CHECK_SMALL( maximum( i, j ) - values.back(), 0.006 );
+        BOOST_CHECK_SMALL( p10( i, j ) - exactQuantile( values, 0.1 ), 0.006 );
+        BOOST_CHECK_SMALL( p50( i, j ) - exactQuantile( values, 0.5 ), 0.006 );
+        BOOST_CHECK_SMALL( p90( i, j ) - exactQuantile( values, 0.9 ), 0.006 );
+        //three runs at 10 degrees and two at 350
+        double d = direction( i, j );
+        BOOST_CHECK( d >= 2.0 && d <= 3.0 );
+    }
+}
+
+/**
+* Test the P-square estimates of 1000 runs against the exact quantiles of
+* the same speeds, to within 1% of their range.
+*/
+BOOST_AUTO_TEST_CASE( quantiles )
+{
+    const int nRuns = 1000;
+    std::vector<double> percentiles;
+    percentiles.push_back( 10.0 );
+    percentiles.push_back( 50.0 );
+    percentiles.push_back( 90.0 );
+    EnsembleStats stats( percentiles );
+    addRuns( stats, nRuns, prefix );
+    stats.write();
+
+    AsciiGrid<double> p10 = readStat( "p10_vel" );
+    AsciiGrid<double> p50 = readStat( "p50_vel" );
+    AsciiGrid<double> p90 = readStat( "p90_vel" );
+    AsciiGrid<double> maximum = readStat( "max_vel" );
+    for( int c = 0; c < nCells; c++ )
+    {
+        std::vector<double> values;
+        for( int r = 0; r < nRuns; r++ )
+            values.push_back( runSpeed( r, c, nRuns ) );
+        std::sort( values.begin(), values.end() );
+
+        int i = c / 2, j = c % 2;
+        BOOST_CHECK_SMALL( p10( i, j ) - exactQuantile( values, 0.1 ), 0.2 );
+        BOOST_CHECK_SMALL( p50( i, j ) - exactQuantile( values, 0.5 ), 0.2 );
+        BOOST_CHECK_SMALL( p90( i, j ) - exactQuantile( values, 0.9 ), 0.2 );
+        BOOST_CHECK_SMALL( maximum( i, j ) - values.back(), 0.006 );
+    }
+}
+
+/**
+* Test that a run with another output grid is refused.
+*/
+BOOST_AUTO_TEST_CASE( mismatch )
+{
+    std::vector<double> percentiles( 1, 50.0 );
+    EnsembleStats stats( percentiles );
+    addRuns( stats, 2, prefix );
+
+    AsciiGrid<double> speed( 3, 2, 0.0, 0.0, 100.0, -9999.0, 1.0 );
+    AsciiGrid<double> direction( 3, 2, 0.0, 0.0, 100.0, -9999.0, 0.0 );
+    BOOST_CHECK_THROW( stats.add( speed, direction, prefix ), std::runtime_error );
+    BOOST_CHECK_EQUAL( stats.getNumRuns(), 2 );
+
+    std::vector<double> badPercentiles( 1, 100.0 );
+    BOOST_CHECK_THROW( EnsembleStats badStats( badPercentiles ), std::range_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,6 +30,7 @@
 #include <string>
 
 #include "ascii_grid.h"
+#include "gridRemapPlan.h"
 #include "ninja_conv.h"
 #include "omp_guard.h"
 
@@ -40,6 +41,8 @@
 *******************************************************************************
 *   Tests:
 *       grid_interp/order
+*       grid_interp/points
+*       grid_interp/remap
 ******************************************************************************/
 
 BOOST_AUTO_TEST_SUITE( grid_interp )
@@ -62,6 +65,86 @@ BOOST_AUTO_TEST_CASE( order )
     
 }
 
+/**
+* Test inverse distance weighting from points against a brute force sum over
+* every point, for finite and infinite influence radii
+*/
+BOOST_AUTO_TEST_CASE( points )
+{
+    const int numPoints = 50;
+    double X[numPoints], Y[numPoints], radius[numPoints];
+    double a[numPoints], b[numPoints];
+    srand(42);
+    for(int k = 0; k < numPoints; k++)
+    {
+        X[k] = -500.0 + 11000.0 * rand() / RAND_MAX;
+        Y[k] = -500.0 + 8000.0 * rand() / RAND_MAX;
+        radius[k] = (k % 5 == 0) ? -1.0 : 500.0 + 2000.0 * rand() / RAND_MAX;
+        a[k] = 10.0 * rand() / RAND_MAX;
+        b[k] = -5.0 + 10.0 * rand() / RAND_MAX;
+    }
+
+    double powers[3] = {1.0, 2.0, 2.5};
+    for(int p = 0; p < 3; p++)
+    {
+        AsciiGrid<double> A(97, 71, 0.0, 0.0, 100.0, -9999.0);
+        AsciiGrid<double> B(A);
+        AsciiGrid<double> *grids[2] = {&A, &B};
+        double *data[2] = {a, b};
+        AsciiGrid<double>::interpolateFromPoints(grids, data, 2, X, Y, radius,
+                                                 numPoints, powers[p]);
+
+        for(int i = 0; i < A.get_nRows(); i++)
+        {
+            for(int j = 0; j < A.get_nCols(); j++)
+            {
+                double xC, yC, w, wSum = 0, aSum = 0, bSum = 0;
+                A.get_cellPosition(i, j, &xC, &yC);
+                for(int k = 0; k < numPoints; k++)
+                {
+                    double d = std::sqrt((xC-X[k])*(xC-X[k]) + (yC-Y[k])*(yC-Y[k]));
+                    if(radius[k] >= 0.0 && d > radius[k])
+                        continue;
+                    w = 1.0 / std::pow(d, powers[p]);
+                    wSum += w;
+                    aSum += a[k] * w;
+                    bSum += b[k] * w;
+                }
+                BOOST_CHECK_CLOSE(A(i, j), aSum / wSum, 1e-6);
+                BOOST_CHECK_CLOSE(B(i, j), bSum / wSum, 1e-6);
+            }
+        }
+    }
+}
+
+/**
+* Test that a remap plan gives the same values as interpolateFromGrid(),
+* including no data values and the cells along the edge of the source
+*/
+BOOST_AUTO_TEST_CASE( remap )
+{
+    AsciiGrid<double> source(23, 17, 1000.0, 2000.0, 450.0, -9999.0);
+    for(int i = 0; i < source.get_nRows(); i++)
+        for(int j = 0; j < source.get_nCols(); j++)
+            source(i, j) = std::sin(0.3 * i) + std::cos(0.2 * j) + i * j;
+    source(5, 7) = -9999.0;
+
+    AsciiGrid<double> target(101, 75, 1000.0, 2000.0, 100.0, -1.0);
+    AsciiGrid<double> expected(target);
+    expected.interpolateFromGrid(source, AsciiGrid<double>::order1);
+
+    GridRemapPlan plan(source, target);
+    BOOST_REQUIRE(plan.matches(source, target));
+    plan.apply(source, target);
+
+    BOOST_CHECK_EQUAL(target.get_noDataValue(), expected.get_noDataValue());
+    for(int i = 0; i < target.get_nRows(); i++)
+        for(int j = 0; j < target.get_nCols(); j++)
+            BOOST_CHECK_EQUAL(target(i, j), expected(i, j));
+
+    AsciiGrid<double> other(101, 75, 1100.0, 2000.0, 100.0, -1.0);
+    BOOST_CHECK(!plan.matches(source, other));
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 /******************************************************************************
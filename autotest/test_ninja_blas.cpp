@@ -0,0 +1,203 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the fused BLAS kernels
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include <vector>
+#include <cmath>
+
+#include "ninjaBlas.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "NINJA_BLAS" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       ninja_blas/blas
+*       ninja_blas/fused
+******************************************************************************/
+
+/*
+** Vector lengths tested: empty, shorter than a vector register, odd lengths
+** with remainders, and odd lengths split between threads.
+*/
+static const int nLengths = 7;
+static const int lengths[nLengths] = { 0, 1, 3, 7, 1001, 2 * NINJA_BLAS_PARALLEL_MIN + 3,
+                                       4 * NINJA_BLAS_PARALLEL_MIN + 17 };
+
+static std::vector<double> testVector( int n, int seed )
+{
+    std::vector<double> x( n + 1 ); //one past the end, to use &x[0] when n is 0
+    for( int i = 0; i < n + 1; i++ )
+        x[i] = std::sin( 0.37 * ( i + 1 ) * ( seed + 1 ) ) + 0.1 * seed;
+    return x;
+}
+
+static void checkVectors( int n, const std::vector<double> &x, const std::vector<double> &y )
+{
+    for( int i = 0; i < n; i++ )
+        BOOST_REQUIRE_SMALL( x[i] - y[i], 1e-12 );
+    //the kernels must not write past the end
+    BOOST_CHECK_EQUAL( x[n], y[n] );
+}
+
+static void checkValues( double a, double b )
+{
+    BOOST_CHECK_SMALL( a - b, 1e-9 * ( 1.0 + std::fabs( b ) ) );
+}
+
+BOOST_AUTO_TEST_SUITE( ninja_blas )
+
+/**
+* Test the BLAS equivalents against plain loops.
+*/
+BOOST_AUTO_TEST_CASE( blas )
+{
+    for( int l = 0; l < nLengths; l++ )
+    {
+        int n = lengths[l];
+        std::vector<double> x = testVector( n, 1 );
+        std::vector<double> y = testVector( n, 2 );
+        std::vector<double> ref = y;
+
+        ninjaBlas::dcopy( n, &x[0], &y[0] );
+        for( int i = 0; i < n; i++ )
+            ref[i] = x[i];
+        checkVectors( n, y, ref );
+
+        ninjaBlas::dscal( n, -0.5, &y[0] );
+        for( int i = 0; i < n; i++ )
+            ref[i] *= -0.5;
+        checkVectors( n, y, ref );
+
+        ninjaBlas::daxpy( n, 1.5, &x[0], &y[0] );
+        for( int i = 0; i < n; i++ )
+            ref[i] += 1.5 * x[i];
+        checkVectors( n, y, ref );
+
+        double dot = 0.0;
+        for( int i = 0; i < n; i++ )
+            dot += x[i] * y[i];
+        checkValues( ninjaBlas::ddot( n, &x[0], &y[0] ), dot );
+
+        double nrm = 0.0;
+        for( int i = 0; i < n; i++ )
+            nrm += x[i] * x[i];
+        checkValues( ninjaBlas::dnrm2( n, &x[0] ), std::sqrt( nrm ) );
+    }
+}
+
+/**
+* Test each fused kernel against the BLAS calls it replaces.
+*/
+BOOST_AUTO_TEST_CASE( fused )
+{
+    for( int l = 0; l < nLengths; l++ )
+    {
+        int n = lengths[l];
+        std::vector<double> x = testVector( n, 1 );
+        std::vector<double> q = testVector( n, 2 );
+        std::vector<double> u = testVector( n, 3 );
+        std::vector<double> uold = testVector( n, 4 );
+        std::vector<double> vold = testVector( n, 5 );
+        std::vector<double> y, ref;
+
+        //Y = alpha*X
+        y = testVector( n, 6 );
+        ref = y;
+        ninjaBlas::dscalCopy( n, 2.5, &x[0], &y[0] );
+        ninjaBlas::dcopy( n, &x[0], &ref[0] );
+        ninjaBlas::dscal( n, 2.5, &ref[0] );
+        checkVectors( n, y, ref );
+
+        //Y = X + beta*Y
+        y = testVector( n, 6 );
+        ref = y;
+        ninjaBlas::dxpay( n, &x[0], 0.75, &y[0] );
+        ninjaBlas::dscal( n, 0.75, &ref[0] );
+        ninjaBlas::daxpy( n, 1.0, &x[0], &ref[0] );
+        checkVectors( n, y, ref );
+
+        //Y = Y + alpha*X, return ||Y||
+        y = testVector( n, 6 );
+        ref = y;
+        double nrm = ninjaBlas::daxpyNrm2( n, -1.25, &x[0], &y[0] );
+        ninjaBlas::daxpy( n, -1.25, &x[0], &ref[0] );
+        checkVectors( n, y, ref );
+        checkValues( nrm, ninjaBlas::dnrm2( n, &ref[0] ) );
+
+        //X = X + alpha*P, R = R - alpha*Q, return ||R||
+        std::vector<double> p = testVector( n, 7 );
+        std::vector<double> xs = testVector( n, 8 );
+        std::vector<double> xsRef = xs;
+        y = testVector( n, 6 );
+        ref = y;
+        nrm = ninjaBlas::dcgUpdate( n, 0.3, &p[0], &q[0], &xs[0], &y[0] );
+        ninjaBlas::daxpy( n, 0.3, &p[0], &xsRef[0] );
+        ninjaBlas::daxpy( n, -0.3, &q[0], &ref[0] );
+        checkVectors( n, xs, xsRef );
+        checkVectors( n, y, ref );
+        checkValues( nrm, ninjaBlas::dnrm2( n, &ref[0] ) );
+
+        //R = R - alpha*V - beta*VOLD, Z = Z - alpha*U - beta*UOLD, return R.Z
+        std::vector<double> z = testVector( n, 9 );
+        std::vector<double> zRef = z;
+        y = testVector( n, 6 );
+        ref = y;
+        double dot = ninjaBlas::dlanczosUpdate( n, 0.4, -0.2, &x[0], &vold[0], &y[0],
+                                                &u[0], &uold[0], &z[0] );
+        ninjaBlas::daxpy( n, -0.4, &x[0], &ref[0] );
+        ninjaBlas::daxpy( n, 0.2, &vold[0], &ref[0] );
+        ninjaBlas::daxpy( n, -0.4, &u[0], &zRef[0] );
+        ninjaBlas::daxpy( n, 0.2, &uold[0], &zRef[0] );
+        checkVectors( n, y, ref );
+        checkVectors( n, z, zRef );
+        checkValues( dot, ninjaBlas::ddot( n, &ref[0], &zRef[0] ) );
+
+        //W = (U - rho2*WOLD - rho3*WOOLD)/rho1, X = X + ceta*W
+        std::vector<double> w = testVector( n, 10 );
+        std::vector<double> wRef( n + 1 );
+        wRef[n] = w[n];
+        xs = testVector( n, 8 );
+        xsRef = xs;
+        double rho1 = 1.7, rho2 = 0.6, rho3 = -0.9, ceta = 0.45;
+        ninjaBlas::dminresUpdate( n, 1.0 / rho1, rho2, rho3, &u[0], &uold[0], &vold[0],
+                                  &w[0], ceta, &xs[0] );
+        ninjaBlas::dcopy( n, &u[0], &wRef[0] );
+        ninjaBlas::daxpy( n, -rho2, &uold[0], &wRef[0] );
+        ninjaBlas::daxpy( n, -rho3, &vold[0], &wRef[0] );
+        ninjaBlas::dscal( n, 1.0 / rho1, &wRef[0] );
+        ninjaBlas::daxpy( n, ceta, &wRef[0], &xsRef[0] );
+        checkVectors( n, w, wRef );
+        checkVectors( n, xs, xsRef );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the background output writers
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "ninja.h"
+#include "outputQueue.h"
+#include "ninja_conv.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "OUTPUT_QUEUE" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       output_queue/swap
+*       output_queue/write
+******************************************************************************/
+
+struct OutputDir
+{
+    OutputDir()
+    {
+        GDALAllRegister();
+        pszOutputDir = CPLStrdup( CPLGenerateTempFilename( "NINJA_OUTPUT_QUEUE" ) );
+        VSIMkdir( pszOutputDir, 0777 );
+    }
+    ~OutputDir()
+    {
+        NinjaUnlinkTree( pszOutputDir );
+        CPLFree( pszOutputDir );
+    }
+    char *pszOutputDir;
+};
+
+BOOST_FIXTURE_TEST_SUITE( output_queue, OutputDir )
+
+/**
+* Test that swapping grids exchanges their data and header without copying.
+*/
+BOOST_AUTO_TEST_CASE( swap )
+{
+    AsciiGrid<double> a( 4, 3, 100.0, 200.0, 10.0, -9999.0, 1.0 );
+    AsciiGrid<double> b( 2, 5, 300.0, 400.0, 20.0, -9999.0, 2.0 );
+    const double *aData = &a( 0, 0 );
+
+    a.swap( b );
+
+    BOOST_CHECK_EQUAL( b.get_nCols(), 4 );
+    BOOST_CHECK_EQUAL( b.get_nRows(), 3 );
+    BOOST_CHECK_EQUAL( b.get_xllCorner(), 100.0 );
+    BOOST_CHECK_EQUAL( b.get_yllCorner(), 200.0 );
+    BOOST_CHECK_EQUAL( b.get_cellSize(), 10.0 );
+    BOOST_CHECK_EQUAL( &b( 0, 0 ), aData );
+    BOOST_CHECK_EQUAL( b( 2, 3 ), 1.0 );
+
+    BOOST_CHECK_EQUAL( a.get_nCols(), 2 );
+    BOOST_CHECK_EQUAL( a.get_nRows(), 5 );
+    BOOST_CHECK_EQUAL( a.get_cellSize(), 20.0 );
+    BOOST_CHECK_EQUAL( a( 4, 1 ), 2.0 );
+}
+
+/**
+* Test that a queue shorter than the number of outputs, served by several
+* writers, writes the files of every run with the grids of that run.
+*/
+BOOST_AUTO_TEST_CASE( write )
+{
+    const int nRuns = 6;
+    OutputQueue queue( 2, 1 );
+    BOOST_REQUIRE_EQUAL( queue.getNumWriters(), 2 );
+
+    std::vector<std::string> velFiles( nRuns );
+    for( int r = 0; r < nRuns; r++ )
+    {
+        ninja *writer = new ninja();
+        writer->input.inputsRunNumber = r;
+        writer->input.asciiOutFlag = true;
+        writer->input.asciiAaigridOutFlag = true;
+        writer->input.asciiProjOutFlag = true;
+        writer->input.angResolution = 10.0;
+        writer->input.velResolution = 10.0;
+        writer->input.outputBufferClipping = 1.0;   //no dem grid to buffer to
+        writer->input.angFile = CPLFormFilename( pszOutputDir, CPLSPrintf( "run%d_ang", r ), "asc" );
+        writer->input.velFile = CPLFormFilename( pszOutputDir, CPLSPrintf( "run%d_vel", r ), "asc" );
+        velFiles[r] = writer->input.velFile;
+        writer->AngleGrid = AsciiGrid<double>( 8, 6, 0.0, 0.0, 10.0, -9999.0, 45.0 );
+        writer->VelocityGrid = AsciiGrid<double>( 8, 6, 0.0, 0.0, 10.0, -9999.0, r + 1.0 );
+
+        AsciiGrid<double> demGrid;
+        queue.push( writer, demGrid );
+    }
+    queue.finish();
+
+    BOOST_CHECK_EQUAL( queue.getNumFailed(), 0 );
+    BOOST_CHECK_EQUAL( queue.getNumWriters(), 0 );
+    for( int r = 0; r < nRuns; r++ )
+    {
+        AsciiGrid<double> vel;
+        vel.GDALReadGrid( velFiles[r] );
+        BOOST_REQUIRE_EQUAL( vel.get_nCols(), 8 );
+        BOOST_REQUIRE_EQUAL( vel.get_nRows(), 6 );
+        BOOST_CHECK_CLOSE( vel( 3, 4 ), r + 1.0, 1e-6 );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,221 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Test solver preconditioners
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY,
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include <vector>
+#include <cmath>
+
+#include "preconditioner.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "PRECONDITIONER" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       preconditioner/lanczos_bounds
+*       preconditioner/chebyshev
+******************************************************************************/
+
+/*
+** Build a symmetric tridiagonal test matrix in the upper triangle CSR storage
+** used by ninja::solve() (diagonal first in each row).
+*/
+static void buildTestMatrix( int n, std::vector<double> &a, std::vector<int> &row_ptr,
+                             std::vector<int> &col_ind )
+{
+    row_ptr.resize( n + 1 );
+    for( int i = 0; i < n; i++ )
+    {
+        row_ptr[i] = col_ind.size();
+        col_ind.push_back( i );
+        a.push_back( 2.0 + 0.01 * i );
+        if( i + 1 < n )
+        {
+            col_ind.push_back( i + 1 );
+            a.push_back( -1.0 );
+        }
+    }
+    row_ptr[n] = col_ind.size();
+}
+
+static void symSpMV( int n, const std::vector<double> &a, const std::vector<int> &row_ptr,
+                     const std::vector<int> &col_ind, const std::vector<double> &x,
+                     std::vector<double> &y )
+{
+    for( int i = 0; i < n; i++ )
+        y[i] = 0.0;
+    for( int i = 0; i < n; i++ )
+    {
+        for( int j = row_ptr[i]; j < row_ptr[i+1]; j++ )
+        {
+            y[i] += a[j] * x[col_ind[j]];
+            if( col_ind[j] != i )
+                y[col_ind[j]] += a[j] * x[i];
+        }
+    }
+}
+
+/*
+** Run preconditioned CG the same way ninja::solve() does and return the
+** iteration count.
+*/
+static int runPCG( int precondType, int n, std::vector<double> &a, std::vector<int> &row_ptr,
+                   std::vector<int> &col_ind )
+{
+    char matdescra[6] = { 's', 'u', 'n', 'c', 0, 0 };
+    Preconditioner M;
+    M.initialize( n, &a[0], &row_ptr[0], &col_ind[0], precondType, matdescra );
+
+    std::vector<double> x( n, 0.0 ), r( n, 1.0 ), z( n ), p( n ), q( n );
+    std::vector<double> lanczosAlpha, lanczosBeta;
+    double rho, rho_1 = 0.0, alpha, beta, normb = std::sqrt( (double)n );
+    bool restart = false;
+
+    int it;
+    for( it = 1; it < 10 * n; it++ )
+    {
+        M.solve( &r[0], &z[0], &row_ptr[0], &col_ind[0] );
+        rho = 0.0;
+        for( int i = 0; i < n; i++ )
+            rho += z[i] * r[i];
+        if( it == 1 || restart )
+        {
+            p = z;
+            restart = false;
+        }
+        else
+        {
+            beta = rho / rho_1;
+            if( M.needsSpectralBounds() )
+                lanczosBeta.push_back( beta );
+            for( int i = 0; i < n; i++ )
+                p[i] = z[i] + beta * p[i];
+        }
+        symSpMV( n, a, row_ptr, col_ind, p, q );
+        double pq = 0.0;
+        for( int i = 0; i < n; i++ )
+            pq += p[i] * q[i];
+        alpha = rho / pq;
+        if( M.needsSpectralBounds() )
+        {
+            lanczosAlpha.push_back( alpha );
+            if( lanczosAlpha.size() >= 10 )
+            {
+                double lambdaMin, lambdaMax;
+                BOOST_REQUIRE( Preconditioner::lanczosEigenvalueBounds( lanczosAlpha, lanczosBeta,
+                                                                         lambdaMin, lambdaMax ) );
+                M.setSpectralBounds( lambdaMin, lambdaMax );
+                restart = true;
+            }
+        }
+        double rr = 0.0;
+        for( int i = 0; i < n; i++ )
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+            rr += r[i] * r[i];
+        }
+        if( std::sqrt( rr ) / normb < 1e-8 )
+            break;
+        rho_1 = rho;
+    }
+    return it;
+}
+
+BOOST_AUTO_TEST_SUITE( preconditioner )
+
+/**
+* Test the spectral bounds from the CG coefficients against a matrix with a
+* known spectrum.  For A = diag(1..n), unpreconditioned CG with n iterations
+* reproduces the full spectrum.
+*/
+BOOST_AUTO_TEST_CASE( lanczos_bounds )
+{
+    int n = 8;
+    std::vector<double> a, x( n, 0.0 ), r( n, 1.0 ), p, q( n );
+    std::vector<double> cgAlpha, cgBeta;
+    double rho, rho_1 = 0.0;
+    for( int i = 0; i < n; i++ )
+        a.push_back( i + 1.0 );
+    for( int it = 0; it < n; it++ )
+    {
+        rho = 0.0;
+        for( int i = 0; i < n; i++ )
+            rho += r[i] * r[i];
+        if( it == 0 )
+            p = r;
+        else
+        {
+            cgBeta.push_back( rho / rho_1 );
+            for( int i = 0; i < n; i++ )
+                p[i] = r[i] + cgBeta.back() * p[i];
+        }
+        double pq = 0.0;
+        for( int i = 0; i < n; i++ )
+        {
+            q[i] = a[i] * p[i];
+            pq += p[i] * q[i];
+        }
+        cgAlpha.push_back( rho / pq );
+        for( int i = 0; i < n; i++ )
+        {
+            x[i] += cgAlpha.back() * p[i];
+            r[i] -= cgAlpha.back() * q[i];
+        }
+        rho_1 = rho;
+    }
+    double lambdaMin, lambdaMax;
+    BOOST_REQUIRE( Preconditioner::lanczosEigenvalueBounds( cgAlpha, cgBeta, lambdaMin, lambdaMax ) );
+    BOOST_CHECK_CLOSE( lambdaMin, 1.0, 1e-3 );
+    BOOST_CHECK_CLOSE( lambdaMax, (double)n, 1e-3 );
+}
+
+/**
+* Test that the Chebyshev preconditioner converges and takes fewer iterations
+* than Jacobi.
+*/
+BOOST_AUTO_TEST_CASE( chebyshev )
+{
+    int n = 2000;
+    std::vector<double> a;
+    std::vector<int> row_ptr, col_ind;
+    buildTestMatrix( n, a, row_ptr, col_ind );
+
+    int nJacobi = runPCG( Preconditioner::Jacobi, n, a, row_ptr, col_ind );
+    int nChebyshev = runPCG( Preconditioner::Chebyshev, n, a, row_ptr, col_ind );
+
+    BOOST_CHECK( nChebyshev < 10 * n - 1 );
+    BOOST_CHECK( nChebyshev < nJacobi );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+/******************************************************************************
+*                        END "PRECONDITIONER" BOOST TEST SUITE
+*****************************************************************************/
@@ -0,0 +1,221 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the result cache
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "resultCache.h"
+#include "deflationSpace.h"
+#include "ninja_conv.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "RESULT_CACHE" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       result_cache/hit
+*       result_cache/miss
+*       result_cache/invalidation
+******************************************************************************/
+
+struct CacheDir
+{
+    CacheDir()
+    {
+        pszCacheDir = CPLStrdup( CPLGenerateTempFilename( "NINJA_RESULT_CACHE" ) );
+        VSIMkdir( pszCacheDir, 0777 );
+        dir = pszCacheDir;
+        input.initializationMethod = WindNinjaInputs::domainAverageInitializationFlag;
+        input.inputSpeed = 10.0;
+        input.inputDirection_geog = 270.0;
+        input.inputWindHeight = 6.1;
+        input.outputWindHeight = 6.1;
+        mesh.meshResolution = 120.0;
+        angle = AsciiGrid<double>( 20, 20, 0.0, 0.0, 100.0, -9999.0, 270.0 );
+        velocity = AsciiGrid<double>( 20, 20, 0.0, 0.0, 100.0, -9999.0, 10.0 );
+        velocity( 3, 4 ) = 12.5;
+    }
+    ~CacheDir()
+    {
+        NinjaUnlinkTree( pszCacheDir );
+        CPLFree( pszCacheDir );
+    }
+    std::string Key( const DeflationSpace *deflation = NULL )
+    {
+        return ResultCache::computeKey( input, mesh, deflation );
+    }
+    /* Key with the configuration option pszKey set to pszValue. */
+    std::string KeyWithOption( const char *pszKey, const char *pszValue )
+    {
+        CPLSetConfigOption( pszKey, pszValue );
+        std::string key = Key();
+        CPLSetConfigOption( pszKey, NULL );
+        return key;
+    }
+    char *pszCacheDir;
+    std::string dir;
+    WindNinjaInputs input;
+    Mesh mesh;
+    AsciiGrid<double> angle;
+    AsciiGrid<double> velocity;
+};
+
+BOOST_FIXTURE_TEST_SUITE( result_cache, CacheDir )
+
+/**
+* Test that the same inputs give the same key, and that the stored grids
+* are loaded back under it.
+*/
+BOOST_AUTO_TEST_CASE( hit )
+{
+    std::string key = Key();
+    BOOST_REQUIRE( !key.empty() );
+    BOOST_CHECK_EQUAL( Key(), key );
+    BOOST_CHECK_EQUAL( KeyWithOption( "NINJA_SOLVER_PRECONDITIONER", "ssor" ), key );
+
+    ResultCache cache( dir, 10.0 );
+    AsciiGrid<double> angleOut, velocityOut;
+    double meshResolution;
+    lengthUnits::eLengthUnits units;
+    BOOST_CHECK( !cache.load( key, angleOut, velocityOut, meshResolution, units ) );
+
+    cache.store( key, angle, velocity, 120.0, lengthUnits::meters );
+    BOOST_REQUIRE( cache.load( key, angleOut, velocityOut, meshResolution, units ) );
+    BOOST_CHECK_EQUAL( meshResolution, 120.0 );
+    BOOST_CHECK( units == lengthUnits::meters );
+    BOOST_REQUIRE_EQUAL( velocityOut.get_nCols(), 20 );
+    BOOST_REQUIRE_EQUAL( velocityOut.get_nRows(), 20 );
+    BOOST_CHECK_EQUAL( velocityOut.get_cellSize(), 100.0 );
+    BOOST_CHECK_EQUAL( velocityOut( 3, 4 ), 12.5 );
+    BOOST_CHECK_EQUAL( velocityOut( 4, 3 ), 10.0 );
+    BOOST_CHECK_EQUAL( angleOut( 3, 4 ), 270.0 );
+}
+
+/**
+* Test that the key changes with the settings that change the output grids
+* without being in the grids themselves: the solver configuration options,
+* the deflation space, the diurnal and stability coefficients and the
+* shading settings.
+*/
+BOOST_AUTO_TEST_CASE( miss )
+{
+    std::string key = Key();
+
+    BOOST_CHECK_NE( KeyWithOption( "NINJA_SOLVER_PRECONDITIONER", "JACOBI" ), key );
+    std::string chebyshev = KeyWithOption( "NINJA_SOLVER_PRECONDITIONER", "CHEBYSHEV" );
+    BOOST_CHECK_NE( chebyshev, key );
+    CPLSetConfigOption( "NINJA_SOLVER_PRECONDITIONER", "CHEBYSHEV" );
+    BOOST_CHECK_NE( KeyWithOption( "NINJA_CHEBYSHEV_DEGREE", "6" ), chebyshev );
+    BOOST_CHECK_NE( KeyWithOption( "NINJA_CHEBYSHEV_LANCZOS_ITERS", "20" ), chebyshev );
+    CPLSetConfigOption( "NINJA_SOLVER_PRECONDITIONER", NULL );
+    //the degree is unused without the Chebyshev preconditioner
+    BOOST_CHECK_EQUAL( KeyWithOption( "NINJA_CHEBYSHEV_DEGREE", "6" ), key );
+
+    DeflationSpace deflation( 8, 24 );
+    DeflationSpace moreVectors( 12, 24 );
+    DeflationSpace largerWindow( 8, 32 );
+    std::string deflated = Key( &deflation );
+    BOOST_CHECK_NE( deflated, key );
+    BOOST_CHECK_NE( Key( &moreVectors ), deflated );
+    BOOST_CHECK_NE( Key( &largerWindow ), deflated );
+
+    input.solverSurfaceWindTol = 0.01;
+    std::string surfaceTol = Key();
+    BOOST_CHECK_NE( surfaceTol, key );
+    BOOST_CHECK_NE( KeyWithOption( "NINJA_SOLVER_SURFACE_CHECK_ITERS", "25" ), surfaceTol );
+    input.solverSurfaceWindTol = -1.0;
+    BOOST_CHECK_EQUAL( Key(), key );
+
+    input.upDragCoeff = 0.3;
+    BOOST_CHECK_NE( Key(), key );
+    input.upDragCoeff = 0.2;
+    input.downEntrainmentCoeff = 0.02;
+    BOOST_CHECK_NE( Key(), key );
+    input.downEntrainmentCoeff = 0.01;
+    input.alphaStability = 0.5;
+    BOOST_CHECK_NE( Key(), key );
+    input.alphaStability = -1;
+    BOOST_CHECK_EQUAL( Key(), key );
+
+    input.diurnalWinds = true;
+    std::string diurnal = Key();
+    BOOST_CHECK_NE( diurnal, key );
+    BOOST_CHECK_NE( KeyWithOption( "NINJA_SHADE_HORIZON_MAP", "FALSE" ), diurnal );
+    BOOST_CHECK_NE( KeyWithOption( "NINJA_HORIZON_SECTORS", "64" ), diurnal );
+}
+
+/**
+* Test that a truncated or corrupted entry isn't loaded and is removed, and
+* that the least recently used entries are evicted over the size limit.
+*/
+BOOST_AUTO_TEST_CASE( invalidation )
+{
+    //an entry of two 20x20 grids is a bit over 6 kB, keep two of them
+    ResultCache cache( dir, 14.0 / 1024.0 );
+    AsciiGrid<double> angleOut, velocityOut;
+    double meshResolution;
+    lengthUnits::eLengthUnits units;
+    std::string filename = CPLFormFilename( dir.c_str(), "truncated", "wnrc" );
+
+    cache.store( "truncated", angle, velocity, 120.0, lengthUnits::meters );
+    VSILFILE *fp = VSIFOpenL( filename.c_str(), "r+b" );
+    BOOST_REQUIRE( fp );
+    VSIFTruncateL( fp, 1000 );
+    VSIFCloseL( fp );
+    VSIStatBufL sStat;
+    BOOST_CHECK( !cache.load( "truncated", angleOut, velocityOut, meshResolution, units ) );
+    BOOST_CHECK( VSIStatL( filename.c_str(), &sStat ) != 0 );
+
+    filename = CPLFormFilename( dir.c_str(), "corrupted", "wnrc" );
+    cache.store( "corrupted", angle, velocity, 120.0, lengthUnits::meters );
+    fp = VSIFOpenL( filename.c_str(), "r+b" );
+    BOOST_REQUIRE( fp );
+    int version = 0;
+    VSIFSeekL( fp, sizeof( int ), SEEK_SET );
+    VSIFWriteL( &version, sizeof( int ), 1, fp );
+    VSIFCloseL( fp );
+    BOOST_CHECK( !cache.load( "corrupted", angleOut, velocityOut, meshResolution, units ) );
+    BOOST_CHECK( VSIStatL( filename.c_str(), &sStat ) != 0 );
+
+    cache.store( "first", angle, velocity, 120.0, lengthUnits::meters );
+    cache.store( "second", angle, velocity, 120.0, lengthUnits::meters );
+    cache.store( "third", angle, velocity, 120.0, lengthUnits::meters );
+    int nEntries = 0;
+    char **papszFiles = VSIReadDir( dir.c_str() );
+    for( int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++ )
+    {
+        if( EQUAL( CPLGetExtension( papszFiles[i] ), "wnrc" ) )
+            nEntries++;
+    }
+    CSLDestroy( papszFiles );
+    BOOST_CHECK_EQUAL( nEntries, 2 );
+    BOOST_CHECK( cache.load( "third", angleOut, velocityOut, meshResolution, units ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
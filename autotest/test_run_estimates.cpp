@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for sizing runs before they read their DEM
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "ninja.h"
+#include "ninja_conv.h"
+#include "gdal_priv.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "RUN_ESTIMATES" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       run_estimates/file_dem
+******************************************************************************/
+
+BOOST_AUTO_TEST_SUITE( run_estimates )
+
+/**
+* Test that the DEM size, mesh size and peak memory of a run with a DEM file
+* are estimated from the file header before the DEM is read, and don't
+* change once it is read.
+*/
+BOOST_AUTO_TEST_CASE( file_dem )
+{
+    GDALAllRegister();
+    std::string demFile = FindDataPath( "big_butte_small.tif" );
+
+    GDALDataset *poDS = (GDALDataset*)GDALOpen( demFile.c_str(), GA_ReadOnly );
+    BOOST_REQUIRE( poDS );
+    double adfGeoTransform[6];
+    BOOST_REQUIRE( poDS->GetGeoTransform( adfGeoTransform ) == CE_None );
+    int nXSize = poDS->GetRasterXSize();
+    int nYSize = poDS->GetRasterYSize();
+    GDALClose( (GDALDatasetH)poDS );
+
+    ninja run;
+    run.set_DEM( demFile );
+    run.set_meshResolution( 100.0, lengthUnits::meters );
+    run.set_numVertLayers( 20 );
+
+    int nRows, nCols;
+    double cellSize;
+    BOOST_REQUIRE( run.estimate_demSize( nRows, nCols, cellSize ) );
+    BOOST_CHECK_EQUAL( nRows, nYSize );
+    BOOST_CHECK_EQUAL( nCols, nXSize );
+    BOOST_CHECK_CLOSE( cellSize, fabs( adfGeoTransform[1] ), 1e-9 );
+
+    long nodes = run.estimate_numNodes();
+    long long memory = run.estimate_peakMemory();
+    BOOST_CHECK_EQUAL( nodes, ( std::max( 2L, (long)( nXSize * cellSize / 100.0 + 0.5 ) ) ) *
+                              ( std::max( 2L, (long)( nYSize * cellSize / 100.0 + 0.5 ) ) ) * 20 );
+    BOOST_CHECK_GT( memory, (long long)nodes * 20 * (long long)sizeof( double ) );
+
+    run.readInputFile();
+    BOOST_CHECK_EQUAL( run.estimate_numNodes(), nodes );
+    BOOST_CHECK_EQUAL( run.estimate_peakMemory(), memory );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the journal of finished army runs
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "runJournal.h"
+#include "ninja_conv.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "RUN_JOURNAL" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       run_journal/key
+*       run_journal/record_find
+*       run_journal/changed_files
+*       run_journal/cut_short
+******************************************************************************/
+
+static void WriteFile( const std::string &filename, const char *pszText )
+{
+    VSILFILE *fp = VSIFOpenL( filename.c_str(), "wb" );
+    BOOST_REQUIRE( fp );
+    VSIFWriteL( pszText, 1, strlen( pszText ), fp );
+    VSIFCloseL( fp );
+}
+
+struct JournalDir
+{
+    JournalDir()
+    {
+        pszJournalDir = CPLStrdup( CPLGenerateTempFilename( "NINJA_RUN_JOURNAL" ) );
+        VSIMkdir( pszJournalDir, 0777 );
+        dir = pszJournalDir;
+        files.push_back( CPLFormFilename( pszJournalDir, "run3_vel", "asc" ) );
+        files.push_back( CPLFormFilename( pszJournalDir, "run3_ang", "asc" ) );
+        WriteFile( files[0], "velocity grid" );
+        WriteFile( files[1], "angle grid" );
+    }
+    ~JournalDir()
+    {
+        NinjaUnlinkTree( pszJournalDir );
+        CPLFree( pszJournalDir );
+    }
+    char *pszJournalDir;
+    std::string dir;
+    std::vector<std::string> files;
+};
+
+BOOST_FIXTURE_TEST_SUITE( run_journal, JournalDir )
+
+/**
+* Test that the key of a run follows the inputs key and the output options.
+*/
+BOOST_AUTO_TEST_CASE( key )
+{
+    WindNinjaInputs input;
+    input.asciiOutFlag = true;
+    input.velResolution = 100.0;
+    std::string key = RunJournal::computeKey( "inputs", input );
+
+    BOOST_CHECK_EQUAL( RunJournal::computeKey( "inputs", input ), key );
+    BOOST_CHECK_NE( RunJournal::computeKey( "other inputs", input ), key );
+
+    WindNinjaInputs kmz( input );
+    kmz.googOutFlag = true;
+    BOOST_CHECK_NE( RunJournal::computeKey( "inputs", kmz ), key );
+
+    WindNinjaInputs resolution( input );
+    resolution.velResolution = 50.0;
+    BOOST_CHECK_NE( RunJournal::computeKey( "inputs", resolution ), key );
+}
+
+/**
+* Test that a recorded run is found by the same journal and by a new one
+* reading the file (a restart), only under its own number and key.
+*/
+BOOST_AUTO_TEST_CASE( record_find )
+{
+    double meshResolution = -1.0;
+    lengthUnits::eLengthUnits units = lengthUnits::feet;
+    {
+        RunJournal journal;
+        BOOST_CHECK( !journal.find( dir, 3, "abc", meshResolution, units ) );
+        journal.record( dir, 3, "abc", 120.0, lengthUnits::meters, files );
+        BOOST_CHECK( journal.find( dir, 3, "abc", meshResolution, units ) );
+    }
+
+    RunJournal restarted;
+    BOOST_CHECK( !restarted.find( dir, 3, "abd", meshResolution, units ) );
+    BOOST_CHECK( !restarted.find( dir, 4, "abc", meshResolution, units ) );
+    BOOST_REQUIRE( restarted.find( dir, 3, "abc", meshResolution, units ) );
+    BOOST_CHECK_EQUAL( meshResolution, 120.0 );
+    BOOST_CHECK( units == lengthUnits::meters );
+
+    //a later record replaces the earlier one
+    restarted.record( dir, 3, "xyz", 60.0, lengthUnits::meters, files );
+    RunJournal again;
+    BOOST_CHECK( !again.find( dir, 3, "abc", meshResolution, units ) );
+    BOOST_CHECK( again.find( dir, 3, "xyz", meshResolution, units ) );
+    BOOST_CHECK_EQUAL( meshResolution, 60.0 );
+}
+
+/**
+* Test that a run is done again when one of its files changed or is gone,
+* and isn't recorded when a file is missing.
+*/
+BOOST_AUTO_TEST_CASE( changed_files )
+{
+    double meshResolution;
+    lengthUnits::eLengthUnits units;
+    RunJournal journal;
+    journal.record( dir, 3, "abc", 120.0, lengthUnits::meters, files );
+
+    WriteFile( files[1], "angle grid, longer" );
+    BOOST_CHECK( !journal.find( dir, 3, "abc", meshResolution, units ) );
+
+    WriteFile( files[1], "angle grid" );
+    BOOST_CHECK( journal.find( dir, 3, "abc", meshResolution, units ) );
+
+    VSIUnlink( files[0].c_str() );
+    BOOST_CHECK( !journal.find( dir, 3, "abc", meshResolution, units ) );
+
+    std::vector<std::string> missing( files );
+    missing.push_back( CPLFormFilename( dir.c_str(), "run5_vel", "asc" ) );
+    journal.record( dir, 5, "def", 120.0, lengthUnits::meters, missing );
+    BOOST_CHECK( !journal.find( dir, 5, "def", meshResolution, units ) );
+}
+
+/**
+* Test that a journal whose last line was cut short (a killed army) still
+* gives the runs recorded before it.
+*/
+BOOST_AUTO_TEST_CASE( cut_short )
+{
+    {
+        RunJournal journal;
+        journal.record( dir, 3, "abc", 120.0, lengthUnits::meters, files );
+    }
+    std::string journalFile = CPLFormFilename( dir.c_str(), "windninja_runs.journal", NULL );
+    VSILFILE *fp = VSIFOpenL( journalFile.c_str(), "ab" );
+    BOOST_REQUIRE( fp );
+    const char *pszPartial = "{\"run\":4,\"key\":\"de";
+    VSIFWriteL( pszPartial, 1, strlen( pszPartial ), fp );
+    VSIFCloseL( fp );
+
+    double meshResolution;
+    lengthUnits::eLengthUnits units;
+    RunJournal restarted;
+    BOOST_CHECK( restarted.find( dir, 3, "abc", meshResolution, units ) );
+    BOOST_CHECK( !restarted.find( dir, 4, "de", meshResolution, units ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Unit tests for the shading shared by the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "Shade.h"
+#include "horizonMap.h"
+#include "cellDiurnal.h"
+#include "hillDistanceMap.h"
+
+#include <boost/test/unit_test.hpp>
+
+/******************************************************************************
+*                        "TERRAIN_SHADING" BOOST TEST SUITE
+*******************************************************************************
+*   Tests:
+*       terrain_shading/horizon_map
+*       terrain_shading/hill_distances
+******************************************************************************/
+
+struct HillyDem
+{
+    /* Two hills and a ridge on a gently tilted plane, small enough that the
+    ** per-cell traces stay cheap. */
+    HillyDem() : dem( 64, 64, 0.0, 0.0, 30.0, -9999.0, Elevation::meters )
+    {
+        for( int i = 0; i < dem.get_nRows(); i++ )
+        {
+            for( int j = 0; j < dem.get_nCols(); j++ )
+            {
+                double h = 1000.0 + 2.0 * i;
+                h += 400.0 * exp( -( ( i - 20 ) * ( i - 20 ) + ( j - 22 ) * ( j - 22 ) ) / 60.0 );
+                h += 250.0 * exp( -( ( i - 44 ) * ( i - 44 ) + ( j - 45 ) * ( j - 45 ) ) / 40.0 );
+                h += 150.0 * exp( -( ( i + j - 70 ) * ( i + j - 70 ) ) / 30.0 );
+                dem( i, j ) = h;
+            }
+        }
+    }
+    Elevation dem;
+};
+
+BOOST_FIXTURE_TEST_SUITE( terrain_shading, HillyDem )
+
+/**
+ * Shade from the horizon map agrees with the shade traced towards the sun,
+ * over sun positions around the compass and from low to high.  The map
+ * interpolates between its sectors and the trace steps from cell to cell, so
+ * cells on the edges of shadows may differ, up to 4% of the grid.
+ */
+BOOST_AUTO_TEST_CASE( horizon_map )
+{
+    HorizonMap horizon( dem, 32 );
+    const double thetas[] = { 30.0, 120.0, 210.0, 300.0 };
+    const double phis[] = { 8.0, 20.0, 40.0 };
+    for( int t = 0; t < 4; t++ )
+    {
+        for( int p = 0; p < 3; p++ )
+        {
+            Shade traced( &dem, thetas[t], phis[p], 0.0, 1 );
+            Shade mapped( &dem, thetas[t], phis[p], 0.0, 1, &horizon );
+            int nShaded = 0;
+            int nDiffer = 0;
+            for( int i = 0; i < dem.get_nRows(); i++ )
+            {
+                for( int j = 0; j < dem.get_nCols(); j++ )
+                {
+                    if( traced( i, j ) == Shade::shaded )
+                        nShaded++;
+                    if( traced( i, j ) != mapped( i, j ) )
+                        nDiffer++;
+                }
+            }
+            BOOST_TEST_MESSAGE( "theta " << thetas[t] << " phi " << phis[p] <<
+                                ": " << nShaded << " shaded, " << nDiffer << " differ" );
+            BOOST_CHECK_LE( nDiffer, dem.get_nRows() * dem.get_nCols() / 25 );
+        }
+    }
+}
+
+/**
+ * The diurnal wind of every cell is the same whether its track to the
+ * hilltop or valley bottom is walked per cell or taken from a shared
+ * HillDistanceMap, by day (upslope flow, tracks stopped by shade) and by
+ * night (downslope flow).
+ */
+BOOST_AUTO_TEST_CASE( hill_distances )
+{
+    Aspect aspect( &dem, 1 );
+    Slope slope( &dem, 1 );
+    HillDistanceMap hillDistances( dem, aspect, slope );
+
+    boost::local_time::time_zone_ptr tz( new boost::local_time::posix_time_zone( "MST-07" ) );
+    const int hours[] = { 10, 22 };
+    for( int h = 0; h < 2; h++ )
+    {
+        boost::local_time::local_date_time time( boost::gregorian::date( 2023, 7, 15 ),
+                                                 boost::posix_time::hours( hours[h] ), tz,
+                                                 boost::local_time::local_date_time::NOT_DATE_TIME_ON_ERROR );
+        Solar solar( time, 43.6, -116.2, 0.0, 0.0, 0.0 );
+        Shade shade( &dem, solar.get_theta(), solar.get_phi(), 0.0, 1 );
+
+        cellDiurnal traced( &dem, &shade, &solar, 0.0, 0.0001, 0.01, 0.2, 0.2 );
+        cellDiurnal mapped( traced );
+        mapped.hillDistances = &hillDistances;
+
+        int nFlowing = 0;
+        double x, y;
+        double a[7], b[7];
+        for( int i = 0; i < dem.get_nRows(); i++ )
+        {
+            for( int j = 0; j < dem.get_nCols(); j++ )
+            {
+                dem.get_cellPosition( i, j, &x, &y );
+                traced.initialize( x, y, aspect( i, j ), slope( i, j ), 0.0, 293.0, 2.0,
+                                   10.0, 0.25, 1.0, 0.15, 0.0, 0.01, 0.0, 0.0 );
+                mapped.initialize( x, y, aspect( i, j ), slope( i, j ), 0.0, 293.0, 2.0,
+                                   10.0, 0.25, 1.0, 0.15, 0.0, 0.01, 0.0, 0.0 );
+                traced.compute_cell_diurnal_wind( i, j, &a[0], &a[1], &a[2], &a[3],
+                                                  &a[4], &a[5], &a[6] );
+                mapped.compute_cell_diurnal_wind( i, j, &b[0], &b[1], &b[2], &b[3],
+                                                  &b[4], &b[5], &b[6] );
+                if( a[0] != 0.0 || a[1] != 0.0 )
+                    nFlowing++;
+                for( int k = 0; k < 7; k++ )
+                    BOOST_REQUIRE_SMALL( b[k] - a[k], 1e-9 * std::max( 1.0, fabs( a[k] ) ) );
+            }
+        }
+        BOOST_TEST_MESSAGE( hours[h] << ":00: " << nFlowing << " cells with a diurnal wind" );
+        BOOST_CHECK_GT( nFlowing, dem.get_nRows() * dem.get_nCols() / 2 );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -342,6 +342,19 @@ Array2D<T>& Array2D<T>::operator=(const Array2D& rhs)
     return *this;
 }
 
+/**
+*@brief exchanges the contents of two Array2D objects without copying the data
+*@param rhs Array2D object to exchange with
+*/
+template<typename T>
+void Array2D<T>::swap(Array2D& rhs)
+{
+    std::swap(cols, rhs.cols);
+    std::swap(rows, rhs.rows);
+    std::swap(noDataValue, rhs.noDataValue);
+    matrix.swap(rhs.matrix);
+}
+
 /**
 *@brief overloaded equal to operator to determine if 2 Array2D objects are identical
 *@param rhs Array2D object to compare to
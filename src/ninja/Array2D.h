@@ -77,6 +77,7 @@ class Array2D
 
     Array2D& operator=(const T data);
     Array2D& operator=(const Array2D& rhs);
+    void swap(Array2D& rhs);
     bool operator==(const Array2D& rhs);
     bool operator!=(const Array2D& rhs);
 
@@ -86,6 +87,7 @@ class Array2D
     bool get_dataBoundaries(int maxNoData, int& minRow, int& maxRow, int& minCol, int& maxCol);
     
     inline T* data() {return matrix.data();}
+    inline const T* data() const {return matrix.data();}
 
   private:
     std::vector<T> matrix;
@@ -36,7 +36,13 @@ Shade::Shade():AsciiGrid<short>()
 	smalll = 1.0e-013;
 }
 
-Shade::Shade(Elevation const* elev, double Theta, double Phi, double angleFromNorth, int number_threads):AsciiGrid<short>(elev->get_nCols(), elev->get_nRows(), elev->get_xllCorner(), elev->get_yllCorner(), elev->get_cellSize(), elev->get_noDataValue())
+/**
+ * Shade of elev for a sun position.  Without a horizon map the terrain is
+ * traced towards the sun; with one (it must be the map of elev, see
+ * TerrainContext::getHorizonMap()) each cell is a lookup.
+ */
+Shade::Shade(Elevation const* elev, double Theta, double Phi, double angleFromNorth, int number_threads,
+             const HorizonMap *horizon):AsciiGrid<short>(elev->get_nCols(), elev->get_nRows(), elev->get_xllCorner(), elev->get_yllCorner(), elev->get_cellSize(), elev->get_noDataValue())
 {	
 	elevation = elev;
     theta = Theta;  // expects the raw input value to be in geographic coordinates
@@ -45,7 +51,7 @@ Shade::Shade(Elevation const* elev, double Theta, double Phi, double angleFromNo
 	number_CPUs = number_threads;
 	grid_made = false;
 	smalll = 1.0e-013;
-	if(!compute_gridShade())
+	if(!(horizon ? compute_gridShade(*horizon) : compute_gridShade()))
 	{
 		#ifdef ASPECT_DEBUG
 			std::cout << "Could not make shade grid..." << std::endl;
@@ -266,6 +272,27 @@ bool Shade::compute_gridShade()
 	}
 }
 
+//shades the cells whose horizon towards the sun is above it
+bool Shade::compute_gridShade(const HorizonMap &horizon)
+{
+	const double tanPhi = tan(phi*pi/180.0);
+	const int nRows = get_nRows();
+	const int nCols = get_nCols();
+
+	#pragma omp parallel for
+	for(int i = 0; i < nRows; i++)
+	{
+		for(int j = 0; j < nCols; j++)
+		{
+			if(phi <= 0.0 || tanPhi < horizon.getHorizonTangent(i, j, theta))
+				data(i,j) = shaded;
+			else
+				data(i,j) = unshaded;
+		}
+	}
+	return true;
+}
+
 bool Shade::compute_gridShade(Elevation const* elev, double Theta, double Phi, double angleFromNorth, int number_threads)
 {	
 	elevation = elev;
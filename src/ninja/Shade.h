@@ -33,6 +33,7 @@
 #include "ascii_grid.h"
 #include "Elevation.h"
 #include "ninjaMathUtility.h"
+#include "horizonMap.h"
 //#include <conio.h>  // This can be taken out!! only here for debugging...
 #include <stdio.h>  // This can be taken out!! only here for debugging...
 
@@ -48,7 +49,8 @@ class Shade : public AsciiGrid<short>
 {
 public:
 	Shade();
-	Shade(Elevation const* elev, double Theta, double Phi, double angleFromNorth, int number_CPUs);
+	Shade(Elevation const* elev, double Theta, double Phi, double angleFromNorth, int number_CPUs,
+	      const HorizonMap *horizon = NULL);
 	~Shade();
 	bool read_shade(std::string filename);
     inline bool set_theta(double sunAngle, double angleFromNorth)
@@ -92,6 +94,7 @@ private:
 	long outer_loop_num;
 
 	bool compute_gridShade();
+	bool compute_gridShade(const HorizonMap &horizon);
 	bool track_along_ray(double px, double py, int *X, int *Y);
 	
 };
@@ -47,6 +47,7 @@ WindNinjaInputs::WindNinjaInputs()
     outputWindHeightUnits = lengthUnits::meters;
     outputWindHeight = -1.0;
     stationFetch=false;
+    stationFormat = wxStation::invalidFormat;
     matchWxStations = false;
     outer_relax = atof(CPLGetConfigOption("NINJA_POINT_MATCH_OUT_RELAX", "1.0"));
     CPLDebug("NINJA", "Setting NINJA_POINT_MATCH_OUT_RELAX to %lf", outer_relax);
@@ -59,6 +60,10 @@ WindNinjaInputs::WindNinjaInputs()
     latitude = -10000.0;
     longitude = -10000.0;
     numberCPUs = 1;
+    solverTolerance = 1E-1;
+    solverMaxIterations = -1;
+    solverTimeLimit = -1.0;
+    solverSurfaceWindTol = -1.0;
     outputBufferClipping = 0.0;
     googOutFlag = false;
 
@@ -90,6 +95,8 @@ WindNinjaInputs::WindNinjaInputs()
     wxModelGeoTiffOutFlag = false;
     wxModelGeoTiffFile = "!set";
     txtOutFlag = false;
+    solverStatsOutFlag = false;
+    solverStatsFile = "!set";
     volVTKOutFlag = false;
     kmlFile = "!set";
     kmzFile = "!set";
@@ -182,11 +189,6 @@ WindNinjaInputs::WindNinjaInputs()
 
     outputPath = "!set";
 
-#ifdef _OPENMP
-    omp_set_nested(false);
-    omp_set_dynamic(false);
-#endif //_OPENMP
-
 }
 
 WindNinjaInputs::~WindNinjaInputs()
@@ -211,6 +213,7 @@ WindNinjaInputs::WindNinjaInputs(const WindNinjaInputs &rhs)
     dirInitGridFilename = rhs.dirInitGridFilename;
     initializationMethod = rhs.initializationMethod;
     forecastFilename = rhs.forecastFilename;
+    forecast = rhs.forecast;
     inputSpeedUnits = rhs.inputSpeedUnits;
     outputSpeedUnits = rhs.outputSpeedUnits;
     inputSpeed = rhs.inputSpeed;
@@ -224,6 +227,7 @@ WindNinjaInputs::WindNinjaInputs(const WindNinjaInputs &rhs)
     stations = rhs.stations;
     realStations = rhs.realStations;
     wxStationFilename = rhs.wxStationFilename;
+    stationFormat = rhs.stationFormat;
     stationsScratch = rhs.stationsScratch;
     stationsOldInput = rhs.stationsOldInput;
     stationsOldOutput = rhs.stationsOldOutput;
@@ -277,6 +281,10 @@ WindNinjaInputs::WindNinjaInputs(const WindNinjaInputs &rhs)
     latitude = rhs.latitude;
     longitude = rhs.longitude;
     numberCPUs = rhs.numberCPUs;
+    solverTolerance = rhs.solverTolerance;
+    solverMaxIterations = rhs.solverMaxIterations;
+    solverTimeLimit = rhs.solverTimeLimit;
+    solverSurfaceWindTol = rhs.solverSurfaceWindTol;
     outputBufferClipping = rhs.outputBufferClipping;
     googOutFlag = rhs.googOutFlag;
     googSpeedScaling = rhs.googSpeedScaling;
@@ -306,6 +314,8 @@ WindNinjaInputs::WindNinjaInputs(const WindNinjaInputs &rhs)
     wxModelGeoTiffOutFlag = rhs.wxModelGeoTiffOutFlag;
     wxModelGeoTiffFile = rhs.wxModelGeoTiffFile;
     txtOutFlag = rhs.txtOutFlag;
+    solverStatsOutFlag = rhs.solverStatsOutFlag;
+    solverStatsFile = rhs.solverStatsFile;
     volVTKOutFlag = rhs.volVTKOutFlag;
     kmlFile = rhs.kmlFile;
     kmzFile = rhs.kmzFile;
@@ -381,11 +391,7 @@ WindNinjaInputs::WindNinjaInputs(const WindNinjaInputs &rhs)
     //class crap
     dem = rhs.dem;
     surface = rhs.surface;
-
-#ifdef _OPENMP
-    omp_set_nested(false);
-    omp_set_dynamic(false);
-#endif //_OPENMP
+    terrain = rhs.terrain;
 
 }
 
@@ -438,6 +444,7 @@ WindNinjaInputs &WindNinjaInputs::operator=(const WindNinjaInputs &rhs)
       dirInitGridFilename = rhs.dirInitGridFilename;
       initializationMethod = rhs.initializationMethod;
       forecastFilename = rhs.forecastFilename;
+      forecast = rhs.forecast;
       inputSpeedUnits = rhs.inputSpeedUnits;
       outputSpeedUnits = rhs.outputSpeedUnits;
       inputSpeed = rhs.inputSpeed;
@@ -451,6 +458,7 @@ WindNinjaInputs &WindNinjaInputs::operator=(const WindNinjaInputs &rhs)
       stations = rhs.stations;
       realStations = rhs.realStations;
       wxStationFilename = rhs.wxStationFilename;
+      stationFormat = rhs.stationFormat;
       stationsScratch = rhs.stationsScratch;
       stationsOldInput = rhs.stationsOldInput;
       stationsOldOutput = rhs.stationsOldOutput;
@@ -504,6 +512,10 @@ WindNinjaInputs &WindNinjaInputs::operator=(const WindNinjaInputs &rhs)
       latitude = rhs.latitude;
       longitude = rhs.longitude;
       numberCPUs = rhs.numberCPUs;
+      solverTolerance = rhs.solverTolerance;
+      solverMaxIterations = rhs.solverMaxIterations;
+      solverTimeLimit = rhs.solverTimeLimit;
+      solverSurfaceWindTol = rhs.solverSurfaceWindTol;
       outputBufferClipping = rhs.outputBufferClipping;
       googOutFlag = rhs.googOutFlag;
       googSpeedScaling = rhs.googSpeedScaling;
@@ -533,6 +545,8 @@ WindNinjaInputs &WindNinjaInputs::operator=(const WindNinjaInputs &rhs)
       wxModelGeoTiffOutFlag = rhs.wxModelGeoTiffOutFlag;
       wxModelGeoTiffFile = rhs.wxModelGeoTiffFile;
       txtOutFlag = rhs.txtOutFlag;
+      solverStatsOutFlag = rhs.solverStatsOutFlag;
+      solverStatsFile = rhs.solverStatsFile;
       volVTKOutFlag = rhs.volVTKOutFlag;
       kmlFile = rhs.kmlFile;
       kmzFile = rhs.kmzFile;
@@ -608,11 +622,7 @@ WindNinjaInputs &WindNinjaInputs::operator=(const WindNinjaInputs &rhs)
       //class crap
       dem = rhs.dem;
       surface = rhs.surface;
-
-#ifdef _OPENMP
-      omp_set_nested(false);
-      omp_set_dynamic(false);
-#endif //_OPENMP
+      terrain = rhs.terrain;
 
     }
   return *this;
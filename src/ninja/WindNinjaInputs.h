@@ -47,6 +47,13 @@
 #include "ninjaCom.h"
 #include "ninja_conv.h"
 
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#endif
+
+class TerrainContext;
+class ForecastCache;
+
 struct WindNinjaInputs
 {
 public:
@@ -109,6 +116,7 @@ public:
     std::string dirInitGridFilename;  //raster file of gridded wind directions
     eInitializationMethod initializationMethod;	//method to initialize WindNinja
     std::string forecastFilename;	//name of coarse weather model initialization file (NDFD, NAM, GFS, RUC, etc.)
+    boost::shared_ptr<ForecastCache> forecast;	//forecast grids shared with the other runs of an army, empty if not shared
     velocityUnits::eVelocityUnits inputSpeedUnits;			//units of input windspeed (0=>m/s, 1=>mph, 2=>kph, 3=>kts) (note that inputSpeed is always stored as m/s, and converted to and from the other units)
     velocityUnits::eVelocityUnits outputSpeedUnits;			//units of output windspeed (0=>m/s, 1=>mph, 2=>kph, 3=>kts)
     double inputSpeed;			//input wind speed in m/s
@@ -123,6 +131,7 @@ public:
     std::vector<wxStation> stations;		//array of weather stations used in point initialization
     std::vector<wxStation> realStations;
     std::string wxStationFilename;	//filename of a weather station(s) file
+    wxStation::eStationFormat stationFormat;	//format of the station file, the times of new format runs go in the output file names
     std::vector<wxStation> stationsScratch;		//scratch space for a copy of WindNinjaInputs::stations to use during outer ninja interations for wind field vs wx station matching
     std::vector<wxStation> stationsOldInput;		//old copy of WindNinjaInputs::stations to use during outer ninja interations for wind field vs wx station matching
     std::vector<wxStation> stationsOldOutput;		//old copy of WindNinjaInputs::stations to use during outer ninja interations for wind field vs wx station matching
@@ -134,6 +143,7 @@ public:
      *  Surface Properties
      *-----------------------------------------------------------------------------*/
     surfProperties surface;		//surface properties data (roughness, albedo, etc...)
+    boost::shared_ptr<TerrainContext> terrain;	//terrain shared with the other runs of an army, empty if not shared
 
     /*-----------------------------------------------------------------------------
      *  Diurnal Inputs
@@ -153,6 +163,10 @@ public:
      *  CPU Paremeters
      *-----------------------------------------------------------------------------*/
     int numberCPUs;			//number of CPUs to use (at this point, only the diurnal is multithreaded...)
+    double solverTolerance;		//stopping tolerance on the relative 2-norm of the solver residual
+    int solverMaxIterations;	//iteration budget, the result is kept when it is reached (-1 => no budget, fail at the default maximum)
+    double solverTimeLimit;		//time budget for the iterations of each solve in seconds (-1 => no limit)
+    double solverSurfaceWindTol;	//stop when the wind at the output height changes less than this between checks, in m/s (-1 => off)
 
     
     /*-----------------------------------------------------------------------------
@@ -185,6 +199,8 @@ public:
     lengthUnits::eLengthUnits geoTiffUnits;
 
     bool txtOutFlag;			//flag specifying if a text file (*.txt) comparing measured to simulated data at specified points should be written (filenames here are hard-coded into the write_compare_output() function in ninja.cpp)
+    bool solverStatsOutFlag;	//flag specifying if the solver statistics (*_solver.json) should be written beside the other outputs
+    std::string solverStatsFile;
     bool wxModelShpOutFlag;		//flag specifying if a wxModel shapefile should be written
     bool wxModelAsciiOutFlag;		//flag specifying if wxModel ESRI Ascii Raster files should be written
     bool wxModelGeoTiffOutFlag;  //flag specifying if wxModel geotiff files should be written
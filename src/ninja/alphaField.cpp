@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Compact storage of the stability alpha at the mesh nodes
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "alphaField.h"
+
+AlphaField::AlphaField()
+{
+    storage = uniform;
+    nCols = 0;
+    nodesPerLayer = 0;
+    values.assign(1, 1.0);
+}
+
+/**
+ * Use one value for every node.
+ * @param value Alpha of the domain.
+ */
+void AlphaField::setUniform(double value)
+{
+    storage = uniform;
+    values.assign(1, value);
+}
+
+/**
+ * Store one value per column of nodes of mesh, set with column().
+ * @param mesh Mesh the field is for.
+ */
+void AlphaField::allocateColumns(const Mesh &mesh)
+{
+    storage = columns;
+    nCols = mesh.ncols;
+    nodesPerLayer = mesh.nrows * mesh.ncols;
+    values.assign(nodesPerLayer, 0.0);
+}
+
+/**
+ * Store one value per node of mesh, set with node().
+ * @param mesh Mesh the field is for.
+ */
+void AlphaField::allocateNodes(const Mesh &mesh)
+{
+    storage = nodes;
+    nCols = mesh.ncols;
+    nodesPerLayer = mesh.nrows * mesh.ncols;
+    values.assign(mesh.NUMNP, 0.0);
+}
+
+/**
+ * Set the field to numerator/alpha, with the storage of alpha.  The values of
+ * alpha are taken over, which leaves it uniform.
+ * @param numerator Numerator, alphaH to get alphaV from the stability alpha.
+ * @param alpha Field to invert.
+ */
+void AlphaField::setInverse(double numerator, AlphaField &alpha)
+{
+    storage = alpha.storage;
+    nCols = alpha.nCols;
+    nodesPerLayer = alpha.nodesPerLayer;
+    values.swap(alpha.values);
+    alpha.setUniform(1.0);
+
+    const int nValues = values.size();
+#pragma omp parallel for
+    for(int i = 0; i < nValues; i++)
+        values[i] = numerator / values[i];
+}
+
+/**
+ * Free the values, leaving a uniform alpha of 1.
+ */
+void AlphaField::deallocate()
+{
+    std::vector<double>().swap(values);
+    setUniform(1.0);
+}
+
+double AlphaField::operator() (int row, int col, int layer) const
+{
+    return (*this)(layer * nodesPerLayer + row * nCols + col);
+}
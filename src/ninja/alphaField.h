@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Compact storage of the stability alpha at the mesh nodes
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#ifndef ALPHA_FIELD_H
+#define ALPHA_FIELD_H
+
+#include <vector>
+
+#include "mesh.h"
+
+/**
+ * Atmospheric stability alpha (or alphaV = alphaH/alpha) at the nodes of a
+ * mesh.  Most stability methods give one alpha for the whole domain or one
+ * per column of nodes, so the field stores one value, one value per column
+ * (every layer of a column shares it) or one value per node, and only the
+ * 3D wx model method needs the last.  Values are read by global node number
+ * like a wn_3dScalarField.
+ */
+class AlphaField
+{
+public:
+    enum eStorage{
+        uniform,    //one value for every node
+        columns,    //one value per (row, col), the same in every layer
+        nodes       //one value per node
+    };
+
+    AlphaField();
+
+    void setUniform(double value);
+    void allocateColumns(const Mesh &mesh);
+    void allocateNodes(const Mesh &mesh);
+    void setInverse(double numerator, AlphaField &alpha);
+    void deallocate();
+
+    eStorage getStorage() const { return storage; }
+
+    inline double operator() (int num) const
+    {
+        if(storage == uniform)
+            return values[0];
+        else if(storage == columns)
+            return values[num % nodesPerLayer];
+        return values[num];
+    }
+    double operator() (int row, int col, int layer) const;
+
+    //value of column (row, col), only for columns storage
+    inline double& column(int row, int col) { return values[row * nCols + col]; }
+    //value of node (row, col, layer), only for nodes storage
+    inline double& node(int row, int col, int layer)
+    {
+        return values[layer * nodesPerLayer + row * nCols + col];
+    }
+
+private:
+    eStorage storage;
+    int nCols;
+    int nodesPerLayer;
+    std::vector<double> values;
+};
+
+#endif /* ALPHA_FIELD_H */
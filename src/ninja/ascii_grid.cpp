@@ -1154,44 +1154,131 @@ void AsciiGrid<T>::interpolateFromPoints(T* pointData, double* X, double* Y, dou
     //numPoints is the number of points, and
     //interpDistPower is the power used for the distance weighting (usually 1.0 or 2.0 for inverse distance weighting or inverse distance squared weighting, respectively)
 
+    AsciiGrid<T> *grid = this;
+    interpolateFromPoints(&grid, &pointData, 1, X, Y, influenceRadius, numPoints, interpDistPower);
+}
 
-    double weight, weight_sum, distance, xC, yC;
-    T value;
-
+/**
+ * Interpolate several arrays of point data onto coincident grids with
+ * inverse distance weighting.  The weights only depend on the geometry, so
+ * they are computed once per cell and point and applied to every array.
+ *
+ * The grid is split into blocks of cells, and each block only visits the
+ * points whose influence radius reaches it.  Blocks are interpolated in
+ * parallel.  Cells that no point reaches are left as no data.
+ *
+ * @param grids grids to fill, all coincident with grids[0]
+ * @param pointData values at the points, one array per grid
+ * @param numGrids number of grids (and of pointData arrays)
+ * @param X x coordinates of the points
+ * @param Y y coordinates of the points
+ * @param influenceRadius maximum interpolation distance of each point (if <0 then infinite influence radius)
+ * @param numPoints number of points
+ * @param interpDistPower power used for the distance weighting (1.0 and 2.0 avoid std::pow())
+ */
+template <class T>
+void AsciiGrid<T>::interpolateFromPoints(AsciiGrid<T>** grids, T** pointData, int numGrids,
+                                         double* X, double* Y, double* influenceRadius,
+                                         int numPoints, double interpDistPower)
+{
     if(interpDistPower <= 0)
         throw std::out_of_range("interpDistPower in AsciiGrid<T>::interpolateFromPoints() must be greater than 0.");
     if(numPoints <=0)
         throw std::out_of_range("numPoints in AsciiGrid<T>::interpolateFromPoints() must be greater than 0.");
+    if(numGrids <= 0)
+        throw std::out_of_range("numGrids in AsciiGrid<T>::interpolateFromPoints() must be greater than 0.");
+    for(int g = 1; g < numGrids; g++)
+    {
+        if(!grids[0]->checkForCoincidentGrids(*grids[g]))
+            throw std::logic_error("Grids are not coincident in AsciiGrid<T>::interpolateFromPoints().");
+    }
+
+    for(int g = 0; g < numGrids; g++)
+        *grids[g] = grids[g]->data.getNoDataValue();
+
+    const int blockSize = 32;   //cells on a side of a block
+    const int nRows = grids[0]->get_nRows();
+    const int nCols = grids[0]->get_nCols();
+    const int nBlockRows = (nRows + blockSize - 1) / blockSize;
+    const int nBlockCols = (nCols + blockSize - 1) / blockSize;
+    const double cellSize = grids[0]->get_cellSize();
+    const double xll = grids[0]->get_xllCorner();
+    const double yll = grids[0]->get_yllCorner();
+
+    int block;
+#pragma omp parallel for default(shared) private(block) schedule(dynamic)
+    for(block = 0; block < nBlockRows*nBlockCols; block++)
+    {
+        const int iStart = (block / nBlockCols) * blockSize;
+        const int jStart = (block % nBlockCols) * blockSize;
+        const int iEnd = std::min(iStart + blockSize, nRows);
+        const int jEnd = std::min(jStart + blockSize, nCols);
+
+        //cell centers of the block
+        const double xMin = xll + (jStart + 0.5) * cellSize;
+        const double xMax = xll + (jEnd - 0.5) * cellSize;
+        const double yMin = yll + (iStart + 0.5) * cellSize;
+        const double yMax = yll + (iEnd - 0.5) * cellSize;
+
+        //points (in their original order) that reach the block, with one
+        //cell of slack so rounding never drops a point that reaches a cell
+        std::vector<int> points;
+        std::vector<double> radius2;
+        for(int k = 0; k < numPoints; k++)
+        {
+            if(influenceRadius[k] >= 0.0)   //negative influence radius means infinite influence radius
+            {
+                double dx = std::max(0.0, std::max(xMin - X[k], X[k] - xMax));
+                double dy = std::max(0.0, std::max(yMin - Y[k], Y[k] - yMax));
+                double reach = influenceRadius[k] + cellSize;
+                if(dx*dx + dy*dy > reach*reach)
+                    continue;
+                radius2.push_back(influenceRadius[k]*influenceRadius[k]);
+            }
+            else
+                radius2.push_back(-1.0);
+            points.push_back(k);
+        }
+        if(points.empty())
+            continue;
 
+        std::vector<T> value(numGrids);
+        double weight, weight_sum, distance2, xC, yC;
 
-    *this = data.getNoDataValue();
-
-    for(int i = 0;i < data.get_numRows();i++)
-    {
-        for(int j = 0;j < data.get_numCols();j++)
+        for(int i = iStart; i < iEnd; i++)
         {
-            value = 0.0;
-            get_cellPosition(i, j, &xC, &yC);
-            weight_sum = 0.0;
-
-            for(int k = 0; k < numPoints; k++)
+            yC = yll + (i + 0.5) * cellSize;
+            for(int j = jStart; j < jEnd; j++)
             {
-                distance = std::sqrt((xC-X[k])*(xC-X[k]) + (yC-Y[k])*(yC-Y[k]));
-                if(influenceRadius[k] >= 0.0)   //negative influence radius means infinite influence radius
+                xC = xll + (j + 0.5) * cellSize;
+                std::fill(value.begin(), value.end(), T(0));
+                weight_sum = 0.0;
+
+                for(unsigned int p = 0; p < points.size(); p++)
                 {
-                    if(distance > influenceRadius[k])   //if distance from current cell location to station is larger than the influence radius, skip this station
+                    const int k = points[p];
+                    distance2 = (xC-X[k])*(xC-X[k]) + (yC-Y[k])*(yC-Y[k]);
+                    if(radius2[p] >= 0.0 && distance2 > radius2[p])   //station is farther than its influence radius
                         continue;
+
+                    if(interpDistPower == 2.0)
+                        weight = 1.0/distance2;
+                    else if(interpDistPower == 1.0)
+                        weight = 1.0/std::sqrt(distance2);
+                    else
+                        weight = 1.0/std::pow(distance2, 0.5*interpDistPower);
+                    weight_sum = weight_sum + weight;
+                    for(int g = 0; g < numGrids; g++)
+                        value[g] = value[g] + pointData[g][k] * weight;
+                }
+                if(weight_sum != 0) //if value IS zero, then don't set the value because this means all points don't have an influence radius that reaches this cell (this effectively leaves the value as the no_data value)
+                {
+                    for(int g = 0; g < numGrids; g++)
+                        grids[g]->data(i, j) = value[g]/weight_sum;
                 }
-                weight = 1.0/std::pow(distance,interpDistPower);
-                weight_sum = weight_sum + weight;
-                value = value + pointData[k] * weight;
             }
-            if(weight_sum != 0) //if value IS zero, then don't set the value because this means all points don't have an influence radius that reaches this cell (this effectively leaves the value as the no_data value)
-                set_cellValue(i, j, value/weight_sum);
         }
     }
-
-
 }
 
 template <class T>
@@ -2531,6 +2618,22 @@ AsciiGrid<T> &AsciiGrid<T>::operator=(const AsciiGrid &A)
     return *this;
 }
 
+/**
+ * @brief Exchange the contents of two grids without copying the data.
+ *
+ * @param A grid to exchange with
+ */
+template <class T>
+void AsciiGrid<T>::swap(AsciiGrid &A)
+{
+    data.swap(A.data);
+    std::swap(cellSize, A.cellSize);
+    std::swap(xllCorner, A.xllCorner);
+    std::swap(yllCorner, A.yllCorner);
+    prjString.swap(A.prjString);
+    sortedData.swap(A.sortedData);
+}
+
 template <class T>
 bool AsciiGrid<T>::operator==(AsciiGrid &A)
 {
@@ -42,6 +42,7 @@
 #include <stdlib.h>
 #include <limits>
 #include <algorithm>
+#include <vector>
 #include <regex>
 #include "ninjaException.h"
 #include "ninjaMathUtility.h"
@@ -173,6 +174,10 @@ public:
     void interpolateFromPoints(T* pointData, double* X, double* Y,
                                double* influenceRadius, int numPoints,
                                double interpDistPower);
+    static void interpolateFromPoints(AsciiGrid<T>** grids, T** pointData,
+                                      int numGrids, double* X, double* Y,
+                                      double* influenceRadius, int numPoints,
+                                      double interpDistPower);
 
     void clipGridInPlaceSnapToCells(double percentClip);
     void clipGridInPlaceSnapToCells(double north, double east, double south, double west);
@@ -227,6 +232,7 @@ public:
     Array2D<T> data;
 
     AsciiGrid<T> &operator=(const AsciiGrid &A);
+    void swap(AsciiGrid &A);
 
     bool operator=(T m);
 
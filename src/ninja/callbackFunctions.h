@@ -3,4 +3,33 @@
 
 typedef void (*ninjaComMessageHandler)(const char *pszMessage, void *pUser);
 
+/*
+ * Read-only view of the output grids of a finished run, handed to a
+ * ninjaRunCompleteHandler.  The arrays are the run's own grids (nRows rows of
+ * nCols values, the first row is the southern one, speeds in the output
+ * speed units) and are only valid during the call.  u, v and w are the wind
+ * components at the output wind height, NULL unless requested or for runs
+ * that did not solve (e.g. reused from the result cache).  A run that failed
+ * has a non-zero status (the error codes of ninja_threaded_exception.h), no
+ * grids and a size of 0.
+ */
+typedef struct
+{
+    int runNumber;
+    int status;
+    int nCols;
+    int nRows;
+    double cellSize;
+    double xllCorner;
+    double yllCorner;
+    const char *prj;
+    const double *speed;
+    const double *direction;
+    const double *u;
+    const double *v;
+    const double *w;
+} ninjaRunResult;
+
+typedef void (*ninjaRunCompleteHandler)(const ninjaRunResult *pResult, void *pUser);
+
 #endif // CALLBACKFUNCTIONS
@@ -31,7 +31,7 @@
 
 cellDiurnal::cellDiurnal()
 {
-
+    hillDistances = NULL;
 }
 
 cellDiurnal::cellDiurnal(Elevation const* incomingDem, Shade const* shd, 
@@ -48,6 +48,7 @@ cellDiurnal::cellDiurnal(Elevation const* incomingDem, Shade const* shd,
     dem = incomingDem;
     angleFromNorth = angFromNorth;
     shade = shd;
+    hillDistances = NULL;
     diurnalSolar = *solarInput;
 
     xord = 0.0;
@@ -127,6 +128,7 @@ cellDiurnal::cellDiurnal(cellDiurnal &c)
     slope = c.slope;
     angleFromNorth = c.angleFromNorth;
     shade = c.shade;
+    hillDistances = c.hillDistances;
     diurnalSolar = c.diurnalSolar;
 
     xord = c.xord;
@@ -201,6 +203,7 @@ void cellDiurnal::create(Elevation const* incomingDem, Shade const* shd, Solar *
     dem = incomingDem;
     angleFromNorth = angFromNorth;
     shade = shd;
+    hillDistances = NULL;
     diurnalSolar = *solarInput;
 
     xord = 0.0;
@@ -295,10 +298,8 @@ void cellDiurnal::initialize(double& Xord, double& Yord, const double& asp,
 
 void cellDiurnal::compute_solarIntensity()
 {
-    //Set aspect and slope for this cell in the diurnalSolar class BEFORE we run it to compute solar intensity!
-    diurnalSolar.set_aspect(aspect, angleFromNorth);
-    diurnalSolar.set_slope(slope);
-    diurnalSolar.call_solPos();
+    //The sun position is the same for every cell, only the surface changes
+    solarIntensity = diurnalSolar.compute_solarIntensity(aspect, slope, angleFromNorth);
 }
 
 //compute incident shortwave radiation to cell based on Solpos and Holtslag and Ulden 1983 to correct for
@@ -311,7 +312,7 @@ void cellDiurnal::compute_Qsw()
     }
     else
     {
-        sinPsi = diurnalSolar.get_solarIntensity() / 1353.0;
+        sinPsi = solarIntensity / 1353.0;
     }
 
     Qsw = (a1 * sinPsi + a2) * (1.0 + b1 * std::pow(CloudCover, b2));
@@ -452,11 +453,17 @@ void cellDiurnal::compute_cellHillDist()
     //BE SURE STEPMULTIPLIER IS GREATER THAN 1.41421... (SQUARE ROOT OF 2) OR TRACKING CORNER 
     //TO CORNER ON A CELL WON'T MAKE IT ACROSS THE CELL
 
-    stepMultiplier = 1.5;
+    stepMultiplier = HillDistanceMap::stepMultiplier;
     //indicates the order of interpolation used in the interpolation function
     interp_order = AsciiGrid<double>::order1;
     dem->get_cellIndex(xord, yord, &i, &j);
 
+    if(hillDistances)
+    {
+        compute_cellHillDist(hillDistances->getTrack(i, j, up_down == 1));
+        return;
+    }
+
     elevOld = (*dem)(i,j);
     elevNew = elevOld;
 
@@ -541,6 +548,58 @@ void cellDiurnal::compute_cellHillDist()
     }
 }
 
+//Same as compute_cellHillDist() with the terrain tracked beforehand (see
+//HillDistanceMap); only the shade along the track is checked
+void cellDiurnal::compute_cellHillDist(const HillDistanceMap::Track &track)
+{
+    int steps = track.steps;
+    elevOld = track.elevation;
+
+    xComponent = cos(n_to_xy(aspect)*pi/180.0);
+    yComponent = sin(n_to_xy(aspect)*pi/180.0);
+    if(up_down == 1)
+    {
+        xComponent = xComponent*(-1.0);
+        yComponent = yComponent*(-1.0);
+    }
+
+    if(cellDist_shadeFlag == true)
+    {
+        //upslope flow stops at shade, downslope flow at sun; the step that
+        //left the grid was never checked
+        short stopValue = (up_down == 0) ? shade->shaded : shade->unshaded;
+        int lastChecked = track.leftGrid ? track.steps - 1 : track.steps;
+        dem->get_cellPosition(i, j, &xStart, &yStart);
+        X = xStart;
+        Y = yStart;
+        for(int step = 1; step <= lastChecked; step++)
+        {
+            X = X + (stepMultiplier * xComponent * dem->get_cellSize());
+            Y = Y + (stepMultiplier * yComponent * dem->get_cellSize());
+            if(shade->interpolateGrid(X, Y, AsciiGrid<short>::order0) == stopValue)
+            {
+                //the track ends here, at the elevation of the step before
+                steps = step;
+                if(step == 1)
+                    elevOld = (*dem)(i,j);
+                else
+                    elevOld = dem->interpolateGrid(X - (stepMultiplier * xComponent * dem->get_cellSize()),
+                                                   Y - (stepMultiplier * yComponent * dem->get_cellSize()),
+                                                   interp_order);
+                break;
+            }
+        }
+    }
+
+    dist = (steps - 1) * stepMultiplier * dem->get_cellSize();
+    elev_change = fabs(elevOld - (*dem)(i,j));
+    hillValleyDist = std::sqrt(dist*dist +
+                            (elevOld - ((*dem)(i,j)))*(elevOld - (*dem)(i,j)));
+
+    if(up_down == 1)
+        sinAlphaLocal = hillDistances->getSinAlphaLocal(i, j);
+}
+
 void cellDiurnal::compute_S()
 {
     if((diurnal_wind == false) || ((hillValleyDist - epsilon) < 0.0))
@@ -41,6 +41,7 @@
 #include "Aspect.h"
 #include "Slope.h"
 #include "Shade.h"
+#include "hillDistanceMap.h"
 #include "air.h"
 #include "solar.h"
 #include "SurfProperties.h"
@@ -67,6 +68,8 @@ class cellDiurnal
 
         Elevation const* dem;
         Shade const* shade;
+        //tracks of the terrain shared by the runs of an army, may be NULL
+        HillDistanceMap const* hillDistances;
         
         void create(Elevation const* incomingDem, Shade const* shd, Solar *solarInput, const double& angFromNorth);
 
@@ -100,6 +103,7 @@ class cellDiurnal
 	void compute_Qh();
 	void compute_Bl_height();
 	void compute_cellHillDist();
+	void compute_cellHillDist(const HillDistanceMap::Track &track);
 	void compute_S();
 	void compute_UVW();
 
@@ -131,6 +135,7 @@ class cellDiurnal
 	double elev_change; //change in elevation from cell to hilltop/valley bottom (always positive, ie. absolute value)
 	double sinAlphaLocal; //local sine alpha computed in hillDist
 	double S;  //Diurnal windspeed (m/s)
+	double solarIntensity;  //Solar intensity on the cell surface (W/m^2)
 
         //Flag used to switch computation of hillValleyDist to include distance to shaded/unshaded cell
         //false => don't include shaded/unshaded cells    true(default) => include shaded/unshaded cells
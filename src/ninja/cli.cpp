@@ -29,6 +29,7 @@
 *****************************************************************************/
 
 #include "cli.h"
+#include "ninjaServer.h"
 #include <string>
 
 /**
@@ -169,7 +170,7 @@ int countNumCores()
  * @param argv Arguments
  * @return zero if successful, non-zero otherwise
  */
-int windNinjaCLI(int argc, char* argv[])
+int windNinjaCLI(int argc, char* argv[], NinjaServer *server)
 {
     setbuf(stdout, NULL);
 
@@ -203,6 +204,8 @@ int windNinjaCLI(int argc, char* argv[])
                                  "response file (can be specified with '@name', also)")
                         ("citation", "how to cite WindNinja in a publication")
                         ("runtime_options","print all available configuration options")
+                        ("server", "answer runs read from stdin as JSON lines, keeping the terrain of recent DEMs between them")
+                        ("server_dems", po::value<int>()->default_value(4), "number of DEMs the server keeps terrain for")
                             ;
         /*
         ** Set the available wx model names using hard codes for UCAR and api
@@ -244,6 +247,19 @@ int windNinjaCLI(int argc, char* argv[])
         po::options_description config("Simulation options");
         config.add_options()
                 ("num_threads", po::value<int>()->default_value(1), "number of threads to use during simulation")
+                ("memory_budget", po::value<double>()->default_value(-1.0), "memory in MB the runs going at the same time may use (-1 for 80% of the usable RAM)")
+                ("result_cache", po::value<std::string>(), "directory of output grids of earlier runs; identical runs only rewrite their output files")
+                ("result_cache_size", po::value<double>()->default_value(1024.0), "size in MB the result cache directory is kept under")
+                ("resume", po::value<bool>()->default_value(false), "skip the runs whose output files were written by an earlier, stopped start of the same runs (true, false)")
+                ("ensemble_stats", po::value<bool>()->default_value(false), "write the per cell mean, standard deviation, maximum and percentiles of the speed and mean direction of all runs (true, false)")
+                ("ensemble_percentiles", po::value<std::string>()->default_value("50,90"), "comma separated speed percentiles written with ensemble_stats")
+                ("output_writers", po::value<int>()->default_value(-1), "number of threads writing output files in the background while the next runs solve (0 to write them in each run, -1 for NINJA_ARMY_OUTPUT_WRITERS)")
+                ("solver_tolerance", po::value<double>()->default_value(1E-1), "stopping tolerance on the relative solver residual (larger is faster, less accurate)")
+                ("solver_max_iterations", po::value<int>()->default_value(-1), "solver iteration budget, the solution is kept when it is reached (-1 for no budget)")
+                ("solver_time_limit", po::value<double>()->default_value(-1.0), "solver time budget in seconds per solve, the solution is kept when it is reached (-1 for no limit)")
+                ("solver_surface_wind_tolerance", po::value<double>()->default_value(-1.0), "stop the solver when the wind at the output height changes less than this between checks, in output_speed_units (-1 for off)")
+                ("solver_recycling", po::value<bool>()->default_value(false), "reuse approximate eigenvectors between solves so later runs on the same mesh converge faster (true, false)")
+                ("solver_recycling_vectors", po::value<int>()->default_value(8), "number of vectors kept when solver_recycling is on")
                 ("elevation_file", po::value<std::string>(), "input elevation path/filename (*.asc, *.lcp, *.tif, *.img)")
                 ("fetch_elevation", po::value<std::string>(), "download an elevation file from an internet server and save to path/filename")
                 ("north", po::value<double>(), "north extent of elevation file bounding box to download")
@@ -345,6 +361,7 @@ int windNinjaCLI(int argc, char* argv[])
                 ("pdf_width", po::value<double>(), "width of geospatial pdf")
                 ("pdf_size", po::value<std::string>()->default_value("letter"), "pre-defined pdf sizes (letter, legal, tabloid)")
                 ("write_vtk_output", po::value<bool>()->default_value(false), "write VTK output file (true, false). For momentum solver runs, this is NOT of the full openfoam case but is actually of a corresponding mass solver mesh")
+                ("write_solver_stats", po::value<bool>()->default_value(false), "write solver statistics (iterations, residual history, timings) to a *_solver.json file beside the outputs (true, false)")
                 ("output_path", po::value<std::string>(), "path to where output files will be written")
                 ("non_neutral_stability", po::value<bool>()->default_value(false), "use non-neutral stability (true, false)")
                 ("alpha_stability", po::value<double>(), "alpha value for atmospheric stability")
@@ -502,6 +519,16 @@ int windNinjaCLI(int argc, char* argv[])
             return 0;
         }
 
+        if(vm.count("server") && server == NULL){
+            if(vm["server_dems"].as<int>() < 1)
+            {
+                cerr << "Invalid number of server DEMs." << endl;
+                return 1;
+            }
+            NinjaServer ninjaServer(vm["server_dems"].as<int>());
+            return ninjaServer.run();
+        }
+
         if(vm.count("runtime_options")){
             cout<<"==============================================="<<endl;
             cout<<" List of available config options in WindNinja"<<endl;
@@ -671,6 +698,7 @@ int windNinjaCLI(int argc, char* argv[])
         std::string output_path = vm.count("output_path") ? vm["output_path"].as<std::string>() : "";
 
         ninjaArmy windsim;
+        wxStation::eStationFormat wxStationFormat = wxStation::invalidFormat;   //of a point initialization
 
         /* Do we have to fetch an elevation file */
 
@@ -685,7 +713,7 @@ int windNinjaCLI(int argc, char* argv[])
             hDS = OGROpen(vm["fire_perimeter_file"].as<std::string>().c_str(), FALSE, 0);
             if (hDS == 0){
               fprintf(stderr, "Failed to open fire perimeter file.\n");
-              exit(1);
+              return 1;
             }
 
             OGRLayerH hLayer;
@@ -697,7 +725,8 @@ int windNinjaCLI(int argc, char* argv[])
             hFeature = OGR_L_GetNextFeature(hLayer);
             if (hFeature == NULL) {
               fprintf(stderr, "Failed to get fire perimeter feature");
-              exit(1);
+              GDALClose(hDS);
+              return 1;
             }
             hGeo = OGR_F_GetGeometryRef(hFeature);
             OGREnvelope psEnvelope;
@@ -732,7 +761,7 @@ int windNinjaCLI(int argc, char* argv[])
                 if( NULL == fetch )
                 {
                     fprintf(stderr, "Invalid DEM Source\n");
-                    exit(1);
+                    return 1;
                 }
 
                 double srtmRes = fetch->GetXRes();
@@ -775,7 +804,7 @@ int windNinjaCLI(int argc, char* argv[])
                         std::cerr << "Unknown error occurred during fetch.\nThis can happen when either the data source doesn't cover your region or the server that provides the surface data is down or under high usage. \nPlease try again later or try a different data source." << std::endl;
                     }
                     VSIUnlink(new_elev.c_str());
-                    exit(1);
+                    return 1;
                 }
 
                 if( vm["elevation_source"].as<std::string>() != "lcp") {
@@ -828,7 +857,7 @@ int windNinjaCLI(int argc, char* argv[])
             if( NULL == fetch )
             {
                 fprintf(stderr, "Invalid DEM Source\n");
-                exit(1);
+                return 1;
             }
 
             if(vm.count("north") || vm.count("south") ||
@@ -848,7 +877,8 @@ int windNinjaCLI(int argc, char* argv[])
                 if(south >= north || west >= east)
                 {
                     cerr << "Invalid bounding box\n";
-                    exit(1);
+                    delete fetch;
+                    return 1;
                 }
 
                 double bbox[4];
@@ -886,12 +916,14 @@ int windNinjaCLI(int argc, char* argv[])
                    y_buf < 0 )
                 {
                     cerr << "Invalid coordinates for dem\n";
-                    exit(1);
+                    delete fetch;
+                    return 1;
                 }
                 if(b_units != "miles" && b_units != "kilometers")
                 {
                     cerr << "Invalid units for buffer for dem\n";
-                    exit(1);
+                    delete fetch;
+                    return 1;
                 }
 
                 double center[2];
@@ -953,7 +985,7 @@ int windNinjaCLI(int argc, char* argv[])
                     std::cerr << "Unknown error occurred during fetch.\nThis can happen when either the data source doesn't cover your region or the server that provides the surface data is down or under high usage. \nPlease try again later or try a different data source." << std::endl;
                 }
                 VSIUnlink(new_elev.c_str());
-                exit(1);
+                return 1;
             }
 
             elevation_file = &vm["fetch_elevation"].as<std::string>();
@@ -1316,7 +1348,7 @@ int windNinjaCLI(int argc, char* argv[])
 
                 option_dependency(vm,"station_buffer","station_buffer_units");
                 std::string stationPathName;
-                wxStation::SetStationFormat(wxStation::newFormat);
+                wxStationFormat = wxStation::newFormat;
 
                 pointInitialization::setStationBuffer(vm["station_buffer"].as<double>(),
                         vm["station_buffer_units"].as<std::string>()); //Sets buffer
@@ -1454,7 +1486,7 @@ int windNinjaCLI(int argc, char* argv[])
                      *
                      * This is only necessary if the user provides one file to the CLI
                      */
-                    wxStation::SetStationFormat(wxStation::newFormat);
+                    wxStationFormat = wxStation::newFormat;
                     int fileSubFormat = wxStation::GetFirstStationLine(stationFile.c_str());
                     if(fileSubFormat==2) //Time series detected!
                     {
@@ -1503,7 +1535,7 @@ int windNinjaCLI(int argc, char* argv[])
                 }
                 else if (stationFormat==1) //old format
                 {
-                    wxStation::SetStationFormat(wxStation::oldFormat);
+                    wxStationFormat = wxStation::oldFormat;
                     boost::posix_time::ptime noTime;
                     timeList.push_back(noTime);
                     windsim.makePointArmy(timeList,osTimeZone,vm["wx_station_filename"].as<std::string>(),
@@ -1511,7 +1543,7 @@ int windNinjaCLI(int argc, char* argv[])
                 }
                 else if (stationFormat==3) // New Format where there are multiple station files
                 {
-                    wxStation::SetStationFormat(wxStation::newFormat);
+                    wxStationFormat = wxStation::newFormat;
                     CPLDebug("STATION_FETCH","Multiple Timeseries Station Files Detected...");
                     option_dependency(vm, "wx_station_filename", "start_year");
                     option_dependency(vm, "wx_station_filename", "start_month");
@@ -1544,7 +1576,7 @@ int windNinjaCLI(int argc, char* argv[])
                 }
                 else if (stationFormat==4) // New Format where there are multiple one step recent station files
                 {
-                    wxStation::SetStationFormat(wxStation::newFormat);
+                    wxStationFormat = wxStation::newFormat;
                     CPLDebug("STATION_FETCH","Multiple Single Step Station Files Detected...");
 
                     boost::posix_time::ptime noTime;
@@ -1580,12 +1612,39 @@ int windNinjaCLI(int argc, char* argv[])
         }
 //STATION_FETCH
 
+        //keep the terrain of the DEM warm for the next request of a server,
+        //which answers with the results of each run as it finishes
+        if(server)
+        {
+            if(elevation_file)
+                server->prepare(windsim, *elevation_file,
+                                vm["solver_recycling"].as<bool>() ? vm["solver_recycling_vectors"].as<int>() : 0);
+            server->streamRuns(windsim);
+        }
+
         //For loop over all ninjas (just 1 ninja unless it's a weather model run)--------------------
 
         for(int i_ = 0; i_ < windsim.getSize(); i_++)
         {
             windsim.setNumberCPUs( i_, vm["num_threads"].as<int>() );
 
+            if(windsim.setSolverTolerance( i_, vm["solver_tolerance"].as<double>() ) != NINJA_SUCCESS ||
+               windsim.setSolverIterationBudget( i_, vm["solver_max_iterations"].as<int>(),
+                                                 vm["solver_time_limit"].as<double>() ) != NINJA_SUCCESS ||
+               windsim.setSolverSurfaceWindTolerance( i_, vm["solver_surface_wind_tolerance"].as<double>(),
+                                                      vm["output_speed_units"].as<std::string>() ) != NINJA_SUCCESS)
+            {
+                cerr << "Invalid solver stopping options." << endl;
+                return 1;
+            }
+
+            if(vm["solver_recycling"].as<bool>() &&
+               windsim.setSolverRecycling( i_, true, vm["solver_recycling_vectors"].as<int>() ) != NINJA_SUCCESS)
+            {
+                cerr << "Invalid solver recycling options." << endl;
+                return 1;
+            }
+
             //windsim.ninjas[i_].readInputFile(*elevation_file);
 
             windsim.setDEM( i_, *elevation_file );
@@ -1787,9 +1846,8 @@ int windNinjaCLI(int argc, char* argv[])
                 if(vm["write_wx_station_kml"].as<bool>() == true) //If the user wants a KML of the stations
                 {
                     CPLDebug("STATION_FETCH", "Writing wxStation kml for step #%d", i_);
-                    wxStation::writeKmlFile(windsim.getWxStations( i_ ),
-                                                *elevation_file,
-                                                output_path, velocityUnits::getUnit(vm["output_speed_units"].as<std::string>()));
+                    windsim.writeStationKml( i_, *elevation_file,
+                                             output_path, velocityUnits::getUnit(vm["output_speed_units"].as<std::string>()));
                 }
 
                 windsim.setOutputWindHeight( i_, vm["output_wind_height"].as<double>(),
@@ -1798,12 +1856,12 @@ int windNinjaCLI(int argc, char* argv[])
                 if(vm["diurnal_winds"].as<bool>())
                 {
                     if(vm["fetch_station"].as<bool>() == true ||
-                            wxStation::GetStationFormat() == wxStation::newFormat) //new format
+                            wxStationFormat == wxStation::newFormat) //new format
                     {
                         windsim.setDiurnalWinds( i_, true);
                     }
                     if(vm["fetch_station"].as<bool>() == false &&
-                            wxStation::GetStationFormat() == wxStation::oldFormat) //old format
+                            wxStationFormat == wxStation::oldFormat) //old format
                     {
                         option_dependency(vm, "diurnal_winds", "year");
                         option_dependency(vm, "diurnal_winds", "month");
@@ -1839,12 +1897,12 @@ int windNinjaCLI(int argc, char* argv[])
                     else
                     {
                         if(vm["fetch_station"].as<bool>() == true ||
-                                wxStation::GetStationFormat() == wxStation::newFormat) //new format
+                                wxStationFormat == wxStation::newFormat) //new format
                         {
                             windsim.setStabilityFlag( i_, true);
                         }
                         if(vm["fetch_station"].as<bool>() == false &&
-                                wxStation::GetStationFormat() == wxStation::oldFormat) //old format
+                                wxStationFormat == wxStation::oldFormat) //old format
                         {
                             option_dependency(vm, "non_neutral_stability", "year");
                             option_dependency(vm, "non_neutral_stability", "month");
@@ -2256,8 +2314,42 @@ int windNinjaCLI(int argc, char* argv[])
             {
                 windsim.setVtkOutFlag( i_, true );
             }
+            if(vm["write_solver_stats"].as<bool>())
+            {
+                windsim.setSolverStatsOutFlag( i_, true );
+            }
         }   //end for loop over ninjas
 
+        if(windsim.setMemoryBudget(vm["memory_budget"].as<double>()) != NINJA_SUCCESS)
+        {
+            cerr << "Invalid memory budget." << endl;
+            return 1;
+        }
+        if(windsim.setOutputWriters(vm["output_writers"].as<int>()) != NINJA_SUCCESS)
+        {
+            cerr << "Invalid number of output writers." << endl;
+            return 1;
+        }
+        if(vm.count("result_cache"))
+        {
+            if(windsim.setResultCache(vm["result_cache"].as<std::string>(), vm["result_cache_size"].as<double>()) != NINJA_SUCCESS)
+            {
+                cerr << "Invalid result cache size." << endl;
+                return 1;
+            }
+        }
+
+        if(vm["resume"].as<bool>())
+        {
+            windsim.setResume(true);
+        }
+        if(vm["ensemble_stats"].as<bool>() &&
+           windsim.setEnsembleStats(true, vm["ensemble_percentiles"].as<std::string>()) != NINJA_SUCCESS)
+        {
+            cerr << "Invalid ensemble percentiles." << endl;
+            return 1;
+        }
+
         //run the simulations
         if(!windsim.startRuns(vm["num_threads"].as<int>()))
         {
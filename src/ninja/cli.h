@@ -57,7 +57,9 @@ namespace po = boost::program_options;
 
 //#include <QDateTime>
 
-int windNinjaCLI(int argc, char* argv[]);
+class NinjaServer;
+
+int windNinjaCLI(int argc, char* argv[], NinjaServer *server = NULL);
 
 void conflicting_options(const po::variables_map& vm, const char* opt1, const char* opt2);
 
@@ -0,0 +1,668 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Deflation space recycled between solves of the CG solver
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+#include "deflationSpace.h"
+#include "ninjaBlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @param maxVectors Largest number of vectors kept in the space.
+ * @param windowSize Number of Lanczos vectors kept by the RitzCollector of a solve.
+ */
+DeflationSpace::DeflationSpace(int maxVectors, int windowSize)
+{
+    if(maxVectors < 1 || windowSize < 2*maxVectors + 2)
+        throw std::logic_error("The deflation space needs at least one vector and a window of more than twice as many Lanczos vectors.");
+    this->maxVectors = maxVectors;
+    this->windowSize = windowSize;
+    n = 0;
+    k = 0;
+#ifdef _OPENMP
+    omp_init_lock(&lock);
+#endif
+}
+
+DeflationSpace::~DeflationSpace()
+{
+#ifdef _OPENMP
+    omp_destroy_lock(&lock);
+#endif
+}
+
+int DeflationSpace::getMaxVectors() const
+{
+    return maxVectors;
+}
+
+int DeflationSpace::getWindowSize() const
+{
+    return windowSize;
+}
+
+/**
+ * Copy the current vectors for a solve.
+ * @param n Size of the system being solved.
+ * @param W Filled with the vectors, column major n x k.
+ * @return Number of vectors k, 0 if the space is empty or of a different size.
+ */
+int DeflationSpace::getVectors(int n, std::vector<double> &W)
+{
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    if(n != this->n || k == 0)
+        return 0;
+    W = this->W;
+    return k;
+}
+
+void DeflationSpace::clear()
+{
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    n = 0;
+    k = 0;
+    W.clear();
+}
+
+/**
+ * Refine the space after a solve.  The new vectors are the harmonic Ritz
+ * vectors of A for its smallest harmonic Ritz values on Z = [W U]:
+ *
+ *      (AZ)'(AZ) y = theta Z'(AZ) y
+ *
+ * @param n Size of the system.
+ * @param k Number of deflation vectors used in the solve (may be 0).
+ * @param W The deflation vectors used, column major n x k.
+ * @param AW A*W, column major n x k.
+ * @param m Number of new vectors (may be 0).
+ * @param U New approximate eigenvectors from the solve, column major n x m.
+ * @param AU A*U, column major n x m.
+ */
+void DeflationSpace::update(int n, int k, const double *W, const double *AW,
+                            int m, const double *U, const double *AU)
+{
+    const int size = k + m;
+    if(size == 0)
+        return;
+
+    std::vector<const double*> Z(size), AZ(size);
+    for(int a = 0; a < size; a++)
+    {
+        Z[a] = a < k ? W + (long)a*n : U + (long)(a-k)*n;
+        AZ[a] = a < k ? AW + (long)a*n : AU + (long)(a-k)*n;
+    }
+
+    //projected matrices, one dot product per entry of the upper triangle
+    std::vector<double> F(size*size), G(size*size);
+    const int nPairs = size*(size+1)/2;
+    #pragma omp parallel for schedule(dynamic)
+    for(int pair = 0; pair < nPairs; pair++)
+    {
+        int a = 0, b = pair;
+        while(b >= size - a)
+        {
+            b -= size - a;
+            a++;
+        }
+        b += a;
+        double f = 0.5*(ninjaBlas::ddot(n, Z[a], AZ[b]) + ninjaBlas::ddot(n, Z[b], AZ[a]));
+        double g = ninjaBlas::ddot(n, AZ[a], AZ[b]);
+        F[a*size + b] = F[b*size + a] = f;
+        G[a*size + b] = G[b*size + a] = g;
+    }
+
+    std::vector<double> Y;
+    int nFound;
+    if(!harmonicRitz(size, F, G, maxVectors, Y, nFound))
+        return;
+
+    std::vector<double> Wnew((long)n*nFound, 0.0);
+    for(int c = 0; c < nFound; c++)
+    {
+        double *w = &Wnew[(long)c*n];
+        for(int a = 0; a < size; a++)
+        {
+            if(Y[c*size + a] != 0.0)
+                ninjaBlas::daxpy(n, Y[c*size + a], Z[a], w);
+        }
+        double norm = ninjaBlas::dnrm2(n, w);
+        if(norm > 0.0)
+            ninjaBlas::dscal(n, 1.0/norm, w);
+    }
+
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    this->n = n;
+    this->k = nFound;
+    this->W.swap(Wnew);
+}
+
+/**
+ * Solve the small generalized eigenproblem G y = theta F y for F, G
+ * symmetric and F positive definite, and return the eigenvectors of the
+ * smallest eigenvalues.  Columns of F that are (nearly) linearly dependent
+ * on earlier ones are left out, their entries in Y are zero.
+ *
+ * @param size Order of F and G (row major).
+ * @param F Symmetric positive (semi)definite matrix.
+ * @param G Symmetric matrix.
+ * @param nWanted Number of eigenvectors wanted.
+ * @param Y Eigenvectors, column major size x nFound, smallest eigenvalue first.
+ * @param nFound Number of eigenvectors returned.
+ * @return false if no eigenvectors could be found.
+ */
+bool DeflationSpace::harmonicRitz(int size, const std::vector<double> &F, const std::vector<double> &G,
+                                  int nWanted, std::vector<double> &Y, int &nFound)
+{
+    const double pivotTol = 1E-10;
+
+    //scale to a unit diagonal, then Cholesky F = L*L' skipping dependent columns
+    std::vector<double> D(size, 0.0);
+    std::vector<int> keep;
+    std::vector<double> L;  //row major r x r, r grows as columns are kept
+    std::vector<double> row;
+    for(int a = 0; a < size; a++)
+    {
+        if(F[a*size + a] <= 0.0)
+            continue;
+        D[a] = 1.0/std::sqrt(F[a*size + a]);
+        int r = keep.size();
+        row.assign(r, 0.0);
+        for(int b = 0; b < r; b++)
+        {
+            double sum = D[a]*F[a*size + keep[b]]*D[keep[b]];
+            for(int c = 0; c < b; c++)
+                sum -= row[c]*L[b*size + c];
+            row[b] = sum/L[b*size + b];
+        }
+        double pivot = 1.0;
+        for(int b = 0; b < r; b++)
+            pivot -= row[b]*row[b];
+        if(pivot < pivotTol)
+            continue;
+        if(L.empty())
+            L.assign(size*size, 0.0);
+        for(int b = 0; b < r; b++)
+            L[r*size + b] = row[b];
+        L[r*size + r] = std::sqrt(pivot);
+        keep.push_back(a);
+    }
+
+    const int r = keep.size();
+    if(r == 0)
+        return false;
+
+    //C = inv(L) * G * inv(L')
+    std::vector<double> X(r*r), C(r*r);
+    for(int col = 0; col < r; col++)    //X = inv(L) * G, column by column
+    {
+        for(int a = 0; a < r; a++)
+        {
+            double sum = D[keep[a]]*G[keep[a]*size + keep[col]]*D[keep[col]];
+            for(int b = 0; b < a; b++)
+                sum -= L[a*size + b]*X[b*r + col];
+            X[a*r + col] = sum/L[a*size + a];
+        }
+    }
+    for(int col = 0; col < r; col++)    //C = inv(L) * X', X' = G * inv(L')
+    {
+        for(int a = 0; a < r; a++)
+        {
+            double sum = X[col*r + a];
+            for(int b = 0; b < a; b++)
+                sum -= L[a*size + b]*C[b*r + col];
+            C[a*r + col] = sum/L[a*size + a];
+        }
+    }
+    for(int a = 0; a < r; a++)
+        for(int b = a+1; b < r; b++)
+            C[a*r + b] = C[b*r + a] = 0.5*(C[a*r + b] + C[b*r + a]);
+
+    std::vector<double> V;
+    symmetricEigen(r, C, V);
+
+    std::vector<int> order(r);
+    for(int a = 0; a < r; a++)
+        order[a] = a;
+    std::sort(order.begin(), order.end(), [&C, r](int i, int j) { return C[i*r + i] < C[j*r + j]; });
+
+    nFound = std::min(nWanted, r);
+    Y.assign(size*nFound, 0.0);
+    std::vector<double> u(r);
+    for(int c = 0; c < nFound; c++)
+    {
+        //y = D * inv(L') * v
+        for(int a = r-1; a >= 0; a--)
+        {
+            double sum = V[a*r + order[c]];
+            for(int b = a+1; b < r; b++)
+                sum -= L[b*size + a]*u[b];
+            u[a] = sum/L[a*size + a];
+        }
+        for(int a = 0; a < r; a++)
+            Y[c*size + keep[a]] = D[keep[a]]*u[a];
+    }
+
+    return true;
+}
+
+/**
+ * Cyclic Jacobi eigenvalue method for a small symmetric matrix.
+ * @param size Order of C.
+ * @param C Row major symmetric matrix, overwritten, the eigenvalues end up on the diagonal.
+ * @param V Row major eigenvectors, column j belongs to eigenvalue C(j,j).
+ */
+void DeflationSpace::symmetricEigen(int size, std::vector<double> &C, std::vector<double> &V)
+{
+    V.assign(size*size, 0.0);
+    for(int a = 0; a < size; a++)
+        V[a*size + a] = 1.0;
+
+    for(int sweep = 0; sweep < 100; sweep++)
+    {
+        double offDiag = 0.0, diag = 0.0;
+        for(int a = 0; a < size; a++)
+        {
+            diag += C[a*size + a]*C[a*size + a];
+            for(int b = a+1; b < size; b++)
+                offDiag += C[a*size + b]*C[a*size + b];
+        }
+        if(offDiag <= 1E-30*diag)
+            break;
+
+        for(int p = 0; p < size; p++)
+        {
+            for(int q = p+1; q < size; q++)
+            {
+                double cpq = C[p*size + q];
+                if(cpq == 0.0)
+                    continue;
+                double theta = (C[q*size + q] - C[p*size + p])/(2.0*cpq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0)/(std::fabs(theta) + std::sqrt(theta*theta + 1.0));
+                double c = 1.0/std::sqrt(t*t + 1.0);
+                double s = t*c;
+                for(int a = 0; a < size; a++)   //C = C*J
+                {
+                    double cap = C[a*size + p], caq = C[a*size + q];
+                    C[a*size + p] = c*cap - s*caq;
+                    C[a*size + q] = s*cap + c*caq;
+                }
+                for(int a = 0; a < size; a++)   //C = J'*C
+                {
+                    double cpa = C[p*size + a], cqa = C[q*size + a];
+                    C[p*size + a] = c*cpa - s*cqa;
+                    C[q*size + a] = s*cpa + c*cqa;
+                }
+                for(int a = 0; a < size; a++)   //V = V*J
+                {
+                    double vap = V[a*size + p], vaq = V[a*size + q];
+                    V[a*size + p] = c*vap - s*vaq;
+                    V[a*size + q] = s*vap + c*vaq;
+                }
+            }
+        }
+    }
+}
+
+DeflationProjector::DeflationProjector()
+{
+    n = 0;
+    k = 0;
+    W = NULL;
+    AW = NULL;
+}
+
+/**
+ * Factor E = W'*A*W.
+ * @param n Size of the system.
+ * @param k Number of deflation vectors.
+ * @param W Deflation vectors, column major n x k, must stay valid during the solve.
+ * @param AW A*W, column major n x k, must stay valid during the solve.
+ * @return false if E is not positive definite, the projector is then left empty.
+ */
+bool DeflationProjector::initialize(int n, int k, const double *W, const double *AW)
+{
+    this->n = 0;
+    this->k = 0;
+    if(k < 1)
+        return false;
+
+    std::vector<double> E(k*k);
+    for(int a = 0; a < k; a++)
+        for(int b = a; b < k; b++)
+            E[a*k + b] = E[b*k + a] = 0.5*(ninjaBlas::ddot(n, W + (long)a*n, AW + (long)b*n) +
+                                           ninjaBlas::ddot(n, W + (long)b*n, AW + (long)a*n));
+
+    L.assign(k*k, 0.0);
+    for(int a = 0; a < k; a++)
+    {
+        for(int b = 0; b <= a; b++)
+        {
+            double sum = E[a*k + b];
+            for(int d = 0; d < b; d++)
+                sum -= L[a*k + d]*L[b*k + d];
+            if(a == b)
+            {
+                if(sum <= 1E-12*E[a*k + a])
+                    return false;
+                L[a*k + a] = std::sqrt(sum);
+            }
+            else
+                L[a*k + b] = sum/L[b*k + b];
+        }
+    }
+
+    this->n = n;
+    this->k = k;
+    this->W = W;
+    this->AW = AW;
+    c.resize(k);
+    return true;
+}
+
+int DeflationProjector::size() const
+{
+    return k;
+}
+
+/**
+ * x = x + W*inv(E)*W'*r,  r = r - A*W*inv(E)*W'*r
+ */
+void DeflationProjector::correctInitialGuess(double *x, double *r)
+{
+    for(int a = 0; a < k; a++)
+        c[a] = ninjaBlas::ddot(n, W + (long)a*n, r);
+    solveE();
+    for(int a = 0; a < k; a++)
+    {
+        ninjaBlas::daxpy(n, c[a], W + (long)a*n, x);
+        ninjaBlas::daxpy(n, -c[a], AW + (long)a*n, r);
+    }
+}
+
+/**
+ * p = p - W*inv(E)*(A*W)'*z
+ */
+void DeflationProjector::deflateDirection(const double *z, double *p)
+{
+    for(int a = 0; a < k; a++)
+        c[a] = ninjaBlas::ddot(n, AW + (long)a*n, z);
+    solveE();
+    for(int a = 0; a < k; a++)
+        ninjaBlas::daxpy(n, -c[a], W + (long)a*n, p);
+}
+
+/**
+ * c = inv(E)*c using the Cholesky factor.
+ */
+void DeflationProjector::solveE()
+{
+    for(int a = 0; a < k; a++)
+    {
+        for(int b = 0; b < a; b++)
+            c[a] -= L[a*k + b]*c[b];
+        c[a] /= L[a*k + a];
+    }
+    for(int a = k-1; a >= 0; a--)
+    {
+        for(int b = a+1; b < k; b++)
+            c[a] -= L[b*k + a]*c[b];
+        c[a] /= L[a*k + a];
+    }
+}
+
+/**
+ * @param n Size of the system.
+ * @param nev Number of Ritz vectors wanted at the end of the solve.
+ * @param windowSize Largest number of Lanczos vectors kept, more than 2*nev+1.
+ */
+RitzCollector::RitzCollector(int n, int nev, int windowSize)
+{
+    if(nev < 1 || windowSize < 2*nev + 2)
+        throw std::logic_error("The Lanczos window must hold more than twice the number of Ritz vectors wanted.");
+    this->n = n;
+    this->nev = nev;
+    window = windowSize;
+    count = 0;
+    alphaOld = 0.0;
+    V.resize((long)n*window);
+    T.assign(window*window, 0.0);
+    couple.assign(window, 0.0);
+}
+
+/**
+ * Add the Lanczos vector of a CG iteration.
+ * @param z Preconditioned residual of the iteration.
+ * @param rho r'z of the iteration.
+ * @param alpha Step length of the iteration.
+ * @param beta rho/rho of the last iteration, 0 on the first iteration or
+ *        after a restart of the search direction.
+ */
+void RitzCollector::add(const double *z, double rho, double alpha, double beta)
+{
+    if(!(rho > 0.0) || !(alpha > 0.0))
+        return;
+    if(count == window)
+        restart();
+
+    //Lanczos matrix entries from the CG coefficients
+    double offDiag = 0.0;
+    double diag = 1.0/alpha;
+    if(alphaOld > 0.0 && beta > 0.0)
+    {
+        offDiag = -std::sqrt(beta)/alphaOld;
+        diag += beta/alphaOld;
+    }
+    const int c = count;
+    T[c*window + c] = diag;
+    for(int a = 0; a < c; a++)
+        T[a*window + c] = T[c*window + a] = offDiag*couple[a];
+
+    ninjaBlas::dscalCopy(n, 1.0/std::sqrt(rho), z, &V[(long)c*n]);
+
+    std::fill(couple.begin(), couple.end(), 0.0);
+    couple[c] = 1.0;
+    count++;
+    alphaOld = alpha;
+}
+
+/**
+ * Drop the vectors collected so far, used when the preconditioner changes
+ * during a solve.
+ */
+void RitzCollector::clear()
+{
+    count = 0;
+    alphaOld = 0.0;
+    std::fill(T.begin(), T.end(), 0.0);
+    std::fill(couple.begin(), couple.end(), 0.0);
+}
+
+/**
+ * Compress a full window to the Ritz vectors of the nev smallest Ritz
+ * values of the window and of the window without its last vector.
+ */
+void RitzCollector::restart()
+{
+    const int size = count;
+    std::vector<double> Y1, Y2;
+    int n1, n2;
+    smallestRitz(size, nev, Y1, n1);
+    smallestRitz(size - 1, nev, Y2, n2);
+
+    //orthonormal basis Q of [Y1 Y2], column major size x r
+    std::vector<double> Q;
+    Q.reserve(size*(n1 + n2));
+    for(int c = 0; c < n1 + n2; c++)
+    {
+        std::vector<double> q(size, 0.0);
+        if(c < n1)
+            std::copy(Y1.begin() + c*size, Y1.begin() + (c+1)*size, q.begin());
+        else
+            std::copy(Y2.begin() + (c-n1)*(size-1), Y2.begin() + (c-n1+1)*(size-1), q.begin());
+        const int r = Q.size()/size;
+        for(int pass = 0; pass < 2; pass++)
+        {
+            for(int b = 0; b < r; b++)
+            {
+                double dot = 0.0;
+                for(int a = 0; a < size; a++)
+                    dot += Q[b*size + a]*q[a];
+                for(int a = 0; a < size; a++)
+                    q[a] -= dot*Q[b*size + a];
+            }
+        }
+        double norm = 0.0;
+        for(int a = 0; a < size; a++)
+            norm += q[a]*q[a];
+        norm = std::sqrt(norm);
+        if(norm < 1E-8)
+            continue;
+        for(int a = 0; a < size; a++)
+            Q.push_back(q[a]/norm);
+    }
+    const int r = Q.size()/size;
+
+    //Rayleigh-Ritz on span(Q): H = Q'*T*Q = Z*Theta*Z', Y = Q*Z
+    std::vector<double> TQ(size*r, 0.0), H(r*r), Z;
+    for(int c = 0; c < r; c++)
+        for(int a = 0; a < size; a++)
+            for(int b = 0; b < size; b++)
+                TQ[c*size + a] += T[a*window + b]*Q[c*size + b];
+    for(int c = 0; c < r; c++)
+        for(int d = 0; d < r; d++)
+        {
+            double sum = 0.0;
+            for(int a = 0; a < size; a++)
+                sum += Q[c*size + a]*TQ[d*size + a];
+            H[c*r + d] = sum;
+        }
+    for(int c = 0; c < r; c++)
+        for(int d = c+1; d < r; d++)
+            H[c*r + d] = H[d*r + c] = 0.5*(H[c*r + d] + H[d*r + c]);
+    DeflationSpace::symmetricEigen(r, H, Z);
+
+    std::vector<double> Y(size*r, 0.0);
+    for(int c = 0; c < r; c++)
+        for(int d = 0; d < r; d++)
+            for(int a = 0; a < size; a++)
+                Y[c*size + a] += Q[d*size + a]*Z[d*r + c];
+
+    scratch.resize((long)n*r);
+    compress(size, Y, r);
+    std::copy(scratch.begin(), scratch.end(), V.begin());
+
+    //the basis is now the Ritz vectors, the projected matrix is diagonal
+    //and the next Lanczos vector couples through the last one dropped
+    std::fill(T.begin(), T.end(), 0.0);
+    std::fill(couple.begin(), couple.end(), 0.0);
+    for(int c = 0; c < r; c++)
+    {
+        T[c*window + c] = H[c*r + c];
+        couple[c] = Y[c*size + size - 1];
+    }
+    count = r;
+}
+
+/**
+ * Eigenvectors of the leading size x size block of T for its smallest
+ * eigenvalues, column major size x nFound.
+ */
+void RitzCollector::smallestRitz(int size, int nWanted, std::vector<double> &Y, int &nFound)
+{
+    std::vector<double> C(size*size), E;
+    for(int a = 0; a < size; a++)
+        for(int b = 0; b < size; b++)
+            C[a*size + b] = T[a*window + b];
+    DeflationSpace::symmetricEigen(size, C, E);
+
+    std::vector<int> order(size);
+    for(int a = 0; a < size; a++)
+        order[a] = a;
+    std::sort(order.begin(), order.end(), [&C, size](int i, int j) { return C[i*size + i] < C[j*size + j]; });
+
+    nFound = std::min(nWanted, size);
+    Y.resize(size*nFound);
+    for(int c = 0; c < nFound; c++)
+        for(int a = 0; a < size; a++)
+            Y[c*size + a] = E[a*size + order[c]];
+}
+
+/**
+ * scratch = V*Y for the first size columns of V, Y column major size x nCols.
+ * Done in blocks of rows so each column of V is read from memory only once.
+ */
+void RitzCollector::compress(int size, const std::vector<double> &Y, int nCols)
+{
+    const int blockSize = 512;
+    const int nBlocks = (n + blockSize - 1)/blockSize;
+    #pragma omp parallel for schedule(static)
+    for(int block = 0; block < nBlocks; block++)
+    {
+        const long begin = (long)block*blockSize;
+        const long end = std::min((long)n, begin + blockSize);
+        for(int c = 0; c < nCols; c++)
+            std::fill(&scratch[c*(long)n + begin], &scratch[c*(long)n + begin] + (end - begin), 0.0);
+        for(int a = 0; a < size; a++)
+        {
+            const double *v = &V[a*(long)n];
+            for(int c = 0; c < nCols; c++)
+            {
+                const double y = Y[c*size + a];
+                double *s = &scratch[c*(long)n];
+                for(long i = begin; i < end; i++)
+                    s[i] += y*v[i];
+            }
+        }
+    }
+}
+
+/**
+ * Ritz vectors of the smallest Ritz values at the end of the solve.
+ * @param U Filled with the vectors, column major n x nev.
+ * @return Number of vectors in U.
+ */
+int RitzCollector::finish(std::vector<double> &U)
+{
+    if(count < 2)
+        return 0;
+    std::vector<double> Y;
+    int nFound;
+    smallestRitz(count, nev, Y, nFound);
+    scratch.resize((long)n*nFound);
+    compress(count, Y, nFound);
+    U.swap(scratch);
+    return nFound;
+}
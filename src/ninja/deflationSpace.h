@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Deflation space recycled between solves of the CG solver
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+#ifndef DEFLATION_SPACE_H
+#define DEFLATION_SPACE_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#include "omp_guard.h"
+#endif
+
+/**
+ * Small set of approximate eigenvectors of the stiffness matrix belonging
+ * to its smallest eigenvalues, kept between solves.  ninja::solve()
+ * deflates these slowly converging modes out of the CG iterations
+ * (Saad et al., "A deflated version of the conjugate gradient algorithm",
+ * SIAM J. Sci. Comput. 21, 2000).  During each solve a RitzCollector picks
+ * up new approximate eigenvectors from the Lanczos vectors of the CG
+ * iteration, and after the solve the space is refined with the harmonic
+ * Ritz vectors of the old and new vectors together.
+ *
+ * One space can be shared by several ninjas (the army hands the same one
+ * to all runs using it), access is locked.  Any full rank set of vectors
+ * gives a correct solve, so a space from a different matrix of the same
+ * size only costs efficiency; a space of a different size is replaced.
+ */
+class DeflationSpace
+{
+public:
+    DeflationSpace(int maxVectors = 8, int windowSize = 24);
+    ~DeflationSpace();
+
+    int getMaxVectors() const;
+    int getWindowSize() const;
+    int getVectors(int n, std::vector<double> &W);
+    void update(int n, int k, const double *W, const double *AW,
+                int m, const double *U, const double *AU);
+    void clear();
+
+    static bool harmonicRitz(int size, const std::vector<double> &F, const std::vector<double> &G,
+                             int nWanted, std::vector<double> &Y, int &nFound);
+    static void symmetricEigen(int size, std::vector<double> &C, std::vector<double> &V);
+
+private:
+    int maxVectors;     //largest number of vectors kept
+    int windowSize;     //number of Lanczos vectors a RitzCollector keeps before restarting
+    int n;              //length of the vectors
+    int k;              //number of vectors currently kept
+    std::vector<double> W;  //the vectors, column major n x k, unit 2-norm
+
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+
+    //not copyable, share it through a pointer
+    DeflationSpace(const DeflationSpace &);
+    DeflationSpace &operator=(const DeflationSpace &);
+};
+
+/**
+ * Applies a set of deflation vectors W in one CG solve.  E = W'*A*W is
+ * factored once; the initial guess is corrected so that W'*r = 0 and each
+ * new search direction is made A-orthogonal to W.
+ */
+class DeflationProjector
+{
+public:
+    DeflationProjector();
+
+    bool initialize(int n, int k, const double *W, const double *AW);
+    int size() const;
+    void correctInitialGuess(double *x, double *r);
+    void deflateDirection(const double *z, double *p);
+
+private:
+    int n, k;
+    const double *W, *AW;
+    std::vector<double> L;  //Cholesky factor of E, row major k x k
+    std::vector<double> c;  //scratch coefficients
+
+    void solveE();
+};
+
+/**
+ * Collects approximate eigenvectors of the preconditioned matrix during a
+ * CG solve, after eigCG (Stathopoulos and Orginos, SIAM J. Sci. Comput.
+ * 32, 2010).  The normalized preconditioned residuals z/sqrt(r'z) are the
+ * Lanczos vectors of the iteration and the tridiagonal Lanczos matrix comes
+ * for free from the CG coefficients.  Only a window of vectors is kept;
+ * when it is full it is compressed to the Ritz vectors of the smallest
+ * Ritz values of the current and the previous step (thick restart).
+ */
+class RitzCollector
+{
+public:
+    RitzCollector(int n, int nev, int windowSize);
+
+    void add(const double *z, double rho, double alpha, double beta);
+    void clear();
+    int finish(std::vector<double> &U);
+
+private:
+    int n;
+    int nev;            //number of Ritz vectors wanted
+    int window;         //largest number of vectors kept
+    int count;          //number of vectors kept
+    double alphaOld;    //CG alpha of the last iteration
+    std::vector<double> V;      //basis, column major n x window
+    std::vector<double> T;      //projected matrix, row major window x window
+    std::vector<double> couple; //coupling of the next Lanczos vector with the basis, per unit off diagonal
+    std::vector<double> scratch;
+
+    void restart();
+    void smallestRitz(int size, int nWanted, std::vector<double> &Y, int &nFound);
+    void compress(int size, const std::vector<double> &Y, int nCols);
+};
+
+#endif /* DEFLATION_SPACE_H */
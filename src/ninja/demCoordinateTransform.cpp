@@ -0,0 +1,171 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Coordinate transformations between a DEM and lat/lon
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "demCoordinateTransform.h"
+
+#include <stdexcept>
+
+/**
+ * Read the lower left corner and the projection of a DEM.
+ * @param demFile file name of the dem.
+ * @throws std::runtime_error if the dem can't be read.
+ */
+DemCoordinateTransform::DemCoordinateTransform(const std::string &demFile)
+{
+    if(demFile.empty())
+    {
+        throw std::runtime_error("Invalid input, The input demFile is empty.");
+    }
+
+    GDALDataset *poDS = (GDALDataset*) GDALOpen( demFile.c_str(), GA_ReadOnly );
+    if(poDS == NULL)
+    {
+        throw std::runtime_error("Cannot open input demFile.");
+    }
+
+    double adfGeoTransform[6];
+    if(poDS->GetGeoTransform(adfGeoTransform) != CE_None)
+    {
+        GDALClose( (GDALDatasetH)poDS );
+        throw std::runtime_error("Could not get GeoTransform from input demFile.");
+    }
+
+    xllCorner = adfGeoTransform[0];
+    yllCorner = adfGeoTransform[3] + ( adfGeoTransform[5] * poDS->GetRasterYSize() );
+
+    if(poDS->GetProjectionRef() != NULL)
+    {
+        prjString = poDS->GetProjectionRef();
+    }
+
+    GDALClose( (GDALDatasetH)poDS );
+}
+
+DemCoordinateTransform::~DemCoordinateTransform()
+{
+    std::map<std::string, OGRCoordinateTransformation*>::iterator it;
+    for(it = toLatLonTransforms.begin(); it != toLatLonTransforms.end(); ++it)
+    {
+        if(it->second != NULL)
+            OGRCoordinateTransformation::DestroyCT(it->second);
+    }
+    for(it = fromLatLonTransforms.begin(); it != fromLatLonTransforms.end(); ++it)
+    {
+        if(it->second != NULL)
+            OGRCoordinateTransformation::DestroyCT(it->second);
+    }
+}
+
+/**
+ * Transform points from the projection of the dem to lat/lon, in place.
+ * @param n number of points.
+ * @param x x coordinates of the points, longitudes on return.
+ * @param y y coordinates of the points, latitudes on return.
+ * @param datum datum of the lat/lon coordinates.
+ * @return true if all of the points were transformed.
+ */
+bool DemCoordinateTransform::toLatLon(int n, double *x, double *y, const char *datum)
+{
+    OGRCoordinateTransformation *poCT = getTransform(datum, false);
+    if(poCT == NULL)
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Failed to generate OGRCoordinateTransformation, Failed to transform point to lat lon.");
+        return false;
+    }
+
+    if(!poCT->Transform(n, x, y))
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Failed to transform point, Failed to transform point to lat lon.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Transform points from lat/lon to the projection of the dem, in place.
+ * @param n number of points.
+ * @param x longitudes of the points, x coordinates on return.
+ * @param y latitudes of the points, y coordinates on return.
+ * @param datum datum of the lat/lon coordinates.
+ * @return true if all of the points were transformed.
+ */
+bool DemCoordinateTransform::fromLatLon(int n, double *x, double *y, const char *datum)
+{
+    OGRCoordinateTransformation *poCT = getTransform(datum, true);
+    if(poCT == NULL)
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Failed to generate OGRCoordinateTransformation, Failed to transform point from lat lon.");
+        return false;
+    }
+
+    if(!poCT->Transform(n, x, y))
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Failed to transform point, Failed to transform point from lat lon.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Get the transformation between the dem and lat/lon in datum, creating it
+ * the first time it is asked for.
+ */
+OGRCoordinateTransformation* DemCoordinateTransform::getTransform(const char *datum, bool fromLatLon)
+{
+    std::map<std::string, OGRCoordinateTransformation*> &transforms =
+        fromLatLon ? fromLatLonTransforms : toLatLonTransforms;
+
+    std::map<std::string, OGRCoordinateTransformation*>::iterator it = transforms.find(datum);
+    if(it != transforms.end())
+    {
+        return it->second;
+    }
+
+    OGRSpatialReference oDemSRS, oLatLonSRS;
+    oDemSRS.importFromWkt( prjString.c_str() );
+    oLatLonSRS.SetWellKnownGeogCS( datum );
+
+#ifdef GDAL_COMPUTE_VERSION
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+    oDemSRS.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    oLatLonSRS.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif /* GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0) */
+#endif /* GDAL_COMPUTE_VERSION */
+
+    OGRCoordinateTransformation *poCT;
+    if(fromLatLon)
+        poCT = OGRCreateCoordinateTransformation( &oLatLonSRS, &oDemSRS );
+    else
+        poCT = OGRCreateCoordinateTransformation( &oDemSRS, &oLatLonSRS );
+
+    transforms[datum] = poCT;
+    return poCT;
+}
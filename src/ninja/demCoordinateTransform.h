@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Coordinate transformations between a DEM and lat/lon
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#ifndef DEM_COORDINATE_TRANSFORM_H
+#define DEM_COORDINATE_TRANSFORM_H
+
+#include <map>
+#include <string>
+
+#include "gdal_priv.h"
+#include "ogr_spatialref.h"
+
+/**
+ * The lower left corner and the projection of a DEM, read once, with the
+ * coordinate transformations to and from lat/lon created once per datum.
+ * The transformations are done like GDALPointToLatLon() and
+ * GDALPointFromLatLon(), for any number of points at a time, so the stations
+ * of a run are located without opening the DEM or creating a transformation
+ * for each of them.  Not thread safe.
+ */
+class DemCoordinateTransform
+{
+public:
+    DemCoordinateTransform(const std::string &demFile);
+    ~DemCoordinateTransform();
+
+    inline double get_xllCorner() const { return xllCorner; }
+    inline double get_yllCorner() const { return yllCorner; }
+
+    bool toLatLon(int n, double *x, double *y, const char *datum);
+    bool fromLatLon(int n, double *x, double *y, const char *datum);
+
+private:
+    DemCoordinateTransform(const DemCoordinateTransform &);
+    DemCoordinateTransform &operator=(const DemCoordinateTransform &);
+
+    OGRCoordinateTransformation *getTransform(const char *datum, bool fromLatLon);
+
+    double xllCorner, yllCorner;
+    std::string prjString;
+
+    //by datum, NULL if the transformation can't be created
+    std::map<std::string, OGRCoordinateTransformation*> toLatLonTransforms;
+    std::map<std::string, OGRCoordinateTransformation*> fromLatLonTransforms;
+};
+
+#endif /* DEM_COORDINATE_TRANSFORM_H */
@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 #include "domainAverageInitialization.h"
+#include "terrainContext.h"
 
 domainAverageInitialization::domainAverageInitialization() : initialize()
 {
@@ -127,9 +128,12 @@ void domainAverageInitialization::initializeBoundaryLayer(WindNinjaInputs& input
 
         Solar solar(input.ninjaTime, input.latitude, input.longitude, aspect_temp, slope_temp, input.dem.getAngleFromNorth());
 
-        Aspect aspect(&input.dem, input.numberCPUs);
-        Slope slope(&input.dem, input.numberCPUs);
-        Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs);
+        boost::shared_ptr<const Aspect> pAspect = TerrainContext::getAspect(input);
+        const Aspect &aspect = *pAspect;
+        boost::shared_ptr<const Slope> pSlope = TerrainContext::getSlope(input);
+        const Slope &slope = *pSlope;
+        Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs,
+              TerrainContext::getHorizonMap(input).get());
 
         addDiurnal(input, &aspect, &slope, &shade, &solar);  
 
@@ -698,33 +698,17 @@ double element::interpolate_z(double const& x, double const& y, double const& la
 
     node_k = layer; // the layer we want to interpolate on
 
-    //initialize cell values
-    cell_i = -1;
-    cell_j = -1;
-
     //compute cell i value
-    for(node_i=1; node_i<mesh_->nrows; node_i++)
-    {
-        if(y <= mesh_->YORD(node_i, 0, 0))
-        {
-            cell_i = node_i - 1;
-            break;
-        }
-    }
+    cell_i = findCell_i(y);
     if(cell_i<0)
         throw std::range_error("Range error in element::interpolate_xy()");
+    node_i = cell_i + 1;
 
     //compute cell j value
-    for(node_j=1; node_j<mesh_->ncols; node_j++)
-    {
-        if(x <= mesh_->XORD(0, node_j, 0))
-        {
-            cell_j = node_j - 1;
-            break;
-        }
-    }
+    cell_j = findCell_j(x);
     if(cell_j<0)
         throw std::range_error("Range error in element::interpolate_xy()");
+    node_j = cell_j + 1;
 
     answer = (mesh_->ZORD(node_i-1, node_j-1, node_k) +
               mesh_->ZORD(node_i-1, node_j, node_k) +
@@ -734,6 +718,91 @@ double element::interpolate_z(double const& x, double const& y, double const& la
     return answer;
 }
 
+/**
+ * @brief Find the row of cells that contains y.
+ *
+ * The node rows of the mesh are ordered in y, so the first node row at or
+ * north of y is found by bisection.  The result is the same as scanning the
+ * rows from the south edge.
+ *
+ * @param y Requested y location in WN coordinates.
+ * @return Row index of the cell, or -1 if y is north of the mesh.
+ */
+
+int element::findCell_i(double const& y) const
+{
+    int low = 1;
+    int high = mesh_->nrows;
+    int mid;
+
+    while(low < high)
+    {
+        mid = (low + high) / 2;
+        if(y <= mesh_->YORD(mid, 0, 0))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return (low < mesh_->nrows) ? low - 1 : -1;
+}
+
+/**
+ * @brief Find the column of cells that contains x.
+ * @see element::findCell_i()
+ *
+ * @param x Requested x location in WN coordinates.
+ * @return Column index of the cell, or -1 if x is east of the mesh.
+ */
+
+int element::findCell_j(double const& x) const
+{
+    int low = 1;
+    int high = mesh_->ncols;
+    int mid;
+
+    while(low < high)
+    {
+        mid = (low + high) / 2;
+        if(x <= mesh_->XORD(0, mid, 0))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return (low < mesh_->ncols) ? low - 1 : -1;
+}
+
+/**
+ * @brief Find the layer of cells in column (cell_i, cell_j) that contains z.
+ *
+ * Each node layer is represented by the average z of the 4 corner nodes of
+ * the column.  The layers increase in z, so they are searched by bisection.
+ *
+ * @param z Requested z location in WN coordinates.
+ * @param cell_i Row index of the column.
+ * @param cell_j Column index of the column.
+ * @return Layer index of the cell, or -1 if z is above the mesh.
+ */
+
+int element::findCell_k(double const& z, const int &cell_i, const int &cell_j) const
+{
+    int low = 1;
+    int high = mesh_->nlayers;
+    int mid;
+    double zAverage;
+
+    while(low < high)
+    {
+        mid = (low + high) / 2;
+        zAverage = (mesh_->ZORD(cell_i, cell_j, mid) + mesh_->ZORD(cell_i, cell_j+1, mid) +
+                    mesh_->ZORD(cell_i+1, cell_j, mid) + mesh_->ZORD(cell_i+1, cell_j+1, mid)) / 4.0;
+        if(z <= zAverage)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return (low < mesh_->nlayers) ? low - 1 : -1;
+}
+
 /**
  * @brief Given (x,y), find cell (i,j) index.
  *
@@ -750,33 +819,13 @@ double element::interpolate_z(double const& x, double const& y, double const& la
 void element::get_ij(double const& x,double const& y,
                       int& cell_i, int& cell_j)
 {
-    int node_i, node_j;
-
-    //initialize cell values
-    cell_i = -1;
-    cell_j = -1;
-
     //compute cell i value
-    for(node_i=1; node_i<mesh_->nrows; node_i++)
-    {
-        if(y <= mesh_->YORD(node_i, 0, 0))
-        {
-            cell_i = node_i - 1;
-            break;
-        }
-    }
+    cell_i = findCell_i(y);
     if(cell_i<0)
         throw std::range_error("Range error in element::get_ij()");
 
     //compute cell j value
-    for(node_j=1; node_j<mesh_->ncols; node_j++)
-    {
-        if(x <= mesh_->XORD(0, node_j, 0))
-        {
-            cell_j = node_j - 1;
-            break;
-        }
-    }
+    cell_j = findCell_j(x);
     if(cell_j<0)
         throw std::range_error("Range error in element::get_ij()");
 
@@ -787,35 +836,13 @@ void element::get_uv(double const& x,double const& y,
                      double& u, double &v)	//Given (x,y), this function locates the cell (i,j) that the point is in AND 
 	                                                //    the internal "parent" local cell coordinates (u,v) 
 {
-	int node_i, node_j;
-
-	//initialize cell values
-	cell_i = -1;
-	cell_j = -1;
-
 	//compute cell i value
-	for(node_i=1; node_i<mesh_->nrows; node_i++)
-	{
-		if(y <= mesh_->YORD(node_i, 0, 0))
-		//if(y < mesh_->YORD(node_i, 0, 0))
-		{
-			cell_i = node_i - 1;
-			break;
-		}
-	}
+	cell_i = findCell_i(y);
 	if(cell_i<0)
 		throw std::range_error("Range error in element::get_uv()");
 
 	//compute cell j value
-	for(node_j=1; node_j<mesh_->ncols; node_j++)
-	{
-		if(x <= mesh_->XORD(0, node_j, 0))
-		//if(x < mesh_->XORD(0, node_j, 0))
-		{
-			cell_j = node_j - 1;
-			break;
-		}
-	}
+	cell_j = findCell_j(x);
 	if(cell_j<0)
 		throw std::range_error("Range error in element::get_uv()");
 
@@ -859,56 +886,18 @@ void element::get_uvw(double const& x,double const& y, double const& z,
 	                                                //    the internal "parent" local cell coordinates (u,v,w) for use in interpolation in
 	                                                //    functions such as wn_3dScalarField::interpolate().
 {
-	int node_i, node_j, node_k;
-	double zAverage, zAverage_ground;
-
-	//initialize cell values
-	cell_i = -1;
-	cell_j = -1;
-	cell_k = -1;
-
 	//compute cell i value
-	for(node_i=1; node_i<mesh_->nrows; node_i++)
-	{
-		if(y <= mesh_->YORD(node_i, 0, 0))
-		//if(y < mesh_->YORD(node_i, 0, 0))
-		{
-			cell_i = node_i - 1;
-			break;
-		}
-	}
+	cell_i = findCell_i(y);
 	if(cell_i<0)
 		throw std::range_error("Range error in element::get_uvw()");
 
 	//compute cell j value
-	for(node_j=1; node_j<mesh_->ncols; node_j++)
-	{
-		if(x <= mesh_->XORD(0, node_j, 0))
-		//if(x < mesh_->XORD(0, node_j, 0))
-		{
-			cell_j = node_j - 1;
-			break;
-		}
-	}
+	cell_j = findCell_j(x);
 	if(cell_j<0)
 		throw std::range_error("Range error in element::get_uvw()");
 
 	//compute cell k value (estimate using average of 4 points surrounding)
-	for(node_k=1; node_k<mesh_->nlayers; node_k++)
-	{	    
-		zAverage = (mesh_->ZORD(node_i-1, node_j-1, node_k) + mesh_->ZORD(node_i-1, node_j, node_k) + mesh_->ZORD(node_i, node_j-1, node_k) + mesh_->ZORD(node_i, node_j, node_k)) / 4.0; 
-		//zAverage_ground = (mesh_->ZORD(node_i-1, node_j-1, 0) + mesh_->ZORD(node_i-1, node_j, 0) + mesh_->ZORD(node_i, node_j-1, 0) + mesh_->ZORD(node_i, node_j, 0)) / 4.0; 
-
-		
-		if(z <= zAverage)
-		//if(z < zAverage)
-		{
-			cell_k = node_k - 1;
-			break;
-		}
-	}
-	
-			
+	cell_k = findCell_k(z, cell_i, cell_j);
 	if(cell_k<0)
 		throw std::range_error("Range error in element::get_uvw()");
 	
@@ -963,41 +952,14 @@ void element::get_uvw(double const& x,double const& y, double const& z,
 	                                                //    the internal "parent" local cell coordinates (u,v,w) for use in interpolation in
 	                                                //    functions such as wn_3dScalarField::interpolate().
 {
-	int node_i, node_j, node_k;
 	int cell_i, cell_j, cell_k;
-	double zAverage;
 
 	//compute cell i value
-	for(node_i=1; node_i<mesh_->nrows; node_i++)
-	{
-		if(y <= mesh_->YORD(node_i, 0, 0))
-		//if(y < mesh_->YORD(node_i, 0, 0))
-		{
-			cell_i = node_i - 1;
-			break;
-		}
-	}
+	cell_i = findCell_i(y);
 	//compute cell j value
-	for(node_j=1; node_j<mesh_->ncols; node_j++)
-	{
-		if(x <= mesh_->XORD(0, node_j, 0))
-		//if(x < mesh_->XORD(0, node_j, 0))
-		{
-			cell_j = node_j - 1;
-			break;
-		}
-	}
+	cell_j = findCell_j(x);
 	//compute cell k value (estimate using average of 4 points surrounding)
-	for(node_k=1; node_k<mesh_->nlayers; node_k++)
-	{
-		zAverage = (mesh_->ZORD(node_i-1, node_j-1, node_k) + mesh_->ZORD(node_i-1, node_j, node_k) + mesh_->ZORD(node_i, node_j-1, node_k) + mesh_->ZORD(node_i, node_j, node_k)) / 4.0; 
-		if(z <= zAverage)
-		//if(z < zAverage)
-		{
-			cell_k = node_k - 1;
-			break;
-		}
-	}
+	cell_k = findCell_k(z, cell_i, cell_j);
 	
 	interpLocalCoords(x, y, z, cell_i, cell_j, cell_k, u, v, w);
 
@@ -107,6 +107,10 @@ class element
 	    double SFNSu(const double &u, const double &v, const int &n);
 	    double SFNSv(const double &u, const double &v, const int &n);
 
+		int findCell_i(double const& y) const;	//row of cells containing y, or -1
+		int findCell_j(double const& x) const;	//column of cells containing x, or -1
+		int findCell_k(double const& z, const int &cell_i, const int &cell_j) const;	//layer of cells in column (i,j) containing z, or -1
+
 		void interpLocalCoords_xy(const double &x,const double &y,
                                   const int& cell_i, const int& cell_j,
                                   double& u, double &v);
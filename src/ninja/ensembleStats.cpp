@@ -0,0 +1,281 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Per cell statistics of the output grids of the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "ensembleStats.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include "omp_guard.h"
+#endif
+
+static const double ENSEMBLE_PI = 3.14159265358979323846;
+
+/**
+ * @param percentiles Speed percentiles to estimate, in (0, 100).
+ */
+EnsembleStats::EnsembleStats(const std::vector<double> &percentiles)
+{
+    for(unsigned int i = 0; i < percentiles.size(); i++)
+    {
+        if(percentiles[i] <= 0.0 || percentiles[i] >= 100.0)
+            throw std::range_error("Ensemble percentiles must be between 0 and 100 in EnsembleStats::EnsembleStats().");
+        this->percentiles.push_back(percentiles[i] / 100.0);
+    }
+    nRuns = 0;
+    nCols = nRows = 0;
+    xllCorner = yllCorner = cellSize = noDataValue = 0.0;
+#ifdef _OPENMP
+    omp_init_lock(&lock);
+#endif
+}
+
+EnsembleStats::~EnsembleStats()
+{
+#ifdef _OPENMP
+    omp_destroy_lock(&lock);
+#endif
+}
+
+/**
+ * Fold the output grids of a run into the statistics.  Cells that are no
+ * data in either grid are skipped.
+ * @param speed Output speed grid of the run.
+ * @param direction Output direction grid of the run, in degrees.
+ * @param prefix Path and basename of the output files, used from the first run.
+ */
+void EnsembleStats::add(const AsciiGrid<double> &speed, const AsciiGrid<double> &direction,
+                        const std::string &prefix)
+{
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    if(nRuns == 0)
+    {
+        this->prefix = prefix;
+        nCols = speed.get_nCols();
+        nRows = speed.get_nRows();
+        xllCorner = speed.get_xllCorner();
+        yllCorner = speed.get_yllCorner();
+        cellSize = speed.get_cellSize();
+        noDataValue = speed.get_NoDataValue();
+        prjString = speed.prjString;
+
+        size_t nCells = (size_t)nCols * nRows;
+        count.assign(nCells, 0);
+        mean.assign(nCells, 0.0);
+        m2.assign(nCells, 0.0);
+        maximum.assign(nCells, 0.0);
+        sumSin.assign(nCells, 0.0);
+        sumCos.assign(nCells, 0.0);
+        heights.assign(nCells * percentiles.size() * 5, 0.0);
+        positions.assign(nCells * percentiles.size() * 5, 0);
+    }
+    else if(speed.get_nCols() != nCols || speed.get_nRows() != nRows ||
+            speed.get_xllCorner() != xllCorner || speed.get_yllCorner() != yllCorner ||
+            speed.get_cellSize() != cellSize)
+    {
+        throw std::runtime_error("The output grid of the run doesn't match the grid of the ensemble statistics.");
+    }
+    if(direction.get_nCols() != nCols || direction.get_nRows() != nRows)
+        throw std::runtime_error("The output speed and direction grids of the run don't match.");
+
+    const double *s = speed.data.data();
+    const double *d = direction.data.data();
+    double speedNoData = speed.get_NoDataValue();
+    double directionNoData = direction.get_NoDataValue();
+    size_t nCells = count.size();
+    int nPercentiles = (int)percentiles.size();
+    for(size_t c = 0; c < nCells; c++)
+    {
+        double x = s[c];
+        if(x == speedNoData || d[c] == directionNoData)
+            continue;
+
+        int n = ++count[c];
+        double delta = x - mean[c];
+        mean[c] += delta / n;
+        m2[c] += delta * (x - mean[c]);
+        if(n == 1 || x > maximum[c])
+            maximum[c] = x;
+
+        double angle = d[c] * ENSEMBLE_PI / 180.0;
+        sumSin[c] += sin(angle);
+        sumCos[c] += cos(angle);
+
+        for(int k = 0; k < nPercentiles; k++)
+        {
+            size_t m = (c * nPercentiles + k) * 5;
+            addToQuantile(&heights[m], &positions[m], n, percentiles[k], x);
+        }
+    }
+    nRuns++;
+}
+
+/**
+ * Add the n-th value x to the P-square estimate of the p quantile.  The
+ * first five values are kept sorted in q, after that q holds the marker
+ * heights and pos their (zero based) positions.
+ */
+void EnsembleStats::addToQuantile(double *q, int *pos, int n, double p, double x)
+{
+    if(n <= 5)
+    {
+        int i = n - 1;
+        while(i > 0 && q[i - 1] > x)
+        {
+            q[i] = q[i - 1];
+            i--;
+        }
+        q[i] = x;
+        if(n == 5)
+        {
+            for(i = 0; i < 5; i++)
+                pos[i] = i;
+        }
+        return;
+    }
+
+    int k;
+    if(x < q[0])
+    {
+        q[0] = x;
+        k = 0;
+    }
+    else if(x >= q[4])
+    {
+        q[4] = x;
+        k = 3;
+    }
+    else
+    {
+        k = 0;
+        while(x >= q[k + 1])
+            k++;
+    }
+    for(int i = k + 1; i < 5; i++)
+        pos[i]++;
+
+    const double increments[3] = {p / 2.0, p, (1.0 + p) / 2.0};
+    for(int i = 1; i <= 3; i++)
+    {
+        double diff = (n - 1) * increments[i - 1] - pos[i];
+        if((diff >= 1.0 && pos[i + 1] - pos[i] > 1) || (diff <= -1.0 && pos[i - 1] - pos[i] < -1))
+        {
+            int sign = diff >= 0.0 ? 1 : -1;
+            //piecewise parabolic prediction, linear if it leaves the neighbours' range
+            double qp = q[i] + (double)sign / (pos[i + 1] - pos[i - 1]) *
+                        ((pos[i] - pos[i - 1] + sign) * (q[i + 1] - q[i]) / (pos[i + 1] - pos[i]) +
+                         (pos[i + 1] - pos[i] - sign) * (q[i] - q[i - 1]) / (pos[i] - pos[i - 1]));
+            if(q[i - 1] < qp && qp < q[i + 1])
+                q[i] = qp;
+            else
+                q[i] += sign * (q[i + sign] - q[i]) / (pos[i + sign] - pos[i]);
+            pos[i] += sign;
+        }
+    }
+}
+
+/**
+ * P-square estimate of the p quantile after n values, interpolated between
+ * the sorted values when there are five or fewer.
+ */
+double EnsembleStats::getQuantile(const double *q, int n, double p)
+{
+    if(n > 5)
+        return q[2];
+    double rank = p * (n - 1);
+    int i = (int)rank;
+    if(i >= n - 1)
+        return q[n - 1];
+    return q[i] + (rank - i) * (q[i + 1] - q[i]);
+}
+
+/**
+ * Write the statistics grids.
+ * @return The files written, none if no run was added.
+ */
+std::vector<std::string> EnsembleStats::write()
+{
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    std::vector<std::string> files;
+    if(nRuns == 0)
+        return files;
+
+    size_t nCells = count.size();
+    int nPercentiles = (int)percentiles.size();
+    std::vector<double> values(nCells);
+
+    writeGrid(mean, "mean_vel", 2, files);
+
+    for(size_t c = 0; c < nCells; c++)
+        values[c] = count[c] > 1 ? sqrt(m2[c] / (count[c] - 1)) : 0.0;
+    writeGrid(values, "std_vel", 2, files);
+
+    writeGrid(maximum, "max_vel", 2, files);
+
+    for(int k = 0; k < nPercentiles; k++)
+    {
+        for(size_t c = 0; c < nCells; c++)
+        {
+            if(count[c] > 0)
+                values[c] = getQuantile(&heights[(c * nPercentiles + k) * 5], count[c], percentiles[k]);
+        }
+        std::ostringstream name;
+        name << "p" << percentiles[k] * 100.0 << "_vel";
+        writeGrid(values, name.str(), 2, files);
+    }
+
+    for(size_t c = 0; c < nCells; c++)
+    {
+        double angle = atan2(sumSin[c], sumCos[c]) * 180.0 / ENSEMBLE_PI;
+        values[c] = angle < 0.0 ? angle + 360.0 : angle;
+    }
+    writeGrid(values, "mean_ang", 0, files);
+
+    return files;
+}
+
+void EnsembleStats::writeGrid(const std::vector<double> &values, const std::string &name,
+                              int numDecimals, std::vector<std::string> &files)
+{
+    AsciiGrid<double> grid(nCols, nRows, xllCorner, yllCorner, cellSize, noDataValue, prjString);
+    double *g = grid.data.data();
+    for(size_t c = 0; c < count.size(); c++)
+        g[c] = count[c] > 0 ? values[c] : noDataValue;
+
+    std::string filename = prefix + "_ensemble_" + name + ".asc";
+    grid.write_Grid(filename, numDecimals);
+    files.push_back(filename);
+}
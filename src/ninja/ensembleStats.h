@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Per cell statistics of the output grids of the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef ENSEMBLE_STATS_H
+#define ENSEMBLE_STATS_H
+
+#include <string>
+#include <vector>
+
+#include "ascii_grid.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Per cell statistics of the output speed and direction grids of the runs
+ * of an army, updated as each run finishes so the grids of the runs don't
+ * have to be kept.  Memory is a fixed number of values per cell whatever
+ * the number of runs:
+ *
+ *  - mean and standard deviation of the speed (Welford's update),
+ *  - maximum speed,
+ *  - speed percentiles, estimated with the P-square algorithm of Jain and
+ *    Chlamtac (1985), five markers per percentile, exact up to five runs,
+ *  - circular mean of the direction.
+ *
+ * All runs must have the same output grid.  write() writes the statistics
+ * as ascii grids named after the DEM of the first run, in its output
+ * directory (<dem>_ensemble_mean_vel.asc, _std_vel, _max_vel, _p90_vel...,
+ * _mean_ang).  Speeds are in the output speed units of the runs.
+ */
+class EnsembleStats
+{
+public:
+    EnsembleStats(const std::vector<double> &percentiles);
+    ~EnsembleStats();
+
+    void add(const AsciiGrid<double> &speed, const AsciiGrid<double> &direction,
+             const std::string &prefix);
+    std::vector<std::string> write();
+
+    int getNumRuns() const { return nRuns; }
+
+private:
+    std::vector<double> percentiles;    //as fractions
+    int nRuns;
+    std::string prefix;                 //path and basename of the output files
+
+    //grid of the first run
+    int nCols, nRows;
+    double xllCorner, yllCorner, cellSize, noDataValue;
+    std::string prjString;
+
+    std::vector<int> count;         //runs with data, per cell
+    std::vector<double> mean;
+    std::vector<double> m2;         //sum of squared differences from the mean
+    std::vector<double> maximum;
+    std::vector<double> sumSin;     //of the direction
+    std::vector<double> sumCos;
+    std::vector<double> heights;    //P-square markers, 5 per cell and percentile
+    std::vector<int> positions;
+
+    static void addToQuantile(double *q, int *pos, int n, double p, double x);
+    static double getQuantile(const double *q, int n, double p);
+    void writeGrid(const std::vector<double> &values, const std::string &name,
+                   int numDecimals, std::vector<std::string> &files);
+
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+
+    EnsembleStats(const EnsembleStats &);
+    EnsembleStats &operator=(const EnsembleStats &);
+};
+
+#endif /* ENSEMBLE_STATS_H */
@@ -0,0 +1,259 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Weather model grids decoded once for the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "forecastCache.h"
+#include "wxModelInitialization.h"
+
+#include <sstream>
+#include <iomanip>
+
+#include "cpl_conv.h"
+#include "cpl_error.h"
+
+ForecastCache::ForecastCache()
+{
+    mutex = CPLCreateMutex();   //created locked
+    CPLReleaseMutex(mutex);
+    cond = CPLCreateCond();
+}
+
+ForecastCache::~ForecastCache()
+{
+    CPLDestroyCond(cond);
+    CPLDestroyMutex(mutex);
+}
+
+/**
+ * Key of a time of a forecast file.  Times sort in order within a file.
+ */
+std::string ForecastCache::key(const std::string &forecastFilename,
+                               const boost::local_time::local_date_time &time)
+{
+    std::string t = time.is_not_a_date_time() ? std::string("none") :
+                    boost::posix_time::to_iso_string(time.utc_time());
+    return forecastFilename + "|" + t;
+}
+
+/**
+ * What the decoded grids depend on besides the file and time: the
+ * projection and the extent of the DEM.
+ */
+std::string ForecastCache::layout(const WindNinjaInputs &input)
+{
+    std::ostringstream os;
+    os << std::setprecision(17) << input.dem.prjString << "|"
+       << input.dem.get_xllCorner() << "|" << input.dem.get_yllCorner() << "|"
+       << input.dem.get_nCols() << "|" << input.dem.get_nRows() << "|"
+       << input.dem.get_cellSize();
+    return os.str();
+}
+
+/**
+ * Tell the cache that a run of the army needs a time of a forecast file.
+ * Warnings raised while another run decodes the time go to com.
+ */
+void ForecastCache::expect(const std::string &forecastFilename,
+                           const boost::local_time::local_date_time &time,
+                           ninjaComClass *com)
+{
+    CPLAcquireMutex(mutex, 1000.0);
+    std::string k = key(forecastFilename, time);
+    EntryIterator it = entries.find(k);
+    if(it == entries.end())
+        it = entries.insert(std::make_pair(k, Entry(forecastFilename, time, com))).first;
+    it->second.nExpected++;
+    CPLReleaseMutex(mutex);
+}
+
+/**
+ * Number of times, over all files, the runs are expected to need.
+ */
+int ForecastCache::numExpected() const
+{
+    return entries.size();
+}
+
+/**
+ * Fill the surface grids of a run, as model.setSurfaceGrids() does.  Without
+ * a cache (input.forecast) or for a time the army doesn't expect, the run
+ * decodes the grids itself.
+ */
+void ForecastCache::getSurfaceGrids(wxModelInitialization &model,
+                                    WindNinjaInputs &input,
+                                    AsciiGrid<double> &airGrid,
+                                    AsciiGrid<double> &cloudGrid,
+                                    AsciiGrid<double> &uGrid,
+                                    AsciiGrid<double> &vGrid,
+                                    AsciiGrid<double> &wGrid)
+{
+    ForecastCache *cache = input.forecast.get();
+    if(cache)
+    {
+        CPLAcquireMutex(cache->mutex, 1000.0);
+        EntryIterator it = cache->entries.find(key(input.forecastFilename, input.ninjaTime));
+        if(it != cache->entries.end() && it->second.nExpected > 0)
+        {
+            Entry &entry = it->second;
+            if(!entry.tried && !entry.decoding)
+            {
+                std::vector<EntryIterator> batch = cache->claim(it);
+                CPLReleaseMutex(cache->mutex);
+                cache->decode(model, input, batch);
+                CPLAcquireMutex(cache->mutex, 1000.0);
+            }
+            while(entry.decoding)
+                CPLCondWait(cache->cond, cache->mutex);
+
+            if(entry.grids && entry.grids->layout == layout(input))
+            {
+                airGrid = entry.grids->air;
+                cloudGrid = entry.grids->cloud;
+                uGrid = entry.grids->u;
+                vGrid = entry.grids->v;
+                wGrid = entry.grids->w;
+                if(--entry.nExpected == 0)
+                    entry.grids.reset();
+                CPLReleaseMutex(cache->mutex);
+                return;
+            }
+            entry.nExpected--;
+        }
+        CPLReleaseMutex(cache->mutex);
+    }
+    model.setSurfaceGrids(input, airGrid, cloudGrid, uGrid, vGrid, wGrid);
+}
+
+/**
+ * Mark the time of first, then the next expected times of the same file
+ * (NINJA_FORECAST_CACHE_BATCH in all, 8 by default) that nobody has decoded
+ * or is decoding, as being decoded by the calling run.  Called with the lock
+ * held.
+ */
+std::vector<ForecastCache::EntryIterator> ForecastCache::claim(EntryIterator first)
+{
+    int nBatch = std::max(1, atoi(CPLGetConfigOption("NINJA_FORECAST_CACHE_BATCH", "8")));
+    std::vector<EntryIterator> batch;
+    for(EntryIterator it = first; it != entries.end() && (int)batch.size() < nBatch &&
+          it->second.forecastFilename == first->second.forecastFilename; ++it)
+    {
+        Entry &entry = it->second;
+        if(entry.tried || entry.decoding || entry.nExpected == 0)
+            continue;
+        entry.decoding = true;
+        batch.push_back(it);
+    }
+    return batch;
+}
+
+/**
+ * Decode the claimed times, the first being the time of the calling run,
+ * without holding the lock.  The file stays open in between, so drivers
+ * that share datasets (GDALOpenShared()) read its metadata once.  Warnings
+ * for the other times go to the ninjaCom of their runs.  A failure on the
+ * time of the calling run is thrown; a failure on the other times is left
+ * for their runs to report.  Whatever was decoded is stored either way.
+ */
+void ForecastCache::decode(wxModelInitialization &model, WindNinjaInputs &input,
+                           const std::vector<EntryIterator> &batch)
+{
+    const std::string forecastFilename = batch[0]->second.forecastFilename;
+    const boost::local_time::local_date_time ninjaTime = input.ninjaTime;
+    ninjaComClass *com = input.Com;
+    std::vector<boost::shared_ptr<Grids> > decoded(batch.size());
+
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+    GDALDatasetH hDS = GDALOpenShared(forecastFilename.c_str(), GA_ReadOnly);
+    CPLPopErrorHandler();
+
+    int nDecoded = 0;
+    try
+    {
+        for(unsigned int i = 0; i < batch.size(); i++)
+        {
+            const Entry &entry = batch[i]->second;
+            boost::shared_ptr<Grids> grids(new Grids());
+            input.ninjaTime = entry.time;
+            if(i > 0 && entry.com)
+                input.Com = entry.com;
+            try
+            {
+                model.setSurfaceGrids(input, grids->air, grids->cloud,
+                                      grids->u, grids->v, grids->w);
+            }
+            catch(std::exception &e)
+            {
+                input.Com = com;
+                if(i == 0)
+                    throw;
+                CPLDebug("NINJA", "Forecast cache could not decode %s: %s",
+                         batch[i]->first.c_str(), e.what());
+                continue;
+            }
+            input.Com = com;
+            grids->layout = layout(input);
+            decoded[i] = grids;
+            nDecoded++;
+        }
+    }
+    catch(...)
+    {
+        input.Com = com;
+        input.ninjaTime = ninjaTime;
+        if(hDS)
+            GDALClose(hDS);
+        store(batch, decoded);
+        throw;
+    }
+    input.ninjaTime = ninjaTime;
+    if(hDS)
+        GDALClose(hDS);
+    store(batch, decoded);
+    CPLDebug("NINJA", "Forecast cache decoded %d time(s) of %s.",
+             nDecoded, forecastFilename.c_str());
+}
+
+/**
+ * Store the grids decoded for the claimed times, under the lock, and wake
+ * the runs waiting for them.
+ */
+void ForecastCache::store(const std::vector<EntryIterator> &batch,
+                          const std::vector<boost::shared_ptr<Grids> > &decoded)
+{
+    CPLAcquireMutex(mutex, 1000.0);
+    for(unsigned int i = 0; i < batch.size(); i++)
+    {
+        Entry &entry = batch[i]->second;
+        entry.grids = decoded[i];
+        entry.decoding = false;
+        entry.tried = true;
+    }
+    CPLCondBroadcast(cond);
+    CPLReleaseMutex(mutex);
+}
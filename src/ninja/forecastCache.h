@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Weather model grids decoded once for the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef FORECAST_CACHE_H
+#define FORECAST_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ascii_grid.h"
+#include "WindNinjaInputs.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#include <boost/date_time/local_time/local_time.hpp>
+#endif
+
+#include "cpl_multiproc.h"
+
+class wxModelInitialization;
+
+/**
+ * Surface grids of a forecast file, decoded once for the runs of an army.
+ * The army tells the cache which times of which files its runs need
+ * (expect()).  The first run that needs a file decodes its own time and the
+ * next few expected times of that file in one go, keeping the file open so
+ * the band metadata of GRIB files are only read once; the runs of those
+ * times then copy their grids out.  Decoding happens outside the lock, so
+ * runs needing other files, or other times of the same file, decode in
+ * parallel; a run whose time is being decoded by another run waits for it.
+ * Warnings raised decoding a time go to the ninjaCom of the run that expects
+ * it.  Grids are dropped once every run that expects them has taken them.
+ *
+ * Runs get the cache through WindNinjaInputs::forecast, set by
+ * ninjaArmy::startRuns().
+ */
+class ForecastCache
+{
+public:
+    ForecastCache();
+    ~ForecastCache();
+
+    void expect(const std::string &forecastFilename,
+                const boost::local_time::local_date_time &time,
+                ninjaComClass *com);
+    int numExpected() const;
+
+    static void getSurfaceGrids(wxModelInitialization &model,
+                                WindNinjaInputs &input,
+                                AsciiGrid<double> &airGrid,
+                                AsciiGrid<double> &cloudGrid,
+                                AsciiGrid<double> &uGrid,
+                                AsciiGrid<double> &vGrid,
+                                AsciiGrid<double> &wGrid);
+
+private:
+    struct Grids
+    {
+        std::string layout;     //see layout()
+        AsciiGrid<double> air, cloud, u, v, w;
+    };
+
+    struct Entry
+    {
+        std::string forecastFilename;
+        boost::local_time::local_date_time time;
+        ninjaComClass *com;             //of the first run that expects the time
+        int nExpected;                  //runs that haven't taken the grids yet
+        bool decoding;                  //a run is decoding it, outside the lock
+        bool tried;                     //decoded, or failed to
+        boost::shared_ptr<Grids> grids;
+
+        Entry(const std::string &file, const boost::local_time::local_date_time &t,
+              ninjaComClass *c)
+            : forecastFilename(file), time(t), com(c), nExpected(0),
+              decoding(false), tried(false) {}
+    };
+    typedef std::map<std::string, Entry>::iterator EntryIterator;
+
+    std::map<std::string, Entry> entries;   //by key(), so by file then time
+
+    static std::string key(const std::string &forecastFilename,
+                           const boost::local_time::local_date_time &time);
+    static std::string layout(const WindNinjaInputs &input);
+    std::vector<EntryIterator> claim(EntryIterator first);
+    void decode(wxModelInitialization &model, WindNinjaInputs &input,
+                const std::vector<EntryIterator> &batch);
+    void store(const std::vector<EntryIterator> &batch,
+               const std::vector<boost::shared_ptr<Grids> > &decoded);
+
+    CPLMutex *mutex;
+    CPLCond *cond;      //signalled when decoded grids are stored
+
+    ForecastCache(const ForecastCache &);
+    ForecastCache &operator=(const ForecastCache &);
+};
+
+#endif /* FORECAST_CACHE_H */
@@ -29,6 +29,7 @@
 
 #include "gdal_util.h"
 #include "ninja_conv.h"
+#include "gdal_utils.h"
 
 #ifndef PI
 #define PI 3.14159
@@ -1448,7 +1449,7 @@ bool GDALWarpToUtm(const char* filename, GDALDatasetH& hSrcDS, GDALDatasetH& hDs
     /* parse options */
     GDALResampleAlg eAlg = GRA_NearestNeighbour;
 
-    CPLSetConfigOption("GTIFF_DIRECT_IO", "YES");
+    CPLSetThreadLocalConfigOption("GTIFF_DIRECT_IO", "YES");
 
     GDALDriverH hDriver;
 
@@ -1597,7 +1598,7 @@ bool GDALWarpToUtm(const char* filename, GDALDatasetH& hSrcDS, GDALDatasetH& hDs
     CPLFree((void*)padfScanline);
     CPLFree((void*)pszDstWKT);
 
-    CPLSetConfigOption("GTIFF_DIRECT_IO", "NO");
+    CPLSetThreadLocalConfigOption("GTIFF_DIRECT_IO", NULL);
 
     return true;
 }
@@ -1741,3 +1742,126 @@ bool GDALWarpToWKT_GDALAutoCreateWarpedVRT( GDALDatasetH& hSrcDS, int band, GDAL
     return true;
 }
 
+/**
+ * @brief Pixel window of a dataset covering a box in geographic coordinates.
+ *
+ * The edges of the box are sampled and projected into the dataset, and the
+ * window is the bounding box of the samples, grown by two pixels and clipped
+ * to the dataset.
+ *
+ * @param poDS dataset to compute the window in
+ * @param pszWkt spatial reference of poDS, as WKT
+ * @param boundsLonLat box as north, east, south, west in degrees
+ * @param [out] window x offset, y offset, x size and y size in pixels
+ * @return true on success, false if poDS has no geotransform, the box can't
+ *         be projected into it or doesn't overlap it
+ */
+bool GDALGetPixelWindow( GDALDataset *poDS, const char *pszWkt, const double *boundsLonLat, int *window )
+{
+    if(poDS == NULL || pszWkt == NULL || pszWkt[0] == '\0')
+        return false;
+
+    double adfGeoTransform[6], adfInvGeoTransform[6];
+    if(poDS->GetGeoTransform(adfGeoTransform) != CE_None ||
+       !GDALInvGeoTransform(adfGeoTransform, adfInvGeoTransform))
+        return false;
+
+    OGRSpatialReference oSourceSRS, oTargetSRS;
+    oSourceSRS.SetWellKnownGeogCS("WGS84");
+    if(oTargetSRS.importFromWkt(pszWkt) != OGRERR_NONE)
+        return false;
+
+#ifdef GDAL_COMPUTE_VERSION
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+    oSourceSRS.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    oTargetSRS.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif /* GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0) */
+#endif /* GDAL_COMPUTE_VERSION */
+
+    OGRCoordinateTransformation *poCT;
+    poCT = OGRCreateCoordinateTransformation(&oSourceSRS, &oTargetSRS);
+    if(poCT == NULL)
+        return false;
+
+    const int nSamples = 21;    //per edge
+    double north = boundsLonLat[0];
+    double east = boundsLonLat[1];
+    double south = boundsLonLat[2];
+    double west = boundsLonLat[3];
+    std::vector<double> x(4 * nSamples), y(4 * nSamples);
+    for(int i = 0; i < nSamples; i++)
+    {
+        double f = (double)i / (nSamples - 1);
+        x[i] = west + f * (east - west);                y[i] = north;
+        x[nSamples + i] = west + f * (east - west);     y[nSamples + i] = south;
+        x[2 * nSamples + i] = west;                     y[2 * nSamples + i] = south + f * (north - south);
+        x[3 * nSamples + i] = east;                     y[3 * nSamples + i] = south + f * (north - south);
+    }
+    bool bTransformed = poCT->Transform(x.size(), &x[0], &y[0]);
+    OGRCoordinateTransformation::DestroyCT(poCT);
+    if(!bTransformed)
+        return false;
+
+    double minPixel = std::numeric_limits<double>::max();
+    double maxPixel = -std::numeric_limits<double>::max();
+    double minLine = std::numeric_limits<double>::max();
+    double maxLine = -std::numeric_limits<double>::max();
+    for(unsigned int i = 0; i < x.size(); i++)
+    {
+        double pixel, line;
+        GDALApplyGeoTransform(adfInvGeoTransform, x[i], y[i], &pixel, &line);
+        minPixel = std::min(minPixel, pixel);
+        maxPixel = std::max(maxPixel, pixel);
+        minLine = std::min(minLine, line);
+        maxLine = std::max(maxLine, line);
+    }
+
+    int xSize = poDS->GetRasterXSize();
+    int ySize = poDS->GetRasterYSize();
+    if(maxPixel < 0 || minPixel > xSize || maxLine < 0 || minLine > ySize)
+        return false;
+
+    int xOff = std::max(0, (int)std::floor(minPixel) - 2);
+    int yOff = std::max(0, (int)std::floor(minLine) - 2);
+    int xEnd = std::min(xSize, (int)std::ceil(maxPixel) + 2);
+    int yEnd = std::min(ySize, (int)std::ceil(maxLine) + 2);
+    if(xEnd <= xOff || yEnd <= yOff)
+        return false;
+
+    window[0] = xOff;
+    window[1] = yOff;
+    window[2] = xEnd - xOff;
+    window[3] = yEnd - yOff;
+    return true;
+}
+
+/**
+ * @brief Make an in memory VRT of a pixel window of a dataset.
+ *
+ * The VRT has every band of poDS, with the same band numbers, and keeps a
+ * reference to poDS, so it reads only the window from it at full resolution.
+ *
+ * @param poDS dataset to read from
+ * @param window x offset, y offset, x size and y size in pixels, see
+ *        GDALGetPixelWindow()
+ * @return the VRT, to be closed with GDALClose(), or NULL on failure
+ */
+GDALDataset* GDALCreateWindowVRT( GDALDataset *poDS, const int *window )
+{
+    char **papszArgv = NULL;
+    papszArgv = CSLAddString(papszArgv, "-of");
+    papszArgv = CSLAddString(papszArgv, "VRT");
+    papszArgv = CSLAddString(papszArgv, "-srcwin");
+    for(int i = 0; i < 4; i++)
+        papszArgv = CSLAddString(papszArgv, CPLSPrintf("%d", window[i]));
+
+    GDALTranslateOptions *psOptions = GDALTranslateOptionsNew(papszArgv, NULL);
+    CSLDestroy(papszArgv);
+    if(psOptions == NULL)
+        return NULL;
+
+    GDALDatasetH hWindowDS = GDALTranslate("", (GDALDatasetH)poDS, psOptions, NULL);
+    GDALTranslateOptionsFree(psOptions);
+
+    return (GDALDataset*)hWindowDS;
+}
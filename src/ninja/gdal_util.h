@@ -74,5 +74,7 @@ int gdalGetUtmZone (double latitude, double longitude);
 bool GDALWarpToUtm (const char* filename, GDALDatasetH& hSrcDS, GDALDatasetH& hDstDS);
 GDALDataset* gdalWarpToUtm (const char* filename, GDALDataset* pSrcDS);
 bool GDALWarpToWKT_GDALAutoCreateWarpedVRT( GDALDatasetH& hSrcDS, int band, GDALDatasetH& hDstDS, const char *pszDstWkt );
+bool GDALGetPixelWindow( GDALDataset *poDS, const char *pszWkt, const double *boundsLonLat, int *window );
+GDALDataset* GDALCreateWindowVRT( GDALDataset *poDS, const int *window );
 
 #endif /* GDAL_UTIL_H */
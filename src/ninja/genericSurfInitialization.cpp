@@ -395,7 +395,7 @@ void genericSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
     GDALClose((GDALDatasetH) poDS);
 
     // open ds one by one and warp, then write to grid
-    GDALDataset *srcDS, *wrpDS;
+    GDALDataset *srcDS, *winDS, *wrpDS;
     std::string temp;
     std::string srcWkt;
 
@@ -471,7 +471,9 @@ void genericSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
             }
         }
 
-        wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( srcDS, srcWkt.c_str(),
+        winDS = openDemWindow( srcDS, srcWkt.c_str(), input );  //only the part around the DEM
+        demWindowGuard winDSGuard( srcDS, winDS );  //closes winDS on every way out
+        wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( winDS, srcWkt.c_str(),
                                                         dstWkt.c_str(),
                                                         GRA_NearestNeighbour,
                                                         1.0, psWarpOptions );
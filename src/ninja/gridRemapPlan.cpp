@@ -0,0 +1,161 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Precomputed bilinear interpolation between two grid layouts
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "gridRemapPlan.h"
+
+GridRemapPlan::Layout::Layout(const AsciiGrid<double> &grid)
+{
+    nCols = grid.get_nCols();
+    nRows = grid.get_nRows();
+    xllCorner = grid.get_xllCorner();
+    yllCorner = grid.get_yllCorner();
+    cellSize = grid.get_cellSize();
+}
+
+bool GridRemapPlan::Layout::operator==(const Layout &other) const
+{
+    return nCols == other.nCols && nRows == other.nRows &&
+           xllCorner == other.xllCorner && yllCorner == other.yllCorner &&
+           cellSize == other.cellSize;
+}
+
+/**
+ * Compute the source cells and weights of every cell of target, exactly as
+ * AsciiGrid::interpolateGrid() does for order1.  Target cells within half a
+ * cell of the edges of source take the nearest source cell.
+ * @param source Grid the fields are interpolated from.
+ * @param target Grid the fields are interpolated onto.
+ * @throws std::range_error from AsciiGrid::get_cellIndex() if the center of
+ * a target cell is outside of source.
+ */
+GridRemapPlan::GridRemapPlan(const AsciiGrid<double> &source, const AsciiGrid<double> &target)
+    : sourceLayout(source), targetLayout(target)
+{
+    const int nCells = target.get_nRows() * target.get_nCols();
+    cell1.resize(nCells);
+    cell2.resize(nCells);
+    cell3.resize(nCells);
+    cell4.resize(nCells);
+    t.resize(nCells);
+    u.resize(nCells);
+
+    const double cs = source.get_cellSize();
+    const double xll = source.get_xllCorner();
+    const double yll = source.get_yllCorner();
+    const int nSourceCols = source.get_nCols();
+
+    double xCoord, yCoord;
+    int i, j, n;
+    for(int ii = 0; ii < target.get_nRows(); ii++)
+    {
+        for(int jj = 0; jj < target.get_nCols(); jj++)
+        {
+            n = ii * target.get_nCols() + jj;
+            target.get_cellPosition(ii, jj, &xCoord, &yCoord);
+
+            if(xCoord >= (xll + (source.get_xDimension() - (cs / 2)))
+                || xCoord <= xll + (cs / 2)
+                || yCoord >= (yll + (source.get_yDimension() - (cs / 2)))
+                || yCoord <= yll + (cs / 2))
+            {
+                //nearest cell
+                source.get_cellIndex(xCoord, yCoord, &i, &j);
+                cell1[n] = cell2[n] = cell3[n] = cell4[n] = i * nSourceCols + j;
+                t[n] = 0.0;
+                u[n] = 0.0;
+            }
+            else
+            {
+                source.get_cellIndex((xCoord - cs / 2), (yCoord - cs / 2), &i, &j);
+
+                t[n] = (yCoord - ((i * cs + (cs / 2)) + yll)) /
+                       ((((i + 1) * cs + (cs / 2)) + yll) - (((i * cs + (cs / 2))) + yll));
+                u[n] = (xCoord - ((j * cs + (cs / 2)) + xll)) /
+                       ((((j + 1) * cs + (cs / 2)) + xll) - (((j * cs + (cs / 2))) + xll));
+
+                cell1[n] = i * nSourceCols + j;
+                cell2[n] = (i + 1) * nSourceCols + j;
+                cell3[n] = (i + 1) * nSourceCols + j + 1;
+                cell4[n] = i * nSourceCols + j + 1;
+            }
+        }
+    }
+}
+
+/**
+ * Check if the plan interpolates from the layout of source onto the layout
+ * of target.
+ */
+bool GridRemapPlan::matches(const AsciiGrid<double> &source, const AsciiGrid<double> &target) const
+{
+    return sourceLayout == Layout(source) && targetLayout == Layout(target);
+}
+
+/**
+ * Interpolate source onto target, as
+ * target.interpolateFromGrid(source, AsciiGrid<double>::order1).
+ * @param source Grid with the layout the plan was made from.
+ * @param target Grid with the layout the plan was made for.
+ */
+void GridRemapPlan::apply(const AsciiGrid<double> &source, AsciiGrid<double> &target) const
+{
+    if(!matches(source, target))
+        throw std::logic_error("Grids do not match the remap plan in GridRemapPlan::apply().");
+
+    //Set noData value to be the same (since interpolation returns the noDataValue of source for missing values)
+    const double noData = source.data.getNoDataValue();
+    target.data.setNoDataValue(noData);
+
+    const double *in = source.data.data();
+    double *out = target.data.data();
+    const int nCells = static_cast<int>(t.size());
+
+    int n;
+#pragma omp parallel for default(shared) private(n)
+    for(n = 0; n < nCells; n++)
+    {
+        const double val1 = in[cell1[n]];
+        const double val2 = in[cell2[n]];
+        const double val3 = in[cell3[n]];
+        const double val4 = in[cell4[n]];
+
+        if(val1 == noData || val2 == noData || val3 == noData || val4 == noData)
+        {
+            out[n] = noData;
+        }
+        else
+        {
+            out[n] = (1 - t[n]) * (1 - u[n]) * val1
+                   + t[n] * (1 - u[n]) * val2
+                   + t[n] * u[n] * val3
+                   + (1 - t[n]) * u[n] * val4;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Precomputed bilinear interpolation between two grid layouts
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef GRID_REMAP_PLAN_H
+#define GRID_REMAP_PLAN_H
+
+#include <vector>
+
+#include "ascii_grid.h"
+
+/**
+ * Bilinear interpolation (AsciiGrid::interpolateFromGrid() with order1) from
+ * one grid layout onto another, with the source cells and weights of every
+ * target cell computed once.  Applying the plan to a field is a gather that
+ * runs in parallel over the target rows, so the fields of a weather model
+ * (temperature, cloud cover, u, v) and the time steps of a forecast army
+ * share one plan; see TerrainContext::getRemapPlan().
+ */
+class GridRemapPlan
+{
+public:
+    GridRemapPlan(const AsciiGrid<double> &source, const AsciiGrid<double> &target);
+
+    bool matches(const AsciiGrid<double> &source, const AsciiGrid<double> &target) const;
+    void apply(const AsciiGrid<double> &source, AsciiGrid<double> &target) const;
+
+private:
+    struct Layout
+    {
+        int nCols, nRows;
+        double xllCorner, yllCorner, cellSize;
+
+        Layout(const AsciiGrid<double> &grid);
+        bool operator==(const Layout &other) const;
+    };
+
+    Layout sourceLayout;
+    Layout targetLayout;
+
+    //per target cell, in the data order of the target grid: the four source
+    //cells (i,j), (i+1,j), (i+1,j+1), (i,j+1) as indices into the source
+    //data and the weights t (rows) and u (columns).  Cells near the edge of
+    //the source use its nearest cell: all four indices are the same and the
+    //weights are zero.
+    std::vector<int> cell1, cell2, cell3, cell4;
+    std::vector<double> t, u;
+};
+
+#endif /* GRID_REMAP_PLAN_H */
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Hilltop and valley bottom tracks of a DEM for cellDiurnal
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "hillDistanceMap.h"
+
+//cell sizes moved per step, must be larger than sqrt(2) to cross a cell corner to corner
+const double HillDistanceMap::stepMultiplier = 1.5;
+
+/**
+ * Track every sloped cell of dem in parallel, as compute_cellHillDist() does
+ * without the shade.
+ * @param dem Elevation to track.
+ * @param aspect Aspect of dem.
+ * @param slope Slope of dem, cells with zero slope are not tracked.
+ */
+HillDistanceMap::HillDistanceMap(const Elevation &dem, const Aspect &aspect, const Slope &slope)
+    : nCols(dem.get_nCols())
+{
+    const int nRows = dem.get_nRows();
+    const double step = stepMultiplier * dem.get_cellSize();
+    Track flat = { 0, false, 0.0 };
+    upTracks.assign(nRows * nCols, flat);
+    downTracks.assign(nRows * nCols, flat);
+    sinAlphaLocal.assign(nRows * nCols, 0.0);
+
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < nRows; i++)
+    {
+        double xComponent, yComponent, xStart, yStart, X, Y, elevOld, elevNew, dist;
+        for(int j = 0; j < nCols; j++)
+        {
+            if(slope(i,j) == 0)
+                continue;
+
+            dem.get_cellPosition(i, j, &xStart, &yStart);
+            for(int downslope = 0; downslope < 2; downslope++)
+            {
+                //downhill for upslope flow, uphill for downslope flow
+                xComponent = cos(n_to_xy(aspect(i,j))*pi/180.0);
+                yComponent = sin(n_to_xy(aspect(i,j))*pi/180.0);
+                if(downslope)
+                {
+                    xComponent = xComponent*(-1.0);
+                    yComponent = yComponent*(-1.0);
+                }
+
+                Track &track = (downslope ? downTracks : upTracks)[i * nCols + j];
+                X = xStart;
+                Y = yStart;
+                elevNew = dem(i,j);
+                do
+                {
+                    X = X + (stepMultiplier * xComponent * dem.get_cellSize());
+                    Y = Y + (stepMultiplier * yComponent * dem.get_cellSize());
+                    elevOld = elevNew;
+                    track.steps++;
+                    if(!dem.check_inBounds(X, Y))
+                    {
+                        track.leftGrid = true;
+                        break;
+                    }
+                    elevNew = dem.interpolateGrid(X, Y, AsciiGrid<double>::order1);
+                }while(downslope ? elevOld < elevNew : elevOld > elevNew);
+                track.elevation = elevOld;
+
+                if(downslope)
+                {
+                    X = xStart + (step * xComponent);
+                    Y = yStart + (step * yComponent);
+                    if(dem.check_inBounds(X, Y))
+                    {
+                        dist = std::sqrt((X - xStart)*(X - xStart) + (Y - yStart)*(Y - yStart));
+                        sinAlphaLocal[i * nCols + j] = sin(atan((fabs(dem.interpolateGrid(X, Y, AsciiGrid<double>::order1) - dem(i,j))) / dist));
+                    }
+                }
+            }
+        }
+    }
+}
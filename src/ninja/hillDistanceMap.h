@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Hilltop and valley bottom tracks of a DEM for cellDiurnal
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#ifndef HILL_DISTANCE_MAP_H
+#define HILL_DISTANCE_MAP_H
+
+#include <vector>
+
+#include "Elevation.h"
+#include "Aspect.h"
+#include "Slope.h"
+
+/**
+ * Terrain part of cellDiurnal::compute_cellHillDist() for every sloped cell
+ * of a DEM: how far the track from the cell center runs down the aspect
+ * (upslope flow, to the valley bottom) and up it (downslope flow, to the
+ * hilltop) before the terrain turns or the track leaves the grid, and the
+ * local sine of the slope angle used for downslope flow.  The tracks only
+ * depend on the terrain, so the time steps of a diurnal army share one map
+ * through TerrainContext::getHillDistances() and only check the shade along
+ * them.
+ */
+class HillDistanceMap
+{
+public:
+    HillDistanceMap(const Elevation &dem, const Aspect &aspect, const Slope &slope);
+
+    struct Track
+    {
+        int steps;          //steps taken, including the one that ended the track
+        bool leftGrid;      //the last step left the grid
+        double elevation;   //elevation one step before the end
+    };
+
+    static const double stepMultiplier;
+
+    const Track &getTrack(int i, int j, bool downslope) const
+    {
+        return (downslope ? downTracks : upTracks)[i * nCols + j];
+    }
+    double getSinAlphaLocal(int i, int j) const { return sinAlphaLocal[i * nCols + j]; }
+
+private:
+    int nCols;
+    std::vector<Track> upTracks;     //towards the valley bottom, by cell
+    std::vector<Track> downTracks;   //towards the hilltop, by cell
+    std::vector<double> sinAlphaLocal;
+};
+
+#endif /* HILL_DISTANCE_MAP_H */
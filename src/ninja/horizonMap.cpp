@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Horizon angles of a DEM by azimuth sector
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "horizonMap.h"
+#include "ninjaMathUtility.h"
+
+/**
+ * Compute the horizon of every cell of dem in parallel.  Each ray steps one
+ * cell size at a time, with the terrain interpolated bilinearly between cell
+ * centers, until it leaves the grid or no farther terrain can rise above the
+ * horizon found so far.
+ * @param dem Elevation the horizon is computed for.
+ * @param numSectors Number of azimuth sectors, evenly spaced from north.
+ * @throws std::logic_error if numSectors < 1 or dem has fewer than 2 rows or
+ *         columns.
+ */
+HorizonMap::HorizonMap(const Elevation &dem, int numSectors)
+    : nRows(dem.get_nRows()), nCols(dem.get_nCols()), numSectors(numSectors)
+{
+    if(numSectors < 1)
+        throw std::logic_error("A horizon map needs at least one sector.");
+    if(nRows < 2 || nCols < 2)
+        throw std::logic_error("A horizon map needs at least 2 rows and 2 columns.");
+
+    tangents.resize((size_t)nRows * nCols * numSectors);
+
+    //heights in cell sizes, so a ray moves one unit per step
+    const double cellSize = dem.get_cellSize();
+    std::vector<double> z((size_t)nRows * nCols);
+    double zMax = -std::numeric_limits<double>::max();
+    for(int i = 0; i < nRows; i++)
+    {
+        for(int j = 0; j < nCols; j++)
+        {
+            z[i * nCols + j] = dem.get_cellValue(i, j) / cellSize;
+            if(z[i * nCols + j] > zMax)
+                zMax = z[i * nCols + j];
+        }
+    }
+
+    std::vector<double> dx(numSectors), dy(numSectors);
+    for(int k = 0; k < numSectors; k++)
+    {
+        dx[k] = sin(k * 360.0 / numSectors * pi / 180.0);
+        dy[k] = cos(k * 360.0 / numSectors * pi / 180.0);
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < nRows; i++)
+    {
+        double z0, best, px, py, fx, fy, h;
+        int i0, j0, n;
+        for(int j = 0; j < nCols; j++)
+        {
+            z0 = z[i * nCols + j];
+            for(int k = 0; k < numSectors; k++)
+            {
+                best = 0.0;
+                for(int s = 1; zMax - z0 > best * s; s++)
+                {
+                    px = j + s * dx[k];
+                    py = i + s * dy[k];
+                    if(px < 0.0 || px > nCols - 1.0 || py < 0.0 || py > nRows - 1.0)
+                        break;
+                    j0 = std::min((int)px, nCols - 2);
+                    i0 = std::min((int)py, nRows - 2);
+                    fx = px - j0;
+                    fy = py - i0;
+                    n = i0 * nCols + j0;
+                    h = (1.0 - fy) * ((1.0 - fx) * z[n] + fx * z[n + 1]) +
+                        fy * ((1.0 - fx) * z[n + nCols] + fx * z[n + nCols + 1]);
+                    if(h - z0 > best * s)
+                        best = (h - z0) / s;
+                }
+                tangents[((size_t)i * nCols + j) * numSectors + k] = (float)best;
+            }
+        }
+    }
+}
+
+/**
+ * Tangent of the horizon angle of a cell, interpolated between the sectors
+ * around an azimuth.
+ * @param i Row of the cell.
+ * @param j Column of the cell.
+ * @param theta Azimuth in degrees from north, in projected coordinates.
+ * @return Tangent of the horizon angle, zero when no terrain is above the
+ *         cell in that direction.
+ */
+double HorizonMap::getHorizonTangent(int i, int j, double theta) const
+{
+    double sector = wrap0to360(theta) * numSectors / 360.0;
+    int k0 = (int)sector;
+    double w = sector - k0;
+    if(k0 >= numSectors)
+    {
+        k0 = 0;
+        w = 0.0;
+    }
+    int k1 = (k0 + 1) % numSectors;
+    const float *t = &tangents[((size_t)i * nCols + j) * numSectors];
+    return (1.0 - w) * t[k0] + w * t[k1];
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Horizon angles of a DEM by azimuth sector
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#ifndef HORIZON_MAP_H
+#define HORIZON_MAP_H
+
+#include <vector>
+
+#include "Elevation.h"
+
+/**
+ * Horizon of every cell of a DEM: the tangent of the highest elevation angle
+ * of the terrain seen from the cell center in each of numSectors azimuths,
+ * found by marching the DEM to its edge like Shade::track_along_ray() does
+ * towards the sun.  Once computed, the shading of the whole grid for any sun
+ * position is a lookup per cell (see Shade), so the runs of a diurnal army
+ * share one map through TerrainContext::getHorizonMap() instead of tracing
+ * the terrain for every time step.
+ */
+class HorizonMap
+{
+public:
+    HorizonMap(const Elevation &dem, int numSectors);
+
+    int getNumSectors() const { return numSectors; }
+    double getHorizonTangent(int i, int j, double theta) const;
+
+private:
+    int nRows;
+    int nCols;
+    int numSectors;
+
+    //per cell, in the data order of the DEM, numSectors tangents of the
+    //horizon angle, starting north and going clockwise (projected
+    //coordinates).  Horizons below the cell are stored as zero.
+    std::vector<float> tangents;
+};
+
+#endif /* HORIZON_MAP_H */
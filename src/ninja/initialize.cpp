@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include "initialize.h"
+#include "terrainContext.h"
 
 initialize::initialize()
 {
@@ -80,32 +81,41 @@ void initialize::initializeWindFromProfile(WindNinjaInputs &input,
                                 wn_3dScalarField& v0,
                                 wn_3dScalarField& w0)
 {
-    int i, j, k;
-//#pragma omp parallel for default(shared) firstprivate(profile) private(i,j,k)
-    for(i=0;i<input.dem.get_nRows();i++)
+    /*
+    ** Every profile is proportional to the input speed, so the shape factor
+    ** of a node (see windProfile::getShapeFactor()) scales u and v alike and
+    ** the w profile of a zero input speed adds nothing.
+    */
+#pragma omp parallel default(shared)
     {
-        for(j=0;j<input.dem.get_nCols();j++)
+        windProfile columnProfile = profile;
+        int i, j, k;
+        double factor;
+
+#pragma omp for
+        for(i=0;i<input.dem.get_nRows();i++)
         {
-            profile.ObukovLength = L(i,j);
-            profile.ABL_height = bl_height(i,j);
-            profile.Roughness = input.surface.Roughness(i,j);
-            profile.Rough_h = input.surface.Rough_h(i,j);
-            profile.Rough_d = input.surface.Rough_d(i,j);
-            profile.inputWindHeight = input.inputWindHeight;
-
-            for(k=0;k<mesh.nlayers;k++)
+            for(j=0;j<input.dem.get_nCols();j++)
             {
-                //this is height above THE GROUND!! (not "z=0" for the log profile)
-                profile.AGL=mesh.ZORD(i, j, k)-input.dem(i,j);
-
-                profile.inputWindSpeed = uInitializationGrid(i,j);
-                u0(i, j, k) += profile.getWindSpeed();
-
-                profile.inputWindSpeed = vInitializationGrid(i,j);
-                v0(i, j, k) += profile.getWindSpeed();
-
-                profile.inputWindSpeed = 0.0;
-                w0(i, j, k) += profile.getWindSpeed();
+                columnProfile.ObukovLength = L(i,j);
+                columnProfile.ABL_height = bl_height(i,j);
+                columnProfile.Roughness = input.surface.Roughness(i,j);
+                columnProfile.Rough_h = input.surface.Rough_h(i,j);
+                columnProfile.Rough_d = input.surface.Rough_d(i,j);
+                columnProfile.inputWindHeight = input.inputWindHeight;
+                columnProfile.setColumn();
+
+                const double uInput = uInitializationGrid(i,j);
+                const double vInput = vInitializationGrid(i,j);
+                const double ground = input.dem(i,j);
+
+                for(k=0;k<mesh.nlayers;k++)
+                {
+                    //this is height above THE GROUND!! (not "z=0" for the log profile)
+                    factor = columnProfile.getShapeFactor(mesh.ZORD(i, j, k)-ground);
+                    u0(i, j, k) += uInput*factor;
+                    v0(i, j, k) += vInput*factor;
+                }
             }
         }
     }
@@ -123,9 +133,12 @@ void initialize::initializeBoundaryLayer(WindNinjaInputs& input)
         double slope_temp = 0;	//just placeholder, basically
 
         Solar solar(input.ninjaTime, input.latitude, input.longitude, aspect_temp, slope_temp, input.dem.getAngleFromNorth());
-        Aspect aspect(&input.dem, input.numberCPUs);
-        Slope slope(&input.dem, input.numberCPUs);
-        Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs);
+        boost::shared_ptr<const Aspect> pAspect = TerrainContext::getAspect(input);
+        const Aspect &aspect = *pAspect;
+        boost::shared_ptr<const Slope> pSlope = TerrainContext::getSlope(input);
+        const Slope &slope = *pSlope;
+        Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs,
+              TerrainContext::getHorizonMap(input).get());
 
         addDiurnal(input, &aspect, &slope, &shade, &solar);
 
@@ -173,40 +186,47 @@ void initialize::initializeBoundaryLayer(WindNinjaInputs& input)
 void initialize::addDiurnal(WindNinjaInputs& input, Aspect const* asp, Slope const* slp,
                             Shade const* shd, Solar *inSolar) 
 {
+	boost::shared_ptr<const HillDistanceMap> hillDistances = TerrainContext::getHillDistances(input);
 	cellDiurnal cDiurnal(&input.dem, shd, inSolar, input.dem.getAngleFromNorth(), input.downDragCoeff,
                              input.downEntrainmentCoeff, input.upDragCoeff,
                              input.upEntrainmentCoeff);
-
-	double u_, v_, w_, height_, L_, U_star_, BL_height_, Xord, Yord, WindSpeed;
-	int i,j;
+	cDiurnal.hillDistances = hillDistances.get();
 
 	// DO THE WORK
-//	#pragma omp parallel for default(none) private(i,j,u_,v_,w_,height_,L_,U_star_,BL_height_, Xord, Yord, WindSpeed, Z) firstprivate(cDiurnal) shared(input.dem,uDiurnal,vDiurnal,wDiurnal,height,L,u_star,bl_height, airTempGrid, asp, cloudCoverGrid, slp, input.surface)
-    for(i = 0; i < input.dem.get_nRows(); i++)
+	// cellDiurnal keeps the state of the cell it computes, so each thread
+	// works with its own copy
+#pragma omp parallel default(shared)
     {
-        for(j = 0; j < input.dem.get_nCols(); j++)
+        cellDiurnal threadDiurnal(cDiurnal);
+        double u_, v_, w_, height_, L_, U_star_, BL_height_, Xord, Yord, WindSpeed;
+
+#pragma omp for schedule(dynamic)
+        for(int i = 0; i < input.dem.get_nRows(); i++)
         {
-            WindSpeed = speedInitializationGrid(i,j);
-
-            input.dem.get_cellPosition(i, j, &Xord, &Yord);
-
-            cDiurnal.initialize(Xord, Yord, (*asp)(i,j),(*slp)(i,j),
-                    cloudCoverGrid(i,j), airTempGrid(i,j), WindSpeed, input.surface.Z,
-                    input.surface.Albedo(i,j), input.surface.Bowen(i,j),
-                    input.surface.Cg(i,j), input.surface.Anthropogenic(i,j),
-                    input.surface.Roughness(i,j), input.surface.Rough_h(i,j),
-                    input.surface.Rough_d(i,j));
-
-            cDiurnal.compute_cell_diurnal_wind(i, j, &u_, &v_, &w_,
-                    &height_, &L_, &U_star_, &BL_height_);
-
-            uDiurnal.set_cellValue(i, j, u_);
-            vDiurnal.set_cellValue(i, j, v_);
-            wDiurnal.set_cellValue(i, j, w_);
-            height.set_cellValue(i, j, height_);
-            L.set_cellValue(i, j, L_);
-            u_star.set_cellValue(i, j, U_star_);
-            bl_height.set_cellValue(i, j, BL_height_);
+            for(int j = 0; j < input.dem.get_nCols(); j++)
+            {
+                WindSpeed = speedInitializationGrid(i,j);
+
+                input.dem.get_cellPosition(i, j, &Xord, &Yord);
+
+                threadDiurnal.initialize(Xord, Yord, (*asp)(i,j),(*slp)(i,j),
+                        cloudCoverGrid(i,j), airTempGrid(i,j), WindSpeed, input.surface.Z,
+                        input.surface.Albedo(i,j), input.surface.Bowen(i,j),
+                        input.surface.Cg(i,j), input.surface.Anthropogenic(i,j),
+                        input.surface.Roughness(i,j), input.surface.Rough_h(i,j),
+                        input.surface.Rough_d(i,j));
+
+                threadDiurnal.compute_cell_diurnal_wind(i, j, &u_, &v_, &w_,
+                        &height_, &L_, &U_star_, &BL_height_);
+
+                uDiurnal.set_cellValue(i, j, u_);
+                vDiurnal.set_cellValue(i, j, v_);
+                wDiurnal.set_cellValue(i, j, w_);
+                height.set_cellValue(i, j, height_);
+                L.set_cellValue(i, j, L_);
+                u_star.set_cellValue(i, j, U_star_);
+                bl_height.set_cellValue(i, j, BL_height_);
+            }
         }
     }
 }
@@ -218,24 +238,28 @@ void initialize::addDiurnalComponent(WindNinjaInputs &input,
                                     wn_3dScalarField& w0)
 {
     int i, j, k;
-    double AGL=0; //height above top of roughness elements
-#pragma omp parallel for default(shared) private(i,j,k,AGL)
-    //start at 1, not zero because ground nodes must be zero for boundary conditions to work properly
-    for(k=1;k<mesh.nlayers;k++)	
+    double top; //highest node height (above THE GROUND) that gets the diurnal wind
+    /*
+    ** Node heights grow with k, so a column only gets the diurnal wind up to
+    ** the first node at or above the diurnal layer.
+    */
+#pragma omp parallel for default(shared) private(i,j,k,top)
+    for(i=0;i<mesh.nrows;i++)
     {
-        for(i=0;i<mesh.nrows;i++)
+        for(j=0;j<mesh.ncols;j++)
         {
-            for(j=0;j<mesh.ncols;j++)
+            //height above top of roughness elements is below height(i,j)
+            top = input.dem(i,j) + input.surface.Rough_d(i,j) + height(i,j);
+            const double u_ = uDiurnal(i,j);
+            const double v_ = vDiurnal(i,j);
+            const double w_ = wDiurnal(i,j);
+
+            //start at 1, not zero because ground nodes must be zero for boundary conditions to work properly
+            for(k=1;k<mesh.nlayers && mesh.ZORD(i, j, k) < top;k++)
             {
-                //this is height above THE GROUND!! (not "z=0" for the log profile)
-                AGL=mesh.ZORD(i, j, k)-input.dem(i,j);
-
-                if((AGL - input.surface.Rough_d(i,j)) < height(i,j))
-                {
-                    u0(i, j, k) += uDiurnal(i,j);
-                    v0(i, j, k) += vDiurnal(i,j);
-                    w0(i, j, k) += wDiurnal(i,j);
-                }
+                u0(i, j, k) += u_;
+                v0(i, j, k) += v_;
+                w0(i, j, k) += w_;
             }
         }
     }
@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 #include "mesh.h"
+#include "terrainContext.h"
 
 Mesh::Mesh()
 {
@@ -250,17 +251,28 @@ void Mesh::buildStandardMesh(WindNinjaInputs& input)
 
     //Resample DEM to desired computational resolution
     //NOTE: DEM IS THE ELEVATION ABOVE SEA LEVEL
-    if(meshResolution < input.dem.get_cellSize())
+    //Runs sharing their terrain (see TerrainContext) resample it only once
     {
-        //std::cout << "buildStandardMesh, finer" << std::endl;
-        input.dem.resample_Grid_in_place(meshResolution, Elevation::order1); //make the grid finer
-        input.surface.resample_in_place(meshResolution, AsciiGrid<double>::order1); //make the grid finer
-    }else if(meshResolution > input.dem.get_cellSize())
-    {
-        //std::cout << "buildStandardMesh, coarser" << std::endl;
-        input.dem.resample_Grid_in_place(meshResolution, Elevation::order0); //coarsen the grid
-        input.surface.resample_in_place(meshResolution, AsciiGrid<double>::order0); //coarsen the grids
+        TerrainContext *terrain = input.dem.fileName.empty() ? NULL : input.terrain.get();
+        TerrainContext::Guard guard(terrain);
+        if(terrain == NULL || !terrain->copyResampled(input, meshResolution))
+        {
+            if(meshResolution < input.dem.get_cellSize())
+            {
+                //std::cout << "buildStandardMesh, finer" << std::endl;
+                input.dem.resample_Grid_in_place(meshResolution, Elevation::order1); //make the grid finer
+                input.surface.resample_in_place(meshResolution, AsciiGrid<double>::order1); //make the grid finer
+            }else if(meshResolution > input.dem.get_cellSize())
+            {
+                //std::cout << "buildStandardMesh, coarser" << std::endl;
+                input.dem.resample_Grid_in_place(meshResolution, Elevation::order0); //coarsen the grid
+                input.surface.resample_in_place(meshResolution, AsciiGrid<double>::order0); //coarsen the grids
+            }
+            if(terrain)
+                terrain->storeResampled(input, meshResolution);
+        }
     }
+    TerrainContext::releaseInputs(input);
 
     nrows = input.dem.get_nRows();
     ncols = input.dem.get_nCols();
@@ -808,6 +820,58 @@ void Mesh::compute_cellsize(Elevation& dem)
     //printf("resulting meshResolution = %.12g\n",meshResolution);
 }
 
+/**
+ * Estimate the dimensions of the standard mesh before it is built.  Uses the
+ * mesh resolution if it is set, otherwise the resolution compute_cellsize()
+ * would choose, and 20 layers if the number of layers isn't set yet.  Used
+ * by ninjaArmy to schedule runs, before the runs read their DEM.
+ * @param xDimension Width of the DEM the mesh will be built on.
+ * @param yDimension Height of the DEM the mesh will be built on.
+ * @param nrowsEstimate Estimated number of rows of nodes.
+ * @param ncolsEstimate Estimated number of columns of nodes.
+ * @param nlayersEstimate Estimated number of layers of nodes.
+ * @return false if the resolution can't be determined.
+ */
+bool Mesh::estimate_size(double xDimension, double yDimension, long& nrowsEstimate, long& ncolsEstimate, long& nlayersEstimate) const
+{
+    nrowsEstimate = ncolsEstimate = nlayersEstimate = 0;
+
+    double Xlength = xDimension;
+    double Ylength = yDimension;
+    if(Xlength <= 0.0 || Ylength <= 0.0)
+        return false;
+
+    double resolution = meshResolution;
+    if(resolution <= 0.0)
+    {
+        if(targetNumHorizCells <= 0)
+            return false;
+        double nXcells = 2*std::sqrt((double)targetNumHorizCells)*(Xlength/(Xlength+Ylength));
+        double nYcells = 2*std::sqrt((double)targetNumHorizCells)*(Ylength/(Xlength+Ylength));
+        resolution = (Xlength/nXcells + Ylength/nYcells)/2;
+    }
+
+    ncolsEstimate = std::max(2L, (long)(Xlength/resolution + 0.5));
+    nrowsEstimate = std::max(2L, (long)(Ylength/resolution + 0.5));
+    nlayersEstimate = numVertLayers > 0 ? numVertLayers : 20;
+    return true;
+}
+
+/**
+ * Estimate the number of nodes of the standard mesh before it is built,
+ * see estimate_size().
+ * @param xDimension Width of the DEM the mesh will be built on.
+ * @param yDimension Height of the DEM the mesh will be built on.
+ * @return Estimated number of nodes, 0 if the resolution can't be determined.
+ */
+long Mesh::estimate_numNodes(double xDimension, double yDimension) const
+{
+    long nrowsEstimate, ncolsEstimate, nlayersEstimate;
+    if(!estimate_size(xDimension, yDimension, nrowsEstimate, ncolsEstimate, nlayersEstimate))
+        return 0;
+    return nrowsEstimate*ncolsEstimate*nlayersEstimate;
+}
+
 /*
 ** Compute the domain height for the mesh.
 **
@@ -94,6 +94,8 @@ public:
     void set_targetNumHorizCells(long cells);     //sets the target number of horizontal cells in the mesh and computes the cellsize
     void set_meshResChoice(eMeshChoice choice);               //sets the cellsize based on user selection of coarse, medium, or fine (and returns the cellsize, on error returns cellsize < 0)
     void compute_cellsize(Elevation& dem);                  //utility function to compute the horizontal cellsize given a target number of horizontal cells (and DEM)
+    bool estimate_size(double xDimension, double yDimension, long& nrowsEstimate, long& ncolsEstimate, long& nlayersEstimate) const;   //estimate of the mesh dimensions before it is built
+    long estimate_numNodes(double xDimension, double yDimension) const;     //estimate of NUMNP before the mesh is built (0 if it can't be estimated)
     void compute_domain_height(WindNinjaInputs& input);
     void set_domainHeight(double height, lengthUnits::eLengthUnits units);
     void set_numVertLayers(long layers);
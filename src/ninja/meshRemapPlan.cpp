@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Precomputed interpolation from a weather model mesh to a WindNinja mesh
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+
+#include "meshRemapPlan.h"
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * Locate every node of target in source.
+ * @param source Weather model mesh the fields are interpolated from.
+ * @param target WindNinja mesh the fields are interpolated onto.
+ * @throws std::range_error if a target node is outside of source.
+ */
+MeshRemapPlan::MeshRemapPlan(const Mesh &source, const Mesh &target)
+    : sourceMesh(&source)
+{
+    cell.assign(target.NUMNP, -1);
+    u.assign(target.NUMNP, 0.0);
+    v.assign(target.NUMNP, 0.0);
+    w.assign(target.NUMNP, 0.0);
+
+    const int top = target.nlayers - 1;
+
+    //exceptions can't leave the parallel loop, the first problem is thrown after it
+    std::string problem;
+#pragma omp parallel default(shared)
+    {
+        element elem_wx(&source);
+        int elem_wx_i, elem_wx_j, elem_wx_k;
+        int i, j, k, n;
+        double x, y, z;
+        double x_ground, y_ground, z_wx_ground, z_wx;
+        double wnNormDistance, wxNormDistance, normDist;
+
+#pragma omp for
+        for(i = 0; i < target.nrows; i++)
+        {
+            try
+            {
+                for(j = 0; j < target.ncols; j++)
+                {
+                    x_ground = target.XORD(i, j, 0);
+                    y_ground = target.YORD(i, j, 0);
+                    z_wx_ground = groundElevation(elem_wx, source, x_ground, y_ground);
+
+                    wnNormDistance = target.ZORD(i, j, top) - target.ZORD(i, j, 0); //distance from WN ground to Ztop
+                    wxNormDistance = target.ZORD(i, j, top) - z_wx_ground; //distance from WX ground to Ztop
+
+                    //don't interpolate over ground nodes in layer 0 of WN mesh
+                    for(k = 1; k < target.nlayers; k++)
+                    {
+                        x = target.XORD(i, j, k);
+                        y = target.YORD(i, j, k);
+                        if(x == x_ground && y == y_ground)
+                            z_wx = z_wx_ground;
+                        else
+                            z_wx = groundElevation(elem_wx, source, x, y);
+
+                        normDist = (target.ZORD(i, j, k) - target.ZORD(i, j, 0)) / wnNormDistance; //compute normalized distance (0-1)
+                        z = normDist * wxNormDistance; //compute height above ground in wx mesh
+                        z += z_wx; // add height above ground to wx model ground height
+
+                        n = k * target.nrows * target.ncols + i * target.ncols + j;
+                        elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u[n], v[n], w[n]);
+
+                        if(elem_wx_k >= 1) //use log profile to fill below here later
+                            cell[n] = source.get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
+                    }
+                }
+            }
+            catch(std::exception &e)
+            {
+#pragma omp critical
+                problem = e.what();
+            }
+        }
+    }
+    if(!problem.empty())
+        throw std::range_error(problem);
+}
+
+/**
+ * Interpolate source onto target, as source.interpolateScalarData(target, ...).
+ * @param source Field on the mesh the plan was made from.
+ * @param target Field on the mesh the plan was made for.
+ */
+void MeshRemapPlan::apply(const wn_3dScalarField &source, wn_3dScalarField &target) const
+{
+    const int nNodes = static_cast<int>(cell.size());
+
+    int n;
+#pragma omp parallel default(shared) private(n)
+    {
+        element elem(sourceMesh);
+        int cell_i, cell_j, cell_k;
+        double value;
+
+#pragma omp for
+        for(n = 0; n < nNodes; n++)
+        {
+            if(cell[n] < 0)
+            {
+                target(n) = -9999.0;
+                continue;
+            }
+
+            sourceMesh->get_elemIndex(cell[n], cell_i, cell_j, cell_k);
+            value = 0.0;
+            for(int k = 0; k < sourceMesh->NNPE; k++) //Start loop over nodes in the element
+            {
+                value = value + elem.SFNV(u[n], v[n], w[n], k) *
+                        source(sourceMesh->get_global_node(k, cell_i, cell_j, cell_k));
+            }
+            target(n) = value;
+        }
+    }
+}
+
+/**
+ * Elevation of the ground of mesh at (x,y).
+ */
+double MeshRemapPlan::groundElevation(element &elem, const Mesh &mesh,
+                                      const double &x, const double &y)
+{
+    int cell_i, cell_j;
+    double u_ground, v_ground;
+    double x_ground, y_ground, z_ground;
+
+    elem.get_uv(x, y, cell_i, cell_j, u_ground, v_ground);
+    elem.get_xyz(mesh.get_elemNum(cell_i, cell_j, 0), u_ground, v_ground, -1.0,
+                 x_ground, y_ground, z_ground);
+    return z_ground;
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Precomputed interpolation from a weather model mesh to a WindNinja mesh
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef MESH_REMAP_PLAN_H
+#define MESH_REMAP_PLAN_H
+
+#include <vector>
+
+#include "mesh.h"
+#include "element.h"
+#include "wn_3dScalarField.h"
+
+/**
+ * Interpolation of a 3d field from a weather model mesh onto the WindNinja
+ * mesh, as done by wn_3dScalarField::interpolateScalarData(), with the source
+ * cell and the parent cell coordinates (u,v,w) of every target node located
+ * once.  The nodes are placed in the source mesh with the normalized distance
+ * method: the height of a node between the WindNinja ground and the top of
+ * the domain is scaled to the distance between the weather model ground and
+ * the top of the domain.  Applying the plan is a gather that runs in parallel
+ * over the target nodes, so all fields on one source mesh share one plan.
+ */
+class MeshRemapPlan
+{
+public:
+    MeshRemapPlan(const Mesh &source, const Mesh &target);
+
+    void apply(const wn_3dScalarField &source, wn_3dScalarField &target) const;
+
+private:
+    static double groundElevation(element &elem, const Mesh &mesh,
+                                  const double &x, const double &y);
+
+    const Mesh *sourceMesh;
+
+    //per target node, in the node order of the target mesh: the source element
+    //containing the node and its parent cell coordinates.  Nodes in the ground
+    //layer of the target or below the first layer of source have no element
+    //(-1) and are set to -9999 to be filled from a profile later.
+    std::vector<int> cell;
+    std::vector<double> u, v, w;
+};
+
+#endif /* MESH_REMAP_PLAN_H */
@@ -306,7 +306,7 @@ void ncepHrrrSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
     std::string dstWkt;
     dstWkt = input.dem.prjString;
 
-    GDALDataset *wrpDS;
+    GDALDataset *winDS, *wrpDS;
     std::string temp;
     std::string srcWkt;
 
@@ -369,7 +369,9 @@ void ncepHrrrSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
         }
     }
 
-    wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( srcDS, srcWkt.c_str(),
+    winDS = openDemWindow( srcDS, srcWkt.c_str(), input );  //only the part around the DEM
+    demWindowGuard winDSGuard( srcDS, winDS );  //closes winDS on every way out
+    wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( winDS, srcWkt.c_str(),
                                                     dstWkt.c_str(),
                                                     GRA_NearestNeighbour,
                                                     1.0, psWarpOptions );
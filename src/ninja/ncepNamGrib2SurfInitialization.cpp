@@ -215,7 +215,7 @@ void ncepNamGrib2SurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
     std::string dstWkt;
     dstWkt = input.dem.prjString;
 
-    GDALDataset *srcDS, *wrpDS;
+    GDALDataset *srcDS, *winDS, *wrpDS;
     std::string temp;
     std::string srcWkt;
 
@@ -294,7 +294,9 @@ void ncepNamGrib2SurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
         }
     }
 
-    wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( srcDS, srcWkt.c_str(),
+    winDS = openDemWindow( srcDS, srcWkt.c_str(), input );  //only the part around the DEM
+    demWindowGuard winDSGuard( srcDS, winDS );  //closes winDS on every way out
+    wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( winDS, srcWkt.c_str(),
                                                     dstWkt.c_str(),
                                                     GRA_NearestNeighbour,
                                                     1.0, psWarpOptions );
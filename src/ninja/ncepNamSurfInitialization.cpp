@@ -436,7 +436,7 @@ void ncepNamSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
     GDALClose((GDALDatasetH) poDS);
 
     // open ds one by one and warp, then write to grid
-    GDALDataset *srcDS, *wrpDS;
+    GDALDataset *srcDS, *winDS, *wrpDS;
     std::string temp;
     std::string srcWkt;
 
@@ -514,7 +514,9 @@ void ncepNamSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
 
         // FIXME(kyle): valgrind reporting memory leak as psWarpOptions is
         // cloned internally and then not freed
-        wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( srcDS, srcWkt.c_str(),
+        winDS = openDemWindow( srcDS, srcWkt.c_str(), input );  //only the part around the DEM
+        demWindowGuard winDSGuard( srcDS, winDS );  //closes winDS on every way out
+        wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( winDS, srcWkt.c_str(),
                                                         dstWkt.c_str(),
                                                         GRA_NearestNeighbour,
                                                         1.0, psWarpOptions );
@@ -38,6 +38,7 @@ ninja::ninja()
 {
     cancel = false;
     alphaH = 1.0;
+    keepUvwGrids = false;
     isNullRun = false;
     maxStartingOuterDiff = -1.0;
     matchTol = 0.22;    //0.22 m/s is about 1/2 mph
@@ -96,6 +97,9 @@ ninja::ninja(const ninja &rhs)
 : AngleGrid(rhs.AngleGrid)
 , VelocityGrid(rhs.VelocityGrid)
 , CloudGrid(rhs.CloudGrid)
+, UGrid(rhs.UGrid)
+, VGrid(rhs.VGrid)
+, WGrid(rhs.WGrid)
 #ifdef NINJAFOAM
 , TurbulenceGrid(rhs.TurbulenceGrid)
 , colMaxGrid(rhs.colMaxGrid)
@@ -119,6 +123,7 @@ ninja::ninja(const ninja &rhs)
 {
     cancel = rhs.cancel;
     alphaH = rhs.alphaH;
+    keepUvwGrids = rhs.keepUvwGrids;
     isNullRun = rhs.isNullRun;
     maxStartingOuterDiff = rhs.maxStartingOuterDiff;
     nMaxMatchingIters = rhs.nMaxMatchingIters;
@@ -126,6 +131,11 @@ ninja::ninja(const ninja &rhs)
     num_outer_iter_tries_u = rhs.num_outer_iter_tries_u;
     num_outer_iter_tries_v = rhs.num_outer_iter_tries_v;
     num_outer_iter_tries_w = rhs.num_outer_iter_tries_w;
+    deflationSpace = rhs.deflationSpace;
+    outputQueue = rhs.outputQueue;
+    resultCache = rhs.resultCache;
+    runJournal = rhs.runJournal;
+    ensembleStats = rhs.ensembleStats;
 
     //Timers
     startTotal=0.0;
@@ -172,6 +182,9 @@ ninja &ninja::operator=(const ninja &rhs)
         AngleGrid = rhs.AngleGrid;
         VelocityGrid = rhs.VelocityGrid;
         CloudGrid = rhs.CloudGrid;
+        UGrid = rhs.UGrid;
+        VGrid = rhs.VGrid;
+        WGrid = rhs.WGrid;
 #ifdef NINJAFOAM
         TurbulenceGrid = rhs.TurbulenceGrid;
         colMaxGrid = rhs.colMaxGrid;
@@ -196,6 +209,7 @@ ninja &ninja::operator=(const ninja &rhs)
 
         cancel = rhs.cancel;
         alphaH = rhs.alphaH;
+        keepUvwGrids = rhs.keepUvwGrids;
         isNullRun = rhs.isNullRun;
         maxStartingOuterDiff = rhs.maxStartingOuterDiff;
         nMaxMatchingIters = rhs.nMaxMatchingIters;
@@ -203,6 +217,11 @@ ninja &ninja::operator=(const ninja &rhs)
         num_outer_iter_tries_u = rhs.num_outer_iter_tries_u;
         num_outer_iter_tries_v = rhs.num_outer_iter_tries_v;
         num_outer_iter_tries_w = rhs.num_outer_iter_tries_w;
+        deflationSpace = rhs.deflationSpace;
+        outputQueue = rhs.outputQueue;
+        resultCache = rhs.resultCache;
+        runJournal = rhs.runJournal;
+        ensembleStats = rhs.ensembleStats;
 
         //Timers
         startTotal=0.0;
@@ -269,6 +288,32 @@ bool ninja::simulate_wind()
         keepOutputGridsInMemory(true);
     }
 
+    /*
+    ** Skip a run done before the army was restarted, see RunJournal (not
+    ** for runs that keep their grids in memory or add them to the ensemble
+    ** statistics, they aren't in the journal), or reuse the output grids of
+    ** an identical earlier run, see ResultCache.
+    */
+    std::string cacheKey;
+    journalKey.clear();
+    bool useJournal = runJournal && !input.keepOutGridsInMemory && !ensembleStats;
+    if(resultCache || useJournal)
+    {
+        std::string inputKey = ResultCache::computeKey(input, mesh, deflationSpace.get());
+        if(useJournal && !inputKey.empty())
+        {
+            journalKey = RunJournal::computeKey(inputKey, input);
+            if(skipJournaledRun())
+                return true;
+        }
+        if(resultCache)
+        {
+            cacheKey = inputKey;
+            if(!cacheKey.empty() && reuseCachedResult(cacheKey))
+                return true;
+        }
+    }
+
 	#ifdef _OPENMP
 	input.Com->ninjaCom(ninjaComClass::ninjaNone, "Run number %d started with %d threads.", input.inputsRunNumber, input.numberCPUs);
 	#endif
@@ -277,13 +322,18 @@ bool ninja::simulate_wind()
 		startTotal = omp_get_wtime();
 	#endif
 
+	solverStats.clear();
+	solverStatsJson.clear();
+
 	 //taucs_double *SK;
 
 /*  ----------------------------------------*/
 /*  USER INPUTS                             */
 /*  ----------------------------------------*/
      int MAXITS = 100000;             //MAXITS is the maximum number of iterations in the solver
-     double stop_tol = 1E-1;          //stopping criteria for iterations (2-norm of residual)
+     double stop_tol = input.solverTolerance;   //stopping criteria for iterations (2-norm of residual), default 1E-1
+     if(input.solverMaxIterations > 0)
+         MAXITS = input.solverMaxIterations;    //iteration budget, see ninja::solve()
      int print_iters = 10;          //Iterations to print out
     /*
     ** Set matching its from config options, default to 150.
@@ -557,6 +607,18 @@ if(input.frictionVelocityFlag == 1){
 
 		 checkCancel();
 
+	if(!cacheKey.empty())
+	{
+	    try{
+	        resultCache->store(cacheKey, AngleGrid, VelocityGrid, mesh.meshResolution, mesh.meshResolutionUnits);
+	    }catch (exception& e)
+	    {
+	        input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Exception caught while storing the result in the cache: %s", e.what());
+	    }
+	}
+
+	addToEnsembleStats();
+
 /*  ----------------------------------------*/
 /*  WRITE OUTPUT FILES                      */
 /*  ----------------------------------------*/
@@ -566,6 +628,17 @@ if(input.frictionVelocityFlag == 1){
 	//write output files
 	writeOutputFiles();
 
+	solverStatsJson = SolverStats::toJson(solverStats, input.inputsRunNumber);
+	if(input.solverStatsOutFlag)
+	{
+	    try{
+	        SolverStats::writeJson(solverStats, input.inputsRunNumber, input.solverStatsFile);
+	    }catch (exception& e)
+	    {
+	        input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Exception caught: %s", e.what());
+	    }
+	}
+
 	#ifdef _OPENMP
 		endWriteOut = omp_get_wtime();
 		endTotal = omp_get_wtime();
@@ -581,6 +654,13 @@ if(input.frictionVelocityFlag == 1){
 			input.Com->ninjaCom(ninjaComClass::ninjaNone, "Initialization time was %lf seconds.",endInit-startInit);
 			input.Com->ninjaCom(ninjaComClass::ninjaNone, "Equation building time was %lf seconds.",endBuildEq-startBuildEq);
 			input.Com->ninjaCom(ninjaComClass::ninjaNone, "Solver time was %lf seconds.",endSolve-startSolve);
+			for(unsigned int i = 0; i < solverStats.size(); i++)
+			{
+			    input.Com->ninjaCom(ninjaComClass::ninjaDebug, "Solve %d: %s/%s, %d iterations, residual %.3e -> %.3e, setup %lf s, iterating %lf s.",
+			                        i+1, solverStats[i].solverType.c_str(), solverStats[i].preconditionerType.c_str(),
+			                        solverStats[i].numIterations, solverStats[i].initialResidual, solverStats[i].finalResidual,
+			                        solverStats[i].setupTime, solverStats[i].iterationTime);
+			}
 			#ifdef FRICTION_VELOCITY
 			if(input.frictionVelocityFlag == 1){
                 input.Com->ninjaCom(ninjaComClass::ninjaNone, "Friction velocity calculation time was %lf seconds.",endComputeFrictionVelocity-startComputeFrictionVelocity);
@@ -615,6 +695,9 @@ if(input.frictionVelocityFlag == 1){
 	     AngleGrid.deallocate();
          VelocityGrid.deallocate();
 	     CloudGrid.deallocate();
+         UGrid.deallocate();
+         VGrid.deallocate();
+         WGrid.deallocate();
 #ifdef NINJAFOAM
              TurbulenceGrid.deallocate();
              colMaxGrid.deallocate();
@@ -633,6 +716,119 @@ if(input.frictionVelocityFlag == 1){
      return true;
 }
 
+/**
+ * Write the output files of a run from the grids stored in the result cache,
+ * in place of the simulation.
+ * @param key Key of the run, see ResultCache::computeKey().
+ * @return false if the cache has no entry for key.
+ */
+bool ninja::reuseCachedResult(const std::string &key)
+{
+    double meshResolution;
+    lengthUnits::eLengthUnits meshResolutionUnits;
+    if(!resultCache->load(key, AngleGrid, VelocityGrid, meshResolution, meshResolutionUnits))
+        return false;
+
+    input.Com->ninjaCom(ninjaComClass::ninjaNone, "Reusing the cached result of an identical run...");
+    addToEnsembleStats();
+    solverStats.clear();
+    solverStatsJson.clear();
+    mesh.meshResolution = meshResolution;
+    mesh.meshResolutionUnits = meshResolutionUnits;
+    if(input.initializationMethod == WindNinjaInputs::wxModelInitializationFlag)
+    {
+        init.reset(initializationFactory::makeInitialization(input));    //forecast name and times for the outputs
+    }
+
+    input.Com->ninjaCom(ninjaComClass::ninjaNone, "Writing output files...");
+    writeOutputFiles();
+
+    input.Com->ninjaCom(ninjaComClass::ninjaNone, "Run number %d done!", input.inputsRunNumber);
+    if(!input.keepOutGridsInMemory)
+    {
+        AngleGrid.deallocate();
+        VelocityGrid.deallocate();
+    }
+    return true;
+}
+
+/**
+ * Skip a run recorded in the journal with the same key and unchanged output
+ * files; only the output filenames are set, for ninjaArmy.
+ * @return false if the run has to be done.
+ */
+bool ninja::skipJournaledRun()
+{
+    double meshResolution;
+    lengthUnits::eLengthUnits meshResolutionUnits;
+    if(!runJournal->find(computeOutputPath(), input.inputsRunNumber, journalKey, meshResolution, meshResolutionUnits))
+        return false;
+
+    solverStats.clear();
+    solverStatsJson.clear();
+    mesh.meshResolution = meshResolution;
+    mesh.meshResolutionUnits = meshResolutionUnits;
+    set_outputFilenames(mesh.meshResolution, mesh.meshResolutionUnits);
+
+    input.Com->ninjaCom(ninjaComClass::ninjaNone, "Run number %d was done before, keeping its output files.", input.inputsRunNumber);
+    return true;
+}
+
+/**
+ * Add the output grids of the run to the ensemble statistics of the army,
+ * if it keeps them.  A run that doesn't fit (another output grid) only
+ * gets a warning.
+ */
+void ninja::addToEnsembleStats()
+{
+    if(!ensembleStats)
+        return;
+    try{
+        std::string prefix = CPLFormFilename(computeOutputPath().c_str(),
+                                             CPLGetBasename(input.dem.fileName.c_str()), NULL);
+        ensembleStats->add(VelocityGrid, AngleGrid, prefix);
+    }catch (exception& e)
+    {
+        input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Run number %d is not in the ensemble statistics: %s", input.inputsRunNumber, e.what());
+    }
+}
+
+/**
+ * Output files a journaled run must have, see RunJournal.  Only the files
+ * named in the inputs are listed, not the other ascii variants or the
+ * legends.
+ */
+std::vector<std::string> ninja::getJournalFiles()
+{
+    std::vector<std::string> files;
+    if(input.asciiOutFlag && input.asciiAaigridOutFlag && input.asciiProjOutFlag)
+    {
+        files.push_back(input.velFile);
+        files.push_back(input.angFile);
+    }
+    if(input.googOutFlag)
+        files.push_back(input.kmzFile);
+    if(input.shpOutFlag)
+    {
+        files.push_back(input.shpFile);
+        files.push_back(input.dbfFile);
+    }
+    if(input.pdfOutFlag)
+        files.push_back(input.pdfFile);
+    if(input.geoTiffOutFlag)
+    {
+        std::string velGeoTiffFile = input.geoTiffFile;
+        std::string angGeoTiffFile = input.geoTiffFile;
+        velGeoTiffFile.insert(velGeoTiffFile.find(".tif"), "_vel");
+        angGeoTiffFile.insert(angGeoTiffFile.find(".tif"), "_ang");
+        files.push_back(velGeoTiffFile);
+        files.push_back(angGeoTiffFile);
+    }
+    if(input.fgbzOutFlag)
+        files.push_back(input.fgbzFile);
+    return files;
+}
+
 /**Method used to get the smallest radius of influence from a vector of wxStation.
  *
  * @return Value of smallest radius of influence.
@@ -684,8 +880,6 @@ bool ninja::solve(double *A, double *b, double *x, int *row_ptr, int *col_ind, i
     matdescra[2]='n';	//non-unit diagonal
     matdescra[3]='c';	//c-style array (ie 0 is index of first element, not 1 like in Fortran)
 
-    FILE *convergence_history;
-    int i, j;
     double *p, *z, *q, *r;
     double alpha, beta, rho, rho_1, normb, resid;
     double residual_percent_complete, residual_percent_complete_old, time_percent_complete, start_resid;
@@ -693,21 +887,92 @@ bool ninja::solve(double *A, double *b, double *x, int *row_ptr, int *col_ind, i
 
     residual_percent_complete_old = -1.;
 
+    /*
+    ** Statistics for this solve, the residual history is kept every
+    ** NINJA_SOLVER_STATS_STRIDE iterations (default print_iters, 0 for none).
+    */
+    SolverStats stats;
+    stats.solverType = "CG";
+    stats.historyStride = atoi(CPLGetConfigOption("NINJA_SOLVER_STATS_STRIDE", CPLSPrintf("%d", print_iters)));
+    stats.numUnknowns = NUMNP;
+    stats.numNonZeros = row_ptr[NUMNP];
+    stats.matrixBytes = stats.numNonZeros*(sizeof(double) + sizeof(int)) + (long long)(NUMNP + 1)*sizeof(int);
+    stats.tolerance = tol;
+    double startSetup = SolverStats::wallTime();
+    double startIterations;
+    int iter = 0;
+
+    /*
+    ** Stopping policy (see set_solverIterationBudget() and
+    ** set_solverSurfaceWindTolerance()).  Besides the residual tolerance the
+    ** solve can stop on an iteration or time budget, keeping the current
+    ** solution, or when the wind at the output height stops changing.  The
+    ** wind is checked every NINJA_SOLVER_SURFACE_CHECK_ITERS iterations.
+    */
+    bool budgetIterations = input.solverMaxIterations > 0;
+    double timeLimit = input.solverTimeLimit;
+    bool checkSurfaceWind = input.solverSurfaceWindTol > 0.0 && NUMNP == mesh.NUMNP;
+    int surfaceCheckIters = atoi(CPLGetConfigOption("NINJA_SOLVER_SURFACE_CHECK_ITERS", "50"));
+    std::vector<int> surfaceLayer;
+    std::vector<double> xCheckpoint;
+    int surfaceKMin = 0, surfaceKMax = 0;
+    if(surfaceCheckIters < 1)
+        surfaceCheckIters = 1;
+    if(checkSurfaceWind)
+        findOutputHeightLayers(surfaceLayer, surfaceKMin, surfaceKMax);
+
+    /*
+    ** The preconditioner can be chosen with NINJA_SOLVER_PRECONDITIONER
+    ** (SSOR, JACOBI or CHEBYSHEV), default is SSOR.  The Chebyshev polynomial
+    ** preconditioner applies Jacobi for the first NINJA_CHEBYSHEV_LANCZOS_ITERS
+    ** iterations, then uses the CG coefficients from those iterations to
+    ** estimate the spectrum of D^(-1)*A and switches over.
+    */
     Preconditioner M;
-    if(M.initialize(NUMNP, A, row_ptr, col_ind, M.SSOR, matdescra)==false)
+    int precondType = M.SSOR;
+    const char *pszPrecond = CPLGetConfigOption("NINJA_SOLVER_PRECONDITIONER", "SSOR");
+    if(EQUAL(pszPrecond, "JACOBI"))
+        precondType = M.Jacobi;
+    else if(EQUAL(pszPrecond, "CHEBYSHEV"))
+    {
+        precondType = M.Chebyshev;
+        M.setChebyshevDegree(atoi(CPLGetConfigOption("NINJA_CHEBYSHEV_DEGREE", "4")));
+    }
+    int nLanczosIters = atoi(CPLGetConfigOption("NINJA_CHEBYSHEV_LANCZOS_ITERS", "10"));
+    std::vector<double> lanczosAlpha, lanczosBeta;
+    bool restartDirection = false;  //set when the preconditioner changes, p must be restarted from z
+
+    if(M.initialize(NUMNP, A, row_ptr, col_ind, precondType, matdescra)==false)
     {
-        input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Initialization of SSOR preconditioner failed, trying Jacobi preconditioner...");
+        input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Initialization of %s preconditioner failed, trying Jacobi preconditioner...", pszPrecond);
         if(M.initialize(NUMNP, A, row_ptr, col_ind, M.Jacobi, matdescra)==false)
             throw std::runtime_error("Initialization of Jacobi preconditioner failed.");
     }
 
-//#define NINJA_DEBUG_VERBOSE
-#ifdef NINJA_DEBUG_VERBOSE
-    if((convergence_history = fopen ("convergence_history.txt", "w")) == NULL)
-        throw std::runtime_error("A convergence_history file to write to cannot be created.\nIt may be in use by another program.");
-
-    fprintf(convergence_history,"\nIteration\tResidual\tResidual_check");
-#endif //NINJA_DEBUG_VERBOSE
+    /*
+    ** Deflation (see set_deflationSpace()).  The vectors of the space are
+    ** deflated out of the iterations, and Ritz vectors picked up from the
+    ** iterations refine the space after the solve.  A space built for a
+    ** different mesh size is simply replaced.
+    */
+    DeflationProjector deflation;
+    std::vector<double> deflationW, deflationAW;
+    boost::shared_ptr<RitzCollector> ritz;
+    if(deflationSpace)
+    {
+        int nVectors = deflationSpace->getVectors(NUMNP, deflationW);
+        if(nVectors > 0)
+        {
+            deflationAW.resize(deflationW.size());
+            for(int c = 0; c < nVectors; c++)
+                mkl_dcsrmv(&transa, &NUMNP, &NUMNP, &one, matdescra, A, col_ind, row_ptr, &row_ptr[1],
+                           &deflationW[(long)c*NUMNP], &zero, &deflationAW[(long)c*NUMNP]);
+            if(!deflation.initialize(NUMNP, nVectors, &deflationW[0], &deflationAW[0]))
+                input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Deflation vectors do not fit this matrix, solving without deflation...");
+        }
+        ritz.reset(new RitzCollector(NUMNP, deflationSpace->getMaxVectors(), deflationSpace->getWindowSize()));
+    }
+    stats.deflationVectors = deflation.size();
 
     p=new double[NUMNP];
     z=new double[NUMNP];
@@ -720,24 +985,33 @@ bool ninja::solve(double *A, double *b, double *x, int *row_ptr, int *col_ind, i
     //matrix vector multiplication A*x=Ax
     mkl_dcsrmv(&transa, &NUMNP, &NUMNP, &one, matdescra, A, col_ind, row_ptr, &row_ptr[1], x, &zero, r);
 
-    for(i=0;i<NUMNP;i++){
-        r[i]=b[i]-r[i];                  //calculate the initial residual
-    }
+    ninjaBlas::dxpay(NUMNP, b, -1.0, r);  //calculate the initial residual r = b - Ax
 
-    normb = cblas_dnrm2(NUMNP, b, 1);		//calculate the 2-norm of b
-    //normb = nrm2(NUMNP, b);
+    if(deflation.size() > 0)
+        deflation.correctInitialGuess(x, r);    //solve exactly in the deflation space
+
+    normb = ninjaBlas::dnrm2(NUMNP, b);		//calculate the 2-norm of b
 
     if (normb == 0.0)
         normb = 1.;
 
     //compute 2 norm of r
-    resid = cblas_dnrm2(NUMNP, r, 1) / normb;
-    //resid = nrm2(NUMNP, r) / normb;
+    resid = ninjaBlas::dnrm2(NUMNP, r) / normb;
+
+    stats.initialResidual = resid;
+    startIterations = SolverStats::wallTime();
+    stats.setupTime = startIterations - startSetup;
 
     if (resid <= tol)
     {
-        tol = resid;
-        max_iter = 0;
+        delete[] p;
+        delete[] z;
+        delete[] q;
+        delete[] r;
+        stats.finish(0, resid, true);
+        stats.stopReason = "tolerance";
+        stats.preconditionerType = M.getTypeName();
+        solverStats.push_back(stats);
         return true;
     }
 
@@ -746,49 +1020,69 @@ bool ninja::solve(double *A, double *b, double *x, int *row_ptr, int *col_ind, i
     {
         checkCancel();
 
+        iter = i;
+
         M.solve(r, z, row_ptr, col_ind);	//apply preconditioner
 
-        rho = cblas_ddot(NUMNP, z, 1, r, 1);
-        //rho = dot(NUMNP, z, r);
+        rho = ninjaBlas::ddot(NUMNP, z, r);
 
-        if (i == 1)
+        if (i == 1 || restartDirection)
         {
-            cblas_dcopy(NUMNP, z, 1, p, 1);
+            ninjaBlas::dcopy(NUMNP, z, p);
+            if(restartDirection && ritz)
+                ritz->clear();  //the preconditioned matrix changed
+            restartDirection = false;
+            beta = 0.0;
         }else {
             beta = rho / rho_1;
+            if(M.needsSpectralBounds())
+                lanczosBeta.push_back(beta);
 
-#pragma omp parallel for
-            for(j=0; j<NUMNP; j++)
-                p[j] = z[j] + beta*p[j];
+            ninjaBlas::dxpay(NUMNP, z, beta, p);   //p = z + beta * p
         }
 
+        if(deflation.size() > 0)
+            deflation.deflateDirection(z, p);   //keep p A-orthogonal to the deflation space
+
         //matrix vector multiplication!!!		q = A*p;
         mkl_dcsrmv(&transa, &NUMNP, &NUMNP, &one, matdescra, A, col_ind, row_ptr, &row_ptr[1], p, &zero, q);
 
-        alpha = rho / cblas_ddot(NUMNP, p, 1, q, 1);
-        //alpha = rho / dot(NUMNP, p, q);
+        alpha = rho / ninjaBlas::ddot(NUMNP, p, q);
 
-        cblas_daxpy(NUMNP, alpha, p, 1, x, 1);	//x = x + alpha * p;
-        //axpy(NUMNP, alpha, p, x);
+        if(ritz)
+            ritz->add(z, rho, alpha, beta);
 
-        cblas_daxpy(NUMNP, -alpha, q, 1, r, 1);	//r = r - alpha * q;
-        //axpy(NUMNP, -alpha, q, r);
+        if(M.needsSpectralBounds())
+        {
+            lanczosAlpha.push_back(alpha);
+            if((int)lanczosAlpha.size() >= nLanczosIters)
+            {
+                double lambdaMin, lambdaMax;
+                if(Preconditioner::lanczosEigenvalueBounds(lanczosAlpha, lanczosBeta, lambdaMin, lambdaMax))
+                {
+                    CPLDebug("NINJA", "Chebyshev preconditioner spectral bounds estimate: [%lf, %lf]", lambdaMin, lambdaMax);
+                    M.setSpectralBounds(lambdaMin, lambdaMax);
+                    restartDirection = true;
+                }
+                else
+                {
+                    input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Spectral bounds estimate failed, using Jacobi preconditioner...");
+                    M.setSpectralBounds(0.0, 0.0);  //falls back to Jacobi
+                }
+            }
+        }
 
-        resid = cblas_dnrm2(NUMNP, r, 1) / normb;	//compute resid
-        //resid = nrm2(NUMNP, r) / normb;
+        //x = x + alpha * p;  r = r - alpha * q;  resid = ||r|| / ||b||  (one pass)
+        resid = ninjaBlas::dcgUpdate(NUMNP, alpha, p, q, x, r) / normb;
 
         if(i==1) {
             start_resid = resid;
         }
 
+        stats.addResidual(i, resid);
+
         if((i%print_iters)==0)
         {
-
-#ifdef NINJA_DEBUG_VERBOSE
-            input.Com->ninjaCom(ninjaComClass::ninjaDebug, "Iteration = %d\tResidual = %lf\ttol = %lf", i, resid, tol);
-            fprintf(convergence_history,"\n%ld\t%lf\t%lf",i,resid,tol);
-#endif //NINJA_DEBUG_VERBOSE
-
             residual_percent_complete=100-100*((resid-tol)/(start_resid-tol));
 
             if(residual_percent_complete<residual_percent_complete_old)
@@ -816,6 +1110,30 @@ bool ninja::solve(double *A, double *b, double *x, int *row_ptr, int *col_ind, i
 
         if (resid <= tol)	//check residual against tolerance
         {
+            stats.stopReason = "tolerance";
+            break;
+        }
+
+        if(checkSurfaceWind && (i%surfaceCheckIters)==0)
+        {
+            int layerSize = mesh.nrows*mesh.ncols;
+            if(!xCheckpoint.empty())
+            {
+                double change = surfaceWindChange(x, xCheckpoint, surfaceLayer, surfaceKMin);
+                CPLDebug("NINJA", "Iteration %d: output height wind changed %lf m/s since the last check", i, change);
+                if(change < input.solverSurfaceWindTol)
+                {
+                    stats.stopReason = "surface_wind";
+                    break;
+                }
+            }
+            xCheckpoint.assign(x + surfaceKMin*layerSize, x + (surfaceKMax + 1)*layerSize);
+        }
+
+        if(timeLimit > 0.0 && SolverStats::wallTime() - startIterations > timeLimit)
+        {
+            input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Solver time limit of %lf seconds reached after %d iterations, residual is %lf (tolerance %lf).", timeLimit, i, resid, tol);
+            stats.stopReason = "time_limit";
             break;
         }
 
@@ -846,11 +1164,38 @@ bool ninja::solve(double *A, double *b, double *x, int *row_ptr, int *col_ind, i
         r=NULL;
     }
 
-#ifdef NINJA_DEBUG_VERBOSE
-    fclose(convergence_history);
-#endif //NINJA_DEBUG_VERBOSE
+    if(stats.stopReason.empty())
+    {
+        if(budgetIterations)
+        {
+            input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Solver iteration budget of %d reached, residual is %lf (tolerance %lf).", max_iter, resid, tol);
+            stats.stopReason = "iteration_budget";
+        }
+        else
+            stats.stopReason = "max_iterations";
+    }
 
-    if(resid>tol)
+    if(ritz && stats.stopReason != "max_iterations")
+    {
+        std::vector<double> U, AU;
+        int nU = ritz->finish(U);
+        ritz.reset();
+        AU.resize(U.size());
+        for(int c = 0; c < nU; c++)
+            mkl_dcsrmv(&transa, &NUMNP, &NUMNP, &one, matdescra, A, col_ind, row_ptr, &row_ptr[1],
+                       &U[(long)c*NUMNP], &zero, &AU[(long)c*NUMNP]);
+        deflationSpace->update(NUMNP, deflation.size(),
+                               deflation.size() > 0 ? &deflationW[0] : NULL,
+                               deflation.size() > 0 ? &deflationAW[0] : NULL,
+                               nU, nU > 0 ? &U[0] : NULL, nU > 0 ? &AU[0] : NULL);
+    }
+
+    stats.iterationTime = SolverStats::wallTime() - startIterations;
+    stats.finish(iter, resid, stats.stopReason == "tolerance" || stats.stopReason == "surface_wind");
+    stats.preconditionerType = M.getTypeName();
+    solverStats.push_back(stats);
+
+    if(stats.stopReason == "max_iterations")
     {
         throw std::runtime_error("Solution did not converge.\nMAXITS reached.");
     }else{
@@ -867,12 +1212,12 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 {
 
   int i,j, n;
-  double alpha,malpha,beta,mbeta,ibeta,betaold,eta,c=1.0,ceta,cold=1.0,coold,s=0.0,sold=0.0,soold;
-  double rho0,rho1,irho1,rho2,mrho2,rho3,mrho3,dp = 0.0;
+  double alpha,beta,ibeta,betaold,eta,c=1.0,ceta,cold=1.0,coold,s=0.0,sold=0.0,soold;
+  double rho0,rho1,irho1,rho2,rho3,dp = 0.0;
   double rnorm, bnorm;
   double np;	//this is the residual
   double residual_percent_complete_old, residual_percent_complete, time_percent_complete, start_resid;
-  double            *R, *Z, *U, *V, *W, *UOLD, *VOLD, *WOLD, *WOOLD;
+  double            *R, *Z, *U, *V, *W, *UOLD, *VOLD, *WOLD, *WOOLD, *swap;
 
   n = NUMNP;
 
@@ -898,14 +1243,29 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 
   residual_percent_complete_old = -1.;
 
-  FILE *convergence_history;
-
-  if((convergence_history = fopen ("convergence_history.txt", "w")) == NULL)
-  {
-	   input.Com->ninjaCom(ninjaComClass::ninjaFailure, "A convergence_history file to write to cannot be created.\nIt may be in use by another program.");
-	   exit(0);
-  }
-  fprintf(convergence_history,"\nIteration\tResidual\tResidual_check");
+  SolverStats stats;
+  stats.solverType = "MINRES";
+  stats.historyStride = atoi(CPLGetConfigOption("NINJA_SOLVER_STATS_STRIDE", CPLSPrintf("%d", print_iters)));
+  stats.numUnknowns = n;
+  stats.numNonZeros = row_ptr[n];
+  stats.matrixBytes = stats.numNonZeros*(sizeof(double) + sizeof(int)) + (long long)(n + 1)*sizeof(int);
+  stats.tolerance = tol;
+  double startSetup = SolverStats::wallTime();
+  double startIterations;
+  bool converged;
+
+  //same stopping policy as ninja::solve()
+  bool budgetIterations = input.solverMaxIterations > 0;
+  double timeLimit = input.solverTimeLimit;
+  bool checkSurfaceWind = input.solverSurfaceWindTol > 0.0 && n == mesh.NUMNP;
+  int surfaceCheckIters = atoi(CPLGetConfigOption("NINJA_SOLVER_SURFACE_CHECK_ITERS", "50"));
+  std::vector<int> surfaceLayer;
+  std::vector<double> xCheckpoint;
+  int surfaceKMin = 0, surfaceKMax = 0;
+  if(surfaceCheckIters < 1)
+      surfaceCheckIters = 1;
+  if(checkSurfaceWind)
+      findOutputHeightLayers(surfaceLayer, surfaceKMin, surfaceKMax);
 
   Preconditioner precond;
 
@@ -921,22 +1281,26 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 
   //ksp->its = 0;
 
-  for(j=0;j<n;j++)	UOLD[j] = 0.0;	//  u_old  <-   0
-  cblas_dcopy(n, UOLD, 1, VOLD, 1);	//	v_old  <-   0
-  cblas_dcopy(n, UOLD, 1, W, 1);	//	w      <-   0
-  cblas_dcopy(n, UOLD, 1, WOLD, 1);	//	w_old  <-   0
+  for(j=0;j<n;j++)
+  {
+      UOLD[j] = 0.0;	//  u_old  <-   0
+      VOLD[j] = 0.0;	//	v_old  <-   0
+      W[j] = 0.0;	//	w      <-   0
+      WOLD[j] = 0.0;	//	w_old  <-   0
+      WOOLD[j] = 0.0;	//	w_oold <-   0
+  }
 
   mkl_dcsrmv(&transa, &n, &n, &one, matdescra, A, col_ind, row_ptr, &row_ptr[1], x, &zero, R); // r <- b - A*x
 
-  for(j=0;j<n;j++)	R[j] = b[j] - R[j];
+  ninjaBlas::dxpay(n, b, -1.0, R);
 
-  bnorm = cblas_dnrm2(n, b, 1);
+  bnorm = ninjaBlas::dnrm2(n, b);
 
   precond.solve(R, Z, row_ptr, col_ind);	//apply preconditioner    M*z = r
 
   //KSP_PCApply(ksp,R,Z);
 
-  dp = cblas_ddot(n, R, 1, Z, 1);
+  dp = ninjaBlas::ddot(n, R, Z);
   if(dp<0.0)
   {
 	input.Com->ninjaCom(ninjaComClass::ninjaFailure, "ERROR IN SOLVER!!! SQUARE ROOT OF A NEGATIVE NUMBER...");
@@ -947,17 +1311,18 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
   beta = dp;		//  beta <- sqrt(r'*z)
   eta = beta;
 
-  //  VecCopy(R,V)   V = R
-  cblas_dcopy(n, R, 1, V, 1);
-  cblas_dcopy(n, Z, 1, U, 1);
   ibeta = 1.0/beta;
-  cblas_dscal(n, ibeta, V, 1);	//  v <- r/beta
-  cblas_dscal(n, ibeta, U, 1);	//  u <- z/beta
+  ninjaBlas::dscalCopy(n, ibeta, R, V);	//  v <- r/beta
+  ninjaBlas::dscalCopy(n, ibeta, Z, U);	//  u <- z/beta
 
-  np = cblas_dnrm2(n, Z, 1);	//  np <- ||z||
+  np = ninjaBlas::dnrm2(n, Z);	//  np <- ||z||
 
   rnorm = np;
 
+  stats.initialResidual = np;
+  startIterations = SolverStats::wallTime();
+  stats.setupTime = startIterations - startSetup;
+
   // TEST FOR CONVERGENCE HERE!!!!
 
   i = 0;
@@ -968,20 +1333,14 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 
 	  mkl_dcsrmv(&transa, &n, &n, &one, matdescra, A, col_ind, row_ptr, &row_ptr[1], U, &zero, R); // r <- A*x
 
-	  alpha = cblas_ddot(n, U, 1, R, 1);	//  alpha <- r'*u
+	  alpha = ninjaBlas::ddot(n, U, R);	//  alpha <- r'*u
 	  precond.solve(R, Z, row_ptr, col_ind);	//apply preconditioner    M*z = r
 
-	  malpha = -alpha;
-	  cblas_daxpy(n, malpha, V, 1, R, 1);	//  r <- r - alpha*v
-	  cblas_daxpy(n, malpha, U, 1, Z, 1);	//  z <- z - alpha*u
-	  mbeta = -beta;
-	  cblas_daxpy(n, mbeta, VOLD, 1, R, 1);	//  r <- r - beta*v_old
-	  cblas_daxpy(n, mbeta, UOLD, 1, Z, 1);	//  z <- z - beta*u_old
+	  //  r <- r - alpha*v - beta*v_old,  z <- z - alpha*u - beta*u_old,  dp <- r'*z  (one pass)
+	  dp = ninjaBlas::dlanczosUpdate(n, alpha, beta, V, VOLD, R, U, UOLD, Z);
 
 	  betaold = beta;
 
-	  dp = cblas_ddot(n, R, 1, Z, 1);
-
 	  beta = std::sqrt(dp);		//  beta <- sqrt(r'*z)
 
 	  coold = cold; cold = c; soold = sold; sold = s;
@@ -998,28 +1357,28 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 
 	  //  Update
 
-	  cblas_dcopy(n, WOLD, 1, WOOLD, 1);	//  w_oold <- w_old
-	  cblas_dcopy(n, W, 1, WOLD, 1);	//  w_old <- w
+	  //  w_oold <- w_old,  w_old <- w  (rotate the buffers instead of copying)
+	  swap = WOOLD;
+	  WOOLD = WOLD;
+	  WOLD = W;
+	  W = swap;
 
-	  cblas_dcopy(n, U, 1, W, 1);	//  w <- U
-	  mrho2 = -rho2;
-	  cblas_daxpy(n, mrho2, WOLD, 1, W, 1);	//  w <- w - rho2 w_old
-	  mrho3 = -rho3;
-	  cblas_daxpy(n, mrho3, WOOLD, 1, W, 1);	//  w <- w - rho3 w_oold
+	  //  w <- (u - rho2 w_old - rho3 w_oold)/rho1,  x <- x + ceta w  (one pass)
 	  irho1 = 1.0 / rho1;
-	  cblas_dscal(n, irho1, W, 1);	//  w <- w/rho1
-
 	  ceta = c * eta;
-	  cblas_daxpy(n, ceta, W, 1, x, 1);	//  x <- x - ceta w
+	  ninjaBlas::dminresUpdate(n, irho1, rho2, rho3, U, WOLD, WOOLD, W, ceta, x);
 	  eta = - s * eta;
 
-	  cblas_dcopy(n, V, 1, VOLD, 1);	//  v_old <- v
-	  cblas_dcopy(n, U, 1, UOLD, 1);	//  u_old <- u
-	  cblas_dcopy(n, R, 1, V, 1);	//  v <- r
-	  cblas_dcopy(n, Z, 1, U, 1);	//  u <- z
+	  //  v_old <- v,  u_old <- u  (rotate the buffers instead of copying)
+	  swap = VOLD;
+	  VOLD = V;
+	  V = swap;
+	  swap = UOLD;
+	  UOLD = U;
+	  U = swap;
 	  ibeta = 1.0 / beta;
-      cblas_dscal(n, ibeta, V, 1);	//  v <- r / beta
-	  cblas_dscal(n, ibeta, U, 1);	//  u <- z / beta
+	  ninjaBlas::dscalCopy(n, ibeta, R, V);	//  v <- r / beta
+	  ninjaBlas::dscalCopy(n, ibeta, Z, U);	//  u <- z / beta
 
 	  np = rnorm * fabs(s);
 
@@ -1034,8 +1393,14 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 
         if(i==1)
             start_resid = np;
-	
-        if(np<tol)   break;
+
+        stats.addResidual(i+1, np);
+
+        if(np<tol)
+        {
+            stats.stopReason = "tolerance";
+            break;
+        }
 
 	  i++;
 
@@ -1043,14 +1408,7 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 	  if((i%print_iters)==0)
       {
 
-	    #ifdef NINJA_DEBUG_VERBOSE
-		input.Com->ninjaCom(ninjaComClass::ninjaDebug, "solver: n=%d iterations = %d residual norm %12.4e", n,i,rnorm/bnorm);
-		//input.Com->ninjaCom(ninjaComClass::ninjaDebug, "Iteration = %d\tResidual = %lf\ttol = %lf", i, resid, tol);
-		fprintf(convergence_history,"\n%ld\t%lf\t%lf",i,rnorm/bnorm,tol);
-		#endif //NINJA_DEBUG_VERBOSE
-
 		input.Com->ninjaCom(ninjaComClass::ninjaDebug, "solver: n=%d iterations = %d residual norm %12.4e", n,i,rnorm/bnorm);
-		fprintf(convergence_history,"\n%d\t%lf\t%lf",i,rnorm/bnorm,tol);
 
 
 	    residual_percent_complete=100-100*((np-tol)/(start_resid-tol));
@@ -1067,18 +1425,47 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
 		input.Com->ninjaCom(ninjaComClass::ninjaSolverProgress, "%d",(int) (time_percent_complete+0.5));
 	  }
 
+        if(checkSurfaceWind && (i%surfaceCheckIters)==0)
+        {
+            int layerSize = mesh.nrows*mesh.ncols;
+            if(!xCheckpoint.empty())
+            {
+                double change = surfaceWindChange(x, xCheckpoint, surfaceLayer, surfaceKMin);
+                CPLDebug("NINJA", "Iteration %d: output height wind changed %lf m/s since the last check", i, change);
+                if(change < input.solverSurfaceWindTol)
+                {
+                    stats.stopReason = "surface_wind";
+                    break;
+                }
+            }
+            xCheckpoint.assign(x + surfaceKMin*layerSize, x + (surfaceKMax + 1)*layerSize);
+        }
+
+        if(timeLimit > 0.0 && SolverStats::wallTime() - startIterations > timeLimit)
+        {
+            input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Solver time limit of %lf seconds reached after %d iterations, residual is %lf (tolerance %lf).", timeLimit, i, np, tol);
+            stats.stopReason = "time_limit";
+            break;
+        }
+
   }while(i<max_iter);
 
-  if(i >= max_iter)
+  if(stats.stopReason.empty())
   {
-		input.Com->ninjaCom(ninjaComClass::ninjaFailure, "SOLVER DID NOT CONVERGE WITHIN THE SPECIFIED MAXIMUM NUMBER OF ITERATIONS!!");
-		return false;
-  }else{
-		//input.Com->ninjaCom(ninjaComClass::ninjaDebug, "Solver done.");
-		return true;
+      if(budgetIterations)
+      {
+          input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Solver iteration budget of %d reached, residual is %lf (tolerance %lf).", max_iter, np, tol);
+          stats.stopReason = "iteration_budget";
+      }
+      else
+          stats.stopReason = "max_iterations";
   }
 
-	fclose(convergence_history);
+  converged = (stats.stopReason == "tolerance" || stats.stopReason == "surface_wind");
+  stats.iterationTime = SolverStats::wallTime() - startIterations;
+  stats.finish(stats.stopReason == "tolerance" ? i+1 : i, np, converged);
+  stats.preconditionerType = precond.getTypeName();
+  solverStats.push_back(stats);
 
   if(R)
 	delete[] R;
@@ -1099,103 +1486,81 @@ bool ninja::solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_
   if(WOOLD)
 	delete[] WOOLD;
 
-  return true;
-
-}
-
-/**@brief Performs the calculation X = alpha * X.
- * X is an N-element vector and alpha is a scalar.
- * A limited version of the BLAS function dscal().
- * @param N Size of vectors.
- * @param X Source vector.
- * @param incX Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- */
-void ninja::cblas_dscal(const int N, const double alpha, double *X, const int incX)
-{
-     int i, ix;
-
-     if (incX <= 0) return;
-
-     ix = OFFSET(N, incX);
-
-     for (i = 0; i < N; i++) {
-         X[ix] *= alpha;
-         ix    += incX;
-     }
-}
-
-/**Copies values from the X vector to the Y vector.
- * A limited version of the BLAS function dcopy().
- * @param N Size of vectors.
- * @param X Source vector.
- * @param incX Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- * @param Y Target vector to copy values to.
- * @param incY Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- */
-void ninja::cblas_dcopy(const int N, const double *X, const int incX, double *Y, const int incY)
-{
-	int i;
-	for(i=0; i<N; i++)
-		Y[i] = X[i];
-}
-
-/**Performs the dot product X*Y.
- * A limited version of the BLAS function ddot().
- * @param N Size of vectors.
- * @param X Vector of size N.
- * @param incX Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- * @param Y Vector of size N.
- * @param incY Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- * @return Dot product X*Y value.
- */
-double ninja::cblas_ddot(const int N, const double *X, const int incX, const double *Y, const int incY)
-{
-	double val=0.0;
-	int i;
+  if(stats.stopReason == "max_iterations")
+  {
+		input.Com->ninjaCom(ninjaComClass::ninjaFailure, "SOLVER DID NOT CONVERGE WITHIN THE SPECIFIED MAXIMUM NUMBER OF ITERATIONS!!");
+		return false;
+  }
 
-	#pragma omp parallel for reduction(+:val)
-	for(i=0;i<N;i++)
-		val += X[i]*Y[i];
+  return true;
 
-	return val;
 }
 
-/**Performs the calculation Y = Y + alpha * X.
- * A limited version of the BLAS function daxpy().
- * @param N Size of vectors.
- * @param alpha
- * @param X Vector of size N.
- * @param incX Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- * @param Y Vector of size N.
- * @param incY Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
+/**
+ * Find the mesh layer at (or just above) the output wind height for each
+ * column, same search as interp_uvw().  Used by the surface wind stopping check.
+ * @param layer Layer index for each column (row major, mesh.nrows*mesh.ncols).
+ * @param kMin Lowest layer in layer.
+ * @param kMax Highest layer in layer.
  */
-void ninja::cblas_daxpy(const int N, const double alpha, const double *X, const int incX, double *Y, const int incY)
+void ninja::findOutputHeightLayers(std::vector<int> &layer, int &kMin, int &kMax)
 {
-	int i;
-
-	#pragma omp parallel for
-	for(i=0; i<N; i++)
-		Y[i] += alpha*X[i];
+    layer.resize(mesh.nrows*mesh.ncols);
+    kMin = mesh.nlayers - 1;
+    kMax = 1;
+    for(int i = 0; i < mesh.nrows; i++)
+    {
+        for(int j = 0; j < mesh.ncols; j++)
+        {
+            double target = input.outputWindHeight + input.surface.Rough_h(i,j);
+            int k = 1;
+            while(k < mesh.nlayers - 1 && mesh.ZORD(i, j, k) - mesh.ZORD(i, j, 0) < target)
+                k++;
+            layer[i*mesh.ncols + j] = k;
+            kMin = std::min(kMin, k);
+            kMax = std::max(kMax, k);
+        }
+    }
 }
 
-/**Computes the 2-norm of X.
- * A limited version of the BLAS function dnrm2().
- * @param N Size of X.
- * @param X Vector of size N.
- * @param incX Number of values to skip.  MUST BE 1 FOR THIS VERSION!!
- * @return Value of the 2-norm of X.
+/**
+ * Largest change in the horizontal wind at the output wind height between
+ * two solver checkpoints.  The wind depends linearly on PHI (see
+ * computeUVWField()), so the change in u and v is 1/(2*alphaH^2) times the
+ * gradient of the change in PHI, which is estimated here with central
+ * differences along the layer instead of the full element smoothing.
+ * @param x Current solution (PHI).
+ * @param xOld PHI at the last checkpoint, layers kMin to kMax of the mesh.
+ * @param layer Layer index for each column from findOutputHeightLayers().
+ * @param kMin Lowest layer stored in xOld.
+ * @return The largest change in horizontal wind speed, in m/s.
  */
-double ninja::cblas_dnrm2(const int N, const double *X, const int incX)
-{
-	double val=0.0;
-	int i;
-
-	//#pragma omp parallel for reduction(+:val)
-	for(i=0;i<N;i++)
-		val += X[i]*X[i];
-	val = std::sqrt(val);
+double ninja::surfaceWindChange(const double *x, const std::vector<double> &xOld,
+                                const std::vector<int> &layer, int kMin)
+{
+    const int nRows = mesh.nrows;
+    const int nCols = mesh.ncols;
+    const int layerSize = nRows*nCols;
+    const int offset = kMin*layerSize;
+    const double scale = 1.0/(2.0*alphaH*alphaH);
+    double maxChange = 0.0;
+
+    #pragma omp parallel for reduction(max:maxChange)
+    for(int i = 1; i < nRows - 1; i++)
+    {
+        for(int j = 1; j < nCols - 1; j++)
+        {
+            int k = layer[i*nCols + j];
+            int n = k*layerSize + i*nCols + j;
+            double dE = (x[n+1] - xOld[n+1-offset]) - (x[n-1] - xOld[n-1-offset]);
+            double dN = (x[n+nCols] - xOld[n+nCols-offset]) - (x[n-nCols] - xOld[n-nCols-offset]);
+            double du = scale*dE/(mesh.XORD(n+1) - mesh.XORD(n-1));
+            double dv = scale*dN/(mesh.YORD(n+nCols) - mesh.YORD(n-nCols));
+            maxChange = std::max(maxChange, std::sqrt(du*du + dv*dv));
+        }
+    }
 
-	return val;
+    return maxChange;
 }
 
 /**
@@ -1327,10 +1692,10 @@ void ninja::mkl_trans_dcsrmv(char *transa, int *m, int *k, double *alpha, char *
             }
         }
 
-        cblas_dcopy(N, temp, 1, y, 1); // y <- temp
-
     }	//end parallel region
 
+    ninjaBlas::dcopy(N, temp, y); // y <- temp
+
     if(temp)
         delete[] temp;
 }
@@ -1340,6 +1705,13 @@ void ninja::mkl_trans_dcsrmv(char *transa, int *m, int *k, double *alpha, char *
  */
 void ninja::interp_uvw()
 {
+    if(keepUvwGrids)
+    {
+        UGrid.set_headerData(VelocityGrid);
+        VGrid.set_headerData(VelocityGrid);
+        WGrid.set_headerData(VelocityGrid);
+    }
+
 #pragma omp parallel default(shared)
     {
 
@@ -1398,6 +1770,13 @@ void ninja::interp_uvw()
                     VelocityGrid(i,j)=std::pow((uu*uu+vv*vv),0.5);       //calculate velocity magnitude (in x,y plane; I decided to NOT include z here so the wind is the horizontal wind)
                 }
 
+                if(keepUvwGrids)
+                {
+                    UGrid(i,j)=uu;
+                    VGrid(i,j)=vv;
+                    WGrid(i,j)=ww;
+                }
+
                 if (uu==0.0 && vv==0.0)
                     intermedval=0.0;
                 else
@@ -1696,77 +2075,31 @@ void ninja::discretize()
     CPLDebug("STABILITY", "input.stabilityFlag = %i\n", input.stabilityFlag);
 
     Stability stb(input);
-    alphaVfield.allocate(&mesh);
 
     if(input.stabilityFlag==0){  // if stabilityFlag not set
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows;i++)
-            {
-                for(unsigned int j=0; j<mesh.ncols; j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/1.0;
-                }
-            }
-        }
+        alphaVfield.setUniform(alphaH/1.0);
     }
     else if(input.stabilityFlag==1 && input.alphaStability!=-1) // if the alpha was specified directly in the CLI
     {
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows; i++)
-            {
-                for(unsigned int j=0; j<mesh.ncols; j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/input.alphaStability;
-                }
-            }
-        }
+        alphaVfield.setUniform(alphaH/input.alphaStability);
     }
     else if(input.stabilityFlag==1 &&
             input.initializationMethod==WindNinjaInputs::domainAverageInitializationFlag) //it's a domain-average run
 	{
         stb.SetDomainAverageAlpha(input, mesh);  //sets alpha based on incident solar radiation
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows; i++)
-            {
-                for(unsigned int j=0;j<input.dem.get_nCols();j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/stb.alphaField(i,j,k);
-                }
-            }
-        }
+        alphaVfield.setInverse(alphaH, stb.alphaField);
     }
     else if(input.stabilityFlag==1 &&
             input.initializationMethod==WindNinjaInputs::griddedInitializationFlag) //it's a gridded-initialization run
 	{
         stb.SetDomainAverageAlpha(input, mesh);  //sets alpha based on incident solar radiation
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows; i++)
-            {
-                for(unsigned int j=0;j<input.dem.get_nCols();j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/stb.alphaField(i,j,k);
-                }
-            }
-        }
+        alphaVfield.setInverse(alphaH, stb.alphaField);
     }
     else if(input.stabilityFlag==1 &&
             input.initializationMethod==WindNinjaInputs::pointInitializationFlag) //it's a point-initialization run
 	{
         stb.SetPointInitializationAlpha(input, mesh);
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows; i++)
-            {
-                for(unsigned int j=0; j<mesh.ncols; j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/stb.alphaField(i,j,k);
-                }
-            }
-        }
+        alphaVfield.setInverse(alphaH, stb.alphaField);
     }
     //If the run is a 2D WX model run
     else if(input.stabilityFlag==1 &&
@@ -1774,17 +2107,7 @@ void ninja::discretize()
             init->getForecastIdentifier()!="WRF-3D") //it's a 2D wx model run
     {
         stb.Set2dWxInitializationAlpha(input, mesh, CloudGrid);
-
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows; i++)
-            {
-                for(unsigned int j=0; j<mesh.ncols; j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/stb.alphaField(i,j,k);
-                }
-            }
-        }
+        alphaVfield.setInverse(alphaH, stb.alphaField);
     }
 	//If the run is a WX model run where the full WX vertical profile is used and
 	//the potential temp (theta) is available, then use the method below
@@ -1796,17 +2119,7 @@ void ninja::discretize()
 
         stb.Set3dVariableAlpha(input, mesh, init->air3d, u0, v0);
         init->air3d.deallocate();
-
-        for(unsigned int k=0; k<mesh.nlayers; k++)
-        {
-            for(unsigned int i=0; i<mesh.nrows; i++)
-            {
-                for(unsigned int j=0; j<mesh.ncols; j++)
-                {
-                    alphaVfield(i,j,k) = alphaH/stb.alphaField(i,j,k);
-                }
-            }
-        }
+        alphaVfield.setInverse(alphaH, stb.alphaField);
     }
     else{
         throw logic_error( string("Can't determine how to set atmophseric stability.") );
@@ -2293,6 +2606,12 @@ void ninja::prepareOutput()
 	//Clip off bounding doughnut if desired
 	VelocityGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
 	AngleGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
+	if(keepUvwGrids && !isNullRun)
+	{
+	    UGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
+	    VGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
+	    WGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
+	}
 #ifdef NINJAFOAM
 	TurbulenceGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
 	colMaxGrid.clipGridInPlaceSnapToCells(input.outputBufferClipping);
@@ -2306,6 +2625,12 @@ void ninja::prepareOutput()
 	}
 	//change windspeed units back to what is specified by speed units switch
 	velocityUnits::fromBaseUnits(VelocityGrid, input.outputSpeedUnits);
+	if(keepUvwGrids && !isNullRun)
+	{
+	    velocityUnits::fromBaseUnits(UGrid, input.outputSpeedUnits);
+	    velocityUnits::fromBaseUnits(VGrid, input.outputSpeedUnits);
+	    velocityUnits::fromBaseUnits(WGrid, input.outputSpeedUnits);
+	}
 #ifdef NINJAFOAM
         if(input.writeTurbulence)
         {
@@ -3004,6 +3329,62 @@ void ninja::writeOutputFiles()
     v.deallocate();
     w.deallocate();
 
+    if(outputQueue)
+    {
+        /*
+        ** Hand the grids to a writer and return.  The writer only gets what
+        ** writeOutputGrids() uses; the output grids are moved unless the
+        ** caller keeps them in memory.
+        */
+        ninja *writer = new ninja();
+        writer->input = input;
+        writer->init = init;
+        writer->runJournal = runJournal;
+        writer->journalKey = journalKey;
+        writer->mesh.meshResolution = mesh.meshResolution;
+        writer->mesh.meshResolutionUnits = mesh.meshResolutionUnits;
+        if(input.keepOutGridsInMemory)
+        {
+            writer->AngleGrid = AngleGrid;
+            writer->VelocityGrid = VelocityGrid;
+#ifdef FRICTION_VELOCITY
+            writer->UstarGrid = UstarGrid;
+#endif
+#ifdef EMISSIONS
+            writer->DustGrid = DustGrid;
+#endif
+#ifdef NINJAFOAM
+            writer->colMaxGrid = colMaxGrid;
+#endif
+        }
+        else
+        {
+            writer->AngleGrid.swap(AngleGrid);
+            writer->VelocityGrid.swap(VelocityGrid);
+#ifdef FRICTION_VELOCITY
+            writer->UstarGrid.swap(UstarGrid);
+#endif
+#ifdef EMISSIONS
+            writer->DustGrid.swap(DustGrid);
+#endif
+#ifdef NINJAFOAM
+            writer->colMaxGrid.swap(colMaxGrid);
+#endif
+        }
+        outputQueue->push(writer, demGrid);
+        return;
+    }
+
+    writeOutputGrids(demGrid);
+}
+
+/**Writes the raster, text, shape, kmz, pdf and fgbz output files from the
+ * output grids.  Called by writeOutputFiles(), or by an OutputQueue writer.
+ * @param demGrid Grid the outputs are buffered to overlap, unless output
+ *                clipping was set.
+ */
+void ninja::writeOutputGrids(AsciiGrid<double> &demGrid)
+{
     #pragma omp parallel sections
     {
 
@@ -3518,6 +3899,18 @@ void ninja::writeOutputFiles()
         }
     } //end omp section
     }   //end parallel sections region
+
+    //the run is done once its files are written, see RunJournal
+    if(!journalKey.empty())
+    {
+        try{
+            runJournal->record(input.outputPath, input.inputsRunNumber, journalKey,
+                               mesh.meshResolution, mesh.meshResolutionUnits, getJournalFiles());
+        }catch (exception& e)
+        {
+            input.Com->ninjaCom(ninjaComClass::ninjaWarning, "Exception caught while recording the run in the journal: %s", e.what());
+        }
+    }
 }
 
 /**Deletes allocated dynamic memory.
@@ -4801,6 +5194,220 @@ void ninja::set_numberCPUs(int CPUs)
     //	}
     //ninjaCom(ninjaComClass::ninjaDebug, "In parallel = %d", omp_in_parallel());
 }
+
+/**
+ * Set the stopping tolerance of the solver.
+ * @param tol Tolerance on the 2-norm of the residual relative to the right hand side.
+ */
+void ninja::set_solverTolerance(double tol)
+{
+    if(tol <= 0.0)
+        throw std::range_error("Solver tolerance is less than or equal to zero in ninja::set_solverTolerance().");
+    input.solverTolerance = tol;
+}
+
+/**
+ * Set an iteration and/or time budget for each solve.  When the budget is
+ * used up the current solution is kept (with a warning) instead of failing
+ * the run, which is what fast preview runs want.
+ * @param maxIterations Maximum iterations per solve, -1 for no budget.
+ * @param timeLimit Maximum time spent iterating per solve in seconds, -1 for no limit.
+ */
+void ninja::set_solverIterationBudget(int maxIterations, double timeLimit)
+{
+    if(maxIterations == 0 || maxIterations < -1)
+        throw std::range_error("Solver iteration budget must be positive or -1 in ninja::set_solverIterationBudget().");
+    if(timeLimit <= 0.0 && timeLimit != -1.0)
+        throw std::range_error("Solver time limit must be positive or -1 in ninja::set_solverIterationBudget().");
+    input.solverMaxIterations = maxIterations;
+    input.solverTimeLimit = timeLimit;
+}
+
+/**
+ * Stop the solver when the horizontal wind at the output wind height changes
+ * less than tol between checks, even if the residual tolerance isn't reached.
+ * @param tol Tolerance on the change in wind speed, -1 to turn the check off.
+ * @param units Units of tol.
+ */
+void ninja::set_solverSurfaceWindTolerance(double tol, velocityUnits::eVelocityUnits units)
+{
+    if(tol <= 0.0 && tol != -1.0)
+        throw std::range_error("Surface wind tolerance must be positive or -1 in ninja::set_solverSurfaceWindTolerance().");
+    if(tol > 0.0)
+        velocityUnits::toBaseUnits(tol, units);
+    input.solverSurfaceWindTol = tol;
+}
+
+/**
+ * Use a deflation space in the CG solver.  The vectors in the space are
+ * deflated out of each solve and refined afterwards, so runs sharing a space
+ * on the same mesh converge faster as the space improves.
+ * @param space Space to use, may be shared with other runs, NULL to turn deflation off.
+ */
+void ninja::set_deflationSpace(boost::shared_ptr<DeflationSpace> space)
+{
+    deflationSpace = space;
+}
+
+/**
+ * Write the output files in the background.  simulate_wind() hands the output
+ * grids to the queue and returns while they are written, see OutputQueue.
+ * @param queue Queue to use, may be shared with other runs, NULL to write the
+ *              files before simulate_wind() returns.
+ */
+void ninja::set_outputQueue(boost::shared_ptr<OutputQueue> queue)
+{
+    outputQueue = queue;
+}
+
+/**
+ * Reuse the output grids of earlier identical runs.  A run found in the cache
+ * only writes its output files; a run that isn't stores its grids.
+ * @param cache Cache to use, may be shared with other runs, NULL to turn it off.
+ */
+void ninja::set_resultCache(boost::shared_ptr<ResultCache> cache)
+{
+    resultCache = cache;
+}
+
+/**
+ * Skip the run if the journal has it done with unchanged output files, and
+ * record it once its output files are written.  See RunJournal.
+ * @param journal Journal to use, shared with the other runs of the army, NULL to turn it off.
+ */
+void ninja::set_runJournal(boost::shared_ptr<RunJournal> journal)
+{
+    runJournal = journal;
+}
+
+/**
+ * Add the output speed and direction grids of the run to the statistics of
+ * the army once they are computed.  See EnsembleStats.
+ * @param stats Statistics shared with the other runs of the army, NULL to turn it off.
+ */
+void ninja::set_ensembleStats(boost::shared_ptr<EnsembleStats> stats)
+{
+    ensembleStats = stats;
+}
+
+/**
+ * Size of the DEM of a run.  Taken from the elevation grid once it is read,
+ * and from the header of the DEM file before that, so runs can be sized
+ * before they start.
+ * @param nRows Number of rows of the DEM.
+ * @param nCols Number of columns of the DEM.
+ * @param cellSize Cell size of the DEM.
+ * @return false if the DEM isn't read and its file can't be opened.
+ */
+bool ninja::estimate_demSize(int &nRows, int &nCols, double &cellSize)
+{
+    if(input.dem.get_nRows() > 0 && input.dem.get_nCols() > 0)
+    {
+        nRows = input.dem.get_nRows();
+        nCols = input.dem.get_nCols();
+        cellSize = input.dem.get_cellSize();
+        return true;
+    }
+
+    nRows = nCols = 0;
+    cellSize = 0.0;
+    if(input.dem.fileName.empty())
+        return false;
+
+    GDALDataset *poDS = (GDALDataset*)GDALOpen(input.dem.fileName.c_str(), GA_ReadOnly);
+    if(poDS == NULL)
+        return false;
+    double adfGeoTransform[6];
+    bool haveSize = poDS->GetGeoTransform(adfGeoTransform) == CE_None;
+    if(haveSize)
+    {
+        nRows = poDS->GetRasterYSize();
+        nCols = poDS->GetRasterXSize();
+        cellSize = fabs(adfGeoTransform[1]);
+    }
+    GDALClose((GDALDatasetH)poDS);
+    return haveSize;
+}
+
+/**
+ * Estimate the number of mesh nodes of a run before it starts, see
+ * Mesh::estimate_size().
+ * @return Estimated number of nodes, 0 if it can't be estimated.
+ */
+long ninja::estimate_numNodes()
+{
+    int nRows, nCols;
+    double cellSize;
+    if(!estimate_demSize(nRows, nCols, cellSize))
+        return 0;
+    return mesh.estimate_numNodes(nCols*cellSize, nRows*cellSize);
+}
+
+/**
+ * Estimate the peak memory of a run before it starts, used by ninjaArmy to
+ * limit how many runs go at once.  Counts the mesh, the 3d wind fields, the
+ * stiffness matrix (same count of non-zeros as discretize()), the solver
+ * vectors (MINRES, the largest), the deflation vectors, the 2d input and
+ * output grids and the largest grids made for an output file.  The DEM
+ * size comes from estimate_demSize(), so the DEM doesn't need to be read.
+ * @return Estimated peak memory in bytes, 0 if the mesh size can't be estimated.
+ */
+long long ninja::estimate_peakMemory()
+{
+    int demRows, demCols;
+    double demCellSize;
+    if(!estimate_demSize(demRows, demCols, demCellSize))
+        return 0;
+    const double Xlength = demCols*demCellSize;
+    const double Ylength = demRows*demCellSize;
+
+    long nrowsEstimate, ncolsEstimate, nlayersEstimate;
+    if(!mesh.estimate_size(Xlength, Ylength, nrowsEstimate, ncolsEstimate, nlayersEstimate))
+        return 0;
+
+    const long long nNodes = (long long)nrowsEstimate*ncolsEstimate*nlayersEstimate;
+    const long long nCells = (long long)nrowsEstimate*ncolsEstimate;
+    const long long intercols = ncolsEstimate - 2;
+    const long long interrows = nrowsEstimate - 2;
+    const long long interlayers = nlayersEstimate - 2;
+
+    //upper half of the stiffness matrix, as in discretize()
+    long long NZND = (8*8)+(intercols*4+interrows*4+interlayers*4)*12+(intercols*interlayers*2+interrows*interlayers*2+intercols*interrows*2)*18+(intercols*interrows*interlayers)*27;
+    NZND = (NZND - nNodes)/2 + nNodes;
+
+    long long bytes = 0;
+    bytes += 3*nNodes*sizeof(double);              //XORD, YORD, ZORD
+    bytes += 6*nNodes*sizeof(double);              //u0, v0, w0, u, v, w
+    bytes += 6*nNodes*sizeof(double);              //PHI, RHS, DIAG and the gradient scratch arrays
+    bytes += NZND*(sizeof(double) + sizeof(int)) + (nNodes + 1)*sizeof(int);   //SK, col_ind, row_ptr
+    bytes += 10*nNodes*sizeof(double);             //solver vectors and preconditioner
+    if(deflationSpace)
+        bytes += (long long)(deflationSpace->getWindowSize() + 5*deflationSpace->getMaxVectors())*nNodes*sizeof(double);
+
+    //input grids (elevation and surface properties) and AngleGrid, VelocityGrid, CloudGrid
+    bytes += 8*(long long)demRows*demCols*sizeof(double);
+    bytes += 3*nCells*sizeof(double);
+
+    //output files are written one after the other, each resamples a speed and a direction grid
+    long long nOutputCells = 0;
+    double outputResolutions[6] = { input.googOutFlag ? input.kmzResolution : 0.0,
+                                    input.shpOutFlag ? input.shpResolution : 0.0,
+                                    input.asciiOutFlag ? input.velResolution : 0.0,
+                                    input.geoTiffOutFlag ? input.geoTiffResolution : 0.0,
+                                    input.pdfOutFlag ? input.pdfResolution : 0.0,
+                                    input.fgbzOutFlag ? input.fgbzResolution : 0.0 };
+    for(int i = 0; i < 6; i++)
+    {
+        if(outputResolutions[i] > 0.0)
+            nOutputCells = std::max(nOutputCells, (long long)((Xlength/outputResolutions[i] + 1)*(Ylength/outputResolutions[i] + 1)));
+    }
+    bytes += 2*std::max(nOutputCells, nCells)*sizeof(double);
+    if(input.volVTKOutFlag)
+        bytes += 3*nNodes*sizeof(double);
+
+    return bytes;
+}
+
 void ninja::set_outputSpeedGridResolution(double resolution, lengthUnits::eLengthUnits units) {
     lengthUnits::toBaseUnits(resolution, units);
     outputSpeedArrayResolution = resolution;
@@ -4901,6 +5508,50 @@ int ninja::get_outputGridnRows()
     return input.dem.get_nRows();
 }
 
+/**
+ * Statistics of the solves done in the last simulate_wind(), one per call
+ * to the solver (matching runs solve more than once).
+ */
+const std::vector<SolverStats>& ninja::get_solverStats() const
+{
+    return solverStats;
+}
+
+/**
+ * Directory the output files are written to: the custom output path, else
+ * the directory of the forecast for a wxModel run, else that of the DEM.
+ */
+std::string ninja::computeOutputPath()
+{
+    std::string pathName;
+    if(input.customOutputPath == "!set"){ // if a custom output path was not specified in the cli
+        if( input.initializationMethod == WindNinjaInputs::wxModelInitializationFlag ||
+            input.initializationMethod == WindNinjaInputs::foamWxModelInitializationFlag )  //prepend directory paths to rootFile for wxModel run
+        {
+            pathName = CPLGetPath(input.forecastFilename.c_str());
+            //if it's a .tar, write to directory containing the .tar file
+            if( strstr(pathName.c_str(), ".tar") ){
+                pathName.erase( pathName.rfind("/") );
+            }
+        }else{
+            pathName = CPLGetPath(input.dem.fileName.c_str());
+        }
+    }
+    else{ // if a custom output path was specified in the cli
+        pathName = input.customOutputPath;
+    }
+    return pathName;
+}
+
+/**
+ * Solver statistics of the last simulate_wind() as a JSON document.
+ * @return Empty string if no simulation has been done.
+ */
+const char* ninja::get_solverStatsJson() const
+{
+    return solverStatsJson.c_str();
+}
+
 void ninja::set_outputBufferClipping(double percent)
 {
     if(percent < 0.0 || percent >= 50.0)
@@ -5108,6 +5759,11 @@ void ninja::set_txtOutFlag(bool flag)
     input.txtOutFlag = flag;
 }
 
+void ninja::set_solverStatsOutFlag(bool flag)
+{
+    input.solverStatsOutFlag = flag;
+}
+
 void ninja::set_vtkOutFlag(bool flag)
 {
     input.volVTKOutFlag = flag;
@@ -5241,7 +5897,7 @@ void ninja::set_outputFilenames(double& meshResolution,
     }
     else if( input.initializationMethod == WindNinjaInputs::pointInitializationFlag )
     {
-        if(wxStation::stationFormat == wxStation::newFormat)
+        if(input.stationFormat == wxStation::newFormat)
         {
             timestream << input.ninjaTime;
         }
@@ -5249,26 +5905,9 @@ void ninja::set_outputFilenames(double& meshResolution,
     else if( input.stabilityFlag == true && input.alphaStability == -1 )
         timestream << input.ninjaTime;
 
-    std::string pathName;
+    std::string pathName = computeOutputPath();
     std::string baseName(CPLGetBasename(input.dem.fileName.c_str()));
 
-    if(input.customOutputPath == "!set"){ // if a custom output path was not specified in the cli
-        if( input.initializationMethod == WindNinjaInputs::wxModelInitializationFlag ||
-            input.initializationMethod == WindNinjaInputs::foamWxModelInitializationFlag )  //prepend directory paths to rootFile for wxModel run
-        {
-            pathName = CPLGetPath(input.forecastFilename.c_str());
-            //if it's a .tar, write to directory containing the .tar file
-            if( strstr(pathName.c_str(), ".tar") ){
-                pathName.erase( pathName.rfind("/") );
-            }
-        }else{
-            pathName = CPLGetPath(input.dem.fileName.c_str());
-        }
-    }
-    else{ // if a custom output path was specified in the cli
-        pathName = input.customOutputPath;
-    }
-
     rootFile = CPLFormFilename(pathName.c_str(), baseName.c_str(), NULL);
 
     /* set the output path member variable */
@@ -5408,6 +6047,7 @@ void ninja::set_outputFilenames(double& meshResolution,
 
     input.velFile = rootFile + ascii_fileAppend + "_vel.asc";
     input.angFile = rootFile + ascii_fileAppend + "_ang.asc";
+    input.solverStatsFile = rootFile + ascii_fileAppend + "_solver.json";
 
     #ifdef FRICTION_VELOCITY
     input.ustarFile = rootFile + ascii_fileAppend + "_ustar.asc";
@@ -5454,6 +6094,19 @@ void ninja::keepOutputGridsInMemory(bool flag)
     input.keepOutGridsInMemory = flag;
 }
 
+/**
+ * Function that sets a flag to also fill and keep UGrid, VGrid and WGrid,
+ * the wind components at the output wind height, in the output speed units.
+ * They are kept only as long as the other output grids, see
+ * keepOutputGridsInMemory(), and stay empty for runs that don't solve, such
+ * as runs reused from the result cache.
+ * @param flag True to fill the grids.
+ */
+void ninja::keepUvwGridsInMemory(bool flag)
+{
+    keepUvwGrids = flag;
+}
+
 double ninja::getFuelBedDepth(int fuelModel)
 {	
     double depthInFeet;
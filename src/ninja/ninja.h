@@ -68,6 +68,13 @@
 #include "KmlVector.h"
 #include "ShapeVector.h"
 #include "preconditioner.h"
+#include "ninjaBlas.h"
+#include "solverStats.h"
+#include "deflationSpace.h"
+#include "outputQueue.h"
+#include "resultCache.h"
+#include "runJournal.h"
+#include "ensembleStats.h"
 #include "volVTK.h"
 #include "ninjaCom.h"
 #include "ninjaException.h"
@@ -111,8 +118,6 @@
 #include "dust.h"
 #endif
 
-#define OFFSET(N, incX) ((incX) > 0 ?  0 : ((N) - 1) * (-(incX))) //for cblas_dscal
-
 #define LENGTH 256
 
 //#define NINJA_DEBUG
@@ -138,12 +143,13 @@ public:
     AsciiGrid<double>AngleGrid;
     AsciiGrid<double>VelocityGrid;
     AsciiGrid<double>CloudGrid;
+    AsciiGrid<double>UGrid, VGrid, WGrid;   //wind components at the output height, only with keepUvwGridsInMemory()
 #ifdef NINJAFOAM
     AsciiGrid<double>TurbulenceGrid; //this needs to be a member of ninja since we need to write this for ninjafoam runs with diurnal 
     AsciiGrid<double> colMaxGrid; // same as for TurbulenceGrid
 #endif
 
-    wn_3dScalarField alphaVfield; //store spatially varying alphaV variable
+    AlphaField alphaVfield; //store spatially varying alphaV variable
 
     #ifdef FRICTION_VELOCITY
     AsciiGrid<double>UstarGrid;
@@ -175,6 +181,7 @@ public:
     ***************************************************************/
     void readInputFile(std::string fileName);
     void readInputFile();
+    void readInputFileFromDisk();
     void importSingleBand(GDALDataset*);
     void importLCP(GDALDataset*);
     void importGeoTIFF(GDALDataset*);
@@ -298,6 +305,17 @@ public:
     void set_position(double lat_degrees, double lat_minutes, double long_degrees, double long_minutes);	//input as degrees, decimal minutes
     void set_position(double lat_degrees, double lat_minutes, double lat_seconds, double long_degrees, double long_minutes, double long_seconds);	//input as degrees, minutes, seconds
     virtual void set_numberCPUs(int CPUs);
+    void set_solverTolerance(double tol);	//stopping tolerance on the relative residual, default is 1E-1
+    void set_solverIterationBudget(int maxIterations, double timeLimit);	//keep the result after maxIterations or timeLimit seconds (-1 => no budget)
+    void set_solverSurfaceWindTolerance(double tol, velocityUnits::eVelocityUnits units);	//stop when the output height wind changes less than tol between checks (-1 => off)
+    void set_deflationSpace(boost::shared_ptr<DeflationSpace> space);	//deflation space recycled between CG solves, may be shared between runs (NULL => off)
+    void set_outputQueue(boost::shared_ptr<OutputQueue> queue);	//write the output files in the background (NULL => write before simulate_wind() returns)
+    void set_resultCache(boost::shared_ptr<ResultCache> cache);	//reuse the output grids of earlier identical runs (NULL => off)
+    void set_runJournal(boost::shared_ptr<RunJournal> journal);	//skip runs whose output files were written before a restart (NULL => off)
+    void set_ensembleStats(boost::shared_ptr<EnsembleStats> stats);	//add the output grids to the statistics of the army (NULL => off)
+    bool estimate_demSize(int &nRows, int &nCols, double &cellSize);	//size of the DEM, from the file header if it isn't read yet
+    long estimate_numNodes();	//estimated number of mesh nodes of a run, before it starts
+    long long estimate_peakMemory();	//estimated peak memory of a run in bytes, before it starts
     void set_outputSpeedGridResolution(double resolution, lengthUnits::eLengthUnits units);
     void set_outputDirectionGridResolution(double resolution, lengthUnits::eLengthUnits units);
     double *get_outputSpeedGrid();
@@ -341,6 +359,7 @@ public:
     void set_wxModelAsciiOutFlag(bool flag);
     void set_asciiResolution(double Resolution, lengthUnits::eLengthUnits units);	//sets the output resolution of the velocity and angle ASCII grid output files, if negative value the computational mesh resolution is used
     void set_txtOutFlag(bool flag);
+    void set_solverStatsOutFlag(bool flag);	//determines if the solver statistics (*_solver.json) file will be written
     void set_vtkOutFlag(bool flag);		//determines if VTK volume output files will be written
     void set_pdfOutFlag(bool flag);
     void set_pdfResolution(double Resolution, lengthUnits::eLengthUnits units);
@@ -358,10 +377,14 @@ public:
     void set_outputFilenames(double& meshResolution, lengthUnits::eLengthUnits meshResolutionUnits);
     const std::string get_outputPath() const;
     void keepOutputGridsInMemory(bool flag);
+    void keepUvwGridsInMemory(bool flag);	//also keep UGrid, VGrid and WGrid with the output grids
     void set_outputPath(std::string path);
 
     void set_PrjString(std::string prj);
 
+    const std::vector<SolverStats>& get_solverStats() const;
+    const char* get_solverStatsJson() const;
+
     double getFuelBedDepth(int fuelModel);
 
     void checkInputs();
@@ -406,6 +429,16 @@ private:
     double outputSpeedArrayResolution;
     double outputDirectionArrayResolution;
 
+    std::vector<SolverStats> solverStats;   //one record per call to the solver in the last run
+    std::string solverStatsJson;            //solverStats as JSON, returned in the API
+    boost::shared_ptr<DeflationSpace> deflationSpace;   //recycled CG deflation vectors, NULL if not used
+    boost::shared_ptr<OutputQueue> outputQueue;         //background output writers, NULL if not used
+    boost::shared_ptr<ResultCache> resultCache;         //output grids of earlier runs, NULL if not used
+    boost::shared_ptr<RunJournal> runJournal;           //finished runs of the army, NULL if not used
+    std::string journalKey;                             //key of this run in runJournal, empty if not journaled
+    boost::shared_ptr<EnsembleStats> ensembleStats;     //statistics of the army's output grids, NULL if not used
+
+    bool keepUvwGrids;		//fill UGrid, VGrid and WGrid in interp_uvw()
     bool isNullRun;			//flag identifying if this run is a "null" run, ie. run with all zero speed for intitialization
     double maxStartingOuterDiff;   //stores the maximum difference for "matching" runs from the first iteration (used to determine convergence)
 
@@ -434,24 +467,19 @@ private:
     bool solveMinres(double *A, double *b, double *x, int *row_ptr, int *col_ind, int NUMNP, int max_iter, int print_iters, double tol);
 
     /*-----------------------------------------------------------------------------
-     *  MKL Specific Functions
+     *  Stopping checks on the wind at the output height
      *-----------------------------------------------------------------------------*/
-    void cblas_dcopy(const int N, const double *X, const int incX,
-                                        double *Y, const int incY);
-
-    double cblas_ddot(const int N, const double *X, const int incX,
-                                   const double *Y, const int incY);
-
-    void cblas_daxpy(const int N, const double alpha, const double *X, const int incX,
-                                                            double *Y, const int incY);
-
-    double cblas_dnrm2(const int N, const double *X, const int incX);
+    void findOutputHeightLayers(std::vector<int> &layer, int &kMin, int &kMax);
+    double surfaceWindChange(const double *x, const std::vector<double> &xOld,
+                             const std::vector<int> &layer, int kMin);
 
+    /*-----------------------------------------------------------------------------
+     *  MKL Specific Functions (BLAS level 1 routines are in ninjaBlas)
+     *-----------------------------------------------------------------------------*/
     void mkl_dcsrmv(char *transa, int *m, int *k, double *alpha, char *matdescra,
                     double *val, int *indx, int *pntrb, int *pntre, double *x,
                     double *beta, double *y);
 
-    void cblas_dscal(const int N, const double alpha, double *X, const int incX);
     void mkl_trans_dcsrmv(char *transa, int *m, int *k, double *alpha, char *matdescra, double *val, int *indx, int *pntrb, int *pntre, double *x, double *beta, double *y);
 
     /*-----------------------------------------------------------------------------
@@ -489,6 +517,13 @@ private:
     void prepareOutput();
     bool matched(int iter);
     void writeOutputFiles(); 
+    void writeOutputGrids(AsciiGrid<double> &demGrid);
+    bool reuseCachedResult(const std::string &key);
+    bool skipJournaledRun();
+    void addToEnsembleStats();
+    std::vector<std::string> getJournalFiles();
+    std::string computeOutputPath();
+    friend class OutputQueue;
     void deleteDynamicMemory();
 
 };
@@ -28,6 +28,8 @@
 *****************************************************************************/
 
 #include "ninjaArmy.h"
+#include "terrainContext.h"
+#include "forecastCache.h"
 /**
 * @brief Default constructor.
 *
@@ -37,6 +39,23 @@ ninjaArmy::ninjaArmy()
     Com = new ninjaComClass();
     Com->runNumber = 9999;
     Com->printRunNumber = false;
+    memoryBudget = -1.0;
+    nOutputWriters = -1;
+    resultCacheSize = 1024.0;
+    resumeRuns = false;
+    ensembleStatsFlag = false;
+    ensemblePercentiles.push_back( 50.0 );
+    ensemblePercentiles.push_back( 90.0 );
+    pfnRunComplete = NULL;
+    pRunCompleteUser = NULL;
+    runCompleteUvw = false;
+    runsMutex = CPLCreateMutex();   //created locked
+    CPLReleaseMutex( runsMutex );
+    runsThread = NULL;
+    asyncProcessors = 1;
+    asyncStatus = true;
+    asyncDone = true;
+    nRunsFinished = 0;
 
 //    ninjas.push_back(new ninja());
     initLocalData();
@@ -52,6 +71,28 @@ ninjaArmy::ninjaArmy(const ninjaArmy& A)
     Com = new ninjaComClass(*A.Com);
 
     ninjas = A.ninjas;
+    deflationSpace = A.deflationSpace;
+    terrainContext = A.terrainContext;
+    memoryBudget = A.memoryBudget;
+    nOutputWriters = A.nOutputWriters;
+    resultCacheDirectory = A.resultCacheDirectory;
+    resultCacheSize = A.resultCacheSize;
+    resumeRuns = A.resumeRuns;
+    ensembleStatsFlag = A.ensembleStatsFlag;
+    ensemblePercentiles = A.ensemblePercentiles;
+    stationKmlNames = A.stationKmlNames;
+    pfnRunComplete = A.pfnRunComplete;
+    pRunCompleteUser = A.pRunCompleteUser;
+    runCompleteUvw = A.runCompleteUvw;
+    finishedSolverStats = A.finishedSolverStats;
+    finishedSolverStatsJson = A.finishedSolverStatsJson;
+    runsMutex = CPLCreateMutex();
+    CPLReleaseMutex( runsMutex );
+    runsThread = NULL;
+    asyncProcessors = 1;
+    asyncStatus = true;
+    asyncDone = true;
+    nRunsFinished = 0;
     copyLocalData( A );
 }
 
@@ -61,6 +102,13 @@ ninjaArmy::ninjaArmy(const ninjaArmy& A)
 */
 ninjaArmy::~ninjaArmy()
 {
+    if( runsThread != NULL )
+    {
+        cancel();
+        CPLJoinThread( runsThread );
+        runsThread = NULL;
+    }
+    CPLDestroyMutex( runsMutex );
     if(ninjas.size() >= 1)
     {
         delete ninjas[0];
@@ -84,6 +132,21 @@ ninjaArmy& ninjaArmy::operator= (ninjaArmy const& A)
         *Com = *A.Com;
 
         ninjas = A.ninjas;
+        deflationSpace = A.deflationSpace;
+        terrainContext = A.terrainContext;
+        memoryBudget = A.memoryBudget;
+        nOutputWriters = A.nOutputWriters;
+        resultCacheDirectory = A.resultCacheDirectory;
+        resultCacheSize = A.resultCacheSize;
+        resumeRuns = A.resumeRuns;
+        ensembleStatsFlag = A.ensembleStatsFlag;
+        ensemblePercentiles = A.ensemblePercentiles;
+        stationKmlNames = A.stationKmlNames;
+        pfnRunComplete = A.pfnRunComplete;
+        pRunCompleteUser = A.pRunCompleteUser;
+        runCompleteUvw = A.runCompleteUvw;
+        finishedSolverStats = A.finishedSolverStats;
+        finishedSolverStatsJson = A.finishedSolverStatsJson;
         copyLocalData( A );
     }
     return *this;
@@ -227,15 +290,16 @@ void ninjaArmy::makePointArmy(std::vector<boost::posix_time::ptime> timeList,
         }
         ninjas[i]->set_wxStations(stationList);
         ninjas[i]->set_wxStationFilename(stationFileName);
+        //old format files have no times, which then stay out of the output file names
+        ninjas[i]->input.stationFormat = stationFormat == 1 ? wxStation::oldFormat : wxStation::newFormat;
         //Setting the filename also implicitly sets the stations, set above
         //in set_wxStations. Also it gets the units from the first station
         //The function name is a bit misleading as to what it really does.
         ninjas[i]->set_initializationMethod(WindNinjaInputs::pointInitializationFlag, matchPoints);
    }
 
-    // need to always clear these static values out before adding new ones,
-    // between each download/run, or they get kept across downloads/runs.
-    wxStation::stationKmlNames.clear();
+    // station kml files are written per run after the army is made
+    stationKmlNames.clear();
 }
 
 /**
@@ -313,6 +377,268 @@ void ninjaArmy::makeWeatherModelArmy(std::string forecastFilename, std::string t
     delete model;
 }
 
+/**
+* @brief Number of runs that can go at the same time without running out of memory.
+*
+* The peak memory of each run is estimated with ninja::estimate_peakMemory()
+* and the largest runs are assumed to end up running together.  The budget
+* is the one from setMemoryBudget(), else NINJA_ARMY_MEMORY_BUDGET (MB),
+* else 80% of the usable RAM.
+*
+* @return Largest number of concurrent runs, at least 1.
+*/
+int ninjaArmy::maxRunsInMemory()
+{
+    double budget = memoryBudget;
+    if( budget <= 0.0 )
+        budget = atof( CPLGetConfigOption( "NINJA_ARMY_MEMORY_BUDGET", "-1" ) );
+    if( budget > 0.0 )
+        budget *= 1024.0 * 1024.0;
+    else
+        budget = 0.8 * CPLGetUsablePhysicalRAM();
+    if( budget <= 0.0 )
+        return ninjas.size();
+
+    std::vector<long long> memory( ninjas.size() );
+    for( unsigned int i = 0; i < ninjas.size(); i++ )
+        memory[i] = ninjas[i]->estimate_peakMemory();
+    std::sort( memory.begin(), memory.end(), std::greater<long long>() );
+
+    int nRuns = 0;
+    double total = 0.0;
+    while( nRuns < (int)memory.size() && total + memory[nRuns] <= budget )
+    {
+        total += memory[nRuns];
+        nRuns++;
+    }
+    if( nRuns == 0 )
+    {
+        ninjas[0]->input.Com->ninjaCom( ninjaComClass::ninjaWarning,
+                "The largest run needs about %.0lf MB, more than the memory budget of %.0lf MB.",
+                memory[0] / ( 1024.0 * 1024.0 ), budget / ( 1024.0 * 1024.0 ) );
+        nRuns = 1;
+    }
+    else if( nRuns < (int)memory.size() )
+    {
+        CPLDebug( "NINJA", "Memory budget of %.0lf MB allows %d concurrent runs (largest run about %.0lf MB).",
+                  budget / ( 1024.0 * 1024.0 ), nRuns, memory[0] / ( 1024.0 * 1024.0 ) );
+    }
+    return nRuns;
+}
+
+int ninjaArmy::setMemoryBudget( const double megabytes, char ** papszOptions )
+{
+    if( megabytes <= 0.0 && megabytes != -1.0 )
+    {
+        return NINJA_E_INVALID;
+    }
+    memoryBudget = megabytes;
+    return NINJA_SUCCESS;
+}
+
+int ninjaArmy::setOutputWriters( const int nWriters, char ** papszOptions )
+{
+    if( nWriters < -1 )
+    {
+        return NINJA_E_INVALID;
+    }
+    nOutputWriters = nWriters;
+    return NINJA_SUCCESS;
+}
+
+int ninjaArmy::setResultCache( const std::string directory, const double megabytes, char ** papszOptions )
+{
+    if( megabytes <= 0.0 )
+    {
+        return NINJA_E_INVALID;
+    }
+    resultCacheDirectory = directory;
+    resultCacheSize = megabytes;
+    return NINJA_SUCCESS;
+}
+
+int ninjaArmy::setResume( const bool flag, char ** papszOptions )
+{
+    resumeRuns = flag;
+    return NINJA_SUCCESS;
+}
+
+/*
+** Parse a comma separated list of percentiles, all in (0, 100).
+*/
+static bool parsePercentiles( const char *pszList, std::vector<double> &percentiles )
+{
+    char **papszValues = CSLTokenizeString2( pszList, ", ", 0 );
+    std::vector<double> values;
+    for( int i = 0; papszValues != NULL && papszValues[i] != NULL; i++ )
+    {
+        values.push_back( CPLAtof( papszValues[i] ) );
+    }
+    CSLDestroy( papszValues );
+    for( unsigned int i = 0; i < values.size(); i++ )
+    {
+        if( values[i] <= 0.0 || values[i] >= 100.0 )
+        {
+            return false;
+        }
+    }
+    percentiles = values;
+    return true;
+}
+
+int ninjaArmy::setEnsembleStats( const bool flag, const std::string percentiles, char ** papszOptions )
+{
+    if( !parsePercentiles( percentiles.c_str(), ensemblePercentiles ) )
+    {
+        return NINJA_E_INVALID;
+    }
+    ensembleStatsFlag = flag;
+    return NINJA_SUCCESS;
+}
+
+void ninjaArmy::setTerrainContext( boost::shared_ptr<TerrainContext> terrain )
+{
+    terrainContext = terrain;
+}
+
+void ninjaArmy::setDeflationSpace( boost::shared_ptr<DeflationSpace> space )
+{
+    deflationSpace = space;
+}
+
+/**
+* @brief Choose how the runs of the army share the processors.
+*
+* Every split of numProcessors into nConcurrentRuns runs with nThreadsPerRun
+* threads each is tried by list scheduling the runs, most expensive first,
+* on nConcurrentRuns workers.  A run on T threads is assumed to take
+* (1 + s*(T-1))/T of its single thread time, s being the part of a run that
+* doesn't speed up with threads (NINJA_ARMY_SERIAL_FRACTION, default 0.15).
+* The split with the shortest estimated makespan wins, ties go to fewer
+* threads per run.  Small meshes don't scale, so a run gets at most one
+* thread per NINJA_ARMY_NODES_PER_THREAD (default 50000) mesh nodes.
+* NINJA_ARMY_THREADS_PER_RUN forces the number of threads per run.  The
+* number of concurrent runs never exceeds maxRunsInMemory().
+*
+* @param numProcessors Number of processors to use.
+* @param nConcurrentRuns Number of runs to do at the same time.
+* @param nThreadsPerRun Number of threads for each run.
+* @param runOrder Run indices in the order they should be started.
+*/
+void ninjaArmy::scheduleRuns( const int numProcessors, int &nConcurrentRuns,
+                              int &nThreadsPerRun, std::vector<int> &runOrder )
+{
+    const int nRuns = ninjas.size();
+    double serialFraction = atof( CPLGetConfigOption( "NINJA_ARMY_SERIAL_FRACTION", "0.15" ) );
+    long nodesPerThread = atol( CPLGetConfigOption( "NINJA_ARMY_NODES_PER_THREAD", "50000" ) );
+    int nForcedThreads = atoi( CPLGetConfigOption( "NINJA_ARMY_THREADS_PER_RUN", "0" ) );
+
+    /*
+    ** Relative cost of each run on one thread: mesh size, times the outer
+    ** iterations of station matching and the extra work of diurnal and
+    ** stability runs.
+    */
+    std::vector<double> cost( nRuns );
+    long maxNodes = 0;
+    for( int i = 0; i < nRuns; i++ )
+    {
+        long nodes = ninjas[i]->estimate_numNodes();
+        maxNodes = std::max( maxNodes, nodes );
+        cost[i] = nodes > 0 ? (double)nodes : 1.0;
+        if( ninjas[i]->input.initializationMethod == WindNinjaInputs::pointInitializationFlag &&
+            ninjas[i]->input.matchWxStations )
+            cost[i] *= 3.0;
+        if( ninjas[i]->input.diurnalWinds )
+            cost[i] *= 1.25;
+        if( ninjas[i]->input.stabilityFlag )
+            cost[i] *= 1.1;
+    }
+
+    runOrder.resize( nRuns );
+    for( int i = 0; i < nRuns; i++ )
+        runOrder[i] = i;
+    std::stable_sort( runOrder.begin(), runOrder.end(),
+                      [&cost]( int a, int b ) { return cost[a] > cost[b]; } );
+
+    int nMaxRuns = maxRunsInMemory();
+
+    int maxThreads = numProcessors;
+    if( nodesPerThread > 0 && maxNodes > 0 )
+        maxThreads = std::max( 1L, std::min( (long)numProcessors, maxNodes / nodesPerThread ) );
+
+    nThreadsPerRun = 1;
+    nConcurrentRuns = std::min( std::min( nRuns, nMaxRuns ), numProcessors );
+    if( nForcedThreads > 0 )
+    {
+        nThreadsPerRun = std::min( nForcedThreads, numProcessors );
+        nConcurrentRuns = std::max( 1, std::min( std::min( nRuns, nMaxRuns ), numProcessors / nThreadsPerRun ) );
+    }
+    else
+    {
+        double bestMakespan = -1.0;
+        for( int nThreads = 1; nThreads <= maxThreads; nThreads++ )
+        {
+            int nWorkers = std::min( std::min( nRuns, nMaxRuns ), numProcessors / nThreads );
+            double scale = ( 1.0 + serialFraction * ( nThreads - 1 ) ) / nThreads;
+            std::vector<double> finish( nWorkers, 0.0 );
+            for( int k = 0; k < nRuns; k++ )
+            {
+                //the next run goes to the first worker to finish
+                std::vector<double>::iterator worker = std::min_element( finish.begin(), finish.end() );
+                *worker += cost[runOrder[k]] * scale;
+            }
+            double makespan = *std::max_element( finish.begin(), finish.end() );
+            if( bestMakespan < 0.0 || makespan < bestMakespan * ( 1.0 - 1E-9 ) )
+            {
+                bestMakespan = makespan;
+                nThreadsPerRun = nThreads;
+                nConcurrentRuns = nWorkers;
+            }
+        }
+    }
+
+    CPLDebug( "NINJA", "Scheduling %d runs as %d concurrent runs with %d threads each.",
+              nRuns, nConcurrentRuns, nThreadsPerRun );
+}
+
+/*
+** Keeps the output grids of the runs in memory for the run complete handler
+** (see runFinished()) while startRuns() goes, and puts back the settings the
+** runs had when it returns or throws, so later runs free their grids and
+** use the run journal as before.
+*/
+class runCompleteGridsGuard
+{
+public:
+    runCompleteGridsGuard( std::vector<ninja*> &runs, bool uvwFlag ) : ninjas( runs )
+    {
+        for(unsigned int i = 0; i < ninjas.size(); i++)
+        {
+            keptGrids.push_back( ninjas[i]->input.keepOutGridsInMemory );
+            ninjas[i]->keepOutputGridsInMemory( true );
+            ninjas[i]->keepUvwGridsInMemory( uvwFlag );
+        }
+    }
+    ~runCompleteGridsGuard()
+    {
+        for(unsigned int i = 0; i < ninjas.size() && i < keptGrids.size(); i++)
+        {
+            if( ninjas[i] != NULL )  //finished runs may be deleted
+            {
+                ninjas[i]->keepOutputGridsInMemory( keptGrids[i] );
+                ninjas[i]->keepUvwGridsInMemory( false );
+            }
+        }
+    }
+
+private:
+    std::vector<ninja*> &ninjas;
+    std::vector<bool> keptGrids;
+
+    runCompleteGridsGuard( const runCompleteGridsGuard & );
+    void operator=( const runCompleteGridsGuard & );
+};
+
 /**
 * @brief Function to start WindNinja core runs using multiple threads.
 *
@@ -327,6 +653,30 @@ bool ninjaArmy::startRuns(int numProcessors)
     if(ninjas.size()<1 || numProcessors<1)
         return false;
 
+    //finished runs may be deleted before their solver statistics are asked for, see runFinished()
+    CPLAcquireMutex( runsMutex, 1000.0 );
+    finishedSolverStats.assign( ninjas.size(), std::vector<SolverStats>() );
+    finishedSolverStatsJson.assign( ninjas.size(), std::string() );
+    CPLReleaseMutex( runsMutex );
+
+#ifdef _OPENMP
+    /*
+    ** The thread counts and nesting set below only hold for the runs of this
+    ** army; the calling thread gets its own settings back when we return, so
+    ** armies started from different threads of a host program don't clash.
+    */
+    omp_settings_guard ompSettings;
+    omp_set_nested(false);
+    omp_set_dynamic(false);
+#endif
+
+    //runs hand their output grids to the run complete handler, see runFinished()
+    boost::shared_ptr<runCompleteGridsGuard> runCompleteGrids;
+    if( pfnRunComplete != NULL )
+    {
+        runCompleteGrids.reset( new runCompleteGridsGuard( ninjas, runCompleteUvw ) );
+    }
+
     //check for duplicate runs before we start the simulations
     //this is mostly for batch domain avg runs in the GUI and the API
     if(ninjas.size() > 1)
@@ -345,30 +695,70 @@ bool ninjaArmy::startRuns(int numProcessors)
         }
     }
 
+    /*
+    ** Reuse the output grids of identical earlier runs, see ResultCache.  The
+    ** directory is the one from setResultCache(), else NINJA_RESULT_CACHE
+    ** (NINJA_RESULT_CACHE_SIZE MB, default 1024).
+    */
+    std::string cacheDirectory = resultCacheDirectory;
+    double cacheSize = resultCacheSize;
+    if( cacheDirectory.empty() )
+    {
+        cacheDirectory = CPLGetConfigOption( "NINJA_RESULT_CACHE", "" );
+        cacheSize = atof( CPLGetConfigOption( "NINJA_RESULT_CACHE_SIZE", "1024" ) );
+    }
+    if( !cacheDirectory.empty() && cacheSize > 0.0 )
+    {
+        boost::shared_ptr<ResultCache> cache( new ResultCache( cacheDirectory, cacheSize ) );
+        for(unsigned int i = 0; i < ninjas.size(); i++)
+        {
+            ninjas[i]->set_resultCache( cache );
+        }
+    }
+
+    /*
+    ** Skip the runs finished before the army was stopped, see RunJournal.
+    ** Runs record themselves in the journal of their output directory once
+    ** their files are written.
+    */
+    if( resumeRuns || CSLTestBoolean( CPLGetConfigOption( "NINJA_ARMY_RESUME", "FALSE" ) ) )
+    {
+        boost::shared_ptr<RunJournal> journal( new RunJournal() );
+        for(unsigned int i = 0; i < ninjas.size(); i++)
+        {
+            ninjas[i]->set_runJournal( journal );
+        }
+    }
+
 #ifdef NINJAFOAM
-    //if it's a ninjafoam run and the user specified an existing case dir, set it here
-    if(ninjas[0]->identify() == "ninjafoam" & ninjas[0]->input.existingCaseDirectory != "!set"){
-        NinjaFoam::SetFoamPath(ninjas[0]->input.existingCaseDirectory.c_str());
-    }
-    //if it's a ninjafoam run and the case is not set by the user, generate the ninjafoam dir
-    if(ninjas[0]->identify() == "ninjafoam" & ninjas[0]->input.existingCaseDirectory == "!set"){
-        //force temp dir to DEM location
-        CPLSetConfigOption("CPL_TMPDIR", CPLGetDirname(ninjas[0]->input.dem.fileName.c_str()));
-        CPLSetConfigOption("CPLTMPDIR", CPLGetDirname(ninjas[0]->input.dem.fileName.c_str()));
-        CPLSetConfigOption("TEMP", CPLGetDirname(ninjas[0]->input.dem.fileName.c_str()));
-        int status = NinjaFoam::GenerateFoamDirectory(ninjas[0]->input.dem.fileName);
-        if(status != 0){
-            ninjas[0]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Error generating the NINJAFOAM directory.");
-            throw std::runtime_error("Error generating the NINJAFOAM directory.");
+    /*
+    ** The case directory belongs to this army, so concurrent armies each run
+    ** in their own.
+    */
+    if(ninjas[0]->identify() == "ninjafoam"){
+        boost::shared_ptr<std::string> foamPath( new std::string() );
+        //if it's a ninjafoam run and the user specified an existing case dir, set it here
+        if(ninjas[0]->input.existingCaseDirectory != "!set"){
+            *foamPath = ninjas[0]->input.existingCaseDirectory;
+        }
+        //if it's a ninjafoam run and the case is not set by the user, generate the ninjafoam dir
+        else{
+            int status = NinjaFoam::GenerateFoamDirectory(ninjas[0]->input.dem.fileName, *foamPath);
+            if(status != 0){
+                ninjas[0]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Error generating the NINJAFOAM directory.");
+                throw std::runtime_error("Error generating the NINJAFOAM directory.");
+            }
+        }
+        for(unsigned int i = 0; i < ninjas.size(); i++)
+        {
+            if(ninjas[i]->identify() == "ninjafoam")
+            {
+                static_cast<NinjaFoam*>( ninjas[i] )->SetFoamPath( foamPath );
+            }
         }
     }
 #endif //NINJAFOAM
 
-#ifdef _OPENMP
-    omp_set_nested(false);
-    //omp_set_dynamic(true);
-#endif
-
     //TODO: move common parameters (resolutions, input filenames, output arguments) to ninjaArmy or change storage class specifier to static
 
     /*
@@ -406,7 +796,7 @@ bool ninjaArmy::startRuns(int numProcessors)
         int nNewXSize = nXSize * dfRatio;
         int nNewYSize = nYSize * dfRatio;
 
-        CPLSetConfigOption( "GDAL_PAM_ENABLED", "OFF" );
+        CPLSetThreadLocalConfigOption( "GDAL_PAM_ENABLED", "OFF" );
 
         SURF_FETCH_E retval = SURF_FETCH_E_NONE;
         if( ninjas[0]->input.pdfBaseType == WindNinjaInputs::TOPOFIRE )
@@ -490,7 +880,7 @@ bool ninjaArmy::startRuns(int numProcessors)
         {
             ninjas[i]->input.pdfDEMFileName = pszTmpColorRelief;
         }
-        CPLSetConfigOption( "GDAL_PAM_ENABLED", "ON" );
+        CPLSetThreadLocalConfigOption( "GDAL_PAM_ENABLED", NULL );
     }
 
     // prep/reset the stored atmosphere file data, to be filled before ninjas[i] gets deleted after each run
@@ -506,6 +896,10 @@ bool ninjaArmy::startRuns(int numProcessors)
     {
         //set number of threads for the run
         ninjas[0]->set_numberCPUs(numProcessors);
+        if( terrainContext && ninjas[0]->identify() == "ninja" )
+        {
+            ninjas[0]->input.terrain = terrainContext;
+        }
         try{
             if ((ninjas[0]->identify() == "ninjafoam") && ninjas[0]->input.diurnalWinds)
             {
@@ -615,25 +1009,31 @@ bool ninjaArmy::startRuns(int numProcessors)
             //setup the run map visualization filenames, for C-API calls
             setCurrentMapVisualizationFilenames(0);
 
+            runFinished(0);
+
         }catch (bad_alloc& e)
         {
             ninjas[0]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception bad_alloc caught: %s\nWindNinja appears to have run out of memory.", e.what());
             status = false;
+            runFinished(0, STD_BAD_ALLOC_EXC);
             throw;
         }catch (cancelledByUser& e)
         {
             ninjas[0]->input.Com->ninjaCom(ninjaComClass::ninjaNone, "Exception caught: %s", e.what());
             status = false;
+            runFinished(0, NINJA_CANCEL_USER_EXC);
             throw;
         }catch (exception& e)
         {
             ninjas[0]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception caught: %s", e.what());
             status = false;
+            runFinished(0, STD_EXC);
             throw;
         }catch (...)
         {
             ninjas[0]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception caught: Cannot determine exception type.");
             status = false;
+            runFinished(0, STD_UNKNOWN_EXC);
             throw;
         }
     }
@@ -748,33 +1148,38 @@ bool ninjaArmy::startRuns(int numProcessors)
                 //setup the run map visualization filenames, for C-API calls
                 setCurrentMapVisualizationFilenames(i);
 
+                runFinished(i);
+
                 //delete all but ninjas[0] (ninjas[0] is used to set the output path in the GUI)
                 //need to keep the ninjas for now, if doing a consistent color scale set of outputs
                 if( i != 0 && ninjas[0]->input.googUseConsistentColorScale == false && ninjas[0]->input.fgbzUseConsistentColorScale == false )
                 {
-                    delete ninjas[i];
-                    ninjas[i] = NULL;
+                    deleteFinishedNinja(i);
                 }
 
             }catch (bad_alloc& e)
             {
                 ninjas[i]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception bad_alloc caught: %s\nWindNinja appears to have run out of memory.", e.what());
                 status = false;
+                runFinished(i, STD_BAD_ALLOC_EXC);
                 throw;
             }catch (cancelledByUser& e)
             {
                 ninjas[i]->input.Com->ninjaCom(ninjaComClass::ninjaNone, "Exception caught: %s", e.what());
                 status = false;
+                runFinished(i, NINJA_CANCEL_USER_EXC);
                 throw;
             }catch (exception& e)
             {
                 ninjas[i]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception caught: %s", e.what());
                 status = false;
+                runFinished(i, STD_EXC);
                 throw;
             }catch (...)
             {
                 ninjas[i]->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception caught: Cannot determine exception type.");
                 status = false;
+                runFinished(i, STD_UNKNOWN_EXC);
                 throw;
             }
         }
@@ -809,9 +1214,115 @@ bool ninjaArmy::startRuns(int numProcessors)
 #endif //NINJAFOAM
     else
     {
+        /*
+        ** Run nConcurrentRuns ninjas at a time with nThreadsPerRun threads
+        ** each (see scheduleRuns()).  Runs are handed out one at a time, most
+        ** expensive first, so a worker that finishes early takes the next run.
+        */
+        int nConcurrentRuns, nThreadsPerRun;
+        std::vector<int> runOrder;
+        scheduleRuns( numProcessors, nConcurrentRuns, nThreadsPerRun, runOrder );
+
         for(unsigned int i = 0; i < ninjas.size(); i++)
         {
-            ninjas[i]->set_numberCPUs(1);
+            ninjas[i]->set_numberCPUs(nThreadsPerRun);
+        }
+
+        /*
+        ** Read, resample and compute slope/aspect of the DEM once for the whole
+        ** army; see TerrainContext.  NINJA_ARMY_SHARE_TERRAIN=FALSE makes every
+        ** run do its own, unless the terrain came from setTerrainContext().
+        */
+        boost::shared_ptr<TerrainContext> terrain = terrainContext;
+        if( !terrain && ninjas.size() > 1 &&
+            CSLTestBoolean( CPLGetConfigOption( "NINJA_ARMY_SHARE_TERRAIN", "TRUE" ) ) )
+        {
+            terrain.reset( new TerrainContext() );
+        }
+        if( terrain )
+        {
+            for(unsigned int i = 0; i < ninjas.size(); i++)
+            {
+                ninjas[i]->input.terrain = terrain;
+                if( terrain != terrainContext )
+                {
+                    //the army's own terrain drops the DEM as read once it's resampled
+                    terrain->addRun( ninjas[i]->input );
+                }
+            }
+        }
+
+        /*
+        ** Decode the forecast file once for the runs of a weather model
+        ** army; see ForecastCache.  NINJA_ARMY_SHARE_FORECAST=FALSE makes
+        ** every run decode its own time.
+        */
+        if( CSLTestBoolean( CPLGetConfigOption( "NINJA_ARMY_SHARE_FORECAST", "TRUE" ) ) )
+        {
+            boost::shared_ptr<ForecastCache> forecast( new ForecastCache() );
+            int nWxRuns = 0;
+            for(unsigned int i = 0; i < ninjas.size(); i++)
+            {
+                if( ninjas[i]->input.initializationMethod == WindNinjaInputs::wxModelInitializationFlag )
+                {
+                    forecast->expect( ninjas[i]->input.forecastFilename, ninjas[i]->input.ninjaTime, ninjas[i]->input.Com );
+                    nWxRuns++;
+                }
+            }
+            if( nWxRuns > 1 )
+            {
+                for(unsigned int i = 0; i < ninjas.size(); i++)
+                {
+                    if( ninjas[i]->input.initializationMethod == WindNinjaInputs::wxModelInitializationFlag )
+                        ninjas[i]->input.forecast = forecast;
+                }
+            }
+        }
+
+        /*
+        ** Fold the output grids of the runs into per cell statistics as they
+        ** finish, see EnsembleStats.  The percentiles are the ones from
+        ** setEnsembleStats(), else NINJA_ARMY_ENSEMBLE_PERCENTILES.
+        */
+        boost::shared_ptr<EnsembleStats> ensembleStats;
+        if( ensembleStatsFlag || CSLTestBoolean( CPLGetConfigOption( "NINJA_ARMY_ENSEMBLE_STATS", "FALSE" ) ) )
+        {
+            std::vector<double> percentiles = ensemblePercentiles;
+            if( !ensembleStatsFlag &&
+                !parsePercentiles( CPLGetConfigOption( "NINJA_ARMY_ENSEMBLE_PERCENTILES", "50,90" ), percentiles ) )
+            {
+                throw std::range_error( "NINJA_ARMY_ENSEMBLE_PERCENTILES must be between 0 and 100." );
+            }
+            ensembleStats.reset( new EnsembleStats( percentiles ) );
+            for(unsigned int i = 0; i < ninjas.size(); i++)
+            {
+                ninjas[i]->set_ensembleStats( ensembleStats );
+            }
+        }
+
+        /*
+        ** Write the output files in the background while the next runs solve,
+        ** see OutputQueue.  At most NINJA_ARMY_OUTPUT_QUEUE outputs (default
+        ** two per writer) wait for a writer before a finished run blocks.
+        */
+        int nWriters = nOutputWriters;
+        if( nWriters < 0 )
+        {
+            nWriters = atoi( CPLGetConfigOption( "NINJA_ARMY_OUTPUT_WRITERS", "0" ) );
+        }
+        boost::shared_ptr<OutputQueue> outputQueue;
+        if( nWriters > 0 )
+        {
+            int nQueued = atoi( CPLGetConfigOption( "NINJA_ARMY_OUTPUT_QUEUE", "0" ) );
+            if( nQueued <= 0 )
+            {
+                nQueued = 2 * nWriters;
+            }
+            outputQueue.reset( new OutputQueue( nWriters, nQueued ) );
+            for(unsigned int i = 0; i < ninjas.size(); i++)
+            {
+                ninjas[i]->set_outputQueue( outputQueue );
+            }
         }
 
         /*FOR_EVERY(iter_ninja, ninjas)
@@ -819,21 +1330,27 @@ bool ninjaArmy::startRuns(int numProcessors)
             iter_ninja->set_numberCPUs(1);
         }*/
 #ifdef _OPENMP
-        omp_set_num_threads(numProcessors);
+        omp_set_nested(nThreadsPerRun > 1);
+        omp_set_num_threads(nConcurrentRuns);
 #endif
         std::vector<int> anErrors( numProcessors);
         std::vector<std::string>asMessages( numProcessors );
 
         std::vector<boost::local_time::local_date_time> timeList;
 
-    #pragma omp parallel for //spread runs on single threads
+    #pragma omp parallel for schedule(dynamic, 1) //spread runs over the workers
         //FOR_EVERY(iter_ninja, ninjas) //Doesn't work with omp
-        for( int i = 0; i < ninjas.size(); i++ )
+        for( int k = 0; k < (int)runOrder.size(); k++ )
         {
+            int i = runOrder[k];
+            bool handedOver = false;    //to the run complete handler
             try
             {
+#ifdef _OPENMP
+                omp_set_num_threads(nThreadsPerRun);  //threads for the parallel regions of this run
+#endif
                 //start the run
-                ninjas[i]->simulate_wind();  //runs are done on 1 thread each since omp_set_nested(false)
+                ninjas[i]->simulate_wind();
 
                 //store data for atmosphere file
                 if(ninjas[i]->input.atmOutFlag)
@@ -855,12 +1372,17 @@ bool ninjaArmy::startRuns(int numProcessors)
                 //setup the run map visualization filenames, for C-API calls
                 setCurrentMapVisualizationFilenames(i);
 
+                handedOver = true;
+                runFinished(i);
+
+                //runs skipped by the journal or the result cache never resample
+                TerrainContext::releaseInputs( ninjas[i]->input );
+
                 //delete all but ninjas[0] (ninjas[0] is used to set the output path in the GUI)
                 //need to keep the ninjas for now, if doing a consistent color scale set of outputs
                 if( i != 0 && ninjas[0]->input.googUseConsistentColorScale == false && ninjas[0]->input.fgbzUseConsistentColorScale == false )
                 {
-                    delete ninjas[i];
-                    ninjas[i] = NULL;
+                    deleteFinishedNinja(i);
                 }
 
             }catch (bad_alloc& e)
@@ -935,6 +1457,49 @@ bool ninjaArmy::startRuns(int numProcessors)
                 throw;
 #endif
             }
+#ifdef _OPENMP
+            if( !handedOver && ninjas[i] != NULL )
+            {
+                runFinished( i, anErrors[omp_get_thread_num()] );
+            }
+#endif
+            if( ninjas[i] != NULL )
+            {
+                //failed runs don't need the shared terrain either
+                TerrainContext::releaseInputs( ninjas[i]->input );
+            }
+        }
+        if( outputQueue )
+        {
+            outputQueue->finish();
+            if( outputQueue->getNumFailed() > 0 )
+            {
+                Com->ninjaCom( ninjaComClass::ninjaFailure, "%d runs failed to write their output files.",
+                               outputQueue->getNumFailed() );
+                status = false;
+            }
+        }
+        if( ensembleStats )
+        {
+            try{
+                std::vector<std::string> files = ensembleStats->write();
+                Com->ninjaCom( ninjaComClass::ninjaNone, "Ensemble statistics of %d runs written to %s.",
+                               ensembleStats->getNumRuns(),
+                               files.empty() ? "no files" : CPLGetPath( files[0].c_str() ) );
+            }catch (exception& e)
+            {
+                Com->ninjaCom( ninjaComClass::ninjaFailure, "Exception caught while writing the ensemble statistics: %s", e.what() );
+                status = false;
+            }
+        }
+        for(unsigned int i = 0; i < ninjas.size(); i++)
+        {
+            if( ninjas[i] != NULL )
+            {
+                ninjas[i]->input.terrain.reset();  //release the shared terrain
+                ninjas[i]->set_outputQueue( boost::shared_ptr<OutputQueue>() );
+                ninjas[i]->set_ensembleStats( boost::shared_ptr<EnsembleStats>() );
+            }
         }
 #ifdef _OPENMP
         NinjaRethrowThreadedException( anErrors, asMessages, numProcessors );
@@ -980,8 +1545,7 @@ bool ninjaArmy::startRuns(int numProcessors)
                 //delete all but ninjas[0] (ninjas[0] is used to set the output path in the GUI)
                 if( i != 0 )
                 {
-                    delete ninjas[i];
-                    ninjas[i] = NULL;
+                    deleteFinishedNinja(i);
                 }
             }
         }
@@ -1010,6 +1574,148 @@ bool ninjaArmy::startRuns(int numProcessors)
     return status;
 }
 
+int ninjaArmy::startRunsAsync( int numProcessors, char ** papszOptions )
+{
+    if( runsThread != NULL )
+    {
+        return NINJA_E_INVALID;
+    }
+    asyncProcessors = numProcessors;
+    asyncStatus = false;
+    asyncDone = false;
+    asyncException = std::exception_ptr();
+    nRunsFinished = 0;
+    runsThread = CPLCreateJoinableThread( asyncRunsThread, this );
+    if( runsThread == NULL )
+    {
+        asyncDone = true;
+        return NINJA_E_OTHER;
+    }
+    return NINJA_SUCCESS;
+}
+
+void ninjaArmy::asyncRunsThread( void *army )
+{
+    ninjaArmy *a = static_cast<ninjaArmy*>( army );
+    bool status = false;
+    std::exception_ptr e;
+    try
+    {
+        status = a->startRuns( a->asyncProcessors );
+    }
+    catch( ... )
+    {
+        e = std::current_exception();   //rethrown by waitRuns()
+    }
+    CPLAcquireMutex( a->runsMutex, 1000.0 );
+    a->asyncStatus = status;
+    a->asyncException = e;
+    a->asyncDone = true;
+    CPLReleaseMutex( a->runsMutex );
+}
+
+bool ninjaArmy::pollRuns( int &nFinished )
+{
+    CPLAcquireMutex( runsMutex, 1000.0 );
+    nFinished = nRunsFinished;
+    bool done = runsThread == NULL || asyncDone;
+    CPLReleaseMutex( runsMutex );
+    return done;
+}
+
+bool ninjaArmy::waitRuns()
+{
+    if( runsThread == NULL )
+    {
+        return true;
+    }
+    CPLJoinThread( runsThread );
+    runsThread = NULL;
+    if( asyncException )
+    {
+        std::exception_ptr e = asyncException;
+        asyncException = std::exception_ptr();
+        std::rethrow_exception( e );
+    }
+    return asyncStatus;
+}
+
+int ninjaArmy::setRunCompleteHandler( ninjaRunCompleteHandler pfnRunComplete, void *pUser,
+                                      const bool uvwFlag, char ** papszOptions )
+{
+    this->pfnRunComplete = pfnRunComplete;
+    pRunCompleteUser = pUser;
+    runCompleteUvw = uvwFlag;
+    return NINJA_SUCCESS;
+}
+
+static const double * gridView( AsciiGrid<double> &grid )
+{
+    return grid.get_arraySize() > 0 ? &grid( 0, 0 ) : NULL;
+}
+
+/**
+ * Hand the output grids of a finished run to the run complete handler, in
+ * the thread of the run and before the ninja is deleted.  A failed run is
+ * handed over without grids.
+ *
+ * @param runNumber index of the run in ninjas
+ * @param runStatus NINJA_SUCCESS, or the error code of the failed run
+ */
+void ninjaArmy::runFinished( const int runNumber, const int runStatus )
+{
+    if( pfnRunComplete != NULL && runStatus != NINJA_SUCCESS )
+    {
+        ninjaRunResult result;
+        memset( &result, 0, sizeof( result ) );
+        result.runNumber = runNumber;
+        result.status = runStatus;
+        result.prj = "";
+        pfnRunComplete( &result, pRunCompleteUser );
+    }
+    else if( pfnRunComplete != NULL )
+    {
+        ninja *run = ninjas[runNumber];
+        ninjaRunResult result;
+        result.runNumber = runNumber;
+        result.status = NINJA_SUCCESS;
+        result.nCols = run->VelocityGrid.get_nCols();
+        result.nRows = run->VelocityGrid.get_nRows();
+        result.cellSize = run->VelocityGrid.get_cellSize();
+        result.xllCorner = run->VelocityGrid.get_xllCorner();
+        result.yllCorner = run->VelocityGrid.get_yllCorner();
+        result.prj = run->VelocityGrid.prjString.c_str();
+        result.speed = gridView( run->VelocityGrid );
+        result.direction = gridView( run->AngleGrid );
+        result.u = NULL;
+        result.v = NULL;
+        result.w = NULL;
+        if( runCompleteUvw && run->UGrid.get_arraySize() == run->VelocityGrid.get_arraySize() )
+        {
+            result.u = gridView( run->UGrid );
+            result.v = gridView( run->VGrid );
+            result.w = gridView( run->WGrid );
+        }
+        pfnRunComplete( &result, pRunCompleteUser );
+    }
+    CPLAcquireMutex( runsMutex, 1000.0 );
+    if( runNumber < (int)finishedSolverStats.size() )
+    {
+        finishedSolverStats[runNumber] = ninjas[runNumber]->get_solverStats();
+        finishedSolverStatsJson[runNumber] = ninjas[runNumber]->get_solverStatsJson();
+    }
+    nRunsFinished++;
+    CPLReleaseMutex( runsMutex );
+}
+
+void ninjaArmy::deleteFinishedNinja( const int runNumber )
+{
+    CPLAcquireMutex( runsMutex, 1000.0 );
+    delete ninjas[runNumber];
+    ninjas[runNumber] = NULL;
+    CPLReleaseMutex( runsMutex );
+}
+
 /**
  *  @brief Function to start the first ninja run using 1 thread.
  *
@@ -1272,8 +1978,6 @@ int ninjaArmy::NinjaMakePointArmy( int * yearList, int * monthList, int * dayLis
             throw std::runtime_error(CPLSPrintf("Invalid input numStationFiles '%d' in ninjaArmy::NinjaMakePointArmy()", numStationFiles));
         }
 
-        wxStation::SetStationFormat(wxStation::newFormat);
-
         std::vector <boost::posix_time::ptime> timeList;
         for(size_t i=0; i < timeListSize; i++)
         {
@@ -1605,6 +2309,52 @@ int ninjaArmy::setNumberCPUs( const int nIndex, const int nCPUs, char ** papszOp
     IF_VALID_INDEX_TRY( nIndex, ninjas, ninjas[ nIndex ]->set_numberCPUs( nCPUs ) );
 }
 
+int ninjaArmy::setSolverTolerance( const int nIndex, const double tol, char ** papszOptions )
+{
+    IF_VALID_INDEX_TRY( nIndex, ninjas, ninjas[ nIndex ]->set_solverTolerance( tol ) );
+}
+
+int ninjaArmy::setSolverIterationBudget( const int nIndex, const int maxIterations,
+                                         const double timeLimit, char ** papszOptions )
+{
+    IF_VALID_INDEX_TRY( nIndex, ninjas,
+            ninjas[ nIndex ]->set_solverIterationBudget( maxIterations, timeLimit ) );
+}
+
+int ninjaArmy::setSolverSurfaceWindTolerance( const int nIndex, const double tol,
+                                              std::string units, char ** papszOptions )
+{
+    IF_VALID_INDEX_TRY( nIndex, ninjas,
+            ninjas[ nIndex ]->set_solverSurfaceWindTolerance( tol, velocityUnits::getUnit( units ) ) );
+}
+
+int ninjaArmy::setSolverRecycling( const int nIndex, const bool flag,
+                                   const int nVectors, char ** papszOptions )
+{
+    IF_VALID_INDEX_TRY( nIndex, ninjas,
+            ninjas[ nIndex ]->set_deflationSpace( flag ? getDeflationSpace( nVectors ) :
+                                                         boost::shared_ptr<DeflationSpace>() ) );
+}
+
+/**
+ * \brief Return the army's deflation space, creating it if needed
+ *
+ * A space with a different number of vectors is replaced, ninjas already
+ * using the old one keep it.  The Lanczos window of each solve holds four
+ * times as many vectors.
+ *
+ * \param nVectors number of deflation vectors kept
+ * \return the shared space
+ */
+boost::shared_ptr<DeflationSpace> ninjaArmy::getDeflationSpace( const int nVectors )
+{
+    if( !deflationSpace || deflationSpace->getMaxVectors() != nVectors )
+    {
+        deflationSpace.reset( new DeflationSpace( nVectors, 4 * nVectors ) );
+    }
+    return deflationSpace;
+}
+
 int ninjaArmy::setSpeedInitGrid( const int nIndex, const std::string speedFile,
                                  const velocityUnits::eVelocityUnits units, char ** papszOptions )
 {
@@ -1899,6 +2649,23 @@ int ninjaArmy::setWxStationFilename( const int nIndex, const std::string station
             ninjas[ nIndex ]->set_wxStationFilename( station_filename ) );
 }
 
+int ninjaArmy::writeStationKml( const int nIndex, std::string demFileName, std::string outputPath,
+                                velocityUnits::eVelocityUnits velUnits, char ** papszOptions )
+{
+    IF_VALID_INDEX( nIndex, ninjas )
+    {
+        std::string kmlFile = wxStation::writeKmlFile( ninjas[ nIndex ]->get_wxStations(),
+                                                       demFileName, outputPath, velUnits );
+        if( stationKmlNames.size() < ninjas.size() )
+        {
+            stationKmlNames.resize( ninjas.size() );
+        }
+        stationKmlNames[ nIndex ] = kmlFile;
+        return NINJA_SUCCESS;
+    }
+    return NINJA_E_INVALID;
+}
+
 std::vector<wxStation> ninjaArmy::getWxStations( const int nIndex, char ** papszOptions )
 {
     IF_VALID_INDEX( nIndex, ninjas )
@@ -2217,6 +2984,58 @@ const int ninjaArmy::getOutputGridnRows( const int nIndex, char ** papszOptions
         return ninjas[ nIndex ]->get_outputGridnRows( );
     }
 }
+
+int ninjaArmy::getSolverStats( const int nIndex, int * nSolves, int * nIterations,
+                               double * initialResidual, double * finalResidual,
+                               double * setupTime, double * iterationTime,
+                               char ** papszOptions )
+{
+    CHECK_VALID_INDEX( nIndex, ninjas )
+    //from the copy made when the run finished, the ninja may be deleted by now
+    std::vector<SolverStats> stats;
+    CPLAcquireMutex( runsMutex, 1000.0 );
+    if( nIndex < (int)finishedSolverStats.size() && !finishedSolverStats[ nIndex ].empty() )
+        stats = finishedSolverStats[ nIndex ];
+    else if( ninjas[ nIndex ] != NULL )
+        stats = ninjas[ nIndex ]->get_solverStats( );
+    CPLReleaseMutex( runsMutex );
+    if( nSolves )
+        *nSolves = (int)stats.size();
+    if( nIterations )
+        *nIterations = 0;
+    if( setupTime )
+        *setupTime = 0.0;
+    if( iterationTime )
+        *iterationTime = 0.0;
+    if( initialResidual )
+        *initialResidual = stats.empty() ? 0.0 : stats.front().initialResidual;
+    if( finalResidual )
+        *finalResidual = stats.empty() ? 0.0 : stats.back().finalResidual;
+    for( unsigned int i = 0; i < stats.size(); i++ )
+    {
+        if( nIterations )
+            *nIterations += stats[i].numIterations;
+        if( setupTime )
+            *setupTime += stats[i].setupTime;
+        if( iterationTime )
+            *iterationTime += stats[i].iterationTime;
+    }
+    return NINJA_SUCCESS;
+}
+
+const char* ninjaArmy::getSolverStatsJson( const int nIndex, char ** papszOptions )
+{
+    CHECK_VALID_INDEX( nIndex, ninjas )
+    //from the copy made when the run finished, the ninja may be deleted by now
+    const char *json = "";
+    CPLAcquireMutex( runsMutex, 1000.0 );
+    if( nIndex < (int)finishedSolverStatsJson.size() && !finishedSolverStatsJson[ nIndex ].empty() )
+        json = finishedSolverStatsJson[ nIndex ].c_str();
+    else if( ninjas[ nIndex ] != NULL )
+        json = ninjas[ nIndex ]->get_solverStatsJson( );
+    CPLReleaseMutex( runsMutex );
+    return json;
+}
 int ninjaArmy::setOutputBufferClipping( const int nIndex, const double percent,
                                         char ** papszOptions )
 {
@@ -2460,6 +3279,12 @@ int ninjaArmy::setTxtOutFlag( const int nIndex, const bool flag, char ** papszOp
     IF_VALID_INDEX_TRY( nIndex, ninjas,
             ninjas[ nIndex ]->set_txtOutFlag( flag ) );
 }
+
+int ninjaArmy::setSolverStatsOutFlag( const int nIndex, const bool flag, char ** papszOptions )
+{
+    IF_VALID_INDEX_TRY( nIndex, ninjas,
+            ninjas[ nIndex ]->set_solverStatsOutFlag( flag ) );
+}
 //PDF
 int ninjaArmy::setPDFOutFlag( const int nIndex, const bool flag, char ** papszOptions )
 {
@@ -2629,11 +3454,16 @@ void ninjaArmy::reset()
 
 void ninjaArmy::cancel()
 {
+    CPLAcquireMutex( runsMutex, 1000.0 );
     //FOR_EVERY( iter_ninja, ninjas )
     for(unsigned int i = 0; i < ninjas.size(); i++)
     {
-        ninjas[i]->cancel = true;
+        if( ninjas[i] != NULL )   //finished runs are deleted
+        {
+            ninjas[i]->cancel = true;
+        }
     }
+    CPLReleaseMutex( runsMutex );
 }
 
 void ninjaArmy::cancelAndReset()
@@ -2646,23 +3476,12 @@ void ninjaArmy::setCurrentMapVisualizationFilenames(int runNumber)
 {
     fgbzFilenames[runNumber] = ninjas[runNumber]->input.fgbzFile;
 
-    if(ninjas[runNumber]->input.stations.size() == 0)
+    if(runNumber < (int)stationKmlNames.size())
     {
-        stationKmlFilenames[runNumber] = "";
+        stationKmlFilenames[runNumber] = stationKmlNames[runNumber];
     } else
     {
-        if(ninjas[runNumber]->input.stations[runNumber].stationKmlNames.size() == 0)
-        {
-            stationKmlFilenames[runNumber] = "";
-        } else
-        {
-            // all these cout statements are various ways to access the given wxStation::stationKmlNames, which is SHARED across ninjas[runNumber].input.stations[runNumber]
-            // the past attempt of doing a for loop over ninjas[runNumber]->input.stations[runNumber].stationKmlNames[stationIdx] makes NO sense, it results in DUPLICATION
-            //std::cout << "ninjas[0]->input.stations[0].stationKmlNames[" << runNumber << "] = \"" << ninjas[0]->input.stations[0].stationKmlNames[runNumber] << "\"" << std::endl;
-            //std::cout << "ninjas[" << runNumber << "]->input.stations[" << runNumber << "].stationKmlNames[" << runNumber << "] = \"" << ninjas[runNumber]->input.stations[runNumber].stationKmlNames[runNumber] << "\"" << std::endl;
-            //std::cout << "wxStation::stationKmlNames[" << runNumber << "] = \"" << wxStation::stationKmlNames[runNumber] << "\"" << std::endl;
-            stationKmlFilenames[runNumber] = ninjas[runNumber]->input.stations[runNumber].stationKmlNames[runNumber];
-        }
+        stationKmlFilenames[runNumber] = "";
     }
 
     // oh, this one is set to "!set" for non-wxModel runs, the storage of this filename always exists for each ninjas[i]
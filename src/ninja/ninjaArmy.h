@@ -51,7 +51,9 @@
 #endif
 #include "WindNinjaInputs.h"
 #include "fetch_factory.h"
+#include "cpl_multiproc.h"
 #include <memory>
+#include <exception>
 
 namespace blt = boost::local_time;
 namespace bpt = boost::posix_time;
@@ -169,6 +171,128 @@ public:
     void makeWeatherModelArmy(std::string forecastFilename, std::string timeZone, std::vector<blt::local_date_time> timeList, bool momentumFlag);
     std::vector<blt::local_date_time> toBoostLocal(std::vector<std::string> in, std::string timeZone);
     bool startRuns(int numProcessors);
+    /**
+    * \brief Start the runs in a background thread and return
+    *
+    * startRuns() is called in a new thread; use pollRuns() and waitRuns()
+    * to follow it, and cancel() to stop it.  Nothing else may be done with
+    * the army until waitRuns() returns.
+    *
+    * \param numProcessors number of threads for the runs
+    * \return errval Returns NINJA_SUCCESS upon success, NINJA_E_INVALID if
+    *         runs are already going
+    */
+    int startRunsAsync( int numProcessors, char ** papszOptions=NULL );
+    /**
+    * \brief Check on the runs started by startRunsAsync()
+    *
+    * \param nFinished set to the number of runs finished so far
+    * \return true if the runs are done (or were never started)
+    */
+    bool pollRuns( int &nFinished );
+    /**
+    * \brief Wait for the runs started by startRunsAsync()
+    *
+    * Exceptions thrown by the runs are rethrown here.
+    *
+    * \return the return value of startRuns(), true if no runs were started
+    */
+    bool waitRuns();
+    /**
+    * \brief Call a function as each run finishes
+    *
+    * The function is called from the thread of the run, with views of its
+    * output grids that are valid only during the call (see ninjaRunResult),
+    * so the grids of a run can be used while the later runs solve.  Failed
+    * runs call it too, with an error status.  The function must return
+    * quickly or copy what it needs; it may be called from several threads at
+    * once.
+    *
+    * \param pfnRunComplete function to call, NULL to not call one
+    * \param pUser passed to the function
+    * \param uvwFlag also hand over the u, v and w grids
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setRunCompleteHandler( ninjaRunCompleteHandler pfnRunComplete, void *pUser,
+                               const bool uvwFlag, char ** papszOptions=NULL );
+    /**
+    * \brief Limit the memory used by runs going at the same time
+    *
+    * startRuns() estimates the peak memory of each run and starts no more
+    * runs at once than fit in the budget, the others wait for a free slot.
+    *
+    * \param megabytes memory budget in MB, -1 to use 80% of the usable RAM
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setMemoryBudget( const double megabytes, char ** papszOptions=NULL );
+    /**
+    * \brief Write the output files of the runs in background threads
+    *
+    * A finished run hands its output grids to a writer and startRuns() goes
+    * on with the next run; it waits for the writers before returning.
+    *
+    * \param nWriters number of writer threads, 0 to write the files in the
+    *                 run, -1 to use NINJA_ARMY_OUTPUT_WRITERS (default 0)
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setOutputWriters( const int nWriters, char ** papszOptions=NULL );
+    /**
+    * \brief Reuse the output grids of identical earlier runs
+    *
+    * Runs found in the cache directory only write their output files, other
+    * runs store their output grids in it.  See ResultCache.
+    *
+    * \param directory cache directory, empty to turn the cache off (unless
+    *                  NINJA_RESULT_CACHE is set)
+    * \param megabytes size the directory is kept under, in MB
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setResultCache( const std::string directory, const double megabytes, char ** papszOptions=NULL );
+    /**
+    * \brief Skip the runs done before the army was stopped
+    *
+    * A journal of the finished runs is kept in each output directory, runs
+    * recorded with the same inputs and unchanged output files are skipped.
+    * See RunJournal.
+    *
+    * \param flag true to skip the recorded runs, false to use
+    *             NINJA_ARMY_RESUME (default FALSE)
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setResume( const bool flag, char ** papszOptions=NULL );
+    /**
+    * \brief Write per cell statistics of the output grids of the runs
+    *
+    * The output speed and direction grids of each run are folded into the
+    * mean, standard deviation, maximum and percentiles of the speed and the
+    * mean direction as the runs finish; the statistics grids are written
+    * when all runs are done.  See EnsembleStats.
+    *
+    * \param flag true to write the statistics, false to use
+    *             NINJA_ARMY_ENSEMBLE_STATS (default FALSE)
+    * \param percentiles comma separated speed percentiles, e.g. "50,90"
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setEnsembleStats( const bool flag, const std::string percentiles, char ** papszOptions=NULL );
+    /**
+    * \brief Start the runs from terrain kept by the caller
+    *
+    * The runs use (and add to) the given terrain instead of one made for
+    * this army, so a caller running the same DEM again skips reading,
+    * resampling and the slope/aspect computation.  See NinjaServer.
+    *
+    * \param terrain terrain to use, NULL to make one per army
+    */
+    void setTerrainContext( boost::shared_ptr<TerrainContext> terrain );
+    /**
+    * \brief Start solver recycling from a deflation space kept by the caller
+    *
+    * setSolverRecycling() uses the given space if it keeps the same number
+    * of vectors.
+    *
+    * \param space deflation space to use, NULL to make one per army
+    */
+    void setDeflationSpace( boost::shared_ptr<DeflationSpace> space );
     bool startFirstRun();
 
     int ninjaInitialize();
@@ -453,6 +577,49 @@ public:
     */
     int setNumberCPUs( const int nIndex, const int nCPUs, char ** papszOptions=NULL );
     /**
+    * \brief Set the solver stopping tolerance for a ninja
+    *
+    * \param nIndex index of a ninja
+    * \param tol tolerance on the relative residual (default 1E-1)
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setSolverTolerance( const int nIndex, const double tol, char ** papszOptions=NULL );
+    /**
+    * \brief Set an iteration and time budget for the solver of a ninja
+    *
+    * The solution is kept, with a warning, when the budget is used up.
+    *
+    * \param nIndex index of a ninja
+    * \param maxIterations maximum iterations per solve (-1 for no budget)
+    * \param timeLimit maximum iteration time per solve in seconds (-1 for no limit)
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setSolverIterationBudget( const int nIndex, const int maxIterations,
+                                  const double timeLimit, char ** papszOptions=NULL );
+    /**
+    * \brief Stop the solver of a ninja when the output height wind converges
+    *
+    * \param nIndex index of a ninja
+    * \param tol largest change in wind speed between checks (-1 to turn off)
+    * \param units units of tol
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setSolverSurfaceWindTolerance( const int nIndex, const double tol,
+                                       std::string units, char ** papszOptions=NULL );
+    /**
+    * \brief Recycle a deflation space between the CG solves of a ninja
+    *
+    * All ninjas of the army that recycle share one space, so later runs on
+    * the same mesh converge in fewer iterations.
+    *
+    * \param nIndex index of a ninja
+    * \param flag true to recycle, false to turn recycling off
+    * \param nVectors number of deflation vectors kept (default 8)
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int setSolverRecycling( const int nIndex, const bool flag,
+                            const int nVectors=8, char ** papszOptions=NULL );
+    /**
     * \brief Set the intialization method for a ninja
     *
     * \param nIndex index of a ninja
@@ -843,6 +1010,20 @@ public:
     * \return errval Returns NINJA_SUCCESS upon success
     */
     int setNumVertLayers( const int nIndex, const int nLayers, char ** papszOptions=NULL );
+    /**
+    * \brief Write a kml file of the weather stations of a ninja
+    *
+    * The file name is kept by the army and reported for the run by
+    * getMapVisualizationFilenames().
+    *
+    * \param nIndex index of a ninja
+    * \param demFileName the DEM of the run
+    * \param outputPath directory for the kml file
+    * \param velUnits speed units of the kml file
+    * \return errval Returns NINJA_SUCCESS upon success
+    */
+    int writeStationKml( const int nIndex, std::string demFileName, std::string outputPath,
+                         velocityUnits::eVelocityUnits velUnits, char ** papszOptions=NULL );
 
     /*  Accessors  */
     std::vector<wxStation> getWxStations( const int nIndex, char ** papszOptions=NULL );
@@ -1001,6 +1182,35 @@ public:
     */
     const int getOutputGridnRows( const int nIndex, char ** papszOptions=NULL );
 
+    /**
+    * \brief Get a summary of the solver statistics for a ninja
+    *
+    * Totals are over all the solves of the last run (matching runs solve
+    * more than once), the initial residual is from the first solve and the
+    * final residual from the last one.
+    *
+    * \param nIndex index of a ninja
+    * \param nSolves number of solves
+    * \param nIterations total number of solver iterations
+    * \param initialResidual initial residual of the first solve
+    * \param finalResidual final residual of the last solve
+    * \param setupTime total solver setup time in seconds
+    * \param iterationTime total time spent iterating in seconds
+    * \return errval Returns NINJA_SUCCESS if successful
+    */
+    int getSolverStats( const int nIndex, int * nSolves, int * nIterations,
+                        double * initialResidual, double * finalResidual,
+                        double * setupTime, double * iterationTime,
+                        char ** papszOptions=NULL );
+
+    /**
+    * \brief Get the full solver statistics for a ninja as JSON
+    *
+    * \param nIndex index of a ninja
+    * \return JSON document, valid until the runs are started again or the army is destroyed
+    */
+    const char* getSolverStatsJson( const int nIndex, char ** papszOptions=NULL );
+
     /**
     * \brief Set the percent of output buffer clipping for a ninja
     *
@@ -1331,6 +1541,14 @@ public:
     */
     int setTxtOutFlag( const int nIndex, const bool flag, char ** papszOptions=NULL );
     /**
+    * \brief Enable/disable the solver statistics (*_solver.json) output for a ninja
+    *
+    * \param nIndex index of a ninja
+    * \param flag   determines if solver statistics output is enabled or not
+    * \return errval Returns NINJA_SUCCESS if successful
+    */
+    int setSolverStatsOutFlag( const int nIndex, const bool flag, char ** papszOptions=NULL );
+    /**
     * \brief Enable/disable PDF output for a ninja
     *
     * \param nIndex index of a ninja
@@ -1526,9 +1744,14 @@ public:
 protected:
     std::vector<ninja*> ninjas;
     std::string tz;
+    std::vector<std::string> stationKmlNames;  //station kml file of each run, "" if none
 
     void writeFarsiteAtmosphereFile();
 
+    void scheduleRuns( const int numProcessors, int &nConcurrentRuns,
+                       int &nThreadsPerRun, std::vector<int> &runOrder );
+    int maxRunsInMemory();
+
     void setCurrentMapVisualizationFilenames(int runNumber);
 
     void calcConsistentColorScaleSplits(const AsciiGrid<double>* const *inSpdGrids, const int nSets, double **outSplitVals, int *outSize, const eArmySpeedScaling scaling);
@@ -1546,6 +1769,40 @@ protected:
 
 private:
     char *pszTmpColorRelief;
+    boost::shared_ptr<DeflationSpace> deflationSpace;  //shared by the ninjas that recycle, see setSolverRecycling()
+    boost::shared_ptr<TerrainContext> terrainContext;  //see setTerrainContext(), NULL to make one in startRuns()
+    double memoryBudget;    //memory budget for concurrent runs in MB, -1 for 80% of the usable RAM
+    int nOutputWriters;     //background output writer threads, -1 for NINJA_ARMY_OUTPUT_WRITERS
+    std::string resultCacheDirectory;   //see setResultCache(), empty for NINJA_RESULT_CACHE
+    double resultCacheSize;             //result cache size in MB
+    bool resumeRuns;        //skip the runs in the journal, see setResume()
+    bool ensembleStatsFlag;                 //see setEnsembleStats()
+    std::vector<double> ensemblePercentiles;
+    ninjaRunCompleteHandler pfnRunComplete; //see setRunCompleteHandler(), NULL if not used
+    void *pRunCompleteUser;
+    bool runCompleteUvw;
+
+    /*
+    ** State of the runs started by startRunsAsync().  runsMutex also keeps
+    ** cancel() from touching a ninja while a finished run deletes it.
+    */
+    CPLMutex *runsMutex;
+    CPLJoinableThread *runsThread;  //NULL if no runs are going
+    int asyncProcessors;
+    bool asyncStatus;               //return of startRuns()
+    bool asyncDone;
+    std::exception_ptr asyncException;
+    int nRunsFinished;
+
+    static void asyncRunsThread( void *army );
+    void runFinished( const int runNumber, const int runStatus = NINJA_SUCCESS );
+    void deleteFinishedNinja( const int runNumber );
+
+    //solver statistics of the runs of startRuns(), by run, copied by runFinished()
+    std::vector<std::vector<SolverStats> > finishedSolverStats;
+    std::vector<std::string> finishedSolverStatsJson;
+
+    boost::shared_ptr<DeflationSpace> getDeflationSpace( const int nVectors );
     farsiteAtm atmosphere;
     std::vector<blt::local_date_time> overrideList;
 };
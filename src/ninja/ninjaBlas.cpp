@@ -0,0 +1,354 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Vectorized, fused BLAS level 1 kernels for the solvers
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+#include "ninjaBlas.h"
+
+/*-----------------------------------------------------------------------------
+ *  Inner kernels, run by one thread on its chunk.  These are cloned for the
+ *  supported instruction sets, see NINJA_BLAS_DISPATCH.
+ *-----------------------------------------------------------------------------*/
+
+NINJA_BLAS_DISPATCH
+static void kernelCopy(const int n, const double * __restrict X, double * __restrict Y)
+{
+    #pragma omp simd
+    for(int i=0; i<n; i++)
+        Y[i] = X[i];
+}
+
+NINJA_BLAS_DISPATCH
+static void kernelScalCopy(const int n, const double alpha, const double * __restrict X, double * __restrict Y)
+{
+    #pragma omp simd
+    for(int i=0; i<n; i++)
+        Y[i] = alpha*X[i];
+}
+
+NINJA_BLAS_DISPATCH
+static void kernelScal(const int n, const double alpha, double * __restrict X)
+{
+    #pragma omp simd
+    for(int i=0; i<n; i++)
+        X[i] *= alpha;
+}
+
+NINJA_BLAS_DISPATCH
+static double kernelDot(const int n, const double * __restrict X, const double * __restrict Y)
+{
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for(int i=0; i<n; i++)
+        sum += X[i]*Y[i];
+    return sum;
+}
+
+NINJA_BLAS_DISPATCH
+static void kernelAxpy(const int n, const double alpha, const double * __restrict X, double * __restrict Y)
+{
+    #pragma omp simd
+    for(int i=0; i<n; i++)
+        Y[i] += alpha*X[i];
+}
+
+NINJA_BLAS_DISPATCH
+static void kernelXpay(const int n, const double * __restrict X, const double beta, double * __restrict Y)
+{
+    #pragma omp simd
+    for(int i=0; i<n; i++)
+        Y[i] = X[i] + beta*Y[i];
+}
+
+NINJA_BLAS_DISPATCH
+static double kernelAxpyNrm2(const int n, const double alpha, const double * __restrict X, double * __restrict Y)
+{
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for(int i=0; i<n; i++)
+    {
+        double y = Y[i] + alpha*X[i];
+        Y[i] = y;
+        sum += y*y;
+    }
+    return sum;
+}
+
+NINJA_BLAS_DISPATCH
+static double kernelCgUpdate(const int n, const double alpha, const double * __restrict P, const double * __restrict Q,
+                             double * __restrict X, double * __restrict R)
+{
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for(int i=0; i<n; i++)
+    {
+        X[i] += alpha*P[i];
+        double r = R[i] - alpha*Q[i];
+        R[i] = r;
+        sum += r*r;
+    }
+    return sum;
+}
+
+NINJA_BLAS_DISPATCH
+static double kernelLanczosUpdate(const int n, const double alpha, const double beta,
+                                  const double * __restrict V, const double * __restrict VOLD, double * __restrict R,
+                                  const double * __restrict U, const double * __restrict UOLD, double * __restrict Z)
+{
+    double sum = 0.0;
+    #pragma omp simd reduction(+:sum)
+    for(int i=0; i<n; i++)
+    {
+        double r = R[i] - alpha*V[i] - beta*VOLD[i];
+        double z = Z[i] - alpha*U[i] - beta*UOLD[i];
+        R[i] = r;
+        Z[i] = z;
+        sum += r*z;
+    }
+    return sum;
+}
+
+NINJA_BLAS_DISPATCH
+static void kernelMinresUpdate(const int n, const double irho1, const double rho2, const double rho3,
+                               const double * __restrict U, const double * __restrict WOLD, const double * __restrict WOOLD,
+                               double * __restrict W, const double ceta, double * __restrict X)
+{
+    #pragma omp simd
+    for(int i=0; i<n; i++)
+    {
+        double w = irho1*(U[i] - rho2*WOLD[i] - rho3*WOOLD[i]);
+        W[i] = w;
+        X[i] += ceta*w;
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ *  Threaded drivers
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * @brief Computes the chunk [begin, end) of an N-element vector for the calling thread.
+ *
+ * Must be called from inside a parallel region (or serially, giving the whole range).
+ */
+void ninjaBlas::threadRange(const int N, int &begin, int &end)
+{
+#ifdef _OPENMP
+    int nThreads = omp_get_num_threads();
+    int thread = omp_get_thread_num();
+#else
+    int nThreads = 1;
+    int thread = 0;
+#endif
+    int chunk = (N + nThreads - 1) / nThreads;
+    begin = std::min(N, thread*chunk);
+    end = std::min(N, begin + chunk);
+}
+
+/**@brief Copies values from the X vector to the Y vector.
+ * @param N Size of vectors.
+ * @param X Source vector.
+ * @param Y Target vector.
+ */
+void ninjaBlas::dcopy(const int N, const double *X, double *Y)
+{
+    #pragma omp parallel if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        kernelCopy(end-begin, X+begin, Y+begin);
+    }
+}
+
+/**@brief Performs the calculation X = alpha * X.
+ * @param N Size of vector.
+ * @param alpha Scalar.
+ * @param X Vector to scale.
+ */
+void ninjaBlas::dscal(const int N, const double alpha, double *X)
+{
+    #pragma omp parallel if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        kernelScal(end-begin, alpha, X+begin);
+    }
+}
+
+/**@brief Performs the dot product X*Y.
+ * @param N Size of vectors.
+ * @param X Vector of size N.
+ * @param Y Vector of size N.
+ * @return Dot product X*Y value.
+ */
+double ninjaBlas::ddot(const int N, const double *X, const double *Y)
+{
+    double val = 0.0;
+    #pragma omp parallel reduction(+:val) if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        val += kernelDot(end-begin, X+begin, Y+begin);
+    }
+    return val;
+}
+
+/**@brief Performs the calculation Y = Y + alpha * X.
+ * @param N Size of vectors.
+ * @param alpha Scalar.
+ * @param X Vector of size N.
+ * @param Y Vector of size N.
+ */
+void ninjaBlas::daxpy(const int N, const double alpha, const double *X, double *Y)
+{
+    #pragma omp parallel if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        kernelAxpy(end-begin, alpha, X+begin, Y+begin);
+    }
+}
+
+/**@brief Computes the 2-norm of X.
+ * @param N Size of X.
+ * @param X Vector of size N.
+ * @return Value of the 2-norm of X.
+ */
+double ninjaBlas::dnrm2(const int N, const double *X)
+{
+    return std::sqrt(ddot(N, X, X));
+}
+
+/**@brief Performs the calculation Y = alpha * X (a copy and scale in one pass).
+ * @param N Size of vectors.
+ * @param alpha Scalar.
+ * @param X Source vector.
+ * @param Y Target vector.
+ */
+void ninjaBlas::dscalCopy(const int N, const double alpha, const double *X, double *Y)
+{
+    #pragma omp parallel if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        kernelScalCopy(end-begin, alpha, X+begin, Y+begin);
+    }
+}
+
+/**@brief Performs the calculation Y = X + beta * Y.
+ * @param N Size of vectors.
+ * @param X Vector of size N.
+ * @param beta Scalar.
+ * @param Y Vector of size N.
+ */
+void ninjaBlas::dxpay(const int N, const double *X, const double beta, double *Y)
+{
+    #pragma omp parallel if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        kernelXpay(end-begin, X+begin, beta, Y+begin);
+    }
+}
+
+/**@brief Performs the calculation Y = Y + alpha * X and returns the 2-norm of the new Y.
+ * @param N Size of vectors.
+ * @param alpha Scalar.
+ * @param X Vector of size N.
+ * @param Y Vector of size N.
+ * @return Value of the 2-norm of Y after the update.
+ */
+double ninjaBlas::daxpyNrm2(const int N, const double alpha, const double *X, double *Y)
+{
+    double val = 0.0;
+    #pragma omp parallel reduction(+:val) if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        val += kernelAxpyNrm2(end-begin, alpha, X+begin, Y+begin);
+    }
+    return std::sqrt(val);
+}
+
+/**@brief Updates the CG solution and residual in one pass.
+ * Performs X = X + alpha * P and R = R - alpha * Q, and returns the 2-norm of the new R.
+ * @param N Size of vectors.
+ * @param alpha CG step length.
+ * @param P Search direction.
+ * @param Q A*P.
+ * @param X Solution vector.
+ * @param R Residual vector.
+ * @return Value of the 2-norm of R after the update.
+ */
+double ninjaBlas::dcgUpdate(const int N, const double alpha, const double *P, const double *Q,
+                            double *X, double *R)
+{
+    double val = 0.0;
+    #pragma omp parallel reduction(+:val) if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        val += kernelCgUpdate(end-begin, alpha, P+begin, Q+begin, X+begin, R+begin);
+    }
+    return std::sqrt(val);
+}
+
+/**@brief Lanczos three term recurrence for MINRES in one pass.
+ * Performs R = R - alpha*V - beta*VOLD and Z = Z - alpha*U - beta*UOLD, and returns R*Z.
+ * @return Dot product of R and Z after the update.
+ */
+double ninjaBlas::dlanczosUpdate(const int N, const double alpha, const double beta,
+                                 const double *V, const double *VOLD, double *R,
+                                 const double *U, const double *UOLD, double *Z)
+{
+    double val = 0.0;
+    #pragma omp parallel reduction(+:val) if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        val += kernelLanczosUpdate(end-begin, alpha, beta, V+begin, VOLD+begin, R+begin,
+                                   U+begin, UOLD+begin, Z+begin);
+    }
+    return val;
+}
+
+/**@brief MINRES direction and solution update in one pass.
+ * Performs W = (U - rho2*WOLD - rho3*WOOLD) / rho1 and X = X + ceta*W.
+ * @param irho1 1/rho1.
+ */
+void ninjaBlas::dminresUpdate(const int N, const double irho1, const double rho2, const double rho3,
+                              const double *U, const double *WOLD, const double *WOOLD,
+                              double *W, const double ceta, double *X)
+{
+    #pragma omp parallel if(N > NINJA_BLAS_PARALLEL_MIN)
+    {
+        int begin, end;
+        threadRange(N, begin, end);
+        kernelMinresUpdate(end-begin, irho1, rho2, rho3, U+begin, WOLD+begin, WOOLD+begin,
+                           W+begin, ceta, X+begin);
+    }
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Vectorized, fused BLAS level 1 kernels for the solvers
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+#ifndef NINJA_BLAS_H
+#define NINJA_BLAS_H
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+** Runtime dispatch for the inner kernels.  Where the toolchain supports it
+** (GCC/Clang with ifunc on x86-64), each kernel is compiled for AVX-512,
+** AVX2+FMA and baseline x86-64, and the loader picks the best one for the
+** cpu.  Elsewhere the kernels are compiled once for the target architecture.
+*/
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) && \
+    (!defined(__clang__) || __clang_major__ >= 14)
+#define NINJA_BLAS_DISPATCH __attribute__((target_clones("arch=skylake-avx512", "arch=haswell", "default")))
+#else
+#define NINJA_BLAS_DISPATCH
+#endif
+
+/*
+** Vectors shorter than this are processed by one thread, the fork/join cost
+** is higher than the work.
+*/
+#define NINJA_BLAS_PARALLEL_MIN 8192
+
+/**
+ * @brief BLAS level 1 kernels used by the CG and MINRES solvers.
+ *
+ * All vectors have unit stride.  Each routine splits the vectors into one
+ * contiguous, statically assigned chunk per OpenMP thread (the same split
+ * for every routine, so threads keep touching the same memory), and each
+ * chunk is handled by an explicitly vectorized kernel.  The fused routines
+ * do the work of several BLAS calls in one pass over memory.
+ */
+class ninjaBlas
+{
+public:
+    /* BLAS equivalents */
+    static void dcopy(const int N, const double *X, double *Y);                       //Y = X
+    static void dscal(const int N, const double alpha, double *X);                    //X = alpha*X
+    static double ddot(const int N, const double *X, const double *Y);                //return X.Y
+    static void daxpy(const int N, const double alpha, const double *X, double *Y);   //Y = Y + alpha*X
+    static double dnrm2(const int N, const double *X);                                //return ||X||
+
+    /* fused kernels */
+    static void dscalCopy(const int N, const double alpha, const double *X, double *Y);  //Y = alpha*X
+    static void dxpay(const int N, const double *X, const double beta, double *Y);       //Y = X + beta*Y
+    static double daxpyNrm2(const int N, const double alpha, const double *X, double *Y);   //Y = Y + alpha*X, return ||Y||
+    static double dcgUpdate(const int N, const double alpha, const double *P, const double *Q,
+                            double *X, double *R);  //X = X + alpha*P, R = R - alpha*Q, return ||R||
+    static double dlanczosUpdate(const int N, const double alpha, const double beta,
+                                 const double *V, const double *VOLD, double *R,
+                                 const double *U, const double *UOLD, double *Z);   //R = R - alpha*V - beta*VOLD, Z = Z - alpha*U - beta*UOLD, return R.Z
+    static void dminresUpdate(const int N, const double irho1, const double rho2, const double rho3,
+                              const double *U, const double *WOLD, const double *WOOLD,
+                              double *W, const double ceta, double *X);   //W = (U - rho2*WOLD - rho3*WOOLD)/rho1, X = X + ceta*W
+
+private:
+    static void threadRange(const int N, int &begin, int &end);
+};
+
+#endif //NINJA_BLAS_H
@@ -0,0 +1,373 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Long running server answering WindNinja runs read from stdin
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "ninjaServer.h"
+#include "cli.h"
+
+#include <iostream>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+NinjaServer::NinjaServer(int nDems) : nDems(nDems), out(NULL), requestGrids(false)
+{
+    if(this->nDems < 1)
+        this->nDems = 1;
+    outMutex = CPLCreateMutex();    //created locked
+    CPLReleaseMutex(outMutex);
+}
+
+NinjaServer::~NinjaServer()
+{
+    if(out != NULL)
+        fclose(out);
+    CPLDestroyMutex(outMutex);
+}
+
+/**
+ * Answer requests from stdin until shutdown or the end of stdin.
+ *
+ * The protocol is written to the original stdout, which is then pointed at
+ * stderr so the messages of the runs do not mix with the replies.
+ *
+ * @return 0, or 1 if stdout could not be set up.
+ */
+int NinjaServer::run()
+{
+    fflush(stdout);
+#ifdef WIN32
+    int fd = _dup(_fileno(stdout));
+    if(fd >= 0)
+    {
+        _dup2(_fileno(stderr), _fileno(stdout));
+        out = _fdopen(fd, "w");
+    }
+#else
+    int fd = dup(fileno(stdout));
+    if(fd >= 0)
+    {
+        dup2(fileno(stderr), fileno(stdout));
+        out = fdopen(fd, "w");
+    }
+#endif
+    if(out == NULL)
+    {
+        fprintf(stderr, "Could not set up the server output stream.\n");
+        return 1;
+    }
+
+    CPLDebug("NINJA", "Server started, keeping terrain for %d DEMs.", nDems);
+
+    std::string line;
+    while(std::getline(std::cin, line))
+    {
+        if(line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        if(!handle(line))
+            break;
+    }
+
+    fclose(out);
+    out = NULL;
+    return 0;
+}
+
+/**
+ * Use the kept terrain and recycling space of a DEM for an army, keeping
+ * new ones if the DEM was not seen before or changed on disk.  Called by
+ * windNinjaCLI() before the runs are set up.
+ *
+ * @param army Army about to run.
+ * @param demFile DEM of the runs.
+ * @param nRecyclingVectors Number of solver recycling vectors, 0 if the
+ *        runs do not recycle.
+ */
+void NinjaServer::prepare(ninjaArmy &army, const std::string &demFile, int nRecyclingVectors)
+{
+    std::string current = stamp(demFile);
+    std::map<std::string, Entry>::iterator it = entries.find(demFile);
+    if(it != entries.end() && it->second.stamp != current)
+    {
+        CPLDebug("NINJA", "Server: %s changed, reading it again.", demFile.c_str());
+        order.remove(demFile);
+        entries.erase(it);
+        it = entries.end();
+    }
+
+    if(it == entries.end())
+    {
+        Entry entry;
+        entry.stamp = current;
+        entry.terrain.reset(new TerrainContext());
+        it = entries.insert(std::make_pair(demFile, entry)).first;
+    }
+    else
+    {
+        CPLDebug("NINJA", "Server: reusing the terrain of %s.", demFile.c_str());
+        order.remove(demFile);
+    }
+    order.push_front(demFile);
+
+    while((int)order.size() > nDems)
+    {
+        CPLDebug("NINJA", "Server: dropping the terrain of %s.", order.back().c_str());
+        entries.erase(order.back());
+        order.pop_back();
+    }
+
+    Entry &entry = it->second;
+    if(nRecyclingVectors > 0 &&
+       (!entry.space || entry.space->getMaxVectors() != nRecyclingVectors))
+    {
+        entry.space.reset(new DeflationSpace(nRecyclingVectors, 4 * nRecyclingVectors));
+    }
+
+    army.setTerrainContext(entry.terrain);
+    army.setDeflationSpace(entry.space);
+}
+
+/**
+ * Reply to the request being run as each run of an army finishes, see
+ * runComplete().  Called by windNinjaCLI() before the runs are started.
+ */
+void NinjaServer::streamRuns(ninjaArmy &army)
+{
+    army.setRunCompleteHandler(&NinjaServer::runComplete, this, false);
+}
+
+/**
+ * Answer one request line.
+ *
+ * @return false if the server should stop.
+ */
+bool NinjaServer::handle(const std::string &line)
+{
+    CPLJSONDocument document;
+    CPLJSONObject message;
+    if(!document.LoadMemory(line))
+    {
+        message.Add("status", "error");
+        message.Add("message", "request is not valid JSON");
+        reply(message);
+        return true;
+    }
+
+    CPLJSONObject request = document.GetRoot();
+    CPLJSONObject id = request.GetObj("id");
+    if(id.IsValid())
+        message.Add("id", id);
+
+    std::string command = request.GetString("command", "run");
+    if(command == "shutdown")
+    {
+        message.Add("status", "shutdown");
+        reply(message);
+        return false;
+    }
+    if(command != "run")
+    {
+        message.Add("status", "error");
+        message.Add("message", "unknown command " + command);
+        reply(message);
+        return true;
+    }
+
+    std::vector<std::string> args;
+    CPLJSONArray array = request.GetArray("args");
+    for(int i = 0; i < array.Size(); i++)
+    {
+        std::string arg;
+        if(!argString(array[i], arg))
+        {
+            message.Add("status", "error");
+            message.Add("message", CPLSPrintf("argument %d is not a string, number or boolean", i));
+            reply(message);
+            return true;
+        }
+        args.push_back(arg);
+    }
+    std::string configFile = request.GetString("config_file");
+    if(!configFile.empty())
+    {
+        args.push_back("--config_file");
+        args.push_back(configFile);
+    }
+    if(args.empty())
+    {
+        message.Add("status", "error");
+        message.Add("message", "request has no args or config_file");
+        reply(message);
+        return true;
+    }
+
+    message.Add("status", "started");
+    reply(message);
+
+    requestId = id;
+    requestGrids = request.GetBool("grids", false);
+#ifdef _OPENMP
+    double start = omp_get_wtime();
+#endif
+    int code = runRequest(args);
+
+    message.Set("status", code == 0 ? "ok" : "error");
+    message.Add("code", code);
+#ifdef _OPENMP
+    message.Add("seconds", omp_get_wtime() - start);
+#endif
+    reply(message);
+    return true;
+}
+
+int NinjaServer::runRequest(const std::vector<std::string> &args)
+{
+    std::vector<std::string> strings;
+    strings.push_back("WindNinja_cli");
+    strings.insert(strings.end(), args.begin(), args.end());
+
+    std::vector<char*> argv;
+    for(unsigned int i = 0; i < strings.size(); i++)
+        argv.push_back(&strings[i][0]);
+    argv.push_back(NULL);
+
+    int code;
+    try
+    {
+        code = windNinjaCLI((int)strings.size(), &argv[0], this);
+    }
+    catch(std::exception &e)
+    {
+        fprintf(stderr, "Exception caught: %s\n", e.what());
+        code = -1;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    return code;
+}
+
+void NinjaServer::reply(const CPLJSONObject &message)
+{
+    CPLAcquireMutex(outMutex, 1000.0);
+    write(message);
+    CPLReleaseMutex(outMutex);
+}
+
+/* Write a reply, with outMutex held. */
+void NinjaServer::write(const CPLJSONObject &message)
+{
+    std::string text = message.Format(CPLJSONObject::PrettyFormat::Plain);
+    fprintf(out, "%s\n", text.c_str());
+    fflush(out);
+}
+
+/**
+ * Command line text of a request argument, by its JSON type.
+ *
+ * @return false if the argument is not a string, number or boolean.
+ */
+bool NinjaServer::argString(const CPLJSONObject &value, std::string &arg)
+{
+    switch(value.GetType())
+    {
+        case CPLJSONObject::Type::String:
+            arg = value.ToString();
+            return true;
+        case CPLJSONObject::Type::Boolean:
+            arg = value.ToBool() ? "true" : "false";
+            return true;
+        case CPLJSONObject::Type::Integer:
+        case CPLJSONObject::Type::Long:
+            arg = CPLSPrintf("%lld", (long long)value.ToLong());
+            return true;
+        case CPLJSONObject::Type::Double:
+            arg = CPLSPrintf("%.17g", value.ToDouble());
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Run complete handler of the armies of a request, see streamRuns().
+ * Called from the threads of the runs.
+ */
+void NinjaServer::runComplete(const ninjaRunResult *pResult, void *pUser)
+{
+    NinjaServer *server = static_cast<NinjaServer*>(pUser);
+
+    //the reply is built with the lock held, it shares the request id with the other runs
+    CPLAcquireMutex(server->outMutex, 1000.0);
+    server->writeRun(*pResult);
+    CPLReleaseMutex(server->outMutex);
+}
+
+/* Write the reply for a finished run, with outMutex held. */
+void NinjaServer::writeRun(const ninjaRunResult &result)
+{
+    CPLJSONObject message;
+    if(requestId.IsValid())
+        message.Add("id", requestId);
+    message.Add("status", "run");
+    message.Add("run", result.runNumber);
+    message.Add("code", result.status);
+    message.Add("rows", result.nRows);
+    message.Add("cols", result.nCols);
+    message.Add("cellSize", result.cellSize);
+    message.Add("xllCorner", result.xllCorner);
+    message.Add("yllCorner", result.yllCorner);
+    message.Add("prj", std::string(result.prj));
+    if(requestGrids && result.speed != NULL && result.direction != NULL)
+    {
+        CPLJSONArray speed, direction;
+        for(int i = 0; i < result.nRows * result.nCols; i++)
+        {
+            speed.Add(result.speed[i]);
+            direction.Add(result.direction[i]);
+        }
+        message.Add("speed", speed);
+        message.Add("direction", direction);
+    }
+    write(message);
+}
+
+std::string NinjaServer::stamp(const std::string &demFile)
+{
+    VSIStatBufL sStat;
+    if(VSIStatL(demFile.c_str(), &sStat) != 0)
+        return "";
+    return CPLSPrintf("%lld:%lld", (long long)sStat.st_size, (long long)sStat.st_mtime);
+}
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Long running server answering WindNinja runs read from stdin
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef NINJA_SERVER_H
+#define NINJA_SERVER_H
+
+#include <cstdio>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cpl_json.h"
+#include "cpl_multiproc.h"
+
+#include "ninjaArmy.h"
+#include "terrainContext.h"
+#include "deflationSpace.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#endif
+
+/**
+ * Runs the command line interface for requests read from stdin, one JSON
+ * object per line, without restarting the process in between:
+ *
+ *   {"id": 1, "args": ["--config_file", "run.cfg", "--num_threads", 4]}
+ *   {"id": 2, "config_file": "run.cfg", "grids": true}
+ *   {"command": "shutdown"}
+ *
+ * Arguments may be strings, numbers or booleans.  Each request is answered
+ * on stdout with {"id": .., "status": "started"}, then with
+ * {"id": .., "status": "run", "run": .., "code": .., "rows": .., ...} as
+ * each of its runs finishes (code non-zero if the run failed, with the
+ * "speed" and "direction" grids, first row southern, if the request asked
+ * for "grids"), and when its runs are done with {"id": .., "status": "ok"
+ * or "error", "code": .., "seconds": ..}, code being the return value of
+ * windNinjaCLI().  Everything else the runs print goes to stderr.  The
+ * server stops on shutdown or at the end of stdin.
+ *
+ * The terrain (see TerrainContext) and the solver recycling space (see
+ * DeflationSpace) of the last nDems DEMs are kept, so a request on a DEM
+ * seen before skips reading, resampling and the slope/aspect computation,
+ * and its solves start from the vectors of the earlier ones.  A DEM file
+ * changed on disk is read again.
+ */
+class NinjaServer
+{
+public:
+    NinjaServer(int nDems);
+    ~NinjaServer();
+
+    int run();
+    void prepare(ninjaArmy &army, const std::string &demFile, int nRecyclingVectors);
+    void streamRuns(ninjaArmy &army);
+
+private:
+    struct Entry
+    {
+        std::string stamp;  //size and modification time of the DEM
+        boost::shared_ptr<TerrainContext> terrain;
+        boost::shared_ptr<DeflationSpace> space;
+    };
+
+    int nDems;
+    std::list<std::string> order;   //DEMs, most recently used first
+    std::map<std::string, Entry> entries;
+    FILE *out;                      //protocol stream, the original stdout
+    CPLMutex *outMutex;             //replies come from the threads of the runs too
+    CPLJSONObject requestId;        //id of the request being run, invalid if it has none
+    bool requestGrids;              //stream the output grids of its runs
+
+    bool handle(const std::string &line);
+    int runRequest(const std::vector<std::string> &args);
+    void reply(const CPLJSONObject &message);
+    void write(const CPLJSONObject &message);
+    void writeRun(const ninjaRunResult &result);
+
+    static bool argString(const CPLJSONObject &value, std::string &arg);
+    static void runComplete(const ninjaRunResult *pResult, void *pUser);
+    static std::string stamp(const std::string &demFile);
+
+    NinjaServer(const NinjaServer &);
+    NinjaServer &operator=(const NinjaServer &);
+};
+
+#endif /* NINJA_SERVER_H */
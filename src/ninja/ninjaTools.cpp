@@ -496,8 +496,6 @@ int ninjaTools::fetchStationFromBBox( const int* yearList, const int * monthList
         }
         // End Custom API_KEY STUFF
 
-        wxStation::SetStationFormat(wxStation::newFormat);
-
         if(!fetchLatestFlag)
         {
             boost::local_time::tz_database tz_db;
@@ -563,8 +561,6 @@ int ninjaTools::fetchStationByName( const int* yearList, const int * monthList,
         }
         // End Custom API_KEY STUFF
 
-        wxStation::SetStationFormat(wxStation::newFormat);
-
         if(!fetchLatestFlag)
         {
             boost::local_time::tz_database tz_db;
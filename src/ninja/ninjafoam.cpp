@@ -29,11 +29,10 @@
 
 #include "ninjafoam.h"
 
-const char* NinjaFoam::pszFoamPath = NULL;
-
 NinjaFoam::NinjaFoam() : ninja()
 {
     foamVersion = "";
+    foamPath = boost::shared_ptr<std::string>( new std::string() );
     
     pszVrtMem = NULL;
     pszGridFilename = NULL;
@@ -83,7 +82,7 @@ NinjaFoam::NinjaFoam() : ninja()
 
 NinjaFoam::NinjaFoam(NinjaFoam const& A ) : ninja(A)
 {
-
+    foamPath = A.foamPath;
 }
 
 
@@ -97,6 +96,7 @@ NinjaFoam& NinjaFoam::operator= (NinjaFoam const& A)
 {
     if(&A != this) {
         ninja::operator=(A);
+        foamPath = A.foamPath;
     }
     return *this;
 }
@@ -329,8 +329,8 @@ bool NinjaFoam::simulate_wind()
         /*  write OpenFOAM files                    */
         /*------------------------------------------*/
 
-        // if pszFoamPath is not valid, create a new case
-        if(!CheckForValidCaseDir(pszFoamPath)){
+        // if foamPath is not valid, create a new case
+        if(!CheckForValidCaseDir(foamPath->c_str())){
             GenerateNewCase();
         }
         else{ // otherwise, we're just updating an existing case
@@ -402,14 +402,10 @@ bool NinjaFoam::simulate_wind()
                 input.Com->ninjaCom(ninjaComClass::ninjaNone, "Smoothing elevation file, smoothDist = %d",smoothDist);
                 input.dem.smooth_elevation(smoothDist);
 
-                CPLDebug("NINJAFOAM", "unlinking %s", CPLSPrintf( "%s", pszFoamPath ));
-                NinjaUnlinkTree( CPLSPrintf( "%s", pszFoamPath ) );
+                CPLDebug("NINJAFOAM", "unlinking %s", CPLSPrintf( "%s", foamPath->c_str() ));
+                NinjaUnlinkTree( CPLSPrintf( "%s", foamPath->c_str() ) );
                 CPLDebug("NINJAFOAM", "generating new NINJAFOAM directory");
-                // force temp dir to DEM location
-                CPLSetConfigOption("CPL_TMPDIR", CPLGetDirname(input.dem.fileName.c_str()));
-                CPLSetConfigOption("CPLTMPDIR", CPLGetDirname(input.dem.fileName.c_str()));
-                CPLSetConfigOption("TEMP", CPLGetDirname(input.dem.fileName.c_str()));
-                int retval = GenerateFoamDirectory(input.dem.fileName);
+                int retval = GenerateFoamDirectory(input.dem.fileName, *foamPath);
                 if(retval != 0){
                     throw std::runtime_error("Error generating the NINJAFOAM directory.");
                 }
@@ -463,11 +459,11 @@ bool NinjaFoam::simulate_wind()
         const char *pszInput;
         const char *pszOutput;
         if ( foamVersion == "2.2.0" ) {
-            pszInput = CPLFormFilename(pszFoamPath, "system/sampleDict", "");
-            pszOutput = CPLFormFilename(pszFoamPath, "system/sampleDict", "");
+            pszInput = CPLFormFilename(foamPath->c_str(), "system/sampleDict", "");
+            pszOutput = CPLFormFilename(foamPath->c_str(), "system/sampleDict", "");
         } else {
-            pszInput = CPLFormFilename(pszFoamPath, "system/surfaces", "");
-            pszOutput = CPLFormFilename(pszFoamPath, "system/surfaces", "");
+            pszInput = CPLFormFilename(foamPath->c_str(), "system/surfaces", "");
+            pszOutput = CPLFormFilename(foamPath->c_str(), "system/surfaces", "");
         }
         CopyFile(pszInput, pszOutput, "$interpolationScheme$", scheme);
 
@@ -500,14 +496,10 @@ bool NinjaFoam::simulate_wind()
             input.Com->ninjaCom(ninjaComClass::ninjaNone, "Smoothing elevation file, smoothDist = %d",smoothDist);
             input.dem.smooth_elevation(smoothDist);
 
-            CPLDebug("NINJAFOAM", "unlinking %s", CPLSPrintf( "%s", pszFoamPath ));
-            NinjaUnlinkTree( CPLSPrintf( "%s", pszFoamPath ) );
+            CPLDebug("NINJAFOAM", "unlinking %s", CPLSPrintf( "%s", foamPath->c_str() ));
+            NinjaUnlinkTree( CPLSPrintf( "%s", foamPath->c_str() ) );
             CPLDebug("NINJAFOAM", "generating new NINJAFOAM directory");
-            // force temp dir to DEM location
-            CPLSetConfigOption("CPL_TMPDIR", CPLGetDirname(input.dem.fileName.c_str()));
-            CPLSetConfigOption("CPLTMPDIR", CPLGetDirname(input.dem.fileName.c_str()));
-            CPLSetConfigOption("TEMP", CPLGetDirname(input.dem.fileName.c_str()));
-            int retval = GenerateFoamDirectory(input.dem.fileName);
+            int retval = GenerateFoamDirectory(input.dem.fileName, *foamPath);
             if(retval != 0){
                 throw std::runtime_error("Error generating the NINJAFOAM directory.");
             }
@@ -867,7 +859,7 @@ void NinjaFoam::WriteFoamFiles()
         pszFilename = CPLGetFilename(papszFileList[i]);
         osFullPath = papszFileList[i];
         if(std::string(pszFilename) == ""){
-            pszTempFoamPath = CPLFormFilename(pszFoamPath, osFullPath.c_str(), "");
+            pszTempFoamPath = CPLFormFilename(foamPath->c_str(), osFullPath.c_str(), "");
             VSIMkdir(pszTempFoamPath, 0777);
         }
     }
@@ -893,7 +885,7 @@ void NinjaFoam::WriteFoamFiles()
             }
             
             pszInput = CPLFormFilename(pszArchive, osFullPath.c_str(), "");
-            pszOutput = CPLFormFilename(pszFoamPath, osFullPath.c_str(), "");
+            pszOutput = CPLFormFilename(foamPath->c_str(), osFullPath.c_str(), "");
 
             fin = VSIFOpenL( pszInput, "r" );
             fout = VSIFOpenL( pszOutput, "w" );
@@ -913,17 +905,46 @@ void NinjaFoam::WriteFoamFiles()
     CSLDestroy( papszFileList );
 }
 
-void NinjaFoam::SetFoamPath(const char* pszPath)
+/**
+ * Set the case directory of the run.  The ninjas of an army share one path
+ * so a directory regenerated by a retry is seen by the later runs, without
+ * touching the case of another army.
+ * @param path Shared case directory.
+ */
+void NinjaFoam::SetFoamPath(boost::shared_ptr<std::string> path)
 {
-    pszFoamPath = pszPath;
-
+    foamPath = path;
 }
 
-int NinjaFoam::GenerateFoamDirectory(std::string demName)
+/**
+ * Make a new case directory for a DEM next to the DEM.  The temp directory
+ * is pointed at the DEM location for the calling thread only, and put back
+ * when the directory is made.
+ * @param demName DEM of the runs.
+ * @param path Set to the new directory.
+ * @return NINJA_SUCCESS
+ */
+int NinjaFoam::GenerateFoamDirectory(std::string demName, std::string &path)
 {
+    static const char *apszTmpOptions[] = { "CPL_TMPDIR", "CPLTMPDIR", "TEMP" };
+    std::string oldValues[3];
+    bool hadValues[3];
+    std::string demDir = CPLGetDirname(demName.c_str());
+    for(int i = 0; i < 3; i++)
+    {
+        const char *pszOld = CPLGetThreadLocalConfigOption(apszTmpOptions[i], NULL);
+        hadValues[i] = pszOld != NULL;
+        if(hadValues[i])
+            oldValues[i] = pszOld;
+        CPLSetThreadLocalConfigOption(apszTmpOptions[i], demDir.c_str());
+    }
+
     std::string t = NinjaSanitizeString(std::string(CPLGetBasename(demName.c_str())));
-    pszFoamPath = CPLStrdup(CPLGenerateTempFilename( CPLSPrintf("NINJAFOAM_%s", t.c_str())));
-    VSIMkdir( pszFoamPath, 0777 );
+    path = CPLGenerateTempFilename( CPLSPrintf("NINJAFOAM_%s", t.c_str()));
+    VSIMkdir( path.c_str(), 0777 );
+
+    for(int i = 0; i < 3; i++)
+        CPLSetThreadLocalConfigOption(apszTmpOptions[i], hadValues[i] ? oldValues[i].c_str() : NULL);
 
     return NINJA_SUCCESS;
 }
@@ -1172,18 +1193,18 @@ void NinjaFoam::SetBlockMeshParametersFromDem()
     initialFirstCellHeight = blockMeshResolution; //height of first cell
 
     //firstCellheight will be used when decomposing domain for moveDynamicMesh
-    CopyFile(CPLFormFilename(pszFoamPath, "0/U", ""), 
-            CPLFormFilename(pszFoamPath, "0/U", ""), 
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/U", ""), 
+            CPLFormFilename(foamPath->c_str(), "0/U", ""), 
             "-9999.9", 
             CPLSPrintf("%.2f", initialFirstCellHeight));
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/k", ""), 
-            CPLFormFilename(pszFoamPath, "0/k", ""), 
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/k", ""), 
+            CPLFormFilename(foamPath->c_str(), "0/k", ""), 
             "-9999.9", 
             CPLSPrintf("%.2f", initialFirstCellHeight));
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/epsilon", ""), 
-            CPLFormFilename(pszFoamPath, "0/epsilon", ""), 
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/epsilon", ""), 
+            CPLFormFilename(foamPath->c_str(), "0/epsilon", ""), 
             "-9999.9", 
             CPLSPrintf("%.2f", initialFirstCellHeight));
     
@@ -1224,10 +1245,10 @@ void NinjaFoam::writeBlockMesh()
 
     if( foamVersion == "9" || foamVersion == "11" ) {
         pszInput = CPLFormFilename(pszArchive, "system/blockMeshDict", "");
-        pszOutput = CPLFormFilename(pszFoamPath, "system/blockMeshDict", "");
+        pszOutput = CPLFormFilename(foamPath->c_str(), "system/blockMeshDict", "");
     } else {  // if ( foamVersion == "2.2.0" )
         pszInput = CPLFormFilename(pszArchive, "constant/polyMesh/blockMeshDict", "");
-        pszOutput = CPLFormFilename(pszFoamPath, "constant/polyMesh/blockMeshDict", "");
+        pszOutput = CPLFormFilename(foamPath->c_str(), "constant/polyMesh/blockMeshDict", "");
     }
 
     VSILFILE *fin;
@@ -1314,7 +1335,7 @@ void NinjaFoam::writeMoveDynamicMesh()
     }
 
     pszInput = CPLFormFilename(pszArchive, "0/pointDisplacement", "");
-    pszOutput = CPLFormFilename(pszFoamPath, "0/pointDisplacement", "");
+    pszOutput = CPLFormFilename(foamPath->c_str(), "0/pointDisplacement", "");
 
     fin = VSIFOpenL( pszInput, "r" );
     fout = VSIFOpenL( pszOutput, "w" );
@@ -1343,8 +1364,8 @@ void NinjaFoam::writeMoveDynamicMesh()
     VSIFCloseL(fin);
     VSIFCloseL(fout);
     
-    pszInput = CPLFormFilename(pszFoamPath, "0/pointDisplacement", "");
-    pszOutput = CPLFormFilename(pszFoamPath, "0/pointDisplacement", "");
+    pszInput = CPLFormFilename(foamPath->c_str(), "0/pointDisplacement", "");
+    pszOutput = CPLFormFilename(foamPath->c_str(), "0/pointDisplacement", "");
     
     /*
      * Check firstCellHeight in the block mesh. 
@@ -1449,8 +1470,8 @@ void NinjaFoam::MoveDynamicMesh()
         DecomposePar();
 
         //re-write controlDict for moveDynamicMesh
-        pszInput = CPLFormFilename(pszFoamPath, "system/controlDict_moveDynamicMesh", "");
-        pszOutput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
+        pszInput = CPLFormFilename(foamPath->c_str(), "system/controlDict_moveDynamicMesh", "");
+        pszOutput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
         CopyFile(pszInput, pszOutput);
 
         CPLSpawnedProcess *sp;
@@ -1463,7 +1484,7 @@ void NinjaFoam::MoveDynamicMesh()
                                       CPLSPrintf("%d", input.numberCPUs),
                                       "moveDynamicMesh",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                       NULL };
 
@@ -1479,7 +1500,7 @@ void NinjaFoam::MoveDynamicMesh()
                                       CPLSPrintf("%d", input.numberCPUs),
                                       "moveDynamicMesh",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                       NULL };
 
@@ -1497,7 +1518,7 @@ void NinjaFoam::MoveDynamicMesh()
                                       "-solver",
                                       "movingMesh",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                       NULL };
 
@@ -1513,7 +1534,7 @@ void NinjaFoam::MoveDynamicMesh()
                                       "--allow-run-as-root",
                                       "moveDynamicMesh",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                       NULL };
 
@@ -1563,8 +1584,8 @@ void NinjaFoam::MoveDynamicMesh()
     else{ // single processor
 
         //re-write controlDict for moveDynamicMesh
-        pszInput = CPLFormFilename(pszFoamPath, "system/controlDict_moveDynamicMesh", "");
-        pszOutput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
+        pszInput = CPLFormFilename(foamPath->c_str(), "system/controlDict_moveDynamicMesh", "");
+        pszOutput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
         CopyFile(pszInput, pszOutput);
 
         CPLSpawnedProcess *sp;
@@ -1575,7 +1596,7 @@ void NinjaFoam::MoveDynamicMesh()
                                               "-solver",
                                               "movingMesh",
                                               "-case",
-                                              pszFoamPath,
+                                              foamPath->c_str(),
                                               NULL };
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
         }
@@ -1583,7 +1604,7 @@ void NinjaFoam::MoveDynamicMesh()
         {
             const char *const papszArgv[] = { "moveDynamicMesh",
                                               "-case",
-                                              pszFoamPath,
+                                              foamPath->c_str(),
                                               NULL };
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
         }
@@ -1621,15 +1642,15 @@ void NinjaFoam::MoveDynamicMesh()
     }
     
     // write moveDynamicMesh stdout to a log file 
-    fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.moveDynamicMesh", ""), "w");
+    fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.moveDynamicMesh", ""), "w");
     const char * d = s.c_str();
     int nSize = strlen(d);
     VSIFWriteL(d, nSize, 1, fout);
     VSIFCloseL(fout);
     
     //re-write controlDict for flow
-    pszInput = CPLFormFilename(pszFoamPath, "system/controlDict_simpleFoam", "");
-    pszOutput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
+    pszInput = CPLFormFilename(foamPath->c_str(), "system/controlDict_simpleFoam", "");
+    pszOutput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
     CopyFile(pszInput, pszOutput); 
     
     //update dict files
@@ -1646,13 +1667,13 @@ void NinjaFoam::RefineSurfaceLayer()
     const char *pszOutput;
     
     //write/edit topoSetDict
-    pszInput = CPLFormFilename(pszFoamPath, "system/topoSetDict", "");
-    pszOutput = CPLFormFilename(pszFoamPath, "system/topoSetDict", "");
+    pszInput = CPLFormFilename(foamPath->c_str(), "system/topoSetDict", "");
+    pszOutput = CPLFormFilename(foamPath->c_str(), "system/topoSetDict", "");
 
     std::string stlName = NinjaSanitizeString(std::string(CPLGetBasename(input.dem.fileName.c_str())));
 
     CopyFile(pszInput, pszOutput, "$terrain$", 
-            CPLFormFilename(CPLSPrintf("%s/constant/triSurface", pszFoamPath), stlName.c_str(), ""));
+            CPLFormFilename(CPLSPrintf("%s/constant/triSurface", foamPath->c_str()), stlName.c_str(), ""));
     CopyFile(pszInput, pszOutput, "$xout$", CPLSPrintf("%.2f", (bbox[0] + 10)));
     CopyFile(pszInput, pszOutput, "$yout$", CPLSPrintf("%.2f", (bbox[1] + 10)));
     CopyFile(pszInput, pszOutput, "$zout$", CPLSPrintf("%.2f", (bbox[5] - 10)));
@@ -1667,12 +1688,12 @@ void NinjaFoam::RefineSurfaceLayer()
     //write/edit refineMeshDict
     if( foamVersion == "2.2.0" )
     {
-        pszInput = CPLFormFilename(pszFoamPath, "system/refineMeshDict_xyz", "");
-        pszOutput = CPLFormFilename(pszFoamPath, "system/refineMeshDict", "");
+        pszInput = CPLFormFilename(foamPath->c_str(), "system/refineMeshDict_xyz", "");
+        pszOutput = CPLFormFilename(foamPath->c_str(), "system/refineMeshDict", "");
         CopyFile(pszInput, pszOutput);
     }
-    //pszInput = CPLFormFilename(pszFoamPath, "system/refineMeshDict", "");
-    //pszOutput = CPLFormFilename(pszFoamPath, "system/refineMeshDict", "");
+    //pszInput = CPLFormFilename(foamPath->c_str(), "system/refineMeshDict", "");
+    //pszOutput = CPLFormFilename(foamPath->c_str(), "system/refineMeshDict", "");
     
     input.Com->ninjaCom(ninjaComClass::ninjaNone, "(refineMesh) 10%% complete...");
 
@@ -1695,8 +1716,8 @@ void NinjaFoam::RefineSurfaceLayer()
         UpdateSimpleFoamControlDict();
         UpdateTimeDirFiles();
 
-        pszInput = CPLFormFilename(pszFoamPath, "system/topoSetDict", "");
-        pszOutput = CPLFormFilename(pszFoamPath, "system/topoSetDict", "");
+        pszInput = CPLFormFilename(foamPath->c_str(), "system/topoSetDict", "");
+        pszOutput = CPLFormFilename(foamPath->c_str(), "system/topoSetDict", "");
         
         CopyFile(pszInput, pszOutput, 
                 CPLSPrintf("nearDistance    %.2f", oldFirstCellHeight),
@@ -1720,26 +1741,26 @@ void NinjaFoam::RefineSurfaceLayer()
 void NinjaFoam::UpdateTimeDirFiles()
 {
     /* copy files to latestTime and update firstCellHeight */   
-    CopyFile(CPLFormFilename(pszFoamPath, "0/U", ""), 
-            CPLFormFilename(pszFoamPath, CPLSPrintf("%s/U", boost::lexical_cast<std::string>(latestTime).c_str()),  ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/U", ""), 
+            CPLFormFilename(foamPath->c_str(), CPLSPrintf("%s/U", boost::lexical_cast<std::string>(latestTime).c_str()),  ""),
             CPLSPrintf("firstCellHeight %.2f;", initialFirstCellHeight),
             CPLSPrintf("firstCellHeight %.2f;", finalFirstCellHeight));
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/k", ""), 
-            CPLFormFilename(pszFoamPath, CPLSPrintf("%s/k", boost::lexical_cast<std::string>(latestTime).c_str()),  ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/k", ""), 
+            CPLFormFilename(foamPath->c_str(), CPLSPrintf("%s/k", boost::lexical_cast<std::string>(latestTime).c_str()),  ""),
             CPLSPrintf("firstCellHeight %.2f;", initialFirstCellHeight),
             CPLSPrintf("firstCellHeight %.2f;", finalFirstCellHeight)); 
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/epsilon", ""), 
-            CPLFormFilename(pszFoamPath, CPLSPrintf("%s/epsilon", boost::lexical_cast<std::string>(latestTime).c_str()),  ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/epsilon", ""), 
+            CPLFormFilename(foamPath->c_str(), CPLSPrintf("%s/epsilon", boost::lexical_cast<std::string>(latestTime).c_str()),  ""),
             CPLSPrintf("firstCellHeight %.2f;", initialFirstCellHeight),
             CPLSPrintf("firstCellHeight %.2f;", finalFirstCellHeight)); 
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/nut", ""),
-            CPLFormFilename(pszFoamPath, CPLSPrintf("%s/nut", boost::lexical_cast<std::string>(latestTime).c_str()),  ""));
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/nut", ""),
+            CPLFormFilename(foamPath->c_str(), CPLSPrintf("%s/nut", boost::lexical_cast<std::string>(latestTime).c_str()),  ""));
 
-    CopyFile(CPLFormFilename(pszFoamPath, "0/p", ""), 
-            CPLFormFilename(pszFoamPath, CPLSPrintf("%s/p", boost::lexical_cast<std::string>(latestTime).c_str()),  ""));
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/p", ""), 
+            CPLFormFilename(foamPath->c_str(), CPLSPrintf("%s/p", boost::lexical_cast<std::string>(latestTime).c_str()),  ""));
 }
 
 void NinjaFoam::UpdateSimpleFoamControlDict()
@@ -1748,8 +1769,8 @@ void NinjaFoam::UpdateSimpleFoamControlDict()
     int oldSimpleFoamEndTime = simpleFoamEndTime; 
     simpleFoamEndTime = latestTime + input.nIterations; //only write final timestep
     CPLDebug("NINJAFOAM", "simpleFoamEndTime = %d", simpleFoamEndTime);
-    const char *pszInput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
-    const char *pszOutput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
+    const char *pszInput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
+    const char *pszOutput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
     //update endTime based on latestTime
     CopyFile(pszInput, pszOutput, 
         CPLSPrintf("endTime         %d", oldSimpleFoamEndTime),
@@ -1765,11 +1786,11 @@ void NinjaFoam::TopoSet()
     {
         const char *const papszArgv[] = { "topoSet",
                                         "-case",
-                                        pszFoamPath,
+                                        foamPath->c_str(),
                                         "-latestTime",
                                         NULL };
 
-        VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.topoSet", ""), "w");
+        VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.topoSet", ""), "w");
         
         nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
         if(nRet != 0)
@@ -1781,13 +1802,13 @@ void NinjaFoam::TopoSet()
     {
         const char *const papszArgv[] = { "topoSet",
                                         "-case",
-                                        pszFoamPath,
+                                        foamPath->c_str(),
                                         "-dict",
                                         "system/topoSetDict",
                                         "-latestTime",
                                         NULL };
 
-        VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.topoSet", ""), "w");
+        VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.topoSet", ""), "w");
         
         nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
         if(nRet != 0)
@@ -1805,10 +1826,10 @@ void NinjaFoam::RefineMesh()
     {
         const char *const papszArgv[] = { "refineMesh",
                                         "-case",
-                                        pszFoamPath,
+                                        foamPath->c_str(),
                                         NULL };
 
-        VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.refineMesh", ""), "w");
+        VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.refineMesh", ""), "w");
         
         nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
         if(nRet != 0)
@@ -1820,12 +1841,12 @@ void NinjaFoam::RefineMesh()
     {
         const char *const papszArgv[] = { "refineMesh",
                                         "-case",
-                                        pszFoamPath,
+                                        foamPath->c_str(),
                                         "-dict",
                                         "system/refineMeshDict", 
                                         NULL };
 
-        VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.refineMesh", ""), "w");
+        VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.refineMesh", ""), "w");
         
         nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
         if(nRet != 0)
@@ -1841,10 +1862,10 @@ void NinjaFoam::BlockMesh()
 
     const char *const papszArgv[] = { "blockMesh", 
                                     "-case",
-                                    pszFoamPath,
+                                    foamPath->c_str(),
                                     NULL };
 
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.blockMesh", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.blockMesh", ""), "w");
 
     nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
     if(nRet != 0)
@@ -1859,11 +1880,11 @@ void NinjaFoam::DecomposePar()
 
     const char *const papszArgv[] = { "decomposePar", 
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-force", 
                                       NULL };
     
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.decomposePar", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.decomposePar", ""), "w");
 
     nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
     if(nRet != 0)
@@ -1878,11 +1899,11 @@ void NinjaFoam::ReconstructPar()
 
     const char *const papszArgv[] = { "reconstructPar", 
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-latestTime",
                                       NULL };
     
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.reconstructPar", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.reconstructPar", ""), "w");
 
     nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
     if(nRet != 0)
@@ -1897,12 +1918,12 @@ void NinjaFoam::RenumberMesh()
 
     const char *const papszArgv[] = { "renumberMesh", 
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-latestTime",
                                       "-overwrite", 
                                       NULL };
 
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.renumberMesh", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.renumberMesh", ""), "w");
 
     nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
     if(nRet != 0)
@@ -1915,8 +1936,8 @@ void NinjaFoam::ApplyInit()
 {
     if( foamVersion == "11" )
     {
-        const char *pszInput = CPLFormFilename(pszFoamPath, "constant/dynamicMeshDict", "");
-        const char *pszOutput = CPLFormFilename(pszFoamPath, "constant/dynamicMeshDict__moveDynamicMesh", "");
+        const char *pszInput = CPLFormFilename(foamPath->c_str(), "constant/dynamicMeshDict", "");
+        const char *pszOutput = CPLFormFilename(foamPath->c_str(), "constant/dynamicMeshDict__moveDynamicMesh", "");
         int nRet = VSIRename(pszInput, pszOutput);
         if(nRet != 0)
         {
@@ -1928,10 +1949,10 @@ void NinjaFoam::ApplyInit()
 
     const char *const papszArgv[] = { "applyInit", 
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       NULL };
 
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.applyInit", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.applyInit", ""), "w");
 
     nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
     if(nRet != 0)
@@ -1960,7 +1981,7 @@ bool NinjaFoam::SimpleFoam()
                                       CPLSPrintf("%d", input.numberCPUs),
                                       "simpleFoam",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                        NULL };
         sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
@@ -1973,7 +1994,7 @@ bool NinjaFoam::SimpleFoam()
                                       CPLSPrintf("%d", input.numberCPUs),
                                       "simpleFoam",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                        NULL };
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
@@ -1988,7 +2009,7 @@ bool NinjaFoam::SimpleFoam()
                                       "-solver",
                                       "incompressibleFluid",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                        NULL };
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
@@ -2001,7 +2022,7 @@ bool NinjaFoam::SimpleFoam()
                                       "--allow-run-as-root",
                                       "simpleFoam",
                                       "-case",
-                                      pszFoamPath,
+                                      foamPath->c_str(),
                                       "-parallel",
                                        NULL };
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
@@ -2048,7 +2069,7 @@ bool NinjaFoam::SimpleFoam()
                                            "-solver",
                                            "incompressibleFluid",
                                            "-case",
-                                           pszFoamPath,
+                                           foamPath->c_str(),
                                            NULL };
 
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
@@ -2057,7 +2078,7 @@ bool NinjaFoam::SimpleFoam()
         {
             const char *const papszArgv[] = { "simpleFoam",
                                            "-case",
-                                           pszFoamPath,
+                                           foamPath->c_str(),
                                            NULL };
 
             sp = CPLSpawnAsync(NULL, papszArgv, FALSE, TRUE, TRUE, NULL);
@@ -2094,7 +2115,7 @@ bool NinjaFoam::SimpleFoam()
     }
     
     // write simpleFoam stdout to a log file 
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.simpleFoam", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.simpleFoam", ""), "w");
     const char * d = s.c_str();
     int nSize = strlen(d);
     VSIFWriteL(d, nSize, 1, fout);
@@ -2107,13 +2128,13 @@ void NinjaFoam::Sample()
 {
     int nRet = -1;
     
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.sample", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.sample", ""), "w");
     
     if( foamVersion == "2.2.0" )
     {
         const char *const papszArgv[] = { "sample",
                                           "-case",
-                                          pszFoamPath,
+                                          foamPath->c_str(),
                                           "-latestTime",
                                           NULL };
         nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
@@ -2122,7 +2143,7 @@ void NinjaFoam::Sample()
     {
         const char *const papszArgv[] = { "foamPostProcess",
                                           "-case",
-                                          pszFoamPath,
+                                          foamPath->c_str(),
                                           "-func",
                                           "surfaces",
                                           "-latestTime",
@@ -2133,7 +2154,7 @@ void NinjaFoam::Sample()
     {
         const char *const papszArgv[] = { "simpleFoam",
                                           "-case",
-                                          pszFoamPath,
+                                          foamPath->c_str(),
                                           "-postProcess",
                                           "-func",
                                           "surfaces",
@@ -2219,22 +2240,22 @@ int NinjaFoam::SanitizeOutput()
     /*-------------------------------------------------------------------*/
     /* sanitize the u, v, and k output                                       */
     /*-------------------------------------------------------------------*/
-    pszMem = CPLSPrintf("%s/output.raw", pszFoamPath);
+    pszMem = CPLSPrintf("%s/output.raw", foamPath->c_str());
     /* This is a member, hold on to it so we can read it later */
-    pszVrtMem = CPLStrdup(CPLSPrintf("%s/output.vrt", pszFoamPath));
+    pszVrtMem = CPLStrdup(CPLSPrintf("%s/output.vrt", foamPath->c_str()));
 
     char **papszOutputSurfacePath;
-    papszOutputSurfacePath = VSIReadDir(CPLSPrintf("%s/postProcessing/surfaces/", pszFoamPath));
+    papszOutputSurfacePath = VSIReadDir(CPLSPrintf("%s/postProcessing/surfaces/", foamPath->c_str()));
 
     for(int i = 0; i < CSLCount(papszOutputSurfacePath); i++)
     {
         if(std::string(papszOutputSurfacePath[i]) != "." && std::string(papszOutputSurfacePath[i]) != "..")
         {
             fin = VSIFOpen(CPLSPrintf("%s/postProcessing/surfaces/%s/U_triSurfaceSampling.raw",
-                           pszFoamPath,
+                           foamPath->c_str(),
                            papszOutputSurfacePath[i]), "r");
             fin2 = VSIFOpen(CPLSPrintf("%s/postProcessing/surfaces/%s/k_triSurfaceSampling.raw",
-                            pszFoamPath,
+                            foamPath->c_str(),
                             papszOutputSurfacePath[i]), "r");
             break;
         }
@@ -2343,19 +2364,19 @@ int NinjaFoam::SanitizeOutput_foam10()
     /*-------------------------------------------------------------------*/
     /* sanitize the u, v, and k output                                       */
     /*-------------------------------------------------------------------*/
-    pszMem = CPLSPrintf("%s/output.raw", pszFoamPath);
+    pszMem = CPLSPrintf("%s/output.raw", foamPath->c_str());
     /* This is a member, hold on to it so we can read it later */
-    pszVrtMem = CPLStrdup(CPLSPrintf("%s/output.vrt", pszFoamPath));
+    pszVrtMem = CPLStrdup(CPLSPrintf("%s/output.vrt", foamPath->c_str()));
 
     char **papszOutputSurfacePath;
-    papszOutputSurfacePath = VSIReadDir(CPLSPrintf("%s/postProcessing/surfaces/", pszFoamPath));
+    papszOutputSurfacePath = VSIReadDir(CPLSPrintf("%s/postProcessing/surfaces/", foamPath->c_str()));
 
     for(int i = 0; i < CSLCount(papszOutputSurfacePath); i++)
     {
         if(std::string(papszOutputSurfacePath[i]) != "." && std::string(papszOutputSurfacePath[i]) != "..")
         {
             fin = VSIFOpen(CPLSPrintf("%s/postProcessing/surfaces/%s/triSurfaceSampling.xy",
-                           pszFoamPath,
+                           foamPath->c_str(),
                            papszOutputSurfacePath[i]), "r");
             break;
         }
@@ -2484,7 +2505,7 @@ int NinjaFoam::SampleCloud()
     nYSize = outputSampleGrid.get_nRows();
 
     GDALDriverH hDriver = GDALGetDriverByName( "GTiff" );
-    pszGridFilename = CPLStrdup( CPLSPrintf( "%s/foam.tif", pszFoamPath ) );
+    pszGridFilename = CPLStrdup( CPLSPrintf( "%s/foam.tif", foamPath->c_str() ) );
     hGriddedDS = GDALCreate( hDriver, pszGridFilename, nXSize, nYSize, 2,
                              GDT_Float64, NULL );
     GDALRasterBandH hUBand, hVBand;
@@ -2631,7 +2652,7 @@ int NinjaFoam::SampleCloudGrid()
     sOptions.dfNoDataValue = -9999.0;
 
     GDALDriverH hDriver = GDALGetDriverByName( "GTiff" );
-    pszGridFilename = CPLStrdup( CPLSPrintf( "%s/foam.tif", pszFoamPath ) );
+    pszGridFilename = CPLStrdup( CPLSPrintf( "%s/foam.tif", foamPath->c_str() ) );
     hGriddedDS = GDALCreate( hDriver, pszGridFilename, nXSize, nYSize, 3,
                              GDT_Float64, NULL );
     padfData = (double*)CPLMalloc( sizeof( double ) * nXSize * nYSize );
@@ -2844,11 +2865,11 @@ void NinjaFoam::writeProbeSampleFile( const wn_3dArray& x, const wn_3dArray& y,
     std::string probes_file;
     if(foamVersion == "2.2.0")
     {
-        probes_file = CPLFormFilename(pszFoamPath, "system/sampleDict_probes", "");
+        probes_file = CPLFormFilename(foamPath->c_str(), "system/sampleDict_probes", "");
     }
     else
     {
-        probes_file = CPLFormFilename(pszFoamPath, "system/probes", "");
+        probes_file = CPLFormFilename(foamPath->c_str(), "system/probes", "");
     }
 
     VSILFILE *fin = VSIFOpenL(probes_file.c_str(), "r");
@@ -2926,13 +2947,13 @@ void NinjaFoam::runProbeSample()
     
     int nRet = -1;
     
-    VSILFILE *fout = VSIFOpenL(CPLFormFilename(pszFoamPath, "log.probeSample", ""), "w");
+    VSILFILE *fout = VSIFOpenL(CPLFormFilename(foamPath->c_str(), "log.probeSample", ""), "w");
     
     // increase write precision for this sample
     int oldPrecisionVal = 10;  // /data/ninjafoam/ files have this value set there
     int newPrecisionVal = 20;
-    const char *pszInput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
-    const char *pszOutput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
+    const char *pszInput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
+    const char *pszOutput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
     CopyFile(pszInput, pszOutput, 
         CPLSPrintf("writePrecision  %d", oldPrecisionVal),
         CPLSPrintf("writePrecision  %d", newPrecisionVal));
@@ -2943,31 +2964,31 @@ void NinjaFoam::runProbeSample()
     if( foamVersion == "2.2.0" )
     {
         // additional step to swap back and forth between sampleDicts
-        const char *pszInput2 = CPLFormFilename(pszFoamPath, "system/sampleDict", "");
-        const char *pszOutput2 = CPLFormFilename(pszFoamPath, "system/sampleDict_surfaces", "");
+        const char *pszInput2 = CPLFormFilename(foamPath->c_str(), "system/sampleDict", "");
+        const char *pszOutput2 = CPLFormFilename(foamPath->c_str(), "system/sampleDict_surfaces", "");
         CopyFile(pszInput2, pszOutput2);
-        pszInput2 = CPLFormFilename(pszFoamPath, "system/sampleDict_probes", "");
-        pszOutput2 = CPLFormFilename(pszFoamPath, "system/sampleDict", "");
+        pszInput2 = CPLFormFilename(foamPath->c_str(), "system/sampleDict_probes", "");
+        pszOutput2 = CPLFormFilename(foamPath->c_str(), "system/sampleDict", "");
         CopyFile(pszInput2, pszOutput2);
         
         const char *const papszArgv[] = { "sample",
                                           "-case",
-                                          pszFoamPath,
+                                          foamPath->c_str(),
                                           "-latestTime",
                                           NULL };
         
         nRet = CPLSpawn(papszArgv, NULL, fout, TRUE);
         
         // swap back to the original sampleDict names
-        pszInput2 = CPLFormFilename(pszFoamPath, "system/sampleDict_surfaces", "");
-        pszOutput2 = CPLFormFilename(pszFoamPath, "system/sampleDict", "");
+        pszInput2 = CPLFormFilename(foamPath->c_str(), "system/sampleDict_surfaces", "");
+        pszOutput2 = CPLFormFilename(foamPath->c_str(), "system/sampleDict", "");
         CopyFile(pszInput2, pszOutput2);
     }
     else if( foamVersion == "11" )
     {
         const char *const papszArgv[] = { "foamPostProcess",
                                           "-case",
-                                          pszFoamPath,
+                                          foamPath->c_str(),
                                           "-func",
                                           "probes",
                                           "-latestTime",
@@ -2979,7 +3000,7 @@ void NinjaFoam::runProbeSample()
     {
         const char *const papszArgv[] = { "simpleFoam",
                                           "-case",
-                                          pszFoamPath,
+                                          foamPath->c_str(),
                                           "-postProcess",
                                           "-func",
                                           "probes",
@@ -3017,7 +3038,7 @@ void NinjaFoam::readInProbeData( const wn_3dArray& x, const wn_3dArray& y, const
     
     // method from surfaces sampling, to find the time directory for the surfaces file
     char **papszOutputProbeDataPath;
-    papszOutputProbeDataPath = VSIReadDir(CPLSPrintf("%s/postProcessing/%s/", pszFoamPath, probesPostProcessDirname));
+    papszOutputProbeDataPath = VSIReadDir(CPLSPrintf("%s/postProcessing/%s/", foamPath->c_str(), probesPostProcessDirname));
     
     const char *probeSampleData_filename;
     const char *timeDir;
@@ -3026,7 +3047,7 @@ void NinjaFoam::readInProbeData( const wn_3dArray& x, const wn_3dArray& y, const
         if(std::string(papszOutputProbeDataPath[i]) != "." && std::string(papszOutputProbeDataPath[i]) != "..")
         {
             timeDir = papszOutputProbeDataPath[i];
-            probeSampleData_filename = CPLSPrintf("%s/postProcessing/%s/%s/points_U.xy", pszFoamPath, probesPostProcessDirname, timeDir);
+            probeSampleData_filename = CPLSPrintf("%s/postProcessing/%s/%s/points_U.xy", foamPath->c_str(), probesPostProcessDirname, timeDir);
             break;
         }
     }
@@ -3156,7 +3177,7 @@ void NinjaFoam::readInProbeData( const wn_3dArray& x, const wn_3dArray& y, const
     
     // method from surfaces sampling, to find the time directory for the surfaces file
     char **papszOutputProbeDataPath;
-    papszOutputProbeDataPath = VSIReadDir(CPLSPrintf("%s/postProcessing/%s/", pszFoamPath, probesPostProcessDirname));
+    papszOutputProbeDataPath = VSIReadDir(CPLSPrintf("%s/postProcessing/%s/", foamPath->c_str(), probesPostProcessDirname));
     
     const char *probeSampleData_filename;
     const char *timeDir;
@@ -3165,7 +3186,7 @@ void NinjaFoam::readInProbeData( const wn_3dArray& x, const wn_3dArray& y, const
         if(std::string(papszOutputProbeDataPath[i]) != "." && std::string(papszOutputProbeDataPath[i]) != "..")
         {
             timeDir = papszOutputProbeDataPath[i];
-            probeSampleData_filename = CPLSPrintf("%s/postProcessing/%s/%s/points_k.xy", pszFoamPath, probesPostProcessDirname, timeDir);
+            probeSampleData_filename = CPLSPrintf("%s/postProcessing/%s/%s/points_k.xy", foamPath->c_str(), probesPostProcessDirname, timeDir);
             break;
         }
     }
@@ -3284,7 +3305,7 @@ void NinjaFoam::readInProbeData_foam10(const wn_3dArray& x, const wn_3dArray& y,
 
     // method from surfaces sampling, to find the time directory for the surfaces file
     char **papszOutputProbeDataPath;
-    papszOutputProbeDataPath = VSIReadDir(CPLSPrintf("%s/postProcessing/%s/", pszFoamPath, probesPostProcessDirname));
+    papszOutputProbeDataPath = VSIReadDir(CPLSPrintf("%s/postProcessing/%s/", foamPath->c_str(), probesPostProcessDirname));
 
     const char *probeSampleData_filename;
     const char *timeDir;
@@ -3293,7 +3314,7 @@ void NinjaFoam::readInProbeData_foam10(const wn_3dArray& x, const wn_3dArray& y,
         if(std::string(papszOutputProbeDataPath[i]) != "." && std::string(papszOutputProbeDataPath[i]) != "..")
         {
             timeDir = papszOutputProbeDataPath[i];
-            probeSampleData_filename = CPLSPrintf("%s/postProcessing/%s/%s/points.xy", pszFoamPath, probesPostProcessDirname, timeDir);
+            probeSampleData_filename = CPLSPrintf("%s/postProcessing/%s/%s/points.xy", foamPath->c_str(), probesPostProcessDirname, timeDir);
             break;
         }
     }
@@ -4255,7 +4276,7 @@ void NinjaFoam::UpdateExistingCase()
 {
     if(!CheckForValidDem())
         throw std::runtime_error(std::string("The DEM ") + input.dem.fileName.c_str() + 
-                " does not correspond to the supplied case directory " + pszFoamPath);
+                " does not correspond to the supplied case directory " + foamPath->c_str());
 
     input.Com->ninjaCom(ninjaComClass::ninjaNone, "Using existing case directory...");
     input.Com->ninjaCom(ninjaComClass::ninjaNone, "Updating case files...");
@@ -4268,7 +4289,7 @@ void NinjaFoam::UpdateExistingCase()
         CPLDebug("NINJAFOAM", "Keeping all timesteps for simulation.");
 
         char *pszPath;
-        char *pszFoamTimePath = CPLStrdup(CPLSPrintf("%s_run%d", pszFoamPath, input.inputsRunNumber-1));
+        char *pszFoamTimePath = CPLStrdup(CPLSPrintf("%s_run%d", foamPath->c_str(), input.inputsRunNumber-1));
         VSIMkdir(pszFoamTimePath, 0777);
         
         CPLDebug("NINJAFOAM", "Writing files for the previous timestep to %s", pszFoamTimePath);
@@ -4278,7 +4299,7 @@ void NinjaFoam::UpdateExistingCase()
         char **papszFileList;
         const char *pszFilename;
         std::string osFullPath;
-        papszFileList = NinjaVSIReadDirRecursive(pszFoamPath);
+        papszFileList = NinjaVSIReadDirRecursive(foamPath->c_str());
         for(int i = 0; i < CSLCount( papszFileList ); i++){
             pszFilename = CPLGetFilename(papszFileList[i]);
             osFullPath = papszFileList[i];
@@ -4286,7 +4307,7 @@ void NinjaFoam::UpdateExistingCase()
                 VSIMkdir(CPLFormFilename(pszFoamTimePath, osFullPath.c_str(), ""), 0777);
             }
             else{
-                pszInput = CPLFormFilename(pszFoamPath, osFullPath.c_str(), "");
+                pszInput = CPLFormFilename(foamPath->c_str(), osFullPath.c_str(), "");
                 pszOutput = CPLFormFilename(pszFoamTimePath, osFullPath.c_str(), "");
                 CopyFile(pszInput, pszOutput);
             }
@@ -4296,12 +4317,12 @@ void NinjaFoam::UpdateExistingCase()
     }
 
     //find and delete the old sampled output and residual directories
-    std::string outputSurfacePath = CPLSPrintf("%s/postProcessing/surfaces/", pszFoamPath);
-    std::string outputProbesPath = CPLSPrintf("%s/postProcessing/probes/", pszFoamPath);
+    std::string outputSurfacePath = CPLSPrintf("%s/postProcessing/surfaces/", foamPath->c_str());
+    std::string outputProbesPath = CPLSPrintf("%s/postProcessing/probes/", foamPath->c_str());
     if ( foamVersion == "2.2.0" ) {
-        outputProbesPath = CPLSPrintf("%s/postProcessing/sets/", pszFoamPath);
+        outputProbesPath = CPLSPrintf("%s/postProcessing/sets/", foamPath->c_str());
     }
-    std::string outputResidualsPath = CPLSPrintf("%s/postProcessing/residuals/", pszFoamPath);
+    std::string outputResidualsPath = CPLSPrintf("%s/postProcessing/residuals/", foamPath->c_str());
 
     NinjaUnlinkTree( outputSurfacePath.c_str() );
     NinjaUnlinkTree( outputProbesPath.c_str() );
@@ -4317,13 +4338,13 @@ void NinjaFoam::UpdateExistingCase()
     //make a tmp copy of those files overwritten by writeFoamFiles(), but where the values are not replaced back in
     std::string tmpPath = CPLGetPath(input.dem.fileName.c_str());
     if( foamVersion == "9" || foamVersion == "11" ) {
-        CopyFile(CPLFormFilename(pszFoamPath,     "system/blockMeshDict", ""),
+        CopyFile(CPLFormFilename(foamPath->c_str(),     "system/blockMeshDict", ""),
                  CPLFormFilename(tmpPath.c_str(), "blockMeshDict", ""));
     } else {  // if( foamVersion == "2.2.0" )
-        CopyFile(CPLFormFilename(pszFoamPath,     "constant/polyMesh/blockMeshDict", ""),
+        CopyFile(CPLFormFilename(foamPath->c_str(),     "constant/polyMesh/blockMeshDict", ""),
                  CPLFormFilename(tmpPath.c_str(), "blockMeshDict", ""));
     }
-    CopyFile(CPLFormFilename(pszFoamPath,     "system/topoSetDict", ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(),     "system/topoSetDict", ""),
              CPLFormFilename(tmpPath.c_str(), "topoSetDict", ""));
 
     // it is tempting to also preserve the "/system/probes" file (/system/sampleDict_probes for foamVersion "2.2.0") across meshes, if it exists.
@@ -4335,13 +4356,13 @@ void NinjaFoam::UpdateExistingCase()
     //put the tmp copy files back, delete the leftover tmp files from the tmp location
     if( foamVersion == "9" || foamVersion == "11" ) {
         CopyFile(CPLFormFilename(tmpPath.c_str(), "blockMeshDict", ""),
-                 CPLFormFilename(pszFoamPath,     "system/blockMeshDict", ""));
+                 CPLFormFilename(foamPath->c_str(),     "system/blockMeshDict", ""));
     } else {  // if( foamVersion == "2.2.0" )
         CopyFile(CPLFormFilename(tmpPath.c_str(), "blockMeshDict", ""),
-                 CPLFormFilename(pszFoamPath,     "constant/polyMesh/blockMeshDict", ""));
+                 CPLFormFilename(foamPath->c_str(),     "constant/polyMesh/blockMeshDict", ""));
     }
     CopyFile(CPLFormFilename(tmpPath.c_str(), "topoSetDict", ""),
-             CPLFormFilename(pszFoamPath,     "system/topoSetDict", ""));
+             CPLFormFilename(foamPath->c_str(),     "system/topoSetDict", ""));
     VSIUnlink(CPLFormFilename(tmpPath.c_str(), "blockMeshDict", ""));
     VSIUnlink(CPLFormFilename(tmpPath.c_str(), "topoSetDict", ""));
 
@@ -4349,25 +4370,25 @@ void NinjaFoam::UpdateExistingCase()
     latestTime = GetLatestTimeOnDisk();
     if( latestTime > 50+nRoundsRefinement )
     {
-        NinjaUnlinkTree(CPLSPrintf("%s/%d", pszFoamPath, latestTime));
+        NinjaUnlinkTree(CPLSPrintf("%s/%d", foamPath->c_str(), latestTime));
     }
 
     //now latestTime on disk is where we want to start (the mesh is here)
     latestTime = GetLatestTimeOnDisk();
 
     //Get rid of -9999.9 in 0/ files
-    CopyFile(CPLFormFilename(pszFoamPath, "0/U", ""),
-             CPLFormFilename(pszFoamPath, "0/U", ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/U", ""),
+             CPLFormFilename(foamPath->c_str(), "0/U", ""),
              "-9999.9",
              CPLSPrintf("%.2f", initialFirstCellHeight));
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/k", ""),
-             CPLFormFilename(pszFoamPath, "0/k", ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/k", ""),
+             CPLFormFilename(foamPath->c_str(), "0/k", ""),
              "-9999.9",
              CPLSPrintf("%.2f", initialFirstCellHeight));
             
-    CopyFile(CPLFormFilename(pszFoamPath, "0/epsilon", ""),
-             CPLFormFilename(pszFoamPath, "0/epsilon", ""),
+    CopyFile(CPLFormFilename(foamPath->c_str(), "0/epsilon", ""),
+             CPLFormFilename(foamPath->c_str(), "0/epsilon", ""),
              "-9999.9",
              CPLSPrintf("%.2f", initialFirstCellHeight));
 
@@ -4383,15 +4404,15 @@ void NinjaFoam::UpdateExistingCase()
     }
 
     //update controlDict
-    CopyFile(CPLSPrintf("%s/system/controlDict_simpleFoam", pszFoamPath),
-             CPLSPrintf("%s/system/controlDict", pszFoamPath));
+    CopyFile(CPLSPrintf("%s/system/controlDict_simpleFoam", foamPath->c_str()),
+             CPLSPrintf("%s/system/controlDict", foamPath->c_str()));
     // this is for updating controlDict to a different, better form,
     // rather than the standard form set in the line above
-    //CopyFile(CPLSPrintf("%s/system/controlDict", pszFoamPath),
-    //         CPLSPrintf("%s/system/controlDict", pszFoamPath),
+    //CopyFile(CPLSPrintf("%s/system/controlDict", foamPath->c_str()),
+    //         CPLSPrintf("%s/system/controlDict", foamPath->c_str()),
     //         "startFrom       latestTime", "startFrom       startTime");
-    //CopyFile(CPLSPrintf("%s/system/controlDict", pszFoamPath),
-    //         CPLSPrintf("%s/system/controlDict", pszFoamPath),
+    //CopyFile(CPLSPrintf("%s/system/controlDict", foamPath->c_str()),
+    //         CPLSPrintf("%s/system/controlDict", foamPath->c_str()),
     //         "latestTime", CPLSPrintf("%d", latestTime));
 
     //update simpleFoam controlDict endTime
@@ -4400,22 +4421,22 @@ void NinjaFoam::UpdateExistingCase()
     //rm any processor* directories
     std::vector<std::string> dirList = GetProcessorDirsOnDisk();
     for(int n=0; n<dirList.size(); n++){
-        NinjaUnlinkTree( CPLSPrintf( "%s/processor%d", pszFoamPath, n) );
+        NinjaUnlinkTree( CPLSPrintf( "%s/processor%d", foamPath->c_str(), n) );
     }
 
     //rm any additional log, output, and system files that will later be replaced during the run, if they exist
     //log.blockMesh, log.moveDynamicMesh, log.refineMesh, log.topoSet should be kept, those processes aren't rerun
     char **papszFileList = NULL;
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.decomposePar", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.reconstructPar", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.renumberMesh", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.applyInit", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.simpleFoam", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.sample", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "foam.tif", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "output.raw", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "output.vrt", "") );
-    papszFileList = CSLAddString( papszFileList, CPLFormFilename(pszFoamPath, "log.probeSample", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.decomposePar", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.reconstructPar", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.renumberMesh", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.applyInit", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.simpleFoam", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.sample", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "foam.tif", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "output.raw", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "output.vrt", "") );
+    papszFileList = CSLAddString( papszFileList, CPLFormFilename(foamPath->c_str(), "log.probeSample", "") );
     for(int i = 0; i < CSLCount( papszFileList ); i++)
     {
         VSIUnlink(papszFileList[i]);
@@ -4440,8 +4461,8 @@ void NinjaFoam::GenerateNewCase()
     WriteFoamFiles();
 
     //write controlDict for flow solution--this will get modified during moveDynamicMesh
-    const char *pszInput = CPLFormFilename(pszFoamPath, "system/controlDict_simpleFoam", "");
-    const char *pszOutput = CPLFormFilename(pszFoamPath, "system/controlDict", "");
+    const char *pszInput = CPLFormFilename(foamPath->c_str(), "system/controlDict_simpleFoam", "");
+    const char *pszOutput = CPLFormFilename(foamPath->c_str(), "system/controlDict", "");
     CopyFile(pszInput, pszOutput);
 
     checkCancel();
@@ -4466,7 +4487,7 @@ void NinjaFoam::GenerateNewCase()
 
     std::string demName = NinjaSanitizeString(CPLGetBasename(input.dem.fileName.c_str()));
     const char *pszStlFileName = CPLStrdup(CPLFormFilename(
-                (CPLSPrintf("%s/constant/triSurface/", pszFoamPath)),
+                (CPLSPrintf("%s/constant/triSurface/", foamPath->c_str())),
                 CPLSPrintf("%s.stl", demName.c_str()), ""));
 
     //buffer input.dem on all edges to ensure it is larger than the blockMesh
@@ -4499,7 +4520,7 @@ void NinjaFoam::GenerateNewCase()
 
     // create the output surface stl with NinjaElevationToStl unless
     demName = NinjaSanitizeString(CPLGetBasename(input.dem.fileName.c_str()));
-    pszStlFileName = CPLStrdup((CPLSPrintf("%s/constant/triSurface/%s_out.stl", pszFoamPath, demName.c_str())));
+    pszStlFileName = CPLStrdup((CPLSPrintf("%s/constant/triSurface/%s_out.stl", foamPath->c_str(), demName.c_str())));
 
     //create the grid to sample on (input.outputWindHeight above the DEM)
     //note that input.dem has already been resampled to the mesh resolution
@@ -4559,7 +4580,7 @@ void NinjaFoam::WriteNinjaLog()
 {
     //write log.ninja to store info needed for reusing cases
     int nRet = -1;
-    const char *pszInput = CPLSPrintf("%s/log.ninja", pszFoamPath);
+    const char *pszInput = CPLSPrintf("%s/log.ninja", foamPath->c_str());
     VSILFILE *fout;
     fout = VSIFOpenL(pszInput, "w");
     if( !fout ){
@@ -4573,7 +4594,7 @@ void NinjaFoam::WriteNinjaLog()
 void NinjaFoam::ReadNinjaLog()
 {
     // set meshResolution and other values from log.ninja
-    const char *pszInput = CPLSPrintf("%s/log.ninja", pszFoamPath);
+    const char *pszInput = CPLSPrintf("%s/log.ninja", foamPath->c_str());
     VSILFILE *fin;
     fin = VSIFOpenL(pszInput, "r");
     if(fin == NULL)
@@ -4633,7 +4654,7 @@ std::vector<std::string> NinjaFoam::GetProcessorDirsOnDisk()
 {
     char **papszFileList;
     const char *pszFilename;
-    papszFileList = VSIReadDir( pszFoamPath );
+    papszFileList = VSIReadDir( foamPath->c_str() );
     std::vector<std::string> dirList;
 
     for(int i=0; i<CSLCount( papszFileList ); i++){
@@ -4653,7 +4674,7 @@ std::vector<std::string> NinjaFoam::GetTimeDirsOnDisk()
 {
     char **papszFileList;
     const char *pszFilename;
-    papszFileList = VSIReadDir( pszFoamPath );
+    papszFileList = VSIReadDir( foamPath->c_str() );
     std::vector<std::string> dirList;
 
     for(int i=0; i<CSLCount( papszFileList ); i++){
@@ -4677,7 +4698,7 @@ bool NinjaFoam::StringIsNumeric(const std::string &str)
 double NinjaFoam::GetFirstCellHeightFromDisk(int time)
 {
     //read time/U and search for firstCellHeight
-    const char *pszInput = CPLSPrintf("%s/%d/U", pszFoamPath, time);
+    const char *pszInput = CPLSPrintf("%s/%d/U", foamPath->c_str(), time);
     VSILFILE *fin;
 
     fin = VSIFOpenL( pszInput, "r" );
@@ -4725,7 +4746,7 @@ bool NinjaFoam::CheckForValidDem()
 {
     char **papszFileList;
     const char *pszFilename;
-    papszFileList = VSIReadDir( CPLSPrintf("%s/constant/triSurface", pszFoamPath ) );
+    papszFileList = VSIReadDir( CPLSPrintf("%s/constant/triSurface", foamPath->c_str() ) );
 
     for(int i=0; i<CSLCount( papszFileList ); i++){
         pszFilename = CPLGetFilename( papszFileList[i] );
@@ -4748,7 +4769,7 @@ bool NinjaFoam::CheckForValidDem()
 void NinjaFoam::SetMeshResolutionAndResampleDem()
 {
     //if we are re-using a case, just set the meshResolution
-    if(CheckForValidCaseDir(pszFoamPath)){
+    if(CheckForValidCaseDir(foamPath->c_str())){
         //set meshResolution and other values from log.ninja
         ReadNinjaLog();
     }
@@ -84,13 +84,13 @@ public:
     virtual void set_numberCPUs(int CPUs);
     virtual void set_meshResolution(double resolution, lengthUnits::eLengthUnits units);
     virtual double get_meshResolution();
-    static int GenerateFoamDirectory(std::string demName);
-    static void SetFoamPath(const char *pszPath);
+    static int GenerateFoamDirectory(std::string demName, std::string &path);
+    void SetFoamPath(boost::shared_ptr<std::string> path);
 
 private:
     std::string foamVersion;
     
-    static const char *pszFoamPath;
+    boost::shared_ptr<std::string> foamPath; //case directory, shared by the ninjas of an army
 
     /* OpenFOAM case setup */
     void UpdateExistingCase();
@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include "nomads_wx_init.h"
+#include "meshRemapPlan.h"
 
 int NomadsWxModel::CheckFileName( const char *pszFile, const char *pszFormat )
 {
@@ -1296,10 +1297,12 @@ void NomadsWxModel::set3dGrids( WindNinjaInputs &input, Mesh const& mesh )
     GDALClose( hDS );
     GDALClose( hVrtDS );
 
+    /* All of the fields are on wxMesh, locate the nodes of mesh in it once */
+    MeshRemapPlan plan( wxMesh, mesh );
     for( i = 0; i < 4; i++ )
     {
         fields[i]->allocate( &mesh );
-        wxFields[i]->interpolateScalarData((*(fields[i])), mesh, input);
+        plan.apply( *(wxFields[i]), *(fields[i]) );
     }
 
     GDALDestroyWarpOptions(psWarpOptions);
@@ -61,4 +61,20 @@ omp_guard::~omp_guard ()
 {
     release ();
 }
+
+/** Construct guard object and save the settings of this thread */
+omp_settings_guard::omp_settings_guard ()
+: maxThreads_ (omp_get_max_threads ())
+, maxActiveLevels_ (omp_get_max_active_levels ())
+, dynamic_ (omp_get_dynamic ())
+{
+}
+
+/** Destruct guard object, restore the saved settings */
+omp_settings_guard::~omp_settings_guard ()
+{
+    omp_set_num_threads (maxThreads_);
+    omp_set_max_active_levels (maxActiveLevels_);
+    omp_set_dynamic (dynamic_);
+}
 #endif
@@ -67,6 +67,32 @@ private:
     void operator= (const omp_guard &);
 };
 
+/** Guard object for the OpenMP settings of the calling thread.
+*  The thread count, nesting and dynamic adjustment are saved on construction
+*  and restored on destruction, so code that tunes them for its own parallel
+*  regions leaves the caller (and other threads of a host program) alone. */
+
+class omp_settings_guard {
+
+public:
+
+    /** Save the settings of the calling thread */
+    omp_settings_guard ();
+
+    /** Restore the saved settings */
+    ~omp_settings_guard ();
+
+private:
+
+    int maxThreads_;        // omp_get_max_threads() on entry
+    int maxActiveLevels_;   // omp_get_max_active_levels() on entry
+    int dynamic_;           // omp_get_dynamic() on entry
+
+    // Disallow copies or assignment
+    omp_settings_guard (const omp_settings_guard &);
+    void operator= (const omp_settings_guard &);
+};
+
 #endif /*OMP_GUARD_H*/
 
 #endif /* _OPENMP */
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Queue of output files written by background threads
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "outputQueue.h"
+#include "ninja.h"
+
+/**
+ * Start the writer threads.
+ * @param nWriters Number of background writer threads.
+ * @param nMaxQueued Number of outputs that may wait for a writer before
+ *                   push() blocks.
+ */
+OutputQueue::OutputQueue(int nWriters, int nMaxQueued)
+{
+    if(nWriters < 1 || nMaxQueued < 1)
+        throw std::range_error("Bad number of output writers or queue length in OutputQueue::OutputQueue().");
+
+    this->nMaxQueued = nMaxQueued;
+    nFailed = 0;
+    done = false;
+    mutex = CPLCreateMutex();   //created locked
+    CPLReleaseMutex(mutex);
+    cond = CPLCreateCond();
+
+    for(int i = 0; i < nWriters; i++)
+    {
+        CPLJoinableThread *thread = CPLCreateJoinableThread(writerThread, this);
+        if(thread == NULL)
+        {
+            CPLDebug("NINJA", "Could only start %d output writer threads.", i);
+            break;
+        }
+        threads.push_back(thread);
+    }
+}
+
+OutputQueue::~OutputQueue()
+{
+    finish();
+    CPLDestroyCond(cond);
+    CPLDestroyMutex(mutex);
+}
+
+/**
+ * Queue the outputs of a run, waiting for room in the queue if it is full.
+ * @param writer ninja holding the inputs and output grids of the run, the
+ *               queue takes ownership.
+ * @param demGrid Grid the outputs are buffered to overlap, its data is moved
+ *                into the queue.
+ */
+void OutputQueue::push(ninja *writer, AsciiGrid<double> &demGrid)
+{
+    Job *job = new Job();
+    job->writer = writer;
+    job->demGrid.swap(demGrid);
+
+    if(threads.empty())    //no writers (or finished), write it here
+    {
+        write(job);
+        return;
+    }
+
+    CPLAcquireMutex(mutex, 1000.0);
+    while((int)jobs.size() >= nMaxQueued)
+        CPLCondWait(cond, mutex);
+    jobs.push_back(job);
+    CPLCondBroadcast(cond);
+    CPLReleaseMutex(mutex);
+}
+
+/**
+ * Wait until all queued outputs are written and stop the writer threads.
+ * Outputs pushed afterwards are written by the calling thread.
+ */
+void OutputQueue::finish()
+{
+    if(threads.empty())
+        return;
+
+    CPLAcquireMutex(mutex, 1000.0);
+    done = true;
+    CPLCondBroadcast(cond);
+    CPLReleaseMutex(mutex);
+
+    for(unsigned int i = 0; i < threads.size(); i++)
+        CPLJoinThread(threads[i]);
+    threads.clear();
+}
+
+void OutputQueue::writerThread(void *queue)
+{
+    OutputQueue *q = static_cast<OutputQueue*>(queue);
+    for(;;)
+    {
+        CPLAcquireMutex(q->mutex, 1000.0);
+        while(q->jobs.empty() && !q->done)
+            CPLCondWait(q->cond, q->mutex);
+        if(q->jobs.empty())
+        {
+            CPLReleaseMutex(q->mutex);
+            return;
+        }
+        Job *job = q->jobs.front();
+        q->jobs.pop_front();
+        CPLCondBroadcast(q->cond);   //room for push()
+        CPLReleaseMutex(q->mutex);
+
+        q->write(job);
+    }
+}
+
+/**
+ * Write the files of one run and report the outcome through its ninjaCom.
+ */
+void OutputQueue::write(Job *job)
+{
+    ninja *writer = job->writer;
+    bool failed = false;
+#ifdef _OPENMP
+    omp_set_num_threads(writer->input.numberCPUs);    //for the sections in writeOutputGrids()
+#endif
+    try{
+        writer->writeOutputGrids(job->demGrid);
+        writer->input.Com->ninjaCom(ninjaComClass::ninjaNone, "Run number %d output files written.", writer->input.inputsRunNumber);
+    }catch (std::exception& e)
+    {
+        writer->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception caught during output file writing: %s", e.what());
+        failed = true;
+    }catch (...)
+    {
+        writer->input.Com->ninjaCom(ninjaComClass::ninjaFailure, "Exception caught during output file writing: Cannot determine exception type.");
+        failed = true;
+    }
+
+    if(failed)
+    {
+        CPLAcquireMutex(mutex, 1000.0);
+        nFailed++;
+        CPLReleaseMutex(mutex);
+    }
+    delete writer;
+    delete job;
+}
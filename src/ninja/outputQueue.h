@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Queue of output files written by background threads
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+
+#include <deque>
+#include <vector>
+
+#include "cpl_multiproc.h"
+#include "ascii_grid.h"
+
+class ninja;
+
+/**
+ * Bounded queue of output file sets written by background threads, so a
+ * run can start its next solve while its files are written.
+ *
+ * ninja::writeOutputFiles() hands over a small ninja holding only what
+ * writing needs (inputs, output grids moved out of the run) and returns.
+ * push() blocks while the queue is full, which keeps the memory held by
+ * pending outputs bounded.  Each writer reports completion and errors
+ * through the ninjaCom of the run.  finish() waits for all queued outputs.
+ */
+class OutputQueue
+{
+public:
+    OutputQueue(int nWriters, int nMaxQueued);
+    ~OutputQueue();
+
+    void push(ninja *writer, AsciiGrid<double> &demGrid);
+    void finish();
+
+    int getNumWriters() const { return (int)threads.size(); }
+    int getNumFailed() const { return nFailed; }
+
+private:
+    struct Job
+    {
+        ninja *writer;                  //owned by the job
+        AsciiGrid<double> demGrid;      //extents the outputs are buffered to
+    };
+
+    static void writerThread(void *queue);
+    void write(Job *job);
+
+    std::deque<Job*> jobs;
+    int nMaxQueued;
+    int nFailed;
+    bool done;
+    std::vector<CPLJoinableThread*> threads;
+    CPLMutex *mutex;
+    CPLCond *cond;      //signalled when a job is queued, taken or the queue is finished
+
+    OutputQueue(const OutputQueue &);
+    OutputQueue &operator=(const OutputQueue &);
+};
+
+#endif /* OUTPUT_QUEUE_H */
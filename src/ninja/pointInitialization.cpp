@@ -143,8 +143,11 @@ void pointInitialization::setInitializationGrids(WindNinjaInputs& input)
     input.inputWindHeight = maxStationHeight;  //for use later during vertical fill of 3D grid
     input.surface.Z = input.inputWindHeight;
 
-    airTempGrid.interpolateFromPoints(T, X, Y, influenceRadius, input.stationsScratch.size(), dfInvDistWeight);
-    cloudCoverGrid.interpolateFromPoints(cc, X, Y, influenceRadius, input.stationsScratch.size(), dfInvDistWeight);
+    //air temperature and cloud cover share the station weights
+    AsciiGrid<double> *tempCloudGrids[2] = {&airTempGrid, &cloudCoverGrid};
+    double *tempCloudData[2] = {T, cc};
+    AsciiGrid<double>::interpolateFromPoints(tempCloudGrids, tempCloudData, 2, X, Y, influenceRadius,
+                                             input.stationsScratch.size(), dfInvDistWeight);
 
     //Check one grid to be sure that the interpolation completely filled the grid
     if(cloudCoverGrid.checkForNoDataValues())
@@ -278,8 +281,10 @@ void pointInitialization::setInitializationGrids(WindNinjaInputs& input)
         }
     }
 
-    uInitializationGrid.interpolateFromPoints(u, X, Y, influenceRadius, input.stationsScratch.size(), dfInvDistWeight);
-    vInitializationGrid.interpolateFromPoints(v, X, Y, influenceRadius, input.stationsScratch.size(), dfInvDistWeight);
+    AsciiGrid<double> *uvGrids[2] = {&uInitializationGrid, &vInitializationGrid};
+    double *uvData[2] = {u, v};
+    AsciiGrid<double>::interpolateFromPoints(uvGrids, uvData, 2, X, Y, influenceRadius,
+                                             input.stationsScratch.size(), dfInvDistWeight);
 
     input.surface.windSpeedGrid.set_headerData(uInitializationGrid);
     input.surface.windGridExists = true;
@@ -1298,6 +1303,10 @@ vector<wxStation> pointInitialization::makeWxStation(vector<vector<preInterpolat
 
     vector<vector<preInterpolate> >stationDataList;
     stationDataList=data;
+
+    vector<double> xCoords, yCoords;
+    vector<std::string> coordSystems, datums;
+
     //here is where a wxstation is made
     for (int i=0;i<idxCount.size();i++) //loop over the stations
     {
@@ -1311,15 +1320,16 @@ vector<wxStation> pointInitialization::makeWxStation(vector<vector<preInterpolat
         {
             //This has not been tested, I have no idea if this works or not
             CPLDebug("STATION_FETCH","USING PROJCS!");
-            subDat.set_location_projected(stationDataList[i][0].coord_x,stationDataList[i][0].coord_y,demFile);
-//            subDat.set_location_projected(stationDataList[i][0].coord_y,stationDataList[i][0].coord_x,demFile);
         }
         else //GEOGCS!
         {
             CPLDebug("STATION_FETCH","USING GEOGCS!");
-            subDat.set_location_LatLong(stationDataList[i][0].coord_y,stationDataList[i][0].coord_x,
-                    demFile,Datum.c_str());
         }
+        //located below, x is the longitude and y the latitude for GEOGCS
+        xCoords.push_back(stationDataList[i][0].coord_x);
+        yCoords.push_back(stationDataList[i][0].coord_y);
+        coordSystems.push_back(CoordSys);
+        datums.push_back(Datum);
 
         for (int k=0;k<stationDataList[i].size();k++) //set the weather values for each time step and station
         {    
@@ -1334,6 +1344,15 @@ vector<wxStation> pointInitialization::makeWxStation(vector<vector<preInterpolat
 
         stationData.push_back(subDat);
     }
+
+    //the dem is read and the coordinate transformations are made once for all
+    //of the stations, one per coordinate system and datum, if there are any
+    if(!stationData.empty())
+    {
+        DemCoordinateTransform demTransform(demFile);
+        wxStation::set_locations(stationData, xCoords, yCoords, coordSystems, datums, demTransform);
+    }
+
     return stationData;
 }
 /**
@@ -32,6 +32,7 @@
 Preconditioner::Preconditioner()
 {
 	NUMNP = 0;
+	preConditionerType = none;
 	D = NULL;
 	Lt = NULL;
 	U = NULL;
@@ -40,6 +41,16 @@ Preconditioner::Preconditioner()
 	L_col_ind = NULL;
 	w = 1.0;
 
+	chebyshevDegree = 4;
+	haveSpectralBounds = false;
+	lambdaMin = 0.0;
+	lambdaMax = 0.0;
+	Af = NULL;
+	Af_row_ptr = NULL;
+	Af_col_ind = NULL;
+	chebD = NULL;
+	chebRes = NULL;
+
 	//stuff for sparse BLAS solve
 	one=1.E0;
 	zero=0.E0;
@@ -77,6 +88,17 @@ Preconditioner::~Preconditioner()
 		delete[] L_col_ind;
 	//if(U_col_ind)
 	//	delete U_col_ind;
+
+	if(Af)
+		delete[] Af;
+	if(Af_row_ptr)
+		delete[] Af_row_ptr;
+	if(Af_col_ind)
+		delete[] Af_col_ind;
+	if(chebD)
+		delete[] chebD;
+	if(chebRes)
+		delete[] chebRes;
 }
 
 bool Preconditioner::initialize(int numnp, double *A, int *row_ptr, int *col_ind, int preconditionerType, char *matdescra)
@@ -176,6 +198,69 @@ bool Preconditioner::initialize(int numnp, double *A, int *row_ptr, int *col_ind
 				count++;
 			}
 		}
+	}else if(preconditionerType == Chebyshev)
+	{
+		//--------------------------------------------------------------------------------------------------
+		//	Chebyshev polynomial preconditioner on the Jacobi scaled matrix D^(-1)*A
+		//		z = p(D^(-1)*A)*D^(-1)*r, where p is the Chebyshev polynomial of degree chebyshevDegree
+		//		that best approximates 1/x over [lambdaMin, lambdaMax].
+		//		Only SpMVs and axpys are needed, so every step is row parallel (no triangular sweeps).
+		//		The spectral bounds must be given with setSpectralBounds() (see lanczosEigenvalueBounds()),
+		//		until then the Jacobi preconditioner is applied.
+		//--------------------------------------------------------------------------------------------------
+		if(matdescra[0] != 's')	//only implemented for the symmetric, upper triangle storage used by the CG solver
+			return false;
+
+		preConditionerType = preconditionerType;
+		NUMNP = numnp;
+		haveSpectralBounds = false;
+
+		int i, j;
+
+		D = new double[NUMNP];
+		for(i=0; i<NUMNP; i++)
+			D[i] = 1./A[row_ptr[i]];	//D is really stored as M^(-1)
+
+		//Expand the upper triangle storage to full storage so the SpMV doesn't need the serial scatter
+		Af_row_ptr = new int[NUMNP+1];
+		for(i=0; i<=NUMNP; i++)
+			Af_row_ptr[i] = 0;
+		for(i=0; i<NUMNP; i++)
+		{
+			Af_row_ptr[i+1] += row_ptr[i+1] - row_ptr[i];	//upper triangle, including diagonal
+			for(j=row_ptr[i]+1; j<row_ptr[i+1]; j++)
+				Af_row_ptr[col_ind[j]+1]++;	//mirrored lower triangle
+		}
+		for(i=0; i<NUMNP; i++)
+			Af_row_ptr[i+1] += Af_row_ptr[i];
+
+		Af = new double[Af_row_ptr[NUMNP]];
+		Af_col_ind = new int[Af_row_ptr[NUMNP]];
+
+		int *fill = new int[NUMNP];
+		for(i=0; i<NUMNP; i++)
+			fill[i] = Af_row_ptr[i];
+		for(i=0; i<NUMNP; i++)
+		{
+			for(j=row_ptr[i]; j<row_ptr[i+1]; j++)
+			{
+				Af[fill[i]] = A[j];
+				Af_col_ind[fill[i]] = col_ind[j];
+				fill[i]++;
+				if(col_ind[j] != i)
+				{
+					Af[fill[col_ind[j]]] = A[j];
+					Af_col_ind[fill[col_ind[j]]] = i;
+					fill[col_ind[j]]++;
+				}
+			}
+		}
+		delete[] fill;
+
+		chebD = new double[NUMNP];
+		chebRes = new double[NUMNP];
+
+		return true;
 	}
 
 	return true;
@@ -186,7 +271,7 @@ bool Preconditioner::solve(double *r, double *z, int *row_ptr, int *col_ind)
 
 	if(preConditionerType == none)
 	{
-		cblas_dcopy(NUMNP, r, 1, z, 1);
+		ninjaBlas::dcopy(NUMNP, r, z);
 	}else if(preConditionerType == Jacobi)
 	{
 		for(int i=0; i<NUMNP; i++)
@@ -206,12 +291,233 @@ bool Preconditioner::solve(double *r, double *z, int *row_ptr, int *col_ind)
 		mkl_dcsrsv(&L_transa, &NUMNP, &one, L_matdescra, Lt, L_col_ind, L_row_ptr, &L_row_ptr[1], r, scratch);
 		mkl_dcsrsv(&U_transa, &NUMNP, &one, U_matdescra, U, col_ind, row_ptr, &row_ptr[1], scratch, z);
 
+		return true;
+	}else if(preConditionerType == Chebyshev)
+	{
+		int i;
+
+		if(!haveSpectralBounds)	//fall back to Jacobi until the spectrum has been estimated
+		{
+			#pragma omp parallel for
+			for(i=0; i<NUMNP; i++)
+				z[i] = D[i]*r[i];
+
+			return true;
+		}
+
+		//--------------------------------------------------
+		//Chebyshev iteration for A*z = r started from z = 0
+		//	theta = center of the spectrum, delta = half width
+		//--------------------------------------------------
+		double theta = 0.5*(lambdaMax + lambdaMin);
+		double delta = 0.5*(lambdaMax - lambdaMin);
+		double sigma = theta/delta;
+		double rho_old = 1.0/sigma;
+		double rho;
+
+		#pragma omp parallel for
+		for(i=0; i<NUMNP; i++)
+		{
+			chebD[i] = D[i]*r[i]/theta;
+			z[i] = chebD[i];
+		}
+
+		for(int k=1; k<chebyshevDegree; k++)
+		{
+			fullSpMV(z, chebRes);	//chebRes = A*z
+
+			rho = 1.0/(2.0*sigma - rho_old);
+			double c1 = rho*rho_old;
+			double c2 = 2.0*rho/delta;
+
+			#pragma omp parallel for
+			for(i=0; i<NUMNP; i++)
+			{
+				chebD[i] = c1*chebD[i] + c2*D[i]*(r[i] - chebRes[i]);
+				z[i] += chebD[i];
+			}
+
+			rho_old = rho;
+		}
+
 		return true;
 	}
 
 	return false;
 }
 
+/**
+ * @brief Name of the preconditioner currently applied, used in the solver statistics.
+ */
+const char* Preconditioner::getTypeName() const
+{
+	switch(preConditionerType)
+	{
+		case Jacobi:
+			return "Jacobi";
+		case SSOR:
+			return "SSOR";
+		case Chebyshev:
+			return "Chebyshev";
+		default:
+			return "none";
+	}
+}
+
+/**
+ * @brief Sets the degree of the Chebyshev polynomial preconditioner.
+ *
+ * The degree is the number of terms of the Chebyshev iteration, each application does
+ * degree-1 matrix-vector products (degree 1 is the Jacobi preconditioner scaled by the
+ * center of the spectrum).
+ *
+ * @param degree Polynomial degree, must be at least 1.
+ */
+void Preconditioner::setChebyshevDegree(int degree)
+{
+	if(degree < 1)
+		throw std::logic_error("ERROR IN PRECONDITIONER: CHEBYSHEV DEGREE MUST BE AT LEAST 1");
+	chebyshevDegree = degree;
+}
+
+/**
+ * @brief Returns true if this is a Chebyshev preconditioner still waiting for its spectral bounds.
+ */
+bool Preconditioner::needsSpectralBounds() const
+{
+	return (preConditionerType == Chebyshev && !haveSpectralBounds);
+}
+
+/**
+ * @brief Sets the spectral bounds of D^(-1)*A used by the Chebyshev preconditioner.
+ *
+ * The upper bound must not underestimate the largest eigenvalue, or the preconditioner is
+ * no longer positive definite, so a safety factor is applied to lambdaMax here.
+ * The lower bound only affects the rate of convergence.
+ * A non-positive lambda_max permanently falls back to the Jacobi preconditioner.
+ *
+ * @param lambda_min Estimate of the smallest eigenvalue of D^(-1)*A.
+ * @param lambda_max Estimate of the largest eigenvalue of D^(-1)*A.
+ */
+void Preconditioner::setSpectralBounds(double lambda_min, double lambda_max)
+{
+	if(lambda_max <= 0.0)	//no usable estimate, stay with the Jacobi part for the rest of the solve
+	{
+		preConditionerType = Jacobi;
+		return;
+	}
+
+	lambdaMax = 1.1*lambda_max;
+	lambdaMin = lambda_min;
+	if(lambdaMin <= 0.0 || lambdaMin >= lambdaMax)
+		lambdaMin = lambdaMax/30.0;
+	haveSpectralBounds = true;
+}
+
+/**
+ * @brief Estimates the extreme eigenvalues of the preconditioned matrix from CG coefficients.
+ *
+ * The alpha and beta coefficients of k preconditioned CG iterations define the k x k Lanczos
+ * tridiagonal matrix T, whose extreme eigenvalues (Ritz values) approximate the extreme
+ * eigenvalues of M^(-1)*A. The eigenvalues of T are found by bisection on the Sturm sequence.
+ *
+ * @param cgAlpha Alpha (step length) from each CG iteration.
+ * @param cgBeta Beta from each CG iteration after the first (one less than cgAlpha).
+ * @param lambdaMin Smallest eigenvalue estimate.
+ * @param lambdaMax Largest eigenvalue estimate.
+ * @return Returns false if there is not enough information to form T.
+ */
+bool Preconditioner::lanczosEigenvalueBounds(const std::vector<double> &cgAlpha, const std::vector<double> &cgBeta,
+                                             double &lambdaMin, double &lambdaMax)
+{
+	int n = cgAlpha.size();
+	if(n < 2 || (int)cgBeta.size() < n-1)
+		return false;
+
+	std::vector<double> diag(n), offDiag2(n-1);	//diagonal and squared off diagonal of T
+	for(int k=0; k<n; k++)
+	{
+		if(cgAlpha[k] <= 0.0)
+			return false;
+		diag[k] = 1.0/cgAlpha[k];
+		if(k > 0)
+			diag[k] += cgBeta[k-1]/cgAlpha[k-1];
+		if(k < n-1)
+			offDiag2[k] = cgBeta[k]/(cgAlpha[k]*cgAlpha[k]);
+	}
+
+	//Gershgorin interval containing all eigenvalues of T
+	double lo = diag[0], hi = diag[0];
+	for(int k=0; k<n; k++)
+	{
+		double radius = 0.0;
+		if(k > 0)
+			radius += std::sqrt(offDiag2[k-1]);
+		if(k < n-1)
+			radius += std::sqrt(offDiag2[k]);
+		lo = std::min(lo, diag[k] - radius);
+		hi = std::max(hi, diag[k] + radius);
+	}
+
+	//bisect for the smallest (index 1) and largest (index n) eigenvalues
+	for(int which=0; which<2; which++)
+	{
+		int target = (which == 0) ? 1 : n;
+		double a = lo, b = hi;
+		for(int it=0; it<100 && (b-a) > 1e-10*std::max(std::fabs(a), std::fabs(b)); it++)
+		{
+			double mid = 0.5*(a+b);
+			if(sturmCount(diag, offDiag2, mid) >= target)
+				b = mid;
+			else
+				a = mid;
+		}
+		if(which == 0)
+			lambdaMin = b;
+		else
+			lambdaMax = b;
+	}
+
+	return (lambdaMax > 0.0);
+}
+
+/**
+ * @brief Returns the number of eigenvalues of the symmetric tridiagonal matrix less than x.
+ */
+int Preconditioner::sturmCount(const std::vector<double> &diag, const std::vector<double> &offDiag2, double x)
+{
+	int count = 0;
+	double d = 1.0;
+	for(unsigned int k=0; k<diag.size(); k++)
+	{
+		d = diag[k] - x - ((k > 0) ? offDiag2[k-1]/d : 0.0);
+		if(d == 0.0)
+			d = -1e-300;
+		if(d < 0.0)
+			count++;
+	}
+	return count;
+}
+
+/**
+ * @brief Computes y = A*x using the fully stored copy of A.
+ *
+ * Each row is independent, so this is a parallel gather with no reduction over rows.
+ */
+void Preconditioner::fullSpMV(const double *x, double *y)
+{
+	int i, j;
+
+	#pragma omp parallel for private(j)
+	for(i=0; i<NUMNP; i++)
+	{
+		double sum = 0.0;
+		for(j=Af_row_ptr[i]; j<Af_row_ptr[i+1]; j++)
+			sum += Af[j]*x[Af_col_ind[j]];
+		y[i] = sum;
+	}
+}
+
 void Preconditioner::mkl_dcsrsv(char *transa, int *m, double *alpha, char *matdescra, double *val, int *indx, int *pntrb, int *pntre, double *x, double *y)
 {	// My version of the mkl_dcsrsv() function; solves val*y=x
 	// Only works for my specific settings
@@ -259,10 +565,3 @@ void Preconditioner::mkl_dcsrsv(char *transa, int *m, double *alpha, char *matde
 	}else
 		throw std::logic_error("ERROR IN PRECONDITIONER: TRIANGULAR SOLVER FAILED");
 }
-
-void Preconditioner::cblas_dcopy(const int N, const double *X, const int incX, double *Y, const int incY)
-{	// My version of cblas_dcopy, only works for incX==1 and incY==1
-	int i;
-	for(i=0; i<N; i++)
-		Y[i] = X[i];
-}
@@ -36,9 +36,14 @@
 #include <new>
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
 	
 
 #include "ninjaException.h"
+#include "ninjaBlas.h"
 
 
 #ifdef _OPENMP
@@ -55,11 +60,20 @@ public:
 	enum precondType{
 		none,
 		Jacobi,
-		SSOR
+		SSOR,
+		Chebyshev
 	};
     
     bool initialize(int numnp, double *A, int *row_ptr, int *col_ind, int preconditionerType, char *matdescra);
 	bool solve(double *r, double *z, int *row_ptr, int *col_ind);
+	const char* getTypeName() const;
+
+	//Chebyshev polynomial preconditioner support
+	void setChebyshevDegree(int degree);
+	bool needsSpectralBounds() const;
+	void setSpectralBounds(double lambdaMin, double lambdaMax);
+	static bool lanczosEigenvalueBounds(const std::vector<double> &cgAlpha, const std::vector<double> &cgBeta,
+	                                    double &lambdaMin, double &lambdaMax);
 
 private:
 	
@@ -71,6 +85,14 @@ private:
 	int *L_row_ptr, *L_col_ind;
 	//int *U_row_ptr, *U_col_ind;
 	double w;	//omega used in the SSOR preconditioner
+
+	//stuff for the Chebyshev polynomial preconditioner
+	int chebyshevDegree;	//number of terms, each application does chebyshevDegree-1 SpMVs
+	bool haveSpectralBounds;	//false until the bounds of D^(-1)*A are set, Jacobi is applied until then
+	double lambdaMin, lambdaMax;	//spectral bounds of D^(-1)*A
+	double *Af;	//fully stored (upper and lower) copy of A so the SpMV is a row parallel gather
+	int *Af_row_ptr, *Af_col_ind;
+	double *chebD, *chebRes;	//scratch vectors for the Chebyshev recurrence
 	
 	//stuff for sparse BLAS triangular solve in SSOR preconditioner
 	double one, zero;
@@ -80,7 +102,8 @@ private:
 	char U_matdescra[6];
 
 	void mkl_dcsrsv(char *transa, int *m, double *alpha, char *matdescra, double *val, int *indx, int *pntrb, int *pntre, double *x, double *y);
-	void cblas_dcopy(const int N, const double *X, const int incX, double *Y, const int incY);
+	void fullSpMV(const double *x, double *y);
+	static int sturmCount(const std::vector<double> &diag, const std::vector<double> &offDiag2, double x);
 };
 
 #endif	//PRECONDITIONER_H
@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include "ninja.h"
+#include "terrainContext.h"
 
 /**
  * Read in the input file.  DEM files are read in and one band is imported.
@@ -48,8 +49,30 @@ void ninja::readInputFile(std::string file)
  * LCP files use elevation and fuel model information or canopy height
  * information to set roughness parameters.
  *
+ * If the run shares its terrain with the other runs of an army, the file is
+ * only read by the first run and the others copy its DEM and surface.
  */
 void ninja::readInputFile()
+{
+    if(input.terrain && !input.dem.fileName.empty())
+    {
+        TerrainContext::Guard guard(input.terrain.get());
+        if(input.terrain->copyInputs(input))
+        {
+            CPLDebug("NINJA", "Using the shared terrain of %s", input.dem.fileName.c_str());
+            return;
+        }
+        readInputFileFromDisk();
+        input.terrain->storeInputs(input);
+        return;
+    }
+    readInputFileFromDisk();
+}
+
+/**
+ * Read in the input file from disk, see readInputFile().
+ */
+void ninja::readInputFileFromDisk()
 {
     GDALDataset *poDataset;
 
@@ -0,0 +1,431 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Cache of output grids of earlier runs, keyed by their inputs
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "resultCache.h"
+
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include "cpl_conv.h"
+#include "cpl_vsi.h"
+#include "cpl_sha256.h"
+
+#include "deflationSpace.h"
+#include "wxModelInitializationFactory.h"
+
+#ifdef _OPENMP
+#include "omp_guard.h"
+#endif
+
+static const int RESULT_CACHE_MAGIC = 0x574e5243;    //"WNRC"
+static const int RESULT_CACHE_VERSION = 2;
+static const char *RESULT_CACHE_EXTENSION = ".wnrc";
+
+namespace {
+
+/**
+ * SHA-256 of a run's inputs, see ResultCache::computeKey().
+ */
+class KeyHash
+{
+public:
+    KeyHash() { CPL_SHA256Init(&context); }
+
+    void add(const void *data, size_t size) { CPL_SHA256Update(&context, data, size); }
+    void add(double value) { add(&value, sizeof(value)); }
+    void add(int value) { add(&value, sizeof(value)); }
+    void add(const std::string &value)
+    {
+        add((int)value.size());
+        add(value.data(), value.size());
+    }
+    void add(const AsciiGrid<double> &grid)
+    {
+        add(grid.get_nRows());
+        add(grid.get_nCols());
+        add(grid.get_cellSize());
+        add(grid.get_xllCorner());
+        add(grid.get_yllCorner());
+        add(grid.get_NoDataValue());
+        add(grid.data.data(), sizeof(double) * grid.get_arraySize());
+    }
+    /* Contents of a file, or of all the files in a directory. */
+    void addFile(const std::string &path)
+    {
+        add(std::string(CPLGetFilename(path.c_str())));
+        VSIStatBufL sStat;
+        if(VSIStatL(path.c_str(), &sStat) != 0)
+            return;
+        if(VSI_ISDIR(sStat.st_mode))
+        {
+            char **papszFiles = VSIReadDir(path.c_str());
+            std::vector<std::string> files;
+            for(int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++)
+            {
+                if(!EQUAL(papszFiles[i], ".") && !EQUAL(papszFiles[i], ".."))
+                    files.push_back(papszFiles[i]);
+            }
+            CSLDestroy(papszFiles);
+            std::sort(files.begin(), files.end());
+            for(unsigned int i = 0; i < files.size(); i++)
+                addFile(std::string(CPLFormFilename(path.c_str(), files[i].c_str(), NULL)));
+            return;
+        }
+        VSILFILE *fp = VSIFOpenL(path.c_str(), "rb");
+        if(fp == NULL)
+            return;
+        std::vector<char> buffer(1 << 20);
+        size_t n;
+        while((n = VSIFReadL(&buffer[0], 1, buffer.size(), fp)) > 0)
+            add(&buffer[0], n);
+        VSIFCloseL(fp);
+    }
+
+    std::string hex()
+    {
+        GByte hash[CPL_SHA256_HASH_SIZE];
+        CPL_SHA256Final(&context, hash);
+        std::ostringstream os;
+        for(int i = 0; i < CPL_SHA256_HASH_SIZE; i++)
+            os << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+        return os.str();
+    }
+
+private:
+    CPL_SHA256Context context;
+};
+
+}
+
+/**
+ * @param directory Cache directory, created if it doesn't exist.
+ * @param maxMegabytes Size the directory is kept under, in MB.
+ */
+ResultCache::ResultCache(const std::string &directory, double maxMegabytes)
+{
+    if(maxMegabytes <= 0.0)
+        throw std::range_error("The result cache size must be positive in ResultCache::ResultCache().");
+
+    this->directory = directory;
+    maxBytes = maxMegabytes * 1024.0 * 1024.0;
+    VSIMkdirRecursive(directory.c_str(), 0777);
+#ifdef _OPENMP
+    omp_init_lock(&lock);
+#endif
+}
+
+ResultCache::~ResultCache()
+{
+#ifdef _OPENMP
+    omp_destroy_lock(&lock);
+#endif
+}
+
+/**
+ * Compute the key of the output grids of a run, after the input file is
+ * read and before the mesh is built.  Solver and shading settings that only
+ * come from configuration options are read here, as the run reads them.
+ * @param input Inputs of the run.
+ * @param mesh Mesh settings of the run.
+ * @param deflation Deflation space of the run, NULL if it has none.
+ * @return The key, or an empty string if the run can't be cached.
+ */
+std::string ResultCache::computeKey(WindNinjaInputs &input, const Mesh &mesh, const DeflationSpace *deflation)
+{
+    if(input.volVTKOutFlag || input.solverStatsOutFlag || input.solverTimeLimit > 0.0 ||
+       !input.inputPointsFilename.empty())
+        return "";
+#ifdef FRICTION_VELOCITY
+    if(input.frictionVelocityFlag)
+        return "";
+#endif
+#ifdef EMISSIONS
+    if(input.dustFlag)
+        return "";
+#endif
+    if(input.initializationMethod != WindNinjaInputs::domainAverageInitializationFlag &&
+       input.initializationMethod != WindNinjaInputs::pointInitializationFlag &&
+       input.initializationMethod != WindNinjaInputs::wxModelInitializationFlag &&
+       input.initializationMethod != WindNinjaInputs::griddedInitializationFlag)
+        return "";
+
+    KeyHash hash;
+    hash.add(RESULT_CACHE_VERSION);
+
+    //terrain
+    hash.add(input.dem);
+    hash.add(input.dem.prjString);
+    hash.add(input.dem.getAngleFromNorth());
+    hash.add((int)input.vegetation);
+    hash.add(input.surface.Roughness);
+    hash.add(input.surface.Rough_d);
+    hash.add(input.surface.Rough_h);
+    hash.add(input.surface.Albedo);
+    hash.add(input.surface.Bowen);
+    hash.add(input.surface.Cg);
+    hash.add(input.surface.Anthropogenic);
+
+    //mesh
+    hash.add(mesh.meshResolution);
+    hash.add((int)mesh.meshResChoice);
+    hash.add((double)mesh.targetNumHorizCells);
+    hash.add((double)mesh.numVertLayers);
+    hash.add(mesh.vertGrowth);
+    hash.add(mesh.domainHeight);
+    hash.add(mesh.maxAspectRatio);
+
+    //initialization
+    std::ostringstream time;
+    time << input.ninjaTime;
+    hash.add((int)input.initializationMethod);
+    hash.add(input.inputSpeed);
+    hash.add(input.inputDirection_geog);
+    hash.add(input.inputWindHeight);
+    hash.add((int)input.diurnalWinds);
+    hash.add(time.str());
+    hash.add(input.airTemp);
+    hash.add(input.cloudCover);
+    hash.add(input.latitude);
+    hash.add(input.longitude);
+    hash.add((int)input.stabilityFlag);
+    hash.add(input.alphaStability);
+    hash.add(input.downDragCoeff);
+    hash.add(input.downEntrainmentCoeff);
+    hash.add(input.upDragCoeff);
+    hash.add(input.upEntrainmentCoeff);
+#ifdef NINJA_SPEED_TESTING
+    hash.add(input.speedDampeningRatio);
+#endif
+    if(input.diurnalWinds)
+    {
+        //shading from the shared horizon map, see TerrainContext::getHorizonMap()
+        hash.add((int)CSLTestBoolean(CPLGetConfigOption("NINJA_SHADE_HORIZON_MAP", "TRUE")));
+        hash.add(atoi(CPLGetConfigOption("NINJA_HORIZON_SECTORS", "32")));
+    }
+    if(input.initializationMethod == WindNinjaInputs::wxModelInitializationFlag)
+    {
+        hash.addFile(input.forecastFilename);
+        wxModelInitialization *model = NULL;
+        try{
+            model = wxModelInitializationFactory::makeWxInitialization(input.forecastFilename);
+            hash.add(model->getForecastIdentifier());
+        }catch(std::exception &e)
+        {
+            delete model;
+            return "";      //the run will report it
+        }
+        delete model;
+    }
+    else if(input.initializationMethod == WindNinjaInputs::griddedInitializationFlag)
+    {
+        hash.addFile(input.speedInitGridFilename);
+        hash.addFile(input.dirInitGridFilename);
+    }
+    else if(input.initializationMethod == WindNinjaInputs::pointInitializationFlag)
+    {
+        hash.add((int)input.matchWxStations);
+        hash.add(atoi(CPLGetConfigOption("NINJA_POINT_MAX_MATCH_ITERS", "150")));
+        hash.add((int)input.stations.size());
+        for(unsigned int i = 0; i < input.stations.size(); i++)
+        {
+            wxStation &station = input.stations[i];
+            hash.add(station.get_projXord());
+            hash.add(station.get_projYord());
+            hash.add(station.get_height());
+            hash.add(station.get_speed());
+            hash.add(station.get_direction());
+            hash.add(station.get_w_speed());
+            hash.add(station.get_temperature());
+            hash.add(station.get_cloudCover());
+            hash.add(station.get_influenceRadius());
+        }
+    }
+
+    //options that change the output grids
+    hash.add(input.outputWindHeight);
+    hash.add((int)input.outputSpeedUnits);
+    hash.add(input.outputBufferClipping);
+    hash.add(input.solverTolerance);
+    hash.add(input.solverMaxIterations);
+    hash.add(input.solverSurfaceWindTol);
+    if(input.solverSurfaceWindTol > 0.0)
+        hash.add(atoi(CPLGetConfigOption("NINJA_SOLVER_SURFACE_CHECK_ITERS", "50")));
+
+    //preconditioner and deflation, see ninja::solve()
+    std::string precond = CPLGetConfigOption("NINJA_SOLVER_PRECONDITIONER", "SSOR");
+    std::transform(precond.begin(), precond.end(), precond.begin(), ::toupper);
+    hash.add(precond);
+    if(precond == "CHEBYSHEV")
+    {
+        hash.add(atoi(CPLGetConfigOption("NINJA_CHEBYSHEV_DEGREE", "4")));
+        hash.add(atoi(CPLGetConfigOption("NINJA_CHEBYSHEV_LANCZOS_ITERS", "10")));
+    }
+    hash.add(deflation ? deflation->getMaxVectors() : 0);
+    hash.add(deflation ? deflation->getWindowSize() : 0);
+
+    return hash.hex();
+}
+
+std::string ResultCache::getFilename(const std::string &key) const
+{
+    return std::string(CPLFormFilename(directory.c_str(), key.c_str(), RESULT_CACHE_EXTENSION + 1));
+}
+
+/**
+ * Load the output grids stored under key.
+ * @return false if there is no (valid) entry for key.
+ */
+bool ResultCache::load(const std::string &key, AsciiGrid<double> &angleGrid, AsciiGrid<double> &velocityGrid,
+                       double &meshResolution, lengthUnits::eLengthUnits &meshResolutionUnits)
+{
+    std::string filename = getFilename(key);
+    VSILFILE *fp = VSIFOpenL(filename.c_str(), "r+b");
+    if(fp == NULL)
+        return false;
+
+    int header[6];    //magic, version, resolution units, columns, rows, projection length
+    double geometry[6];  //resolution, cell size, x/y lower left, angle/velocity no data
+    bool valid = VSIFReadL(header, sizeof(int), 6, fp) == 6 &&
+                 header[0] == RESULT_CACHE_MAGIC && header[1] == RESULT_CACHE_VERSION &&
+                 header[3] > 0 && header[4] > 0 && header[5] >= 0 &&
+                 VSIFReadL(geometry, sizeof(double), 6, fp) == 6;
+    std::string prj;
+    if(valid)
+    {
+        prj.resize(header[5]);
+        valid = header[5] == 0 || VSIFReadL(&prj[0], 1, header[5], fp) == (size_t)header[5];
+    }
+    if(valid)
+    {
+        size_t n = (size_t)header[3] * header[4];
+        angleGrid = AsciiGrid<double>(header[3], header[4], geometry[2], geometry[3], geometry[1], geometry[4], prj);
+        velocityGrid = AsciiGrid<double>(header[3], header[4], geometry[2], geometry[3], geometry[1], geometry[5], prj);
+        valid = VSIFReadL(angleGrid.data.data(), sizeof(double), n, fp) == n &&
+                VSIFReadL(velocityGrid.data.data(), sizeof(double), n, fp) == n;
+    }
+    if(valid)
+    {
+        //rewrite the magic number, which marks the entry as recently used
+        VSIFSeekL(fp, 0, SEEK_SET);
+        VSIFWriteL(&RESULT_CACHE_MAGIC, sizeof(int), 1, fp);
+    }
+    VSIFCloseL(fp);
+
+    if(!valid)
+    {
+        CPLDebug("NINJA", "Removing bad result cache entry %s", filename.c_str());
+        VSIUnlink(filename.c_str());
+        return false;
+    }
+    meshResolution = geometry[0];
+    meshResolutionUnits = (lengthUnits::eLengthUnits)header[2];
+    return true;
+}
+
+/**
+ * Store the output grids of a run under key and evict the least recently
+ * used entries if the directory got too large.  Failures are reported as
+ * exceptions, the run itself is not affected.
+ */
+void ResultCache::store(const std::string &key, const AsciiGrid<double> &angleGrid, const AsciiGrid<double> &velocityGrid,
+                        double meshResolution, lengthUnits::eLengthUnits meshResolutionUnits)
+{
+    if(angleGrid.get_nRows() != velocityGrid.get_nRows() || angleGrid.get_nCols() != velocityGrid.get_nCols())
+        throw std::logic_error("Output grids of different sizes in ResultCache::store().");
+
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    std::string filename = getFilename(key);
+    VSIStatBufL sStat;
+    if(VSIStatL(filename.c_str(), &sStat) == 0)
+        return;     //stored by another run
+
+    std::string tmpFilename = filename + CPLSPrintf(".%d.tmp", CPLGetPID());
+    VSILFILE *fp = VSIFOpenL(tmpFilename.c_str(), "wb");
+    if(fp == NULL)
+        throw std::runtime_error("Cannot write result cache entry " + tmpFilename + ".");
+
+    int header[6] = {RESULT_CACHE_MAGIC, RESULT_CACHE_VERSION, (int)meshResolutionUnits,
+                     angleGrid.get_nCols(), angleGrid.get_nRows(), (int)angleGrid.prjString.size()};
+    double geometry[6] = {meshResolution, angleGrid.get_cellSize(), angleGrid.get_xllCorner(),
+                          angleGrid.get_yllCorner(), angleGrid.get_NoDataValue(), velocityGrid.get_NoDataValue()};
+    size_t n = (size_t)angleGrid.get_arraySize();
+    bool ok = VSIFWriteL(header, sizeof(int), 6, fp) == 6 &&
+              VSIFWriteL(geometry, sizeof(double), 6, fp) == 6 &&
+              VSIFWriteL(angleGrid.prjString.data(), 1, header[5], fp) == (size_t)header[5] &&
+              VSIFWriteL(angleGrid.data.data(), sizeof(double), n, fp) == n &&
+              VSIFWriteL(velocityGrid.data.data(), sizeof(double), n, fp) == n;
+    if(VSIFCloseL(fp) != 0)
+        ok = false;
+    if(!ok || VSIRename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+        VSIUnlink(tmpFilename.c_str());
+        throw std::runtime_error("Cannot write result cache entry " + filename + ".");
+    }
+
+    evict();
+}
+
+/**
+ * Remove the least recently used entries until the directory is under
+ * maxBytes.  Called with the lock held.
+ */
+void ResultCache::evict()
+{
+    std::vector<std::pair<long long, std::string> > entries;   //last use, filename
+    double totalBytes = 0.0;
+    char **papszFiles = VSIReadDir(directory.c_str());
+    for(int i = 0; papszFiles != NULL && papszFiles[i] != NULL; i++)
+    {
+        if(!EQUAL(CPLGetExtension(papszFiles[i]), RESULT_CACHE_EXTENSION + 1))
+            continue;
+        std::string filename = CPLFormFilename(directory.c_str(), papszFiles[i], NULL);
+        VSIStatBufL sStat;
+        if(VSIStatL(filename.c_str(), &sStat) != 0)
+            continue;
+        totalBytes += (double)sStat.st_size;
+        entries.push_back(std::make_pair((long long)sStat.st_mtime, filename));
+    }
+    CSLDestroy(papszFiles);
+
+    std::sort(entries.begin(), entries.end());
+    for(unsigned int i = 0; i < entries.size() && totalBytes > maxBytes; i++)
+    {
+        VSIStatBufL sStat;
+        if(VSIStatL(entries[i].second.c_str(), &sStat) == 0 && VSIUnlink(entries[i].second.c_str()) == 0)
+        {
+            CPLDebug("NINJA", "Evicted result cache entry %s", entries[i].second.c_str());
+            totalBytes -= (double)sStat.st_size;
+        }
+    }
+}
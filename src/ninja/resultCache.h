@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Cache of output grids of earlier runs, keyed by their inputs
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <string>
+
+#include "ascii_grid.h"
+#include "WindNinjaInputs.h"
+#include "mesh.h"
+
+class DeflationSpace;
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Directory of output grids of earlier runs, so a repeated run only writes
+ * its output files again.  An entry is keyed by a SHA-256 hash of
+ * everything that determines the output grids: the DEM and surface grids,
+ * the initialization (including the contents of forecast, gridded and
+ * station data, the weather model type and the diurnal and stability
+ * coefficients), the mesh settings and the options that change the grids
+ * (output height, speed units, clipping, solver tolerances, preconditioner,
+ * deflation space and the shading settings of diurnal runs).  Output file
+ * types and resolutions are not part of the key, they are made from the
+ * cached grids.  Runs whose results aren't just the output grids (volume
+ * VTK output, solver statistics, output points, solver time limits) are
+ * not cached.
+ *
+ * The directory is kept under maxMegabytes by removing the least recently
+ * used entries.  Entries are written to a temporary file and renamed, so
+ * several processes may share a directory.
+ */
+class ResultCache
+{
+public:
+    ResultCache(const std::string &directory, double maxMegabytes);
+    ~ResultCache();
+
+    static std::string computeKey(WindNinjaInputs &input, const Mesh &mesh, const DeflationSpace *deflation);
+
+    bool load(const std::string &key, AsciiGrid<double> &angleGrid, AsciiGrid<double> &velocityGrid,
+              double &meshResolution, lengthUnits::eLengthUnits &meshResolutionUnits);
+    void store(const std::string &key, const AsciiGrid<double> &angleGrid, const AsciiGrid<double> &velocityGrid,
+               double meshResolution, lengthUnits::eLengthUnits meshResolutionUnits);
+
+    const std::string &getDirectory() const { return directory; }
+
+private:
+    std::string getFilename(const std::string &key) const;
+    void evict();
+
+    std::string directory;
+    double maxBytes;
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+
+    ResultCache(const ResultCache &);
+    ResultCache &operator=(const ResultCache &);
+};
+
+#endif /* RESULT_CACHE_H */
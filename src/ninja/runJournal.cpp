@@ -0,0 +1,242 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Journal of the finished runs of an army, used to resume it
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "runJournal.h"
+
+#include <sstream>
+#include <iomanip>
+
+#include "cpl_conv.h"
+#include "cpl_vsi.h"
+#include "cpl_json.h"
+#include "cpl_sha256.h"
+
+#ifdef _OPENMP
+#include "omp_guard.h"
+#endif
+
+static const char *RUN_JOURNAL_FILENAME = "windninja_runs.journal";
+
+RunJournal::RunJournal()
+{
+#ifdef _OPENMP
+    omp_init_lock(&lock);
+#endif
+}
+
+RunJournal::~RunJournal()
+{
+#ifdef _OPENMP
+    omp_destroy_lock(&lock);
+#endif
+}
+
+/**
+ * Compute the key of a run for the journal: its inputs and the options
+ * that decide which output files are written and how.
+ * @param inputKey Key of the output grids, see ResultCache::computeKey().
+ * @param input Inputs of the run.
+ * @return The key.
+ */
+std::string RunJournal::computeKey(const std::string &inputKey, const WindNinjaInputs &input)
+{
+    std::ostringstream os;
+    os << std::setprecision(17) << inputKey << "|" << input.customOutputPath
+       << "|" << input.asciiOutFlag << input.asciiAaigridOutFlag << input.asciiJsonOutFlag
+       << input.asciiProjOutFlag << input.asciiGeogOutFlag << input.asciiUvOutFlag
+       << input.googOutFlag << input.shpOutFlag << input.pdfOutFlag << input.geoTiffOutFlag
+       << input.fgbzOutFlag << input.txtOutFlag << input.wxModelGoogOutFlag
+       << input.wxModelShpOutFlag << input.wxModelAsciiOutFlag << input.wxModelGeoTiffOutFlag
+       << input.wxModelFgbzOutFlag
+       << "|" << input.kmzResolution << "|" << input.shpResolution << "|" << input.velResolution
+       << "|" << input.angResolution << "|" << input.pdfResolution << "|" << input.geoTiffResolution
+       << "|" << input.fgbzResolution;
+    std::string text = os.str();
+
+    CPL_SHA256Context context;
+    GByte hash[CPL_SHA256_HASH_SIZE];
+    CPL_SHA256Init(&context);
+    CPL_SHA256Update(&context, text.data(), text.size());
+    CPL_SHA256Final(&context, hash);
+
+    std::ostringstream key;
+    for(int i = 0; i < CPL_SHA256_HASH_SIZE; i++)
+        key << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+    return key.str();
+}
+
+/**
+ * Look for a finished run in the journal of a directory.
+ * @param directory Output directory of the run.
+ * @param runNumber Number of the run in the army.
+ * @param key Key of the run, see computeKey().
+ * @param meshResolution Mesh resolution of the recorded run, set if found.
+ * @param meshResolutionUnits Units of meshResolution, set if found.
+ * @return true if the run is recorded with the same key and its output
+ *         files are unchanged.
+ */
+bool RunJournal::find(const std::string &directory, int runNumber, const std::string &key,
+                      double &meshResolution, lengthUnits::eLengthUnits &meshResolutionUnits)
+{
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    Runs &runs = load(directory);
+    Runs::const_iterator it = runs.find(runNumber);
+    if(it == runs.end() || it->second.key != key)
+        return false;
+
+    const Run &run = it->second;
+    for(unsigned int i = 0; i < run.files.size(); i++)
+    {
+        VSIStatBufL sStat;
+        std::string filename = CPLFormFilename(directory.c_str(), run.files[i].c_str(), NULL);
+        if(VSIStatL(filename.c_str(), &sStat) != 0 || (double)sStat.st_size != run.sizes[i])
+        {
+            CPLDebug("NINJA", "Run number %d is in the journal but %s changed, running it again.",
+                     runNumber, filename.c_str());
+            return false;
+        }
+    }
+    meshResolution = run.meshResolution;
+    meshResolutionUnits = run.meshResolutionUnits;
+    return true;
+}
+
+/**
+ * Record a run whose output files are written.  The run isn't recorded if
+ * one of the files is missing, so it is done again on restart.
+ * @param directory Output directory of the run.
+ * @param runNumber Number of the run in the army.
+ * @param key Key of the run, see computeKey().
+ * @param meshResolution Mesh resolution of the run.
+ * @param meshResolutionUnits Units of meshResolution.
+ * @param files Output files of the run, in directory.
+ */
+void RunJournal::record(const std::string &directory, int runNumber, const std::string &key,
+                        double meshResolution, lengthUnits::eLengthUnits meshResolutionUnits,
+                        const std::vector<std::string> &files)
+{
+    Run run;
+    run.key = key;
+    run.meshResolution = meshResolution;
+    run.meshResolutionUnits = meshResolutionUnits;
+
+    CPLJSONArray fileArray;
+    for(unsigned int i = 0; i < files.size(); i++)
+    {
+        VSIStatBufL sStat;
+        if(VSIStatL(files[i].c_str(), &sStat) != 0)
+        {
+            CPLDebug("NINJA", "Run number %d is not journaled, %s is missing.", runNumber, files[i].c_str());
+            return;
+        }
+        run.files.push_back(CPLGetFilename(files[i].c_str()));
+        run.sizes.push_back((double)sStat.st_size);
+
+        CPLJSONObject file;
+        file.Add("name", run.files.back());
+        file.Add("size", run.sizes.back());
+        fileArray.Add(file);
+    }
+
+    CPLJSONObject entry;
+    entry.Add("run", runNumber);
+    entry.Add("key", key);
+    entry.Add("mesh_resolution", meshResolution);
+    entry.Add("mesh_resolution_units", lengthUnits::getString(meshResolutionUnits));
+    entry.Add("files", fileArray);
+    std::string line = entry.Format(CPLJSONObject::PrettyFormat::Plain) + "\n";
+
+#ifdef _OPENMP
+    omp_guard guard(lock);
+#endif
+    Runs &runs = load(directory);
+    VSILFILE *fp = VSIFOpenL(getFilename(directory).c_str(), "ab");
+    if(fp == NULL)
+        throw std::runtime_error("Cannot open the run journal " + getFilename(directory) + ".");
+    bool written = VSIFWriteL(line.data(), 1, line.size(), fp) == line.size();
+    VSIFCloseL(fp);
+    if(!written)
+        throw std::runtime_error("Cannot write the run journal " + getFilename(directory) + ".");
+    runs[runNumber] = run;
+}
+
+/**
+ * Runs recorded in the journal of a directory, read the first time.  Lines
+ * that can't be read (the end of a journal cut short by a kill) are skipped.
+ * Must be called with the lock held.
+ */
+RunJournal::Runs &RunJournal::load(const std::string &directory)
+{
+    std::map<std::string, Runs>::iterator it = journals.find(directory);
+    if(it != journals.end())
+        return it->second;
+
+    Runs &runs = journals[directory];
+    VSILFILE *fp = VSIFOpenL(getFilename(directory).c_str(), "rb");
+    if(fp == NULL)
+        return runs;
+
+    const char *pszLine;
+    while((pszLine = CPLReadLineL(fp)) != NULL)
+    {
+        CPLJSONDocument document;
+        if(*pszLine == '\0' || !document.LoadMemory(std::string(pszLine)))
+            continue;
+        CPLJSONObject entry = document.GetRoot();
+        Run run;
+        run.key = entry.GetString("key");
+        run.meshResolution = entry.GetDouble("mesh_resolution", -1.0);
+        try{
+            run.meshResolutionUnits = lengthUnits::getUnit(entry.GetString("mesh_resolution_units"));
+        }catch(std::exception &e)
+        {
+            continue;
+        }
+        CPLJSONArray fileArray = entry.GetArray("files");
+        for(int i = 0; i < fileArray.Size(); i++)
+        {
+            run.files.push_back(fileArray[i].GetString("name"));
+            run.sizes.push_back(fileArray[i].GetDouble("size", -1.0));
+        }
+        if(run.key.empty() || run.meshResolution <= 0.0)
+            continue;
+        runs[entry.GetInteger("run", -1)] = run;
+    }
+    VSIFCloseL(fp);
+    CPLDebug("NINJA", "Read %d runs from the journal in %s.", (int)runs.size(), directory.c_str());
+    return runs;
+}
+
+std::string RunJournal::getFilename(const std::string &directory)
+{
+    return std::string(CPLFormFilename(directory.c_str(), RUN_JOURNAL_FILENAME, NULL));
+}
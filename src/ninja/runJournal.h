@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Journal of the finished runs of an army, used to resume it
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "WindNinjaInputs.h"
+#include "ninjaUnits.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Journal of the runs whose output files are written, kept in each output
+ * directory so an army that was stopped (or had a run fail) can be started
+ * again and only do the runs that are missing.
+ *
+ * A run is recorded by run number with a key of its inputs (see
+ * computeKey()), its mesh resolution and the names and sizes of its output
+ * files.  On restart a run is skipped if its number has a record with the
+ * same key and all its files are still there with the recorded sizes.
+ * Records are appended one JSON object per line when the files of a run are
+ * written, a later record of a run replaces an earlier one.
+ */
+class RunJournal
+{
+public:
+    RunJournal();
+    ~RunJournal();
+
+    static std::string computeKey(const std::string &inputKey, const WindNinjaInputs &input);
+
+    bool find(const std::string &directory, int runNumber, const std::string &key,
+              double &meshResolution, lengthUnits::eLengthUnits &meshResolutionUnits);
+    void record(const std::string &directory, int runNumber, const std::string &key,
+                double meshResolution, lengthUnits::eLengthUnits meshResolutionUnits,
+                const std::vector<std::string> &files);
+
+private:
+    struct Run
+    {
+        std::string key;
+        double meshResolution;
+        lengthUnits::eLengthUnits meshResolutionUnits;
+        std::vector<std::string> files;     //names in the directory
+        std::vector<double> sizes;          //in bytes
+    };
+    typedef std::map<int, Run> Runs;
+
+    std::map<std::string, Runs> journals;   //by directory, read on first use
+
+    Runs &load(const std::string &directory);
+    static std::string getFilename(const std::string &directory);
+
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+
+    RunJournal(const RunJournal &);
+    RunJournal &operator=(const RunJournal &);
+};
+
+#endif /* RUN_JOURNAL_H */
@@ -259,6 +259,29 @@ bool Solar::call_solPos()
 	return true;
 }
 
+/**
+ * Solar intensity on a surface (etrtilt of solpos) for the sun position of
+ * the last call_solPos().  The sun position does not depend on the surface,
+ * so the cells of a grid can use this instead of calling solpos each.
+ * @param aspect_in Aspect of the surface in degrees, in projected coordinates.
+ * @param slope_in Slope of the surface in degrees.
+ * @param angleFromNorth Angle of the projection from north, see set_aspect().
+ * @return Intensity in W/m^2, 0 if the sun is behind the surface.
+ */
+double Solar::compute_solarIntensity(double aspect_in, double slope_in, double angleFromNorth) const
+{
+    const double raddeg = 0.0174532925;   //same conversion as solpos
+    double surfaceAspect = wrap0to360( aspect_in + angleFromNorth );
+
+    double cosinc = solarPosData->coszen * cos( raddeg * slope_in ) +
+                    sin( raddeg * solarPosData->zenref ) * sin( raddeg * slope_in ) *
+                    ( cos( raddeg * solarPosData->azim ) * cos( raddeg * surfaceAspect ) +
+                      sin( raddeg * solarPosData->azim ) * sin( raddeg * surfaceAspect ) );
+    if( cosinc > 0.0 )
+        return solarPosData->etrn * cosinc;
+    return 0.0;
+}
+
 bool Solar::print_allSolarPosData()
 {
 	//Compute offset from UTC, including if in daylight savings or not
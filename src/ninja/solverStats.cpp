@@ -0,0 +1,169 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Statistics recorded by the matrix solvers for each solve
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+#include "solverStats.h"
+
+#include <stdexcept>
+#include <cmath>
+
+/*
+** JSON has no NaN or Inf, a diverged solve writes null instead.
+*/
+static std::string jsonNumber(double value)
+{
+    if(!std::isfinite(value))
+        return "null";
+    std::ostringstream os;
+    os << std::setprecision(10) << value;
+    return os.str();
+}
+
+SolverStats::SolverStats()
+{
+    historyStride = 10;
+    reset();
+}
+
+/**
+ * Clear the record for a new solve.  The history stride is kept.
+ */
+void SolverStats::reset()
+{
+    solverType = "";
+    preconditionerType = "";
+    deflationVectors = 0;
+    numUnknowns = 0;
+    numNonZeros = 0;
+    matrixBytes = 0;
+    numIterations = 0;
+    converged = false;
+    stopReason = "";
+    tolerance = 0.0;
+    initialResidual = 0.0;
+    finalResidual = 0.0;
+    setupTime = 0.0;
+    iterationTime = 0.0;
+    historyIterations.clear();
+    historyResiduals.clear();
+}
+
+/**
+ * Store the residual of an iteration in the history if it falls on the stride.
+ * @param iteration Iteration number, starting at 1.
+ * @param residual Residual after the iteration.
+ */
+void SolverStats::addResidual(int iteration, double residual)
+{
+    if(historyStride <= 0 || iteration % historyStride != 0)
+        return;
+    historyIterations.push_back(iteration);
+    historyResiduals.push_back(residual);
+}
+
+/**
+ * Record the end of the solve.  The last residual is always added to the
+ * history so the history ends where the solver stopped.
+ */
+void SolverStats::finish(int iteration, double residual, bool isConverged)
+{
+    numIterations = iteration;
+    finalResidual = residual;
+    converged = isConverged;
+    if(historyStride > 0 && iteration > 0 &&
+       (historyIterations.empty() || historyIterations.back() != iteration))
+    {
+        historyIterations.push_back(iteration);
+        historyResiduals.push_back(residual);
+    }
+}
+
+std::string SolverStats::toJson() const
+{
+    std::ostringstream os;
+    os << "{\"solver\":\"" << solverType << "\""
+       << ",\"preconditioner\":\"" << preconditionerType << "\""
+       << ",\"deflationVectors\":" << deflationVectors
+       << ",\"unknowns\":" << numUnknowns
+       << ",\"nonZeros\":" << numNonZeros
+       << ",\"matrixBytes\":" << matrixBytes
+       << ",\"iterations\":" << numIterations
+       << ",\"converged\":" << (converged ? "true" : "false")
+       << ",\"stopReason\":\"" << stopReason << "\""
+       << ",\"tolerance\":" << jsonNumber(tolerance)
+       << ",\"initialResidual\":" << jsonNumber(initialResidual)
+       << ",\"finalResidual\":" << jsonNumber(finalResidual)
+       << ",\"setupTime\":" << jsonNumber(setupTime)
+       << ",\"iterationTime\":" << jsonNumber(iterationTime)
+       << ",\"historyStride\":" << historyStride
+       << ",\"history\":[";
+    for(unsigned int i = 0; i < historyIterations.size(); i++)
+    {
+        if(i > 0)
+            os << ",";
+        os << "[" << historyIterations[i] << "," << jsonNumber(historyResiduals[i]) << "]";
+    }
+    os << "]}";
+    return os.str();
+}
+
+/**
+ * JSON document for all the solves of a run.
+ */
+std::string SolverStats::toJson(const std::vector<SolverStats> &solves, int runNumber)
+{
+    std::ostringstream os;
+    os << "{\"run\":" << runNumber << ",\"solves\":[";
+    for(unsigned int i = 0; i < solves.size(); i++)
+    {
+        if(i > 0)
+            os << ",\n";
+        else
+            os << "\n";
+        os << solves[i].toJson();
+    }
+    os << "\n]}\n";
+    return os.str();
+}
+
+void SolverStats::writeJson(const std::vector<SolverStats> &solves, int runNumber, const std::string &filename)
+{
+    std::ofstream fout(filename.c_str());
+    if(!fout)
+        throw std::runtime_error("Cannot open solver statistics file " + filename + " for writing.");
+    fout << toJson(solves, runNumber);
+}
+
+double SolverStats::wallTime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
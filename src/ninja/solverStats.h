@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Statistics recorded by the matrix solvers for each solve
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+#ifndef SOLVER_STATS_H
+#define SOLVER_STATS_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Record of one call to a matrix solver (ninja::solve or ninja::solveMinres).
+ * Every solve fills one of these; a run keeps one per solve (matching runs
+ * solve several times) so the numbers can be used to tune mesh and solver
+ * settings.  Residuals are the ones the solver checks against its tolerance.
+ */
+class SolverStats
+{
+public:
+    SolverStats();
+
+    void reset();
+    void addResidual(int iteration, double residual);
+    void finish(int iteration, double residual, bool isConverged);
+
+    std::string toJson() const;
+
+    static std::string toJson(const std::vector<SolverStats> &solves, int runNumber);
+    static void writeJson(const std::vector<SolverStats> &solves, int runNumber, const std::string &filename);
+    static double wallTime();
+
+    std::string solverType;         //"CG" or "MINRES"
+    std::string preconditionerType; //preconditioner actually applied at the end of the solve
+    int deflationVectors;           //vectors deflated out of the CG iterations (see DeflationSpace)
+    int numUnknowns;                //rows in the matrix (NUMNP)
+    long long numNonZeros;          //stored non-zeros in the matrix
+    long long matrixBytes;          //bytes of matrix storage (values, column indices and row pointers)
+    int numIterations;
+    bool converged;
+    std::string stopReason;         //"tolerance", "surface_wind", "iteration_budget", "time_limit" or "max_iterations"
+    double tolerance;
+    double initialResidual;
+    double finalResidual;
+    double setupTime;               //preconditioner setup and initial residual, in seconds
+    double iterationTime;           //time spent iterating, in seconds
+
+    int historyStride;              //residual is kept every historyStride iterations, 0 keeps none
+    std::vector<int> historyIterations;
+    std::vector<double> historyResiduals;
+};
+
+#endif /* SOLVER_STATS_H */
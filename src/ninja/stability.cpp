@@ -28,6 +28,7 @@
  *****************************************************************************/
 
 #include "stability.h"
+#include "terrainContext.h"
 
 Stability::Stability()        //default constructor
 {
@@ -114,22 +115,13 @@ void Stability::Set3dVariableAlpha(WindNinjaInputs &input,
 {
     double hTest;
     double hMax, hMin; // max, min terrain heights
-    double delta_h; //orographic height difference
-    double _r; //horizontal distance 
     double sum1, sum2;
     
-    alphaField.allocate(&mesh);
+    alphaField.allocateNodes(mesh);
     _H.set_headerData(input.dem);
     
-    for(int k = 0; k < mesh.nlayers; k++){
-        for(int i = 0; i < mesh.nrows; i++){
-            for(int j = 0; j < mesh.ncols; j++ ){
-                theta(i,j,k) += 300.0; //convert from perturbation to total potential temperature (theta)
-            }
-        }
-    }
-
-    
+    //theta is the perturbation potential temperature; the total (theta + 300 K)
+    //has the same gradient, so it is only added where theta itself is used
     wn_3dVectorField thetaDerivatives;
     theta.ComputeGradient(input, thetaDerivatives); // calculate dtheta/dz, dx, dy at each node
     
@@ -158,10 +150,16 @@ void Stability::Set3dVariableAlpha(WindNinjaInputs &input,
      * but appears to give bad values for H -- maybe there is a typo
      * in the equation (??)
      */
-    sum1 = 0.0;
-    sum2 = 0.0;
+    std::vector<double> cellSum1(mesh.nrows * mesh.ncols);
+    std::vector<double> cellSum2(mesh.nrows * mesh.ncols);
+    bool badDistance = false;
+#pragma omp parallel for schedule(dynamic) reduction(||:badDistance)
     for(int i=0; i<mesh.nrows; i++){
+        double delta_h; //orographic height difference
+        double _r; //horizontal distance 
         for(int j=0; j<mesh.ncols; j++){
+            double cell1 = 0.0;
+            double cell2 = 0.0;
             for(int ii=0; ii<mesh.nrows; ii++){
                 for(int jj=0; jj<mesh.ncols; jj++){
                     delta_h = std::abs( mesh.ZORD(i,j,0) - mesh.ZORD(ii,jj,0) );
@@ -173,26 +171,47 @@ void Stability::Set3dVariableAlpha(WindNinjaInputs &input,
                     }
                     else{
                         if(_r < 0){
-                            throw std::runtime_error("Division by 0 in Set3dVariableAlpha().");
+                            badDistance = true;
                         }
                         //sum1 += (delta_h / _r); //this calculation appears to be wrong (Eq 2.11)
                         //sum2 += (1 / _r); //this calculation appears to be wrong (Eq 2.11)
                         
-                        sum1 += delta_h / ( std::pow(_r, 2) ); // Eq 2.10
-                        sum2 += 1 / ( std::pow(_r, 2) ); //Eq. 2.10
+                        cell1 += delta_h / ( std::pow(_r, 2) ); // Eq 2.10
+                        cell2 += 1 / ( std::pow(_r, 2) ); //Eq. 2.10
                     }
                 }
             }
+            cellSum1[i * mesh.ncols + j] = cell1;
+            cellSum2[i * mesh.ncols + j] = cell2;
+        }
+    }
+    if(badDistance){
+        throw std::runtime_error("Division by 0 in Set3dVariableAlpha().");
+    }
+
+    //sum1 and sum2 are not reset from node to node, so H of a node is
+    //built from the sums of all the nodes before it; only the sums of each
+    //node are computed in parallel above
+    sum1 = 0.0;
+    sum2 = 0.0;
+    for(int i=0; i<mesh.nrows; i++){
+        for(int j=0; j<mesh.ncols; j++){
+            sum1 += cellSum1[i * mesh.ncols + j];
+            sum2 += cellSum2[i * mesh.ncols + j];
             //_H(i,j) = _c * (hMax - hMin) + (1 - _c) * sum1 / sum2; //this calculation appears to be wrong (Eq 2.11)
             _H(i,j) = sum1 / sum2; //Eq. 2.10
-            
         }
     }
 
+    //exceptions can't leave the parallel loop, the first problem is thrown after it
+    const char *problem = NULL;
+#pragma omp parallel for
     for(int k=0; k<mesh.nlayers; k++){
         for(int i=0; i<mesh.nrows; i++){
             for(int j=0; j<mesh.ncols; j++){
+                double _U, _N, _t, strouhalNumber, alpha;
 
+                double totalTheta = theta(i,j,k) + 300.0; //convert from perturbation to total potential temperature (theta)
                 _U = std::sqrt( ( std::pow(u0(i,j,k), 2) + std::pow(v0(i,j,k), 2) ) );
                     if (_U < 0.2){
                         _U = 0.2;
@@ -200,15 +219,17 @@ void Stability::Set3dVariableAlpha(WindNinjaInputs &input,
                 
                 if( (*thetaDerivatives.vectorData_z)(i,j,k) >= 0.0 ){ // Str = HN/U
                                         
-                    _N = std::sqrt( _g/theta(i,j,k) * (*thetaDerivatives.vectorData_z)(i,j,k) );
+                    _N = std::sqrt( _g/totalTheta * (*thetaDerivatives.vectorData_z)(i,j,k) );
                     strouhalNumber = _H(i,j) * _N / _U;
                 }
                 else if( (*thetaDerivatives.vectorData_z)(i,j,k) < 0.0 ){ // Str = -H/Ut
-                    _t = std::sqrt( -_g/theta(i,j,k) * (*thetaDerivatives.vectorData_z)(i,j,k) );
+                    _t = std::sqrt( -_g/totalTheta * (*thetaDerivatives.vectorData_z)(i,j,k) );
                     strouhalNumber = -_H(i,j) / _U *_t;
                 }
                 else{
-                    throw logic_error("Problem calculating Strouhal number for atmospheric stability.");
+#pragma omp critical
+                    problem = "Problem calculating Strouhal number for atmospheric stability.";
+                    continue;
                 }
                 
                 if(strouhalNumber >= 0.0){
@@ -223,32 +244,39 @@ void Stability::Set3dVariableAlpha(WindNinjaInputs &input,
 //                    cout<<"strouhalNumber = "<<strouhalNumber<<endl;
 //                    cout<<"calculation = "<<std::sqrt( exp( -1.5 * std::pow(strouhalNumber, 1.5) ) )<<endl;
                     
-                    alphaField(i,j,k) = std::sqrt( exp( -1.5 * std::pow(strouhalNumber, 1.5) ) );
+                    alpha = std::sqrt( exp( -1.5 * std::pow(strouhalNumber, 1.5) ) );
                     
-                    //cout<<"alphaField(i,j,k) = "<<alphaField(i,j,k)<<endl;
+                    //cout<<"alpha = "<<alpha<<endl;
                 }
                 else if(strouhalNumber < 0.0){
-                    alphaField(i,j,k) = std::sqrt( exp( 1.5 * std::pow(-strouhalNumber, 1.5) ) );
+                    alpha = std::sqrt( exp( 1.5 * std::pow(-strouhalNumber, 1.5) ) );
                 }
                 else{
-                    throw logic_error("Problem calculating alpha from the Strouhal number for atmospheric stability.");
+#pragma omp critical
+                    problem = "Problem calculating alpha from the Strouhal number for atmospheric stability.";
+                    continue;
                 }
-                if(alphaField(i,j,k) > 5.0){ //max alpha allowed is 5
-                    alphaField(i,j,k) = 5.0;
+                if(alpha > 5.0){ //max alpha allowed is 5
+                    alpha = 5.0;
                 }
-                else if(alphaField(i,j,k) <= 0.0){ // alpha must be greater than 0
-                    alphaField(i,j,k) = 0.1;
+                else if(alpha <= 0.0){ // alpha must be greater than 0
+                    alpha = 0.1;
                 }
-//                if(alphaField(i,j,k) > 5 || alphaField(i,j,k) < 0){
-//                    cout<<"alphaField = "<<alphaField(i,j,k)<<endl;
+//                if(alpha > 5 || alpha < 0){
+//                    cout<<"alphaField = "<<alpha<<endl;
 //                    throw std::runtime_error("Problem with atmospheric stability calculation: alpha < 0 or > 5 in Set3dVariableAlpha().");
 //                }
-                if(alphaField(i,j,k) > 5.0 || alphaField(i,j,k) <= 0.0){
-                    throw std::runtime_error("Problem with atmospheric stability calculation: alpha < 0 or > 5 in Set3dVariableAlpha().");
+                if(alpha > 5.0 || alpha <= 0.0){
+#pragma omp critical
+                    problem = "Problem with atmospheric stability calculation: alpha < 0 or > 5 in Set3dVariableAlpha().";
                 }
+                alphaField.node(i,j,k) = alpha;
             }
         }
     }
+    if(problem){
+        throw std::runtime_error(problem);
+    }
 }
 
 
@@ -267,35 +295,42 @@ void Stability::SetDomainAverageAlpha(WindNinjaInputs &input,
 {
     cloudCoverGrid = input.cloudCover;
     speedGrid = input.inputSpeed;
-                                    
-    alphaField.allocate(&mesh);
+
                                                 
     double aspect_temp = 0;	//just placeholder, basically
 	double slope_temp = 0;	//just placeholder, basically
 	    
     Solar solar(input.ninjaTime, input.latitude, input.longitude, aspect_temp, slope_temp, input.dem.getAngleFromNorth());
 	//solar.print_allSolarPosData();
-	Aspect aspect(&input.dem, input.numberCPUs);
-	Slope slope(&input.dem, input.numberCPUs);
-	Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs);
+	boost::shared_ptr<const Aspect> pAspect = TerrainContext::getAspect(input);
+	const Aspect &aspect = *pAspect;
+	boost::shared_ptr<const Slope> pSlope = TerrainContext::getSlope(input);
+	const Slope &slope = *pSlope;
+	Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs,
+	      TerrainContext::getHorizonMap(input).get());
 	cellDiurnal cDiurnal(&input.dem, &shade, &solar, input.dem.getAngleFromNorth(),
                     input.downDragCoeff, input.downEntrainmentCoeff,
                     input.upDragCoeff, input.upEntrainmentCoeff);
 	cDiurnal.CloudCover = input.cloudCover;  //set CloudCover in cellDiurnal bfore computing Qsw
 		
-	for(unsigned int i=0;i<input.dem.get_nRows();i++)
+#pragma omp parallel default(shared)
 	{
-        for(unsigned int j=0;j<input.dem.get_nCols();j++)
+	cellDiurnal threadDiurnal(cDiurnal);  //cellDiurnal keeps the state of its cell
+#pragma omp for
+	for(int i=0;i<input.dem.get_nRows();i++)
+	{
+        for(int j=0;j<input.dem.get_nCols();j++)
 		{
-		    cDiurnal.i=i;	//Set i,j of current cell
-	        cDiurnal.j=j;
-	        cDiurnal.aspect=aspect(i,j);
-	        cDiurnal.slope=slope(i,j);
-	        cDiurnal.compute_solarIntensity();
-		    cDiurnal.compute_Qsw();
-		    QswGrid(i,j) = cDiurnal.Qsw;  // get shortwave radiation for current cell
+		    threadDiurnal.i=i;	//Set i,j of current cell
+	        threadDiurnal.j=j;
+	        threadDiurnal.aspect=aspect(i,j);
+	        threadDiurnal.slope=slope(i,j);
+	        threadDiurnal.compute_solarIntensity();
+		    threadDiurnal.compute_Qsw();
+		    QswGrid(i,j) = threadDiurnal.Qsw;  // get shortwave radiation for current cell
 		}
     }
+	}
 
 	//QswGrid.write_Grid("QswGrid", 2);
 	//cloudCoverGrid.write_Grid("cloudgrid", 2);
@@ -317,8 +352,7 @@ void Stability::SetPointInitializationAlpha(WindNinjaInputs &input,
 {
     
     speedGrid = input.surface.windSpeedGrid;
-                                    
-    alphaField.allocate(&mesh);
+
         
     double *cc, *X, *Y, *influenceRadius;
 	
@@ -355,27 +389,35 @@ void Stability::SetPointInitializationAlpha(WindNinjaInputs &input,
 	    
     Solar solar(input.ninjaTime, input.latitude, input.longitude, aspect_temp, slope_temp, input.dem.getAngleFromNorth());
     //solar.print_allSolarPosData();
-	Aspect aspect(&input.dem, input.numberCPUs);
-    Slope slope(&input.dem, input.numberCPUs);
-	Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs);
+	boost::shared_ptr<const Aspect> pAspect = TerrainContext::getAspect(input);
+	const Aspect &aspect = *pAspect;
+    boost::shared_ptr<const Slope> pSlope = TerrainContext::getSlope(input);
+    const Slope &slope = *pSlope;
+	Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs,
+	      TerrainContext::getHorizonMap(input).get());
 	cellDiurnal cDiurnal(&input.dem, &shade, &solar, input.dem.getAngleFromNorth(),
                         input.downDragCoeff, input.downEntrainmentCoeff,
                         input.upDragCoeff, input.upEntrainmentCoeff);
 		
-	for(unsigned int i=0;i<input.dem.get_nRows();i++)
+#pragma omp parallel default(shared)
+	{
+	cellDiurnal threadDiurnal(cDiurnal);  //cellDiurnal keeps the state of its cell
+#pragma omp for
+	for(int i=0;i<input.dem.get_nRows();i++)
 	{
-	    for(unsigned int j=0;j<input.dem.get_nCols();j++)
+	    for(int j=0;j<input.dem.get_nCols();j++)
 	    {
-	        cDiurnal.CloudCover = cloudCoverGrid(i,j);  //set CloudCover in cellDiurnal bfore computing Qsw
-	        cDiurnal.i = i;
-	        cDiurnal.j = j;
-	        cDiurnal.aspect=aspect(i,j);
-	        cDiurnal.slope=slope(i,j);
-	        cDiurnal.compute_solarIntensity();
-	        cDiurnal.compute_Qsw();
-	        QswGrid(i,j) = cDiurnal.Qsw;  // get shortwave radiation for current cell
+	        threadDiurnal.CloudCover = cloudCoverGrid(i,j);  //set CloudCover in cellDiurnal bfore computing Qsw
+	        threadDiurnal.i = i;
+	        threadDiurnal.j = j;
+	        threadDiurnal.aspect=aspect(i,j);
+	        threadDiurnal.slope=slope(i,j);
+	        threadDiurnal.compute_solarIntensity();
+	        threadDiurnal.compute_Qsw();
+	        QswGrid(i,j) = threadDiurnal.Qsw;  // get shortwave radiation for current cell
 	    }
 	}
+	}
 		
     //cout<<"station.cloudCover"<<station.cloudCover<<endl;
 	//cout<<"cDiurnal.cloudCover"<<cDiurnal.CloudCover<<endl;
@@ -414,35 +456,42 @@ void Stability::Set2dWxInitializationAlpha(WindNinjaInputs &input,
     
     cloudCoverGrid = cloud;
     speedGrid = input.surface.windSpeedGrid;
-    
-    alphaField.allocate(&mesh);
+
 	    
     double aspect_temp = 0;	//just placeholder, basically
     double slope_temp = 0;	//just placeholder, basically
 	    
     Solar solar(input.ninjaTime, input.latitude, input.longitude, aspect_temp, slope_temp, input.dem.getAngleFromNorth());
     //solar.print_allSolarPosData();
-	Aspect aspect(&input.dem, input.numberCPUs);
-    Slope slope(&input.dem, input.numberCPUs);
-	Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs);
+	boost::shared_ptr<const Aspect> pAspect = TerrainContext::getAspect(input);
+	const Aspect &aspect = *pAspect;
+    boost::shared_ptr<const Slope> pSlope = TerrainContext::getSlope(input);
+    const Slope &slope = *pSlope;
+	Shade shade(&input.dem, solar.get_theta(), solar.get_phi(), input.dem.getAngleFromNorth(), input.numberCPUs,
+	      TerrainContext::getHorizonMap(input).get());
 	cellDiurnal cDiurnal(&input.dem, &shade, &solar, input.dem.getAngleFromNorth(),
                         input.downDragCoeff, input.downEntrainmentCoeff,
                         input.upDragCoeff, input.upEntrainmentCoeff);
 		
-	for(unsigned int i=0;i<input.dem.get_nRows();i++)
+#pragma omp parallel default(shared)
+	{
+	cellDiurnal threadDiurnal(cDiurnal);  //cellDiurnal keeps the state of its cell
+#pragma omp for
+	for(int i=0;i<input.dem.get_nRows();i++)
 	{
-	    for(unsigned int j=0;j<input.dem.get_nCols();j++)
+	    for(int j=0;j<input.dem.get_nCols();j++)
 	    {
-	        cDiurnal.CloudCover = cloud(i,j);  //set CloudCover in cellDiurnal bfore computing Qsw
-	        cDiurnal.i = i;
-	        cDiurnal.j = j;
-	        cDiurnal.aspect=aspect(i,j);
-	        cDiurnal.slope=slope(i,j);
-	        cDiurnal.compute_solarIntensity();
-	        cDiurnal.compute_Qsw();
-	        QswGrid(i,j) = cDiurnal.Qsw;  // get shortwave radiation for current cell
+	        threadDiurnal.CloudCover = cloud(i,j);  //set CloudCover in cellDiurnal bfore computing Qsw
+	        threadDiurnal.i = i;
+	        threadDiurnal.j = j;
+	        threadDiurnal.aspect=aspect(i,j);
+	        threadDiurnal.slope=slope(i,j);
+	        threadDiurnal.compute_solarIntensity();
+	        threadDiurnal.compute_Qsw();
+	        QswGrid(i,j) = threadDiurnal.Qsw;  // get shortwave radiation for current cell
 	    }
 	}
+	}
 	
 	//QswGrid.write_Grid("QswGrid_2dWxInit", 2);
     //cloudCoverGrid.write_Grid("cloudcover_2dWxInit", 2);
@@ -460,99 +509,104 @@ void Stability::Set2dWxInitializationAlpha(WindNinjaInputs &input,
 
 void Stability::SetAlphaField(const Mesh &mesh)
 {
-    for(unsigned int k=0; k<mesh.nlayers; k++)
+    //alpha only depends on the surface, so it is stored once per column
+    alphaField.allocateColumns(mesh);
+
+    bool badClass = false;
+#pragma omp parallel for default(shared)
+    for(int i=0; i<mesh.nrows; i++)
     {
-        for(unsigned int i=0; i<mesh.nrows; i++)
-        {
-            for(unsigned int j=0; j<mesh.ncols; j++)
-            {	
-                if(QswGrid(i,j) > 600.0)
-                {
-                    if(speedGrid(i,j) < 2.0)
-                        stabilityClass = "A";
-                    else if(speedGrid(i,j)  < 3.0)
-                        stabilityClass = "AB";
-                    else if(speedGrid(i,j) < 5.0)
-                        stabilityClass = "B";
-                    else stabilityClass = "C";
-                }
-                else if(QswGrid(i,j) > 350.0)
-                {
-                    if(speedGrid(i,j) < 2.0)
-                        stabilityClass = "AB";
-                    else if(speedGrid(i,j) < 3.0)
-                        stabilityClass = "B";
-                    else if(speedGrid(i,j) < 5.0)
-                        stabilityClass = "BC";
-                    else if(speedGrid(i,j) < 6.0)
-                        stabilityClass = "CD";
-                    else stabilityClass = "D";
-                }
-                else if(QswGrid(i,j) > 0.0)
-                {
-                    if(speedGrid(i,j) < 2.0)
-                        stabilityClass = "B";
-                    else if(speedGrid(i,j) < 5.0)
-                        stabilityClass = "C";
-                    else stabilityClass = "D";
-                }
-                else if(cloudCoverGrid(i,j) > 0.5)
-                {  
-                    if(speedGrid(i,j) < 3.0)
-                        stabilityClass = "E";
-                    else stabilityClass = "D";
-                }
-                else
-                {
-                    if(speedGrid(i,j) < 3.0)
-                        stabilityClass = "F";
-                    else if(speedGrid(i,j) < 5.0)
-                        stabilityClass = "E";
-                    else stabilityClass = "D";
-                }
-                if(stabilityClass=="A")
-                {
-                    alphaField(i,j,k) = 5.0;
-                }
-                else if(stabilityClass=="AB")
-                {
-                    alphaField(i,j,k) = 4.25;
-                }
-                else if(stabilityClass=="B")
-                {
-                    alphaField(i,j,k) = 3.5;
-                }
-                else if(stabilityClass=="BC")
-                {
-                    alphaField(i,j,k) = 2.75;
-                }
-                else if(stabilityClass=="C")
-                {
-                    alphaField(i,j,k) = 2.0;
-                }   
-                else if(stabilityClass=="CD")
-                {
-                    alphaField(i,j,k) = 1.5;
-                }
-                else if(stabilityClass=="D")
-                {
-                    alphaField(i,j,k) = 1.0;
-                }
-                else if(stabilityClass=="E")
-                {
-                    alphaField(i,j,k) = 0.5;
-                }
-                else if(stabilityClass=="F")
-                {
-                    alphaField(i,j,k) = 0.2;
-                }
-                else
-                {
-                    throw std::out_of_range("stabilityClass out of range in Stability::SetAlphaField()");
-                }
+        std::string stabilityClass; //pasquill stability class
+        for(int j=0; j<mesh.ncols; j++)
+        {	
+            if(QswGrid(i,j) > 600.0)
+            {
+                if(speedGrid(i,j) < 2.0)
+                    stabilityClass = "A";
+                else if(speedGrid(i,j)  < 3.0)
+                    stabilityClass = "AB";
+                else if(speedGrid(i,j) < 5.0)
+                    stabilityClass = "B";
+                else stabilityClass = "C";
+            }
+            else if(QswGrid(i,j) > 350.0)
+            {
+                if(speedGrid(i,j) < 2.0)
+                    stabilityClass = "AB";
+                else if(speedGrid(i,j) < 3.0)
+                    stabilityClass = "B";
+                else if(speedGrid(i,j) < 5.0)
+                    stabilityClass = "BC";
+                else if(speedGrid(i,j) < 6.0)
+                    stabilityClass = "CD";
+                else stabilityClass = "D";
+            }
+            else if(QswGrid(i,j) > 0.0)
+            {
+                if(speedGrid(i,j) < 2.0)
+                    stabilityClass = "B";
+                else if(speedGrid(i,j) < 5.0)
+                    stabilityClass = "C";
+                else stabilityClass = "D";
+            }
+            else if(cloudCoverGrid(i,j) > 0.5)
+            {  
+                if(speedGrid(i,j) < 3.0)
+                    stabilityClass = "E";
+                else stabilityClass = "D";
+            }
+            else
+            {
+                if(speedGrid(i,j) < 3.0)
+                    stabilityClass = "F";
+                else if(speedGrid(i,j) < 5.0)
+                    stabilityClass = "E";
+                else stabilityClass = "D";
+            }
+            if(stabilityClass=="A")
+            {
+                alphaField.column(i,j) = 5.0;
+            }
+            else if(stabilityClass=="AB")
+            {
+                alphaField.column(i,j) = 4.25;
+            }
+            else if(stabilityClass=="B")
+            {
+                alphaField.column(i,j) = 3.5;
+            }
+            else if(stabilityClass=="BC")
+            {
+                alphaField.column(i,j) = 2.75;
+            }
+            else if(stabilityClass=="C")
+            {
+                alphaField.column(i,j) = 2.0;
+            }   
+            else if(stabilityClass=="CD")
+            {
+                alphaField.column(i,j) = 1.5;
+            }
+            else if(stabilityClass=="D")
+            {
+                alphaField.column(i,j) = 1.0;
+            }
+            else if(stabilityClass=="E")
+            {
+                alphaField.column(i,j) = 0.5;
+            }
+            else if(stabilityClass=="F")
+            {
+                alphaField.column(i,j) = 0.2;
+            }
+            else
+            {
+                badClass = true;
             }
         }
     }
+    if(badClass)
+        throw std::out_of_range("stabilityClass out of range in Stability::SetAlphaField()");
     QswGrid.deallocate();
     cloudCoverGrid.deallocate();
     speedGrid.deallocate();
@@ -39,6 +39,7 @@
 #include "wn_3dVectorField.h"
 #include "solar.h"
 #include "cellDiurnal.h"
+#include "alphaField.h"
 
 class Stability{
     public:
@@ -60,7 +61,7 @@ class Stability{
                                         const Mesh &mesh,
                                         const AsciiGrid<double> &cloud);
         double strouhalNumber;
-        wn_3dScalarField alphaField;
+        AlphaField alphaField;
         
         
     private:
@@ -0,0 +1,321 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Read-only terrain shared by the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#include "terrainContext.h"
+
+#include <sstream>
+#include <iomanip>
+
+#include "cpl_conv.h"
+#include "cpl_string.h"
+
+TerrainContext::TerrainContext()
+{
+#ifdef _OPENMP
+    omp_init_lock(&lock);
+#endif
+}
+
+TerrainContext::~TerrainContext()
+{
+#ifdef _OPENMP
+    omp_destroy_lock(&lock);
+#endif
+}
+
+/**
+ * Lock the context for the lifetime of the guard.
+ * @param context Context to lock, may be NULL (nothing is locked).
+ */
+TerrainContext::Guard::Guard(TerrainContext *context)
+{
+    this->context = context;
+#ifdef _OPENMP
+    if(context)
+        omp_set_lock(&context->lock);
+#endif
+}
+
+TerrainContext::Guard::~Guard()
+{
+#ifdef _OPENMP
+    if(context)
+        omp_unset_lock(&context->lock);
+#endif
+}
+
+/**
+ * Key of the terrain of a run: the input file and the vegetation type (used
+ * for the surface properties of files without fuel information).
+ */
+std::string TerrainContext::key(const WindNinjaInputs &input)
+{
+    std::ostringstream os;
+    os << input.dem.fileName << "|" << (int)input.vegetation;
+    return os.str();
+}
+
+std::string TerrainContext::key(const WindNinjaInputs &input, double resolution)
+{
+    std::ostringstream os;
+    os << key(input) << "|" << std::setprecision(17) << resolution;
+    return os.str();
+}
+
+/**
+ * Register a run of an army that will read its terrain from this context,
+ * see releaseInputs().
+ */
+void TerrainContext::addRun(const WindNinjaInputs &input)
+{
+    pendingRuns[key(input)].insert(input.inputsRunNumber);
+}
+
+/**
+ * Copy the terrain as read from the input file into input.
+ * @return false if the file hasn't been read yet.
+ */
+bool TerrainContext::copyInputs(WindNinjaInputs &input) const
+{
+    std::map<std::string, Terrain>::const_iterator it = inputs.find(key(input));
+    if(it == inputs.end())
+        return false;
+    input.dem = *it->second.dem;
+    input.surface = *it->second.surface;
+    return true;
+}
+
+/**
+ * Keep the terrain of input just after it has been read from the file.
+ */
+void TerrainContext::storeInputs(const WindNinjaInputs &input)
+{
+    Terrain &terrain = inputs[key(input)];
+    terrain.dem.reset(new Elevation(input.dem));
+    terrain.surface.reset(new surfProperties(input.surface));
+}
+
+/**
+ * Tell the context a run no longer needs the terrain as read from the input
+ * file, because it has its resampled terrain or has stopped.  Once every run
+ * registered with addRun() for the same file did, the context drops its copy.
+ * Takes the lock itself, so it must not be called under a Guard.
+ * @param input Inputs of the run, nothing is done if they have no context.
+ */
+void TerrainContext::releaseInputs(const WindNinjaInputs &input)
+{
+    if(!input.terrain)
+        return;
+    TerrainContext *context = input.terrain.get();
+    Guard guard(context);
+    std::string inputKey = key(input);
+    std::map<std::string, std::set<int> >::iterator it = context->pendingRuns.find(inputKey);
+    if(it == context->pendingRuns.end())
+        return;
+    it->second.erase(input.inputsRunNumber);
+    if(it->second.empty())
+    {
+        context->pendingRuns.erase(it);
+        context->inputs.erase(inputKey);
+        CPLDebug("NINJA", "Dropped the shared terrain of %s as read", input.dem.fileName.c_str());
+    }
+}
+
+/**
+ * Copy the terrain resampled to a mesh resolution into input.
+ * @return false if it hasn't been resampled to that resolution yet.
+ */
+bool TerrainContext::copyResampled(WindNinjaInputs &input, double resolution) const
+{
+    std::map<std::string, Terrain>::const_iterator it = resampled.find(key(input, resolution));
+    if(it == resampled.end())
+        return false;
+    input.dem = *it->second.dem;
+    input.surface = *it->second.surface;
+    return true;
+}
+
+/**
+ * Keep the terrain of input just after it has been resampled to the mesh
+ * resolution.
+ */
+void TerrainContext::storeResampled(const WindNinjaInputs &input, double resolution)
+{
+    Terrain &terrain = resampled[key(input, resolution)];
+    terrain.dem.reset(new Elevation(input.dem));
+    terrain.surface.reset(new surfProperties(input.surface));
+    terrain.aspect.reset();
+    terrain.slope.reset();
+}
+
+/**
+ * Find the resampled terrain input.dem is a copy of.
+ * @return NULL if there is none.
+ */
+TerrainContext::Terrain *TerrainContext::findResampled(const WindNinjaInputs &input)
+{
+    std::map<std::string, Terrain>::iterator it = resampled.find(key(input, input.dem.get_cellSize()));
+    if(it == resampled.end())
+        return NULL;
+    const Elevation &dem = *it->second.dem;
+    if(dem.get_nRows() != input.dem.get_nRows() || dem.get_nCols() != input.dem.get_nCols() ||
+       dem.get_xllCorner() != input.dem.get_xllCorner() || dem.get_yllCorner() != input.dem.get_yllCorner())
+        return NULL;
+    return &it->second;
+}
+
+/**
+ * Aspect of input.dem.  Runs of an army share the aspect of their resampled
+ * DEM, computed by the first run that asks for it; without a shared terrain
+ * it is computed for the run.
+ */
+boost::shared_ptr<const Aspect> TerrainContext::getAspect(const WindNinjaInputs &input)
+{
+    if(input.terrain)
+    {
+        Guard guard(input.terrain.get());
+        Terrain *terrain = input.terrain->findResampled(input);
+        if(terrain)
+        {
+            if(!terrain->aspect)
+                terrain->aspect.reset(new Aspect(terrain->dem.get(), input.numberCPUs));
+            return terrain->aspect;
+        }
+    }
+    return boost::shared_ptr<const Aspect>(new Aspect(&input.dem, input.numberCPUs));
+}
+
+/**
+ * Slope of input.dem, shared like getAspect().
+ */
+boost::shared_ptr<const Slope> TerrainContext::getSlope(const WindNinjaInputs &input)
+{
+    if(input.terrain)
+    {
+        Guard guard(input.terrain.get());
+        Terrain *terrain = input.terrain->findResampled(input);
+        if(terrain)
+        {
+            if(!terrain->slope)
+                terrain->slope.reset(new Slope(terrain->dem.get(), input.numberCPUs));
+            return terrain->slope;
+        }
+    }
+    return boost::shared_ptr<const Slope>(new Slope(&input.dem, input.numberCPUs));
+}
+
+/**
+ * Horizon map of input.dem for Shade.  Runs of an army share the map of
+ * their resampled DEM, computed by the first run that asks for it with
+ * NINJA_HORIZON_SECTORS (32 by default) sectors.  Building the map costs more
+ * than tracing the shade of a few sun positions, so without a shared terrain,
+ * or with NINJA_SHADE_HORIZON_MAP=FALSE, no map is made and the returned
+ * pointer is empty.
+ */
+boost::shared_ptr<const HorizonMap> TerrainContext::getHorizonMap(const WindNinjaInputs &input)
+{
+    if(input.terrain && CSLTestBoolean(CPLGetConfigOption("NINJA_SHADE_HORIZON_MAP", "TRUE")))
+    {
+        Guard guard(input.terrain.get());
+        Terrain *terrain = input.terrain->findResampled(input);
+        if(terrain)
+        {
+            if(!terrain->horizon)
+            {
+                int numSectors = std::max(1, atoi(CPLGetConfigOption("NINJA_HORIZON_SECTORS", "32")));
+                terrain->horizon.reset(new HorizonMap(*terrain->dem, numSectors));
+            }
+            return terrain->horizon;
+        }
+    }
+    return boost::shared_ptr<const HorizonMap>();
+}
+
+/**
+ * Hilltop and valley bottom tracks of input.dem for cellDiurnal, shared by
+ * the runs of an army like getHorizonMap().  Without a shared terrain the
+ * returned pointer is empty and cellDiurnal tracks the cells it needs.
+ */
+boost::shared_ptr<const HillDistanceMap> TerrainContext::getHillDistances(const WindNinjaInputs &input)
+{
+    if(input.terrain)
+    {
+        Guard guard(input.terrain.get());
+        Terrain *terrain = input.terrain->findResampled(input);
+        if(terrain)
+        {
+            if(!terrain->hillDistances)
+            {
+                if(!terrain->aspect)
+                    terrain->aspect.reset(new Aspect(terrain->dem.get(), input.numberCPUs));
+                if(!terrain->slope)
+                    terrain->slope.reset(new Slope(terrain->dem.get(), input.numberCPUs));
+                terrain->hillDistances.reset(new HillDistanceMap(*terrain->dem, *terrain->aspect,
+                                                                 *terrain->slope));
+            }
+            return terrain->hillDistances;
+        }
+    }
+    return boost::shared_ptr<const HillDistanceMap>();
+}
+
+/**
+ * Plan to interpolate grids with the layout of source onto grids with the
+ * layout of target, see GridRemapPlan.  Runs of an army share the plans of
+ * the last few layouts (NINJA_REMAP_PLAN_CACHE_SIZE, 8 by default), so the
+ * time steps of a forecast army only compute theirs once.
+ */
+boost::shared_ptr<const GridRemapPlan> TerrainContext::getRemapPlan(const WindNinjaInputs &input,
+                                                                    const AsciiGrid<double> &source,
+                                                                    const AsciiGrid<double> &target)
+{
+    if(input.terrain)
+    {
+        Guard guard(input.terrain.get());
+        std::vector<boost::shared_ptr<GridRemapPlan> > &plans = input.terrain->remapPlans;
+        for(unsigned int i = 0; i < plans.size(); i++)
+        {
+            if(plans[i]->matches(source, target))
+            {
+                boost::shared_ptr<GridRemapPlan> plan = plans[i];
+                plans.erase(plans.begin() + i);
+                plans.push_back(plan);
+                return plan;
+            }
+        }
+        boost::shared_ptr<GridRemapPlan> plan(new GridRemapPlan(source, target));
+        plans.push_back(plan);
+        unsigned int maxPlans = std::max(1, atoi(CPLGetConfigOption("NINJA_REMAP_PLAN_CACHE_SIZE", "8")));
+        if(plans.size() > maxPlans)
+            plans.erase(plans.begin());
+        return plan;
+    }
+    return boost::shared_ptr<const GridRemapPlan>(new GridRemapPlan(source, target));
+}
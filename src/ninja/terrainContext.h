@@ -0,0 +1,138 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Project:  WindNinja
+ * Purpose:  Read-only terrain shared by the runs of an army
+ * Author:   agent <agent@local>
+ *
+ ******************************************************************************
+ *
+ * THIS SOFTWARE WAS DEVELOPED AT THE ROCKY MOUNTAIN RESEARCH STATION (RMRS)
+ * MISSOULA FIRE SCIENCES LABORATORY BY EMPLOYEES OF THE FEDERAL GOVERNMENT 
+ * IN THE COURSE OF THEIR OFFICIAL DUTIES. PURSUANT TO TITLE 17 SECTION 105 
+ * OF THE UNITED STATES CODE, THIS SOFTWARE IS NOT SUBJECT TO COPYRIGHT 
+ * PROTECTION AND IS IN THE PUBLIC DOMAIN. RMRS MISSOULA FIRE SCIENCES 
+ * LABORATORY ASSUMES NO RESPONSIBILITY WHATSOEVER FOR ITS USE BY OTHER 
+ * PARTIES,  AND MAKES NO GUARANTEES, EXPRESSED OR IMPLIED, ABOUT ITS QUALITY, 
+ * RELIABILITY, OR ANY OTHER CHARACTERISTIC.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *****************************************************************************/
+
+
+#ifndef TERRAIN_CONTEXT_H
+#define TERRAIN_CONTEXT_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Elevation.h"
+#include "SurfProperties.h"
+#include "Aspect.h"
+#include "Slope.h"
+#include "WindNinjaInputs.h"
+#include "gridRemapPlan.h"
+#include "horizonMap.h"
+#include "hillDistanceMap.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/shared_ptr.hpp>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Terrain shared by the runs of an army.  It holds the DEM and surface
+ * properties as read from the input file, their versions resampled to the
+ * mesh resolutions used, the slope, aspect, horizon map and hill distance
+ * tracks of the resampled DEMs and the plans that interpolate weather model
+ * grids onto them.
+ * The first run that needs a piece computes it and the other runs copy it
+ * (the mesh resamples the DEM and surface of a run in place, so each run
+ * still has its own copy in WindNinjaInputs) or borrow it (slope, aspect,
+ * horizon map and hill distances).  The context only holds read-only grids.
+ * Entries are kept per input file and vegetation type, so an army with
+ * several DEMs still works.
+ *
+ * Runs registered with addRun() drop the DEM and surface as read from the
+ * file once every one of them has its resampled terrain (or has stopped),
+ * so the context doesn't hold both versions for the whole army.
+ *
+ * Runs get the context through WindNinjaInputs::terrain, set by
+ * ninjaArmy::startRuns().  A Guard must be held around the copy or store
+ * calls, which makes the first run do the work while the others wait.
+ */
+class TerrainContext
+{
+public:
+    TerrainContext();
+    ~TerrainContext();
+
+    class Guard
+    {
+    public:
+        Guard(TerrainContext *context);
+        ~Guard();
+    private:
+        TerrainContext *context;
+        Guard(const Guard &);
+        Guard &operator=(const Guard &);
+    };
+
+    void addRun(const WindNinjaInputs &input);
+    bool copyInputs(WindNinjaInputs &input) const;
+    void storeInputs(const WindNinjaInputs &input);
+    bool copyResampled(WindNinjaInputs &input, double resolution) const;
+    void storeResampled(const WindNinjaInputs &input, double resolution);
+
+    static void releaseInputs(const WindNinjaInputs &input);
+
+    static boost::shared_ptr<const Aspect> getAspect(const WindNinjaInputs &input);
+    static boost::shared_ptr<const Slope> getSlope(const WindNinjaInputs &input);
+    static boost::shared_ptr<const HorizonMap> getHorizonMap(const WindNinjaInputs &input);
+    static boost::shared_ptr<const HillDistanceMap> getHillDistances(const WindNinjaInputs &input);
+    static boost::shared_ptr<const GridRemapPlan> getRemapPlan(const WindNinjaInputs &input,
+                                                               const AsciiGrid<double> &source,
+                                                               const AsciiGrid<double> &target);
+
+private:
+    struct Terrain
+    {
+        boost::shared_ptr<const Elevation> dem;
+        boost::shared_ptr<const surfProperties> surface;
+        boost::shared_ptr<Aspect> aspect;   //only made for resampled terrain
+        boost::shared_ptr<Slope> slope;
+        boost::shared_ptr<HorizonMap> horizon;
+        boost::shared_ptr<HillDistanceMap> hillDistances;
+    };
+
+    std::map<std::string, Terrain> inputs;      //as read, by key()
+    std::map<std::string, Terrain> resampled;   //by key() and resolution
+    std::map<std::string, std::set<int> > pendingRuns;   //runs still needing inputs, by key()
+    std::vector<boost::shared_ptr<GridRemapPlan> > remapPlans;   //most recently used last
+
+    static std::string key(const WindNinjaInputs &input);
+    static std::string key(const WindNinjaInputs &input, double resolution);
+    Terrain *findResampled(const WindNinjaInputs &input);
+
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+
+    TerrainContext(const TerrainContext &);
+    TerrainContext &operator=(const TerrainContext &);
+};
+
+#endif /* TERRAIN_CONTEXT_H */
@@ -41,6 +41,10 @@ windProfile::windProfile()
 	ObukovLength = 0.0;
 	ABL_height = 0.0; 
 	powerLawPower = 0.143;			//for Askervein study...?
+	inwindheight = 0.0;
+	colDenominator = 1.0;
+	colFactor7z0 = 0.0;
+	colFactorABL = 0.0;
 }
 
 windProfile::~windProfile()
@@ -143,7 +147,7 @@ double windProfile::monin_obukov(double z, double const& U1, double const& z1, d
 	return speed;
 }
 
-double windProfile::stability_function(double const& z_over_L, double const& L_switch)
+double windProfile::stability_function(double const& z_over_L, double const& L_switch) const
 {	//function that computes the stability function for the vertical wind profile (similarity theory)
 	//z_over_L is the height divided by the Monin-Obukov length
 	//L_switch indicates the sign of the Monin-Obukov length (either positive value for stable or negative value for unstable)
@@ -163,3 +167,76 @@ double windProfile::stability_function(double const& z_over_L, double const& L_s
 
 	return value;
 }
+
+/**
+ * Compute the parts of the profile that are the same for every height of a
+ * column: the profile at the input wind height and, for Monin-Obukov
+ * similarity, the shape factors at 7*z0 and at the ABL top.  Every profile
+ * is proportional to inputWindSpeed, so getShapeFactor() then gives the
+ * speed at a height for any input speed (u and v alike) with one log.
+ */
+void windProfile::setColumn()
+{
+	inwindheight = (inputWindHeight + Rough_h) - (Rough_d);	//height of input wind (from z=0 of log profile)
+	colDenominator = 1.0;
+	colFactor7z0 = 0.0;
+	colFactorABL = 0.0;
+
+	if(profile_switch==logarithmic)
+	{
+		colDenominator = log((inwindheight)/Roughness);
+	}else if(profile_switch==monin_obukov_similarity && inwindheight >= 3.0*Roughness)
+	{
+		double z1 = inwindheight;
+		assert(z1/Roughness >= 1);
+		if(ObukovLength == 0.0)
+			colDenominator = log(z1/Roughness);
+		else
+			colDenominator = log(z1/Roughness)-stability_function(z1/ObukovLength,ObukovLength);
+		colFactor7z0 = monin_obukov_factor(7.0*Roughness);
+		if(ABL_height > 0.0)
+			colFactorABL = monin_obukov_factor(ABL_height);
+	}
+}
+
+/**
+ * Shape factor of the profile set by setColumn(): the wind speed at height
+ * agl (above THE GROUND) divided by inputWindSpeed, as getWindSpeed().
+ */
+double windProfile::getShapeFactor(double const& agl) const
+{
+	if(agl==0.0)
+		return 0.0;
+
+	if(profile_switch==uniform)
+	{
+		return 1.0;
+	}else if(profile_switch==logarithmic)
+	{
+		if(agl < (Rough_d + Roughness))	//below the log profile
+			return 0.0;
+		return log((agl-Rough_d)/Roughness)/colDenominator;
+	}else if(profile_switch==power_law_askervein)
+	{
+		return std::pow((agl/inputWindHeight),powerLawPower);
+	}else if(profile_switch==monin_obukov_similarity)
+	{
+		if(inwindheight < 3.0*Roughness)	//see getWindSpeed()
+			return agl/(inwindheight + Rough_d);
+		if(agl < (Rough_d + 7.0*Roughness))	//linearly interpolate below 7*z0
+			return colFactor7z0 * (agl/(7.0*Roughness + Rough_d));
+		if(agl < (Rough_d + ABL_height))
+			return monin_obukov_factor(agl - Rough_d);
+		return colFactorABL;	//above the ABL
+	}else
+	    throw std::runtime_error("Could not identify profile switch.\n");
+}
+
+double windProfile::monin_obukov_factor(double z) const
+{
+    if(z/Roughness<1)  //see monin_obukov()
+        z = Roughness;
+	if(ObukovLength == 0.0)
+		return log(z/Roughness)/colDenominator;
+	return (log(z/Roughness)-stability_function(z/ObukovLength,ObukovLength))/colDenominator;
+}
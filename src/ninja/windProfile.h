@@ -62,12 +62,21 @@ class windProfile
 
 		double getWindSpeed();		//function returns wind velocity given the inputs (profile_switch, AGL, etc...)
         double monin_obukov(double z, double const& U1, double const& z1, double const& z0, double const& L);
-		double stability_function(double const& z_over_L, double const& L_switch);
+		double stability_function(double const& z_over_L, double const& L_switch) const;
+
+		//column form of getWindSpeed(), for many heights and speeds in one column
+		void setColumn();			//call after setting everything but AGL and inputWindSpeed
+		double getShapeFactor(double const& agl) const;	//getWindSpeed()/inputWindSpeed at height agl
 
 	private:
 		double inwindheight;		//height of input wind (from z=0 of log profile)
 		double velocity;			//velocity computed at height AGL
 		double vel7z0;				//used in monin_obukov_similarity
+
+		double colDenominator;		//profile at the input wind height, set by setColumn()
+		double colFactor7z0;		//shape factor at 7*z0, monin_obukov_similarity only
+		double colFactorABL;		//shape factor at the ABL top, monin_obukov_similarity only
+		double monin_obukov_factor(double z) const;
 };
 
 #endif /* WIND_PROFILE_H */
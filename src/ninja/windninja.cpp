@@ -589,6 +589,231 @@ WINDNINJADLL_EXPORT NinjaErr NinjaStartRuns
     return NINJA_SUCCESS;
 }
 
+/**
+ * \brief Start the simulations in the background.
+ *
+ * Returns at once; the runs go on in a thread of their own.  As each run
+ * finishes, pfnRunComplete is called from the thread of that run with
+ * read-only views of its output grids (see ninjaRunResult), valid only
+ * during the call, so the results of the first runs can be used while the
+ * later ones still solve.  Several runs may call it at the same time.  Runs
+ * that fail call it too, with an error status and no grids.
+ *
+ * Follow the runs with NinjaPollRuns(), stop them with NinjaCancel(), and
+ * call NinjaWaitRuns() before using or destroying the army.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nprocessors number of processors to use when compiled with OpenMP
+ *                    support.
+ * \param pfnRunComplete Function called as each run finishes, may be NULL.
+ * \param pUser Passed to pfnRunComplete.
+ * \param uvwFlag Also hand over the u, v and w grids at the output height.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaStartRunsAsync
+    ( NinjaArmyH * army, const unsigned int nprocessors, ninjaRunCompleteHandler pfnRunComplete,
+      void *pUser, const bool uvwFlag, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        ninjaArmy *a = reinterpret_cast<ninjaArmy*>( army );
+        int nFinished;
+        if( !a->pollRuns( nFinished ) )
+        {
+            return NINJA_E_INVALID;
+        }
+        a->setRunCompleteHandler( pfnRunComplete, pUser, uvwFlag );
+        return a->startRunsAsync( nprocessors );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Check on the simulations started by NinjaStartRunsAsync().
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nFinishedRuns Set to the number of runs finished so far.
+ * \param finished Set to true once all runs are done, NinjaWaitRuns() then
+ *                 returns at once.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaPollRuns
+    ( NinjaArmyH * army, int * nFinishedRuns, bool * finished, char ** papszOptions )
+{
+    if( NULL != army && NULL != nFinishedRuns && NULL != finished )
+    {
+        int nFinished;
+        *finished = reinterpret_cast<ninjaArmy*>( army )->pollRuns( nFinished );
+        *nFinishedRuns = nFinished;
+        return NINJA_SUCCESS;
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Wait for the simulations started by NinjaStartRunsAsync().
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ *
+ * \return NINJA_SUCCESS if all runs succeeded, NINJA_E_CANCELLED if they
+ *         were cancelled, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaWaitRuns
+    ( NinjaArmyH * army, char ** papszOptions )
+{
+    if(!army)
+    {
+        return NINJA_E_NULL_PTR;
+    }
+
+    try
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->waitRuns() ? NINJA_SUCCESS : NINJA_E_OTHER;
+    }
+    catch( ... )
+    {
+        return handleException();
+    }
+}
+
+/**
+ * \brief Set the memory budget for runs going at the same time.
+ *
+ * NinjaStartRuns() estimates the peak memory of each run and starts no more
+ * runs at once than fit in the budget, the others wait until a run finishes.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param megabytes Memory budget in MB, -1 to use 80% of the usable RAM.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetMemoryBudget
+    ( NinjaArmyH * army, const double megabytes, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setMemoryBudget( megabytes );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Write the output files in background threads.
+ *
+ * A finished run hands its output grids to a writer and NinjaStartRuns()
+ * goes on with the next run.  NinjaStartRuns() waits for the writers before
+ * returning.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nWriters Number of writer threads, 0 to write the files in the run.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetOutputWriters
+    ( NinjaArmyH * army, const int nWriters, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setOutputWriters( nWriters );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Reuse the output grids of identical earlier runs.
+ *
+ * Runs found in the cache directory only write their output files, other
+ * runs store their output grids in it.  The least recently used entries are
+ * removed to keep the directory under the given size.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param directory Cache directory, created if needed.  NULL or empty turns
+ *                  the cache off.
+ * \param megabytes Size the directory is kept under, in MB.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetResultCache
+    ( NinjaArmyH * army, const char * directory, const double megabytes, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setResultCache( directory ? directory : "", megabytes );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Write per cell statistics of the output grids of the runs.
+ *
+ * The output speed and direction grids of each run are folded into the
+ * statistics as the runs finish, so memory doesn't grow with the number of
+ * runs.  The mean, standard deviation, maximum and percentiles of the speed
+ * and the circular mean of the direction are written as ascii grids named
+ * <dem>_ensemble_*.asc in the output directory when all runs are done.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param flag 1 to write the statistics, 0 not to.
+ * \param percentiles Comma separated speed percentiles, e.g. "50,90".
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetEnsembleStats
+    ( NinjaArmyH * army, const int flag, const char * percentiles, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setEnsembleStats( flag, percentiles ? percentiles : "" );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Resume an army that was stopped.
+ *
+ * A journal of the finished runs is kept in each output directory.  Runs
+ * recorded with the same inputs and unchanged output files are skipped, so
+ * starting a stopped army again only does the missing runs.  Runs that
+ * keep their output grids in memory are not journaled.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param flag 1 to skip the recorded runs, 0 to do all runs.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetResume
+    ( NinjaArmyH * army, const int flag, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setResume( flag );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
 /**
  * \brief Set the initialization method.
  *
@@ -669,6 +894,118 @@ WINDNINJADLL_EXPORT NinjaErr NinjaSetNumberCPUs
     }
 }
 
+/**
+ * \brief Set the stopping tolerance of the solver.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to apply the setting to.
+ * \param tol Tolerance on the 2-norm of the residual relative to the right
+ *            hand side, default is 1E-1.  Larger values give faster, less
+ *            accurate solutions.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverTolerance
+    ( NinjaArmyH * army, const int nIndex, const double tol, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setSolverTolerance( nIndex, tol );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Set an iteration and time budget for the solver.
+ *
+ * When either budget is used up the current solution is kept and a warning
+ * is sent instead of failing the run, for fast preview runs.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to apply the setting to.
+ * \param maxIterations Maximum iterations per solve, -1 for no budget.
+ * \param timeLimit Maximum time spent iterating per solve in seconds, -1 for
+ *                  no limit.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverIterationBudget
+    ( NinjaArmyH * army, const int nIndex, const int maxIterations,
+      const double timeLimit, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setSolverIterationBudget
+            ( nIndex, maxIterations, timeLimit );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Stop the solver when the wind at the output height has converged.
+ *
+ * The horizontal wind at the output wind height is checked periodically
+ * during the solve, and the solve stops when it changes less than tol
+ * between checks.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to apply the setting to.
+ * \param tol Largest change in wind speed between checks, -1 to turn off.
+ * \param units Units of tol ("mph", "mps", "kph", "kts").
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverSurfaceWindTolerance
+    ( NinjaArmyH * army, const int nIndex, const double tol,
+      const char * units, char ** papszOptions )
+{
+    if( NULL != army && NULL != units )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setSolverSurfaceWindTolerance
+            ( nIndex, tol, std::string( units ) );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Recycle a deflation space between solves.
+ *
+ * The runs of the army that recycle share a small set of approximate
+ * eigenvectors of the stiffness matrix.  They are deflated out of each CG
+ * solve and refined afterwards, so later runs on the same mesh (and the
+ * repeated solves of matching runs) need fewer iterations.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to apply the setting to.
+ * \param flag 1 to recycle, 0 to turn recycling off.
+ * \param nVectors Number of deflation vectors kept, 8 is a good start.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverRecycling
+    ( NinjaArmyH * army, const int nIndex, const int flag,
+      const int nVectors, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setSolverRecycling
+            ( nIndex, flag != 0, nVectors );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
 /**
  * \brief Set a ninjaComMessageHandler callback function, for message communications during simulations, to the ninjaArmy level ninjaCom.
  *
@@ -1694,6 +2031,110 @@ WINDNINJADLL_EXPORT const int NinjaGetOutputGridnRows
     }
 }
 
+/**
+ * \brief Get a summary of the solver statistics from a simulation.
+ *
+ * Totals are over all the solves of the run (runs matching weather stations
+ * solve more than once).  Any of the output pointers can be NULL.
+ *
+ * \see NinjaGetSolverStatsJson
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to get the statistics from.
+ * \param nSolves Number of solves.
+ * \param nIterations Total number of solver iterations.
+ * \param initialResidual Initial relative residual of the first solve.
+ * \param finalResidual Final relative residual of the last solve.
+ * \param setupTime Total solver setup time in seconds.
+ * \param iterationTime Total time spent iterating in seconds.
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaGetSolverStats
+    ( NinjaArmyH * army, const int nIndex, int * nSolves, int * nIterations,
+      double * initialResidual, double * finalResidual,
+      double * setupTime, double * iterationTime, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        try
+        {
+            return reinterpret_cast<ninjaArmy*>( army )->getSolverStats( nIndex,
+                    nSolves, nIterations, initialResidual, finalResidual,
+                    setupTime, iterationTime );
+        }
+        catch( ... )
+        {
+            return handleException();
+        }
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
+/**
+ * \brief Get the full solver statistics from a simulation as JSON.
+ *
+ * The document has one entry per solve with the solver and preconditioner
+ * used, matrix size and storage, iteration count, initial and final residual,
+ * setup and iteration times, and the residual history.
+ *
+ * \see NinjaGetSolverStats
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to get the statistics from.
+ *
+ * \return The JSON document, owned by the army and valid until the run is
+ *         started again or the army is destroyed.  NULL on error.
+ */
+WINDNINJADLL_EXPORT const char* NinjaGetSolverStatsJson
+    ( NinjaArmyH * army, const int nIndex, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        try
+        {
+            return reinterpret_cast<ninjaArmy*>( army )->getSolverStatsJson( nIndex );
+        }
+        catch( ... )
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
+/**
+ * \brief Set the flag to write the solver statistics for a simulation.
+ *
+ * The statistics are written as JSON to a *_solver.json file beside the
+ * other output files.
+ *
+ * \param army An opaque handle to a valid ninjaArmy.
+ * \param nIndex The run to apply the setting to.
+ * \param flag The flag which determines whether or not the solver statistics
+ *             will be written (0 = no, 1 = yes).
+ *
+ * \return NINJA_SUCCESS on success, non-zero otherwise.
+ */
+WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverStatsOutFlag
+    ( NinjaArmyH * army, const int nIndex, const bool flag, char ** papszOptions )
+{
+    if( NULL != army )
+    {
+        return reinterpret_cast<ninjaArmy*>( army )->setSolverStatsOutFlag( nIndex, flag );
+    }
+    else
+    {
+        return NINJA_E_NULL_PTR;
+    }
+}
+
 /**
  * \brief Set the output buffer clipping for a simulation.
  *
@@ -1733,8 +2174,7 @@ WINDNINJADLL_EXPORT NinjaErr NinjaSetStationKML
     {
         try
         {
-            wxStation::writeKmlFile( reinterpret_cast<ninjaArmy*>( army )->getWxStations(nIndex), demFileName, outputDirectory, velocityUnits::getUnit(outputSpeedUnits));
-            return NINJA_SUCCESS;
+            return reinterpret_cast<ninjaArmy*>( army )->writeStationKml( nIndex, demFileName, outputDirectory, velocityUnits::getUnit(outputSpeedUnits) );
         }
         catch (const std::exception& e)
         {
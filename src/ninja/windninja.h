@@ -146,6 +146,31 @@ typedef int  NinjaErr;
     WINDNINJADLL_EXPORT NinjaErr NinjaStartRuns
         ( NinjaArmyH * ninjaArmy, const unsigned int nprocessors, char ** options );
 
+    WINDNINJADLL_EXPORT NinjaErr NinjaStartRunsAsync
+        ( NinjaArmyH * ninjaArmy, const unsigned int nprocessors, ninjaRunCompleteHandler pfnRunComplete,
+          void *pUser, const bool uvwFlag, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaPollRuns
+        ( NinjaArmyH * ninjaArmy, int * nFinishedRuns, bool * finished, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaWaitRuns
+        ( NinjaArmyH * ninjaArmy, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetMemoryBudget
+        ( NinjaArmyH * ninjaArmy, const double megabytes, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetOutputWriters
+        ( NinjaArmyH * ninjaArmy, const int nWriters, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetResultCache
+        ( NinjaArmyH * ninjaArmy, const char * directory, const double megabytes, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetResume
+        ( NinjaArmyH * ninjaArmy, const int flag, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetEnsembleStats
+        ( NinjaArmyH * ninjaArmy, const int flag, const char * percentiles, char ** options );
+
     /*-----------------------------------------------------------------------------
      *  Various Simulation Parameters
      *-----------------------------------------------------------------------------*/
@@ -165,6 +190,19 @@ typedef int  NinjaErr;
     WINDNINJADLL_EXPORT NinjaErr NinjaSetNumberCPUs
         ( NinjaArmyH * ninjaArmy, const int nIndex, const int nCPUs, char ** options );
 
+    /*  Solver stopping policy  */
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverTolerance
+        ( NinjaArmyH * ninjaArmy, const int nIndex, const double tol, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverIterationBudget
+        ( NinjaArmyH * ninjaArmy, const int nIndex, const int maxIterations, const double timeLimit, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverSurfaceWindTolerance
+        ( NinjaArmyH * ninjaArmy, const int nIndex, const double tol, const char * units, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverRecycling
+        ( NinjaArmyH * ninjaArmy, const int nIndex, const int flag, const int nVectors, char ** options );
+
     /*  Communication  */
     WINDNINJADLL_EXPORT NinjaErr NinjaSetArmyComMessageHandler
         ( NinjaArmyH * ninjaArmy, ninjaComMessageHandler pMsgHandler, void *pUser, char ** options );
@@ -311,6 +349,17 @@ typedef int  NinjaErr;
     WINDNINJADLL_EXPORT const int NinjaGetOutputGridnRows
         ( NinjaArmyH * ninjaArmy, const int nIndex, char ** options );
 
+    WINDNINJADLL_EXPORT NinjaErr NinjaGetSolverStats
+        ( NinjaArmyH * ninjaArmy, const int nIndex, int * nSolves, int * nIterations,
+          double * initialResidual, double * finalResidual,
+          double * setupTime, double * iterationTime, char ** options );
+
+    WINDNINJADLL_EXPORT const char* NinjaGetSolverStatsJson
+        ( NinjaArmyH * ninjaArmy, const int nIndex, char ** options );
+
+    WINDNINJADLL_EXPORT NinjaErr NinjaSetSolverStatsOutFlag
+        ( NinjaArmyH * ninjaArmy, const int nIndex, const bool flag, char ** options );
+
     WINDNINJADLL_EXPORT NinjaErr NinjaSetOutputBufferClipping
         ( NinjaArmyH * ninjaArmy, const int nIndex, const double percent, char ** options );
 
@@ -29,6 +29,7 @@
  *****************************************************************************/
 
 #include "wn_3dScalarField.h"
+#include "meshRemapPlan.h"
 
 wn_3dScalarField::wn_3dScalarField()
 {
@@ -86,6 +87,8 @@ void wn_3dScalarField::deallocate()
 
 /**
  * @brief Interpolate a wn_3dScalarField from one mesh to another.
+ * Fields that share a mesh should share a MeshRemapPlan instead, it locates
+ * the nodes of the new mesh once for all of them.
  * @param newScalarData The new wn_3dScalarField to be populated.
  * @param mesh WindNinja mesh.
  * @param input WindNinja inputs.
@@ -95,354 +98,8 @@ void wn_3dScalarField::interpolateScalarData(wn_3dScalarField &newScalarData,
                                              Mesh const& mesh,
                                              WindNinjaInputs const& input)
 {
-    element elem(&mesh);
-    element elem_wx(this->mesh_);
-
-	int wx_i; //element index for wx model
-	int elem_wx_i, elem_wx_j, elem_wx_k; // wx model cells
-    int elem_i, elem_j, elem_k; // wn cells
-
-    double x, y, z, x_wx, y_wx, z_wx;
-    double u, v, w;
-    double u_wx, v_wx, w_wx;
-
-    AsciiGrid<double> wnNormDistanceGrid; // stores normalizing distances for WN grid
-    AsciiGrid<double> wxNormDistanceGrid; // stores normalizeing distances for WX grid
-    
-    wnNormDistanceGrid.set_noDataValue(-9999.0);
-    wnNormDistanceGrid.set_headerData(mesh.ncols, mesh.nrows,
-                            mesh.XORD(0,0,0), mesh.YORD(0,0,0),
-                            mesh.meshResolution, -9999.0, 0.0,
-                            input.dem.prjString.c_str());
-    
-    wxNormDistanceGrid.set_noDataValue(-9999.0);
-    wxNormDistanceGrid.set_headerData(mesh.ncols, mesh.nrows,
-                            mesh.XORD(0,0,0), mesh.YORD(0,0,0),
-                            mesh.meshResolution, -9999.0, 0.0,
-                            input.dem.prjString.c_str());
-
-    wnNormDistanceGrid = -1;
-    wxNormDistanceGrid = -1;
-
-    int elemNum;
-    double normDist; //normalized distance to WN top height (0-1)
-
-    /*
-     * populate wnNormDistanceGrid and wxNormDistanceGrid
-     * requires looping through WN gorund nodes to find
-     * WN node locations in the WX mesh so we can find elevations
-     */
-
-    for(int i=0; i<mesh.nrows; i++){
-        for(int j=0; j<mesh.ncols; j++){
-            wnNormDistanceGrid(i,j) = mesh.ZORD(i,j,mesh.nlayers-1) - mesh.ZORD(i,j,0); //distance from WN ground to Ztop
-
-            if(i == mesh.nrows-1 || j == mesh.ncols-1){
-                continue;
-            }
-            elemNum = mesh.get_elemNum(i,j,0); // get element number in WN mesh for i,j
-            elem.get_xyz(elemNum, -1, -1, -1, x, y, z); // get x,y,z for local node 0
-            elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get i,j and u,v coordinates at x,y
-            elem_wx_k = 0;
-            wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-            elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-            wxNormDistanceGrid(i,j) = mesh.ZORD(i,j,mesh.nlayers-1) - z_wx; //distance from WX ground to Ztop
-
-            if(i == mesh.nrows-2 && j == mesh.ncols-2){ //if at upper right corner
-                elem.get_xyz(elemNum, 1, -1, -1, x, y, z); // get x,y,z for local node 1
-                elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get i,j and u,v coordinates at x,y
-                elem_wx_k = 0;
-                wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-                elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-                wxNormDistanceGrid(i,j+1) = mesh.ZORD(i,j+1,mesh.nlayers-1) - z_wx; //distance from WX ground to Ztop
-
-                elem.get_xyz(elemNum, 1, 1, -1, x, y, z); // get x,y,z for local node 2
-                elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get i,j and u,v coordinates at x,y
-                elem_wx_k = 0;
-                wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-                elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-                wxNormDistanceGrid(i+1,j+1) = mesh.ZORD(i+1,j+1,mesh.nlayers-1) - z_wx; //distance from WX ground to Ztop
-
-                elem.get_xyz(elemNum, -1, 1, -1, x, y, z); // get x,y,z for local node 3
-                elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get i,j and u,v coordinates at x,y
-                elem_wx_k = 0;
-                wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-                elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-                wxNormDistanceGrid(i+1,j) = mesh.ZORD(i+1,j,mesh.nlayers-1) - z_wx; //distance from WX ground to Ztop
-            }
-            else if(i == mesh.nrows-2){ //get top-most row elevations
-                elem.get_xyz(elemNum, -1, 1, -1, x, y, z); // get x,y,z for local node 3
-                elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get i,j and u,v coordinates at x,y
-                elem_wx_k = 0;
-                wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-                elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-                wxNormDistanceGrid(i+1,j) = mesh.ZORD(i+1,j,mesh.nlayers-1) - z_wx; //distance from WX ground to Ztop
-            }
-            else if(j == mesh.ncols-2){ //get right-most column elevations
-                elem.get_xyz(elemNum, 1, -1, -1, x, y, z); // get x,y,z for local node 1
-                elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get i,j and u,v coordinates at x,y
-                elem_wx_k = 0;
-                wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-                elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-                wxNormDistanceGrid(i,j+1) = mesh.ZORD(i,j+1,mesh.nlayers-1) - z_wx; //distance from WX ground to Ztop
-            }
-        }
-    }//wnNormDistanceGrid.write_Grid("wnNormDistGrid", 2);
-    //wxNormDistanceGrid.write_Grid("wxNormDistGrid", 2);
-
-    wn_3dScalarField heightAboveGround;
-    heightAboveGround.allocate(&mesh);
-
-    for(int i = 0; i < mesh.nrows; i++){
-        for(int j = 0; j < mesh.ncols; j++){
-            for(int k = 0; k < mesh.nlayers; k++){
-                heightAboveGround(i,j,k) = mesh.ZORD(i,j,k) - mesh.ZORD(i,j,0);
-            }
-        }
-    }
-
-    for(int i = 0; i < mesh.NUMEL; i++){       // Start loop over elements in WN mesh
-        mesh.get_elemIndex(i, elem_i, elem_j, elem_k);  // get i,j,k index for element i in WN mesh
-
-        if(elem_k != 0 && elem_k % 2 != 0){ //only loop over even layers of elements so we don't interpolate same nodes twice
-            if(elem_k != mesh.nlayersElem -1){ // loop through last layer no matter what to get topmost nodes
-                continue;
-            }
-        }
-        if(elem_i != 0 && elem_i % 2 != 0){ //only loop over even rows of elements so we don't interpolate same nodes twice
-            if(elem_i != mesh.nrowsElem - 1){ // loop through last row no matter what to get topmost nodes
-                continue;
-            }
-        }
-
-        //----- node 0 -------------------------------------------------------
-        elem.get_xyz(i, -1.0, -1.0, -1.0, x, y, z); // get x,y,z for local node 0
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1.0, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-       /*
-        * Normalized Distance Method
-        */
-
-        normDist = heightAboveGround(elem_i, elem_j, elem_k)/wnNormDistanceGrid(elem_i, elem_j); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i, elem_j); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-        
-
-        if(elem_k == 0){// don't interpolate over ground nodes in layer 0 of WN mesh
-            newScalarData(elem_i, elem_j, elem_k) = -9999.0;
-        }
-        else{ 
-            elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-        }
-        
-
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i, elem_j, elem_k) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i, elem_j, elem_k) = this->interpolate(x, y, z);
-        }
-
-        //----- node 1 -------------------------------------------------------
-        elem.get_xyz(i, 1, -1, -1, x, y, z); // get x,y,z for local node 1
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i, elem_j+1, elem_k)/wnNormDistanceGrid(elem_i, elem_j+1); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i, elem_j+1); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-        
-        if(elem_k == 0){ // don't interpolate over ground nodes in layer 0 of WN mesh
-            newScalarData(elem_i, elem_j+1, elem_k) = -9999.0;
-        }
-        else{ 
-            elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-        }
-        
-        
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i, elem_j+1, elem_k) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i, elem_j+1, elem_k) = this->interpolate(x, y, z);
-        }
-
-        //----- node 2 -------------------------------------------------------
-        elem.get_xyz(i, 1, 1, -1, x, y, z); // get x,y,z for local node 2
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
- 
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i+1, elem_j+1, elem_k)/wnNormDistanceGrid(elem_i+1, elem_j+1); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i+1, elem_j+1); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-                
-        if(elem_k == 0){ // don't interpolate over ground nodes in layer 0 of WN mesh
-            newScalarData(elem_i+1, elem_j+1, elem_k) = -9999.0;
-        }
-        else{ 
-            elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-        }
-        
-        
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i+1, elem_j+1, elem_k) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i+1, elem_j+1, elem_k) = this->interpolate(x, y, z);
-        }
-
-        //----- node 3 -------------------------------------------------------
-        elem.get_xyz(i, -1, 1, -1, x, y, z); // get x,y,z for local node 3
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates       
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i+1, elem_j, elem_k)/wnNormDistanceGrid(elem_i+1, elem_j); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i+1, elem_j); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-        
-        if(elem_k == 0){ // don't interpolate over ground nodes in layer 0 of WN mesh
-            newScalarData(elem_i+1, elem_j, elem_k) = -9999.0;
-        }
-        else{ 
-            elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-        }
-        
-
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i+1, elem_j, elem_k) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i+1, elem_j, elem_k) = this->interpolate(x, y, z);
-        }
-
-        //----- node 4 -------------------------------------------------------
-        elem.get_xyz(i, -1, -1, 1, x, y, z); // get x,y,z for local node 4
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates       
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i, elem_j, elem_k+1)/wnNormDistanceGrid(elem_i, elem_j); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i, elem_j); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-
-        elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i, elem_j, elem_k+1) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i, elem_j, elem_k+1) = this->interpolate(x, y, z);
-        }
-
-        //----- node 5 -------------------------------------------------------
-        elem.get_xyz(i, 1, -1, 1, x, y, z); // get x,y,z for local node 5
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i, elem_j+1, elem_k+1)/wnNormDistanceGrid(elem_i, elem_j+1); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i, elem_j+1); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-
-        elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i, elem_j+1, elem_k+1) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i, elem_j+1, elem_k+1) = this->interpolate(x, y, z);
-        }
-
-        //----- node 6 -------------------------------------------------------
-        elem.get_xyz(i, 1, 1, 1, x, y, z); // get x,y,z for local node 6
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i+1, elem_j+1, elem_k+1)/wnNormDistanceGrid(elem_i+1, elem_j+1); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i+1, elem_j+1); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-
-        elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i+1, elem_j+1, elem_k+1) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i+1, elem_j+1, elem_k+1) = this->interpolate(x, y, z);
-        }
-
-        //----- node 7 -------------------------------------------------------
-        elem.get_xyz(i, -1, 1, 1, x, y, z); // get x,y,z for local node 7
-        elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates
-        elem_wx_k = 0;
-        wx_i = this->mesh_->get_elemNum(elem_wx_i, elem_wx_j, elem_wx_k);
-        elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
-
-
-        /*
-         * Normalized Distance Method
-         */
-
-        normDist = heightAboveGround(elem_i+1, elem_j, elem_k+1)/wnNormDistanceGrid(elem_i+1, elem_j); //compute normalized distance (0-1)
-        z = normDist * wxNormDistanceGrid(elem_i+1, elem_j); //compute height above ground in wx mesh
-        z += z_wx; // add height above ground to wx model ground height
-
-        elem_wx.get_uvw(x, y, z, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx);
-
-        if(elem_wx_k < 1){ //use log profile to fill below here later
-            newScalarData(elem_i+1, elem_j, elem_k+1) = -9999.0;
-        }
-        else{
-            newScalarData(elem_i+1, elem_j, elem_k+1) = this->interpolate(x, y, z);
-        }
-    }
-
-    heightAboveGround.deallocate();
-    wnNormDistanceGrid.deallocate();
-    wxNormDistanceGrid.deallocate();
+    MeshRemapPlan plan(*mesh_, mesh);
+    plan.apply(*this, newScalarData);
 }
 
 double wn_3dScalarField::interpolate(double const& x,double const& y, double const& z)
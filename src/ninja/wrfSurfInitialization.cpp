@@ -716,7 +716,7 @@ void wrfSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
     GDALClose((GDALDatasetH) poDS); // close original wxModel file
 
     // open ds one by one, set geotranform, set projection, warp, then write to grid
-    GDALDataset *srcDS, *wrpDS;
+    GDALDataset *srcDS, *winDS, *wrpDS;
     std::string temp;
     std::vector<std::string> varList = getVariableList();
 
@@ -873,7 +873,9 @@ void wrfSurfInitialization::setSurfaceGrids( WindNinjaInputs &input,
             }
         }
 
-        wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( srcDS, srcWKT,
+        winDS = openDemWindow( srcDS, srcWKT, input );  //only the part around the DEM
+        demWindowGuard winDSGuard( srcDS, winDS );  //closes winDS on every way out
+        wrpDS = (GDALDataset*) GDALAutoCreateWarpedVRT( winDS, srcWKT,
                                                         dstWkt.c_str(),
                                                         GRA_NearestNeighbour,
                                                         1.0, psWarpOptions );
@@ -28,6 +28,8 @@
  *****************************************************************************/
 
 #include "wxModelInitialization.h"
+#include "terrainContext.h"
+#include "forecastCache.h"
 
 // #define NC_NOERR        0       /* No Error */
 
@@ -342,6 +344,70 @@ int wxModelInitialization::ComputeWxModelBuffer( GDALDataset *poDS, double bound
     return 0;
 }
 
+/**
+ * \brief Window of a forecast dataset around the DEM, to warp instead of the
+ * whole dataset.
+ *
+ * The window covers the DEM plus the buffer of ComputeWxModelBuffer(), so
+ * the grids still overlap the DEM after warping, while the read and the warp
+ * only touch the part of the model grid around it.  The whole dataset is
+ * used if it has no geotransform, the window can't be computed or is most
+ * of the dataset anyway (forecasts downloaded for the DEM), or
+ * NINJA_WX_WINDOW_READ is FALSE.
+ *
+ * \param srcDS forecast dataset, with its projection set
+ * \param pszSrcWkt projection of srcDS, as WKT
+ * \param input inputs of the run, for the DEM
+ * \return a VRT of the window (close it after the warped dataset made from
+ *         it) or srcDS
+ */
+GDALDataset* wxModelInitialization::openDemWindow( GDALDataset *srcDS, const char *pszSrcWkt,
+                                                   const WindNinjaInputs &input )
+{
+    if( !CSLTestBoolean( CPLGetConfigOption( "NINJA_WX_WINDOW_READ", "TRUE" ) ) ||
+        input.dem.prjString.empty() || input.dem.get_nCols() == 0 )
+    {
+        return srcDS;
+    }
+
+    /*
+    ** ComputeWxModelBuffer() works on a dataset, so give it the footprint of
+    ** the DEM as a dataset with no bands.
+    */
+    GDALDriverH hMemDriver = GDALGetDriverByName( "MEM" );
+    if( hMemDriver == NULL )
+        return srcDS;
+    GDALDatasetH hDemDS = GDALCreate( hMemDriver, "", input.dem.get_nCols(),
+                                      input.dem.get_nRows(), 0, GDT_Byte, NULL );
+    if( hDemDS == NULL )
+        return srcDS;
+    double adfGeoTransform[6] = { input.dem.get_xllCorner(), input.dem.get_cellSize(), 0.0,
+                                  input.dem.get_yllCorner() + input.dem.get_nRows() * input.dem.get_cellSize(),
+                                  0.0, -input.dem.get_cellSize() };
+    GDALSetGeoTransform( hDemDS, adfGeoTransform );
+    GDALSetProjection( hDemDS, input.dem.prjString.c_str() );
+
+    double bounds[4];
+    ComputeWxModelBuffer( (GDALDataset*)hDemDS, bounds );
+    GDALClose( hDemDS );
+
+    int window[4];
+    if( !GDALGetPixelWindow( srcDS, pszSrcWkt, bounds, window ) )
+        return srcDS;
+    double windowFraction = ( (double)window[2] * window[3] ) /
+        ( (double)srcDS->GetRasterXSize() * srcDS->GetRasterYSize() );
+    if( windowFraction > 0.8 )
+        return srcDS;
+
+    GDALDataset *winDS = GDALCreateWindowVRT( srcDS, window );
+    if( winDS == NULL )
+        return srcDS;
+    CPLDebug( "WINDNINJA", "Reading a %dx%d window of the %dx%d forecast grid at (%d, %d).",
+              window[2], window[3], srcDS->GetRasterXSize(), srcDS->GetRasterYSize(),
+              window[0], window[1] );
+    return winDS;
+}
+
 /**
  * \brief Default buffer size for wxModel runs.
  *
@@ -1135,7 +1201,7 @@ void wxModelInitialization::ninjaFoamInitializeFields(WindNinjaInputs &input,
 
     setGridHeaderData(input, cloud);
 
-    setSurfaceGrids( input, airTempGrid_wxModel, cloudCoverGrid_wxModel, uGrid_wxModel,
+    ForecastCache::getSurfaceGrids( *this, input, airTempGrid_wxModel, cloudCoverGrid_wxModel, uGrid_wxModel,
              vGrid_wxModel, wGrid_wxModel );
 
     interpolateWxGridsToNinjaGrids(input);
@@ -1201,8 +1267,9 @@ void wxModelInitialization::initializeFields(WindNinjaInputs &input,
 
     setGridHeaderData(input, cloud);
 
-    //Read in wxModel grids (speed, direction, temperature and cloud cover grids)
-    setSurfaceGrids(input, airTempGrid_wxModel, cloudCoverGrid_wxModel, uGrid_wxModel,
+    //Read in wxModel grids (speed, direction, temperature and cloud cover grids),
+    //decoded once for the army if it shares a ForecastCache
+    ForecastCache::getSurfaceGrids(*this, input, airTempGrid_wxModel, cloudCoverGrid_wxModel, uGrid_wxModel,
                     vGrid_wxModel, wGrid_wxModel);
 #ifdef NOMADS_ENABLE_3D
     set3dGrids(input, mesh);
@@ -1249,11 +1316,17 @@ void wxModelInitialization::interpolateWxGridsToNinjaGrids(WindNinjaInputs &inpu
         throw std::logic_error("The weather model grid does not completely overlap the DEM.");
     }
 
-    //Interpolate from original wxModel grids to dem coincident grids
-    airTempGrid.interpolateFromGrid(airTempGrid_wxModel, AsciiGrid<double>::order1);
-    cloudCoverGrid.interpolateFromGrid(cloudCoverGrid_wxModel, AsciiGrid<double>::order1);
-    uInitializationGrid.interpolateFromGrid(uGrid_wxModel, AsciiGrid<double>::order1);
-    vInitializationGrid.interpolateFromGrid(vGrid_wxModel, AsciiGrid<double>::order1);
+    //Interpolate from original wxModel grids to dem coincident grids, the
+    //grids usually share one layout so they share one plan
+    AsciiGrid<double> *wxGrids[4] = {&airTempGrid_wxModel, &cloudCoverGrid_wxModel, &uGrid_wxModel, &vGrid_wxModel};
+    AsciiGrid<double> *ninjaGrids[4] = {&airTempGrid, &cloudCoverGrid, &uInitializationGrid, &vInitializationGrid};
+    boost::shared_ptr<const GridRemapPlan> plan;
+    for(int n = 0; n < 4; n++)
+    {
+        if(!plan || !plan->matches(*wxGrids[n], *ninjaGrids[n]))
+            plan = TerrainContext::getRemapPlan(input, *wxGrids[n], *ninjaGrids[n]);
+        plan->apply(*wxGrids[n], *ninjaGrids[n]);
+    }
 
     /*
     ** Fill in speed and direction grids from interpolated U and V grids.
@@ -1300,6 +1373,21 @@ void wxModelInitialization::interpolateWxGridsToNinjaGrids(WindNinjaInputs &inpu
         throw std::logic_error("Dem and vInitializationGrid are not coincident in wx model interpolation.");
 }
 
+/**
+ * Shape factor at height AGL of the profile from the 3d layer kk of a column
+ * down to the ground.  The column values of columnProfile must already be set.
+ * @see windProfile::getShapeFactor()
+ */
+double wxModelInitialization::shapeFactorFrom3dLayer(windProfile &columnProfile,
+                                                     const Mesh& mesh,
+                                                     int i, int j, int kk,
+                                                     double AGL)
+{
+    columnProfile.inputWindHeight = mesh.ZORD(i,j,kk) - mesh.ZORD(i,j,0) - columnProfile.Rough_h; // height above vegetation
+    columnProfile.setColumn();
+    return columnProfile.getShapeFactor(AGL);
+}
+
 void wxModelInitialization::initializeWindFrom3dData(WindNinjaInputs &input,
                                 const Mesh& mesh,
                                 wn_3dScalarField& u0,
@@ -1307,71 +1395,86 @@ void wxModelInitialization::initializeWindFrom3dData(WindNinjaInputs &input,
                                 wn_3dScalarField& w0)
 {
 //TODO: account for projection rotation from north for 3d data
-    int kk;
-    int i, j, k;
-    double tempGradient;
-//#pragma omp parallel for default(shared) firstprivate(profile) private(i,j,k)
-    for(i = 0; i < input.dem.get_nRows(); i++){
-        for(j = 0; j < input.dem.get_nCols(); j++){
-
-            profile.ObukovLength = L(i,j);
-            profile.ABL_height = bl_height(i,j);
-            profile.Roughness = input.surface.Roughness(i,j);
-            profile.Rough_h = input.surface.Rough_h(i,j);
-            profile.Rough_d = input.surface.Rough_d(i,j);
-
-            for(k = 0; k < mesh.nlayers; k++){
-                profile.AGL=mesh.ZORD(i, j, k)-input.dem(i,j);  // height above the ground
-
-                if(u3d(i,j,k) != -9999) {  // if have 3d winds for current cell
-                    u0(i, j, k) = u3d(i,j,k);
-                }
-                else{ // use log profile from first 3d layer down to ground
-                    kk = k;
-                    do{
-                        kk++;
-                        profile.inputWindHeight = mesh.ZORD(i,j,kk) - mesh.ZORD(i,j,0) - input.surface.Rough_h(i,j); // height above vegetation
-                        profile.inputWindSpeed = u3d(i,j,kk);
-                    }while (u3d(i,j,kk) == -9999);
-                    u0(i, j, k) += profile.getWindSpeed();
-                }
-                if(v3d(i,j,k) != -9999){  // if have 3d winds for current cell
-                    v0(i, j, k) = v3d(i,j,k);
-                }
-                else{
-                    kk = k;
-                    do{
-                        kk++;
-                        profile.inputWindHeight = mesh.ZORD(i,j,kk) - mesh.ZORD(i,j,0) - input.surface.Rough_h(i,j); // height above vegetation
-                        profile.inputWindSpeed = v3d(i,j,kk);
-                    }while (v3d(i,j,kk) == -9999);
-
-                    v0(i, j, k) += profile.getWindSpeed();
-                }
-                if(w3d(i,j,k) != -9999){  // if have 3d winds for current cell
-                    w0(i, j, k) = w3d(i,j,k);
-                }
-                else{
-                    kk = k;
-                    do{
-                        kk++;
-                        profile.inputWindHeight = mesh.ZORD(i,j,kk) - mesh.ZORD(i,j,0) - input.surface.Rough_h(i,j); // height above vegetation
-                        profile.inputWindSpeed = w3d(i,j,kk);
-                    }while (w3d(i,j,kk) == -9999);
-
-                    w0(i, j, k) += profile.getWindSpeed();
-                }
-                if(air3d(i,j,k) == -9999){ //if don't have 3d T for current cell
-                    kk = k;
-                    do{ // find lowest 3d layer; these are perturbation potetential temperatures, not temperature!
-                        kk++;
-                    }while (air3d(i,j,kk) == -9999);
-                    tempGradient = ( air3d(i,j,kk) - air3d(i,j,kk+1) ) /
-                                   ( mesh.ZORD(i,j,kk+1) - mesh.ZORD(i,j,kk) ); // find gradient between lowest two 3D layers
-
-                    for(int m = k; m<kk; m++){
-                        air3d(i,j,m) = air3d(i,j,kk) + (tempGradient *
-                                       ( mesh.ZORD(i,j,kk) - mesh.ZORD(i,j,m) )); //apply this gradient to current layer
+    /*
+    ** Below the lowest 3d layer the winds follow the profile from the first
+    ** layer with data.  u, v and w usually share that layer, so its shape
+    ** factor is computed once per node and scaled by each component.
+    */
+#pragma omp parallel default(shared)
+    {
+        windProfile columnProfile = profile;
+        int i, j, k, kk, kkFactor;
+        double tempGradient, AGL;
+        double factor = 0.0;
+
+#pragma omp for
+        for(i = 0; i < input.dem.get_nRows(); i++){
+            for(j = 0; j < input.dem.get_nCols(); j++){
+
+                columnProfile.ObukovLength = L(i,j);
+                columnProfile.ABL_height = bl_height(i,j);
+                columnProfile.Roughness = input.surface.Roughness(i,j);
+                columnProfile.Rough_h = input.surface.Rough_h(i,j);
+                columnProfile.Rough_d = input.surface.Rough_d(i,j);
+
+                for(k = 0; k < mesh.nlayers; k++){
+                    AGL = mesh.ZORD(i, j, k)-input.dem(i,j);  // height above the ground
+                    kkFactor = -1;  // layer the current factor was computed from
+
+                    if(u3d(i,j,k) != -9999) {  // if have 3d winds for current cell
+                        u0(i, j, k) = u3d(i,j,k);
+                    }
+                    else{ // use log profile from first 3d layer down to ground
+                        kk = k;
+                        do{
+                            kk++;
+                        }while (u3d(i,j,kk) == -9999);
+                        if(kk != kkFactor){
+                            factor = shapeFactorFrom3dLayer(columnProfile, mesh, i, j, kk, AGL);
+                            kkFactor = kk;
+                        }
+                        u0(i, j, k) += u3d(i,j,kk)*factor;
+                    }
+                    if(v3d(i,j,k) != -9999){  // if have 3d winds for current cell
+                        v0(i, j, k) = v3d(i,j,k);
+                    }
+                    else{
+                        kk = k;
+                        do{
+                            kk++;
+                        }while (v3d(i,j,kk) == -9999);
+                        if(kk != kkFactor){
+                            factor = shapeFactorFrom3dLayer(columnProfile, mesh, i, j, kk, AGL);
+                            kkFactor = kk;
+                        }
+                        v0(i, j, k) += v3d(i,j,kk)*factor;
+                    }
+                    if(w3d(i,j,k) != -9999){  // if have 3d winds for current cell
+                        w0(i, j, k) = w3d(i,j,k);
+                    }
+                    else{
+                        kk = k;
+                        do{
+                            kk++;
+                        }while (w3d(i,j,kk) == -9999);
+                        if(kk != kkFactor){
+                            factor = shapeFactorFrom3dLayer(columnProfile, mesh, i, j, kk, AGL);
+                            kkFactor = kk;
+                        }
+                        w0(i, j, k) += w3d(i,j,kk)*factor;
+                    }
+                    if(air3d(i,j,k) == -9999){ //if don't have 3d T for current cell
+                        kk = k;
+                        do{ // find lowest 3d layer; these are perturbation potetential temperatures, not temperature!
+                            kk++;
+                        }while (air3d(i,j,kk) == -9999);
+                        tempGradient = ( air3d(i,j,kk) - air3d(i,j,kk+1) ) /
+                                       ( mesh.ZORD(i,j,kk+1) - mesh.ZORD(i,j,kk) ); // find gradient between lowest two 3D layers
+
+                        for(int m = k; m<kk; m++){
+                            air3d(i,j,m) = air3d(i,j,kk) + (tempGradient *
+                                           ( mesh.ZORD(i,j,kk) - mesh.ZORD(i,j,m) )); //apply this gradient to current layer
+                        }
                     }
                 }
             }
@@ -1432,10 +1535,8 @@ void wxModelInitialization::interpolate2dDataToPoints(WindNinjaInputs &input, co
 void wxModelInitialization::interpolate3dDataToPoints(WindNinjaInputs &input, const Mesh& mesh)
 {
     element elem(&mesh);
-    std::vector<Mesh> meshList;
-    meshList.push_back(xStaggerWxMesh);
-    meshList.push_back(yStaggerWxMesh);
-    meshList.push_back(zStaggerWxMesh);
+    //the staggered meshes of wxU3d, wxV3d and wxW3d
+    const Mesh *meshList[3] = {&xStaggerWxMesh, &yStaggerWxMesh, &zStaggerWxMesh};
 
     int elem_wx_i, elem_wx_j, elem_wx_k; // wx model cells
     int elem_i, elem_j, elem_k; // wn cells
@@ -1449,7 +1550,7 @@ void wxModelInitialization::interpolate3dDataToPoints(WindNinjaInputs &input, co
     double x, y, z; // locations to interpolate to
 
     for(unsigned int i = 0; i < input.latList.size(); i++){
-        for(unsigned int j = 0; j < meshList.size(); j++){
+        for(unsigned int j = 0; j < 3; j++){
             x = input.projXList[i]; //projected (dem) coords
             y = input.projYList[i]; //projected (dem) coords
             z = input.heightList[i]; //height above ground
@@ -1457,10 +1558,10 @@ void wxModelInitialization::interpolate3dDataToPoints(WindNinjaInputs &input, co
             x -= input.dem.xllCorner; //put into wn mesh coords
             y -= input.dem.yllCorner; //put into wn mesh coords
 
-            element elem_wx(&meshList[j]);
+            element elem_wx(meshList[j]);
 
             elem_wx.get_uv(x, y, elem_wx_i, elem_wx_j, u_wx, v_wx); //get u and v coordinates in wx mesh
-            wx_i = meshList[j].get_elemNum(elem_wx_i, elem_wx_j, 0); //wx_i is element number in wx mesh
+            wx_i = meshList[j]->get_elemNum(elem_wx_i, elem_wx_j, 0); //wx_i is element number in wx mesh
             elem_wx.get_xyz(wx_i, u_wx, v_wx, -1, x_wx, y_wx, z_wx); //get real z_wx at wx model ground
             z += z_wx; // add height above ground to wx model ground height, z is now the z to interpolate to
 
@@ -1496,15 +1597,15 @@ void wxModelInitialization::interpolate3dDataToPoints(WindNinjaInputs &input, co
                     w_wxList.push_back(profile.getWindSpeed());
                 }
             }
-            else{//else use linear interpolation
+            else{//else use linear interpolation in the cell found above
                 if(j==0){
-                    u_wxList.push_back(wxU3d.interpolate(x,y,z));
+                    u_wxList.push_back(wxU3d.interpolate(elem_wx, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx));
                 }
                 else if(j==1){
-                    v_wxList.push_back(wxV3d.interpolate(x,y,z));
+                    v_wxList.push_back(wxV3d.interpolate(elem_wx, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx));
                 }
                 else{
-                    w_wxList.push_back(wxW3d.interpolate(x,y,z));
+                    w_wxList.push_back(wxW3d.interpolate(elem_wx, elem_wx_i, elem_wx_j, elem_wx_k, u_wx, v_wx, w_wx));
                 }
             }
         }
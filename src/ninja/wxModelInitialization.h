@@ -79,6 +79,30 @@ extern omp_lock_t netCDF_lock;
 
 static char **papszThreddsCsv = NULL;
 
+/**
+ * Guard for the window of wxModelInitialization::openDemWindow().  Closes
+ * it when the guard goes out of scope, unless it is the forecast dataset
+ * itself, so a throw while warping or reading doesn't leak it.
+ */
+class demWindowGuard
+{
+public:
+    demWindowGuard( GDALDataset *srcDS, GDALDataset *winDS )
+        : srcDS_( srcDS ), winDS_( winDS ) {}
+    ~demWindowGuard()
+    {
+        if( winDS_ != NULL && winDS_ != srcDS_ )
+            GDALClose( (GDALDatasetH) winDS_ );
+    }
+
+private:
+    GDALDataset *srcDS_;
+    GDALDataset *winDS_;
+
+    demWindowGuard( const demWindowGuard & );
+    void operator=( const demWindowGuard & );
+};
+
 /**
  * Class used for coarse weather model initialization.
  * Inherits from initialize.  Mostly contains virtual functions defined by
@@ -90,6 +114,8 @@ static char **papszThreddsCsv = NULL;
 class wn_3dScalarField;
 class wxModelInitialization : public initialize
 {
+    friend class ForecastCache;  //decodes the surface grids of other times
+
  public:
 
     wxModelInitialization();
@@ -137,6 +163,8 @@ class wxModelInitialization : public initialize
 
     int ComputeWxModelBuffer(GDALDataset *poDS, double buffer[4]);
     virtual double GetWxModelBuffer(double delta);
+    GDALDataset* openDemWindow(GDALDataset *srcDS, const char *pszSrcWkt,
+                               const WindNinjaInputs &input);
 
     std::string generateUrl( double north, double west, double east,
                              double south, int hours);
@@ -209,6 +237,11 @@ private:
                                 wn_3dScalarField& v0,
                                 wn_3dScalarField& w0);
 
+    static double shapeFactorFrom3dLayer(windProfile &columnProfile,
+                                         const Mesh& mesh,
+                                         int i, int j, int kk,
+                                         double AGL);
+
     void interpolate2dDataToPoints(WindNinjaInputs& input,
                                  const Mesh& mesh);
 
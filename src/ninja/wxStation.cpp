@@ -28,9 +28,6 @@
  *****************************************************************************/
 #include "wxStation.h"
 
-wxStation::eStationFormat wxStation::stationFormat = invalidFormat;  
-
-vector<std::string> wxStation::stationKmlNames;
 
 wxStation::wxStation()
 : currentTime(boost::local_time::not_a_date_time)
@@ -296,49 +293,32 @@ void wxStation::set_stationName( std::string Name )
  * @param demFile name of the dem file used to create the coordinate transformation
  */
 void wxStation::set_location_projected( double Xord, double Yord, std::string demFile )
+{
+    DemCoordinateTransform transform( demFile );
+    set_location_projected( Xord, Yord, transform );
+}
+
+/**
+ * Set the location of the station in lat/lon coordinates and in ninja coordinates, from dem projection coordinates
+ * @see wxStation::set_location_projected( double, double, std::string )
+ * @param Xord x coordinate in projection system coordinates (dem projection coordinates)
+ * @param Yord y coordinate in projection system coordinates (dem projection coordinates)
+ * @param transform coordinate transformations of the dem
+ */
+void wxStation::set_location_projected( double Xord, double Yord, DemCoordinateTransform &transform )
 {
     coordType = PROJCS;
     datumType = WGS84;  // always use WGS84 for the datum for PROJCS regardless of the input datum type
 
-    projXord = Xord;
-    projYord = Yord;
+    double lonx = Xord;
+    double laty = Yord;
 
-    if(demFile.empty() || demFile == "")
-    {
-        throw std::runtime_error("Invalid input, The input demFile is empty.");
-    }
-
-    GDALDataset *poDS = (GDALDataset*) GDALOpen( demFile.c_str(), GA_ReadOnly );
-    if(poDS == NULL)
-    {
-        throw std::runtime_error("Cannot open input demFile.");
-    }
-
-    //get llcorner to subtract
-    double adfGeoTransform[6];
-    if(poDS->GetGeoTransform(adfGeoTransform) != CE_None)
-    {
-        throw std::runtime_error("Could not get GeoTransform from input demFile.");
-    }
-
-    double llx = adfGeoTransform[0];
-    double lly = adfGeoTransform[3] + ( adfGeoTransform[5] * poDS->GetRasterYSize() );
-
-    xord = Xord - llx;
-    yord = Yord - lly;
-
-    double lonx = projXord;
-    double laty = projYord;
-
-    if(!GDALPointToLatLon(lonx, laty, poDS, "WGS84"))
+    if(!transform.toLatLon(1, &lonx, &laty, "WGS84"))
     {
         throw std::runtime_error("Failed to warp station point to lat lon.");
     }
 
-    lon = lonx;
-    lat = laty;
-
-    GDALClose( (GDALDatasetH)poDS );
+    set_location( Xord, Yord, laty, lonx, transform );
 }
 
 /**
@@ -354,65 +334,168 @@ void wxStation::set_location_projected( double Xord, double Yord, std::string de
 void wxStation::set_location_LatLong( double Lat, double Lon,
                                       const std::string demFile,
                                       const char *datum )
+{
+    DemCoordinateTransform transform( demFile );
+    set_location_LatLong( Lat, Lon, transform, datum );
+}
+
+/**
+ * Set location of the station in projection system coordinates (dem projection coordinates)
+ * and in ninja coordinates, from lat/lon coordinates
+ * @see wxStation::set_location_LatLong( double, double, std::string, const char* )
+ * @param Lat latitude of the station
+ * @param Lon longitude of the station
+ * @param transform coordinate transformations of the dem
+ * @param datum datum to convert to
+ */
+void wxStation::set_location_LatLong( double Lat, double Lon,
+                                      DemCoordinateTransform &transform,
+                                      const char *datum )
 {
     coordType = GEOGCS;
+    datumType = parse_datum( datum );
 
-    if( EQUAL( datum, "WGS84" ) )
+    lon = Lon;
+    lat = Lat;
+
+    double projX = lon;
+    double projY = lat;
+
+    if(!transform.fromLatLon(1, &projX, &projY, datum))
     {
-        datumType = WGS84;
+        throw std::runtime_error("Failed to warp station point from lat lon.");
     }
-    else if( EQUAL( datum, "NAD83" ) )
+
+    set_location( projX, projY, Lat, Lon, transform );
+}
+
+/**
+ * Set the locations of many stations, with one coordinate transformation for
+ * all of the stations in a coordinate system and datum.
+ * @param stations stations to locate
+ * @param xCoords x coordinate of each station, the longitude for GEOGCS stations
+ * @param yCoords y coordinate of each station, the latitude for GEOGCS stations
+ * @param coordSys coordinate system of each station, PROJCS or GEOGCS
+ * @param datums datum of each station, used for GEOGCS stations
+ * @param transform coordinate transformations of the dem
+ * @see wxStation::set_location_projected(), wxStation::set_location_LatLong()
+ */
+void wxStation::set_locations( std::vector<wxStation> &stations,
+                               const std::vector<double> &xCoords, const std::vector<double> &yCoords,
+                               const std::vector<std::string> &coordSys, const std::vector<std::string> &datums,
+                               DemCoordinateTransform &transform )
+{
+    //station indices, PROJCS stations are always WGS84
+    std::vector<int> projected;
+    std::map<std::string, std::vector<int> > latLong;
+
+    for(unsigned int i = 0; i < stations.size(); i++)
     {
-        datumType = NAD83;
+        if( EQUAL( coordSys[i].c_str(), "PROJCS" ) )
+        {
+            stations[i].coordType = PROJCS;
+            stations[i].datumType = WGS84;
+            projected.push_back(i);
+        }
+        else
+        {
+            stations[i].coordType = GEOGCS;
+            stations[i].datumType = parse_datum( datums[i].c_str() );
+            latLong[datums[i]].push_back(i);
+        }
     }
-    else if ( EQUAL( datum, "NAD27" ) )
+
+    std::vector<double> x, y;
+    if(!projected.empty())
     {
-        datumType = NAD27;
+        x.resize(projected.size());
+        y.resize(projected.size());
+        for(unsigned int n = 0; n < projected.size(); n++)
+        {
+            x[n] = xCoords[projected[n]];
+            y[n] = yCoords[projected[n]];
+        }
+
+        if(!transform.toLatLon(projected.size(), &x[0], &y[0], "WGS84"))
+        {
+            throw std::runtime_error("Failed to warp station point to lat lon.");
+        }
+
+        for(unsigned int n = 0; n < projected.size(); n++)
+        {
+            int i = projected[n];
+            stations[i].set_location( xCoords[i], yCoords[i], y[n], x[n], transform );
+        }
     }
-    else
+
+    std::map<std::string, std::vector<int> >::const_iterator it;
+    for(it = latLong.begin(); it != latLong.end(); ++it)
     {
-        throw std::runtime_error("The station datum '"+std::string(datum)+"' is not valid. options are 'WGS84', 'NAD83', 'NAD27'");
-    }
+        const std::vector<int> &group = it->second;
+        x.resize(group.size());
+        y.resize(group.size());
+        for(unsigned int n = 0; n < group.size(); n++)
+        {
+            x[n] = xCoords[group[n]];
+            y[n] = yCoords[group[n]];
+        }
 
-    lon = Lon;
-    lat = Lat;
+        if(!transform.fromLatLon(group.size(), &x[0], &y[0], it->first.c_str()))
+        {
+            throw std::runtime_error("Failed to warp station point from lat lon.");
+        }
 
-    if(demFile.empty() || demFile == "")
-    {
-        throw std::runtime_error("Invalid input, The input demFile is empty.");
+        for(unsigned int n = 0; n < group.size(); n++)
+        {
+            int i = group[n];
+            stations[i].set_location( x[n], y[n], yCoords[i], xCoords[i], transform );
+        }
     }
+}
 
-    GDALDataset *poDS = (GDALDataset*)GDALOpen( demFile.c_str(), GA_ReadOnly );
-    if(poDS == NULL)
+/**
+ * Get the datum type of a datum name
+ * @param datum WGS84, NAD83 or NAD27
+ */
+wxStation::eDatumType wxStation::parse_datum( const char *datum )
+{
+    if( EQUAL( datum, "WGS84" ) )
     {
-        throw std::runtime_error("Cannot open input demFile.");
+        return WGS84;
     }
-
-    double projX = lon;
-    double projY = lat;
-
-    if(!GDALPointFromLatLon(projX, projY, poDS, datum))
+    else if( EQUAL( datum, "NAD83" ) )
     {
-        throw std::runtime_error("Failed to warp station point from lat lon.");
+        return NAD83;
     }
-
-    projXord = projX;
-    projYord = projY;
-
-    //get llcorner to subtract
-    double adfGeoTransform[6];
-    if(poDS->GetGeoTransform(adfGeoTransform) != CE_None)
+    else if ( EQUAL( datum, "NAD27" ) )
     {
-        throw std::runtime_error("Could not get GeoTransform from input demFile.");
+        return NAD27;
     }
+    else
+    {
+        throw std::runtime_error("The station datum '"+std::string(datum)+"' is not valid. options are 'WGS84', 'NAD83', 'NAD27'");
+    }
+}
 
-    double llx = adfGeoTransform[0];
-    double lly = adfGeoTransform[3] + ( adfGeoTransform[5] * poDS->GetRasterYSize() );
+/**
+ * Set the location of the station in all of its coordinate systems
+ * @param Xord x coordinate in projection system coordinates (dem projection coordinates)
+ * @param Yord y coordinate in projection system coordinates (dem projection coordinates)
+ * @param Lat latitude of the station
+ * @param Lon longitude of the station
+ * @param transform coordinate transformations of the dem, for its lower left corner
+ */
+void wxStation::set_location( double Xord, double Yord, double Lat, double Lon,
+                              const DemCoordinateTransform &transform )
+{
+    projXord = Xord;
+    projYord = Yord;
 
-    xord = projXord - llx;
-    yord = projYord - lly;
+    xord = projXord - transform.get_xllCorner();
+    yord = projYord - transform.get_yllCorner();
 
-    GDALClose( (GDALDatasetH)poDS );
+    lon = Lon;
+    lat = Lat;
 }
 
 /**
@@ -613,16 +696,6 @@ void wxStation::stationViewer(wxStation station)
 
 }
 
-void wxStation::SetStationFormat(eStationFormat format)
-{
-    stationFormat = format;
-}
-
-wxStation::eStationFormat wxStation::GetStationFormat()
-{
-    return stationFormat;
-}
-
 /**
  * Check the validity of the csv file named pszFilename.  If it is valid, return
  * the format version of the data.
@@ -908,9 +981,9 @@ void wxStation::writeStationFile( std::vector<wxStation>StationVect,
 /** Write a point kml file for all the weather stations in stations vector.
  * @param stations A vector of wxStationList objects
  * @param outFileName A string for output file
- * @return void
+ * @return The name of the kml file written
  */
-void wxStation::writeKmlFile( std::vector<wxStation> stations,
+std::string wxStation::writeKmlFile( std::vector<wxStation> stations,
                               std::string demFileName, std::string outPath, velocityUnits::eVelocityUnits velUnits)
 {
     std::string outFileNameStamp;
@@ -945,7 +1018,7 @@ void wxStation::writeKmlFile( std::vector<wxStation> stations,
     if( stations.size() == 0 )
     {
         CPLError(CE_Warning, CPLE_AppDefined, "The input stations is empty, skipping kml file.");
-        return;
+        return "";
     }
 
     CPLDebug("STATION_FETCH", "KML PATH: %s", outFileNameStamp.c_str());
@@ -953,7 +1026,7 @@ void wxStation::writeKmlFile( std::vector<wxStation> stations,
     if( fout == NULL )
     {
         CPLError(CE_Failure, CPLE_AppDefined, "Cannot open kml file: %s for writing.", outFileNameStamp.c_str());
-        return;
+        return "";
     }
 
     double heightTemp, speedTemp, directionTemp, ccTemp, temperatureTemp, radOfInflTemp;
@@ -1028,7 +1101,7 @@ void wxStation::writeKmlFile( std::vector<wxStation> stations,
 
     fclose( fout );
 
-    stationKmlNames.push_back(outFileNameStamp);
+    return outFileNameStamp;
 }
 
 void wxStation::writeKMZFile(std::vector<wxStation> stations, string basePath, string demFileName)
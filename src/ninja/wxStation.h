@@ -35,6 +35,7 @@
 #include <string>
 
 #include "gdal_util.h"
+#include "demCoordinateTransform.h"
 #include "gdal_priv.h"
 #include "ogr_spatialref.h"
 #include "ogrsf_frmts.h"
@@ -102,12 +103,19 @@ class wxStation
     void set_stationName( std::string Name );
     inline std::string get_stationName() { return stationName; }
     void set_location_projected( double Xord, double Yord, std::string demFile );
+    void set_location_projected( double Xord, double Yord, DemCoordinateTransform &transform );
     inline double get_projXord() { return projXord; }
     inline double get_projYord() { return projYord; }
     inline double get_xord() { return xord; }
     inline double get_yord() { return yord; }
     void set_location_LatLong( double Lat, double Lon, std::string demFile,
                    const char *datum );
+    void set_location_LatLong( double Lat, double Lon, DemCoordinateTransform &transform,
+                   const char *datum );
+    static void set_locations( std::vector<wxStation> &stations,
+                   const std::vector<double> &xCoords, const std::vector<double> &yCoords,
+                   const std::vector<std::string> &coordSys, const std::vector<std::string> &datums,
+                   DemCoordinateTransform &transform );
     inline double get_lon() { return lon; }
     inline double get_lat() { return lat; }
     void set_height( double Height, lengthUnits::eLengthUnits units );
@@ -153,10 +161,9 @@ class wxStation
 
     static void stationViewer(wxStation station);
 
-    static void writeKmlFile( std::vector<wxStation> stations,
+    static std::string writeKmlFile( std::vector<wxStation> stations,
                   std::string demFileName,std::string basePath, velocityUnits::eVelocityUnits velUnits);
     static void writeKMZFile(std::vector<wxStation> stations,std::string basePath, std::string demFileName);
-    static vector<std::string> stationKmlNames;
 
     static void writeStationFile( std::vector<wxStation> StationVect,
                   const std::string outFileName );
@@ -165,13 +172,13 @@ class wxStation
 
     static int GetHeaderVersion(const char *pszFilename);
     static int GetFirstStationLine(const char *xFilename);
-    static void SetStationFormat(eStationFormat format);
-    static wxStation::eStationFormat GetStationFormat();
-
-    static eStationFormat stationFormat;
 
  private:
 
+    static eDatumType parse_datum( const char *datum );
+    void set_location( double Xord, double Yord, double Lat, double Lon,
+                   const DemCoordinateTransform &transform );
+
     std::string stationName;
     double lat, lon;           //latitude and longitude
     double projXord;           //x-coordinate of station (in projected coordinate system)